@@ -0,0 +1,19 @@
+#include "device.h"
+
+#include <string_view>
+
+namespace fs::device
+{
+
+std::string_view to_string(DeviceKernel kernel)
+{
+    switch (kernel)
+    {
+        case DeviceKernel::POLYNOMIAL_7: return "polynomial_7";
+        case DeviceKernel::TABLE_4096_HERMITE: return "table_4096_hermite";
+    }
+
+    return "unknown";
+}
+
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace fs::device
+{
+
+/**
+ * Kernels the device backend can run.
+ */
+enum class DeviceKernel
+{
+    /** Same as PolynomialKernel<7>. */
+    POLYNOMIAL_7,
+
+    /** Same as TableKernel<4096, Interpolation::HERMITE>. */
+    TABLE_4096_HERMITE
+};
+
+/** Every kernel the device backend can run. */
+inline constexpr DeviceKernel all_kernels[] = {DeviceKernel::POLYNOMIAL_7, DeviceKernel::TABLE_4096_HERMITE};
+
+/**
+ * Get the name of a device kernel, matching the name the harness registers the host version under.
+ *
+ * @param kernel
+ *   Kernel.
+ *
+ * @returns
+ *   Name of kernel.
+ */
+std::string_view to_string(DeviceKernel kernel);
+
+/**
+ * Get the name of the backend this library was built with.
+ *
+ * @returns
+ *   Either cuda, or host when built without USE_CUDA.
+ */
+std::string_view backend();
+
+/**
+ * Check if there is a device to run on. The host fallback is always available.
+ *
+ * @returns
+ *   True if the backend can be used, otherwise false.
+ */
+bool available();
+
+/**
+ * Array of floats in device memory, which is ordinary memory for the host fallback.
+ */
+class Buffer
+{
+  public:
+    /**
+     * Construct a new Buffer.
+     *
+     * @param size
+     *   Number of floats.
+     *
+     * @throws std::runtime_error
+     *   If the memory can't be allocated.
+     */
+    explicit Buffer(std::size_t size);
+
+    ~Buffer();
+
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+
+    Buffer(Buffer &&other) noexcept;
+    Buffer &operator=(Buffer &&other) noexcept;
+
+    /**
+     * Get the device address of the buffer, for passing to calculate.
+     *
+     * @returns
+     *   Device pointer to the first float.
+     */
+    float *data() noexcept;
+
+    /**
+     * Get the device address of the buffer, for passing to calculate.
+     *
+     * @returns
+     *   Device pointer to the first float.
+     */
+    const float *data() const noexcept;
+
+    /**
+     * Get the number of floats in the buffer.
+     *
+     * @returns
+     *   Size of buffer.
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     * Copy values from the host to the start of the buffer, waiting for the copy to finish.
+     *
+     * @param values
+     *   Values to copy, must be no larger than the buffer.
+     *
+     * @throws std::runtime_error
+     *   If the copy fails.
+     */
+    void upload(std::span<const float> values);
+
+    /**
+     * Copy values from the start of the buffer to the host, waiting for the copy to finish.
+     *
+     * @param values
+     *   Where to copy to, must be no larger than the buffer.
+     *
+     * @throws std::runtime_error
+     *   If the copy fails.
+     */
+    void download(std::span<float> values) const;
+
+  private:
+    /** Device memory, null once moved from. */
+    float *data_;
+
+    /** Number of floats. */
+    std::size_t size_;
+};
+
+/**
+ * Calculate sine of arrays already in device memory, waiting for the calculation to finish.
+ *
+ * @param kernel
+ *   Kernel to run.
+ *
+ * @param thetas
+ *   Device pointer to inputs.
+ *
+ * @param results
+ *   Device pointer to where to write results, may be the same as thetas.
+ *
+ * @param count
+ *   Number of inputs.
+ *
+ * @throws std::runtime_error
+ *   If the kernel fails to run.
+ */
+void calculate(DeviceKernel kernel, const float *thetas, float *results, std::size_t count);
+
+/**
+ * Error of a kernel against the reference over a sweep, the same statistics the harness collects on the host.
+ */
+struct SweepErrors
+{
+    /** Number of results compared. */
+    std::uint64_t compared = 0u;
+
+    /** Number of results where only one of the kernel and reference produced NaN. */
+    std::uint64_t nan_mismatches = 0u;
+
+    /** Largest absolute error seen. */
+    double max_error = 0.0;
+
+    /** Input which produced max_error. */
+    float max_error_input = 0.0f;
+
+    /** Sum of all absolute errors. */
+    double sum_error = 0.0;
+};
+
+/**
+ * Run a kernel over every float bit pattern in a range and compare each result to the sine of the input calculated in
+ * double and rounded to float. The inputs are generated and the errors reduced on the device, so only the statistics
+ * are copied back.
+ *
+ * @param kernel
+ *   Kernel to run.
+ *
+ * @param first
+ *   First bit pattern.
+ *
+ * @param count
+ *   Number of bit patterns, first + count must not exceed 2^32.
+ *
+ * @returns
+ *   Error statistics.
+ *
+ * @throws std::runtime_error
+ *   If the kernel fails to run.
+ */
+SweepErrors sweep(DeviceKernel kernel, std::uint64_t first, std::uint64_t count);
+
+}
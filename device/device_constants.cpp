@@ -0,0 +1,44 @@
+#include "device_constants.h"
+
+#include "polynomial.h"
+#include "range_reduction.h"
+#include "special_values.h"
+#include "table_calculator.h"
+
+namespace
+{
+
+using Table = fs::TableKernel<fs::device::detail::table_size, fs::Interpolation::HERMITE>;
+using Reduction = fs::detail::reduction_constants<float>;
+
+}
+
+namespace fs::device::detail
+{
+
+KernelConstants kernel_constants()
+{
+    constexpr auto sin = polynomial::cast<float>(remez::MinimaxCoefficients<7u>::sin);
+    constexpr auto cos = polynomial::cast<float>(remez::MinimaxCoefficients<7u>::cos);
+
+    static_assert(sin.size() == 4u && cos.size() == 5u, "device kernel expects a degree seven polynomial");
+
+    return {
+        .limit = Reduction::limit,
+        .identity_limit = fs::identity_limit_v<float>,
+        .pi_over_2 = {Reduction::pi_over_2_a, Reduction::pi_over_2_b, Reduction::pi_over_2_c},
+        .two_pi = {Reduction::two_pi_a, Reduction::two_pi_b, Reduction::two_pi_c},
+        .sin = {sin[0], sin[1], sin[2], sin[3]},
+        .cos = {cos[0], cos[1], cos[2], cos[3], cos[4]},
+        .table_scale = Table::position_scale<float>,
+        .table_step = {Table::step_a<float>, Table::step_b<float>}};
+}
+
+const float *hermite_table()
+{
+    static_assert(Table::table.size() == 2u * (table_size + 1u), "device kernel expects one extra hermite entry");
+
+    return Table::table.data();
+}
+
+}
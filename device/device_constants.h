@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+
+namespace fs::device::detail
+{
+
+/**
+ * Constants of the host kernels, rounded to float, for the CUDA backend. They are computed by the host headers in a
+ * separate translation unit so device code doesn't need to parse them.
+ */
+struct KernelConstants
+{
+    /** Largest magnitude Cody-Waite reduction is accurate for. */
+    float limit;
+
+    /** Magnitude below which sine is the input, the same as identity_limit_v. */
+    float identity_limit;
+
+    /** pi/2 split into three parts. */
+    float pi_over_2[3];
+
+    /** 2pi split into three parts. */
+    float two_pi[3];
+
+    /** Sine polynomial of PolynomialKernel<7>, lowest power first. */
+    float sin[4];
+
+    /** Cos polynomial of PolynomialKernel<7>, lowest power first. */
+    float cos[5];
+
+    /** Scale from an argument in [-pi, pi] to a position in the hermite table. */
+    float table_scale;
+
+    /** Step between hermite table entries, split into two parts. */
+    float table_step[2];
+};
+
+/** Number of intervals in the hermite table. */
+inline constexpr std::size_t table_size = 4096u;
+
+/**
+ * Get the kernel constants.
+ *
+ * @returns
+ *   Constants.
+ */
+KernelConstants kernel_constants();
+
+/**
+ * Get the hermite table of TableKernel<4096, Interpolation::HERMITE>, a value and scaled derivative per entry.
+ *
+ * @returns
+ *   Pointer to 2 * (table_size + 1) floats.
+ */
+const float *hermite_table();
+
+}
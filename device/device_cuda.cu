@@ -0,0 +1,600 @@
+#include "device.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <cuda_runtime.h>
+
+#include "device_constants.h"
+
+namespace
+{
+
+using fs::device::DeviceKernel;
+using fs::device::detail::table_size;
+
+/** Threads in each block. */
+constexpr unsigned int block_threads = 256u;
+
+/** Most blocks launched, larger arrays are covered by each thread striding over several elements. */
+constexpr unsigned int max_blocks = 4096u;
+
+/** Constants of the host kernels, copied in on first use. */
+__constant__ fs::device::detail::KernelConstants constants;
+
+/**
+ * Error statistics of the elements one thread or block has seen.
+ */
+struct Partial
+{
+    unsigned long long compared;
+    unsigned long long nan_mismatches;
+    double max_error;
+    float max_error_input;
+    double sum_error;
+};
+
+/**
+ * Throw if a CUDA call failed.
+ *
+ * @param error
+ *   Result of call.
+ *
+ * @param what
+ *   What the call was doing, for the message.
+ *
+ * @throws std::runtime_error
+ *   If error isn't success.
+ */
+void check(cudaError_t error, std::string_view what)
+{
+    if (error != cudaSuccess)
+    {
+        throw std::runtime_error{std::string{what} + ": " + cudaGetErrorString(error)};
+    }
+}
+
+/**
+ * Get the hermite table in device memory, copying it and the kernel constants to the device on first use. The table
+ * lives for the rest of the process.
+ *
+ * @returns
+ *   Device pointer to table.
+ *
+ * @throws std::runtime_error
+ *   If the copies fail.
+ */
+const float *device_table()
+{
+    static const float *table = []
+    {
+        const auto host = fs::device::detail::kernel_constants();
+        check(cudaMemcpyToSymbol(constants, &host, sizeof(host)), "copying kernel constants");
+
+        constexpr auto bytes = 2u * (table_size + 1u) * sizeof(float);
+
+        float *pointer = nullptr;
+        check(cudaMalloc(&pointer, bytes), "allocating hermite table");
+        check(
+            cudaMemcpy(pointer, fs::device::detail::hermite_table(), bytes, cudaMemcpyHostToDevice),
+            "copying hermite table");
+
+        return pointer;
+    }();
+
+    return table;
+}
+
+/**
+ * Get the number of blocks to launch over some elements.
+ *
+ * @param count
+ *   Number of elements.
+ *
+ * @returns
+ *   Number of blocks, at least one.
+ */
+unsigned int blocks_for(std::uint64_t count)
+{
+    const auto needed = (count + block_threads - 1u) / block_threads;
+    return static_cast<unsigned int>(std::clamp<std::uint64_t>(needed, 1u, max_blocks));
+}
+
+/**
+ * Check if a float is NaN by looking at its bits.
+ *
+ * @param value
+ *   Value to check.
+ *
+ * @returns
+ *   True if value is NaN, otherwise false.
+ */
+__device__ bool is_nan(float value)
+{
+    return (__float_as_uint(value) & 0x7fffffffu) > 0x7f800000u;
+}
+
+/**
+ * Round to the nearest integer with halves away from zero, as the host kernels pick a quadrant.
+ *
+ * @param value
+ *   Value to round.
+ *
+ * @returns
+ *   Nearest integer.
+ */
+__device__ int round_half_away(float value)
+{
+    return static_cast<int>(value + (value < 0.0f ? -0.5f : 0.5f));
+}
+
+/**
+ * Sine of an argument too large for Cody-Waite reduction. The host kernels use Payne-Hanek here, on the device the
+ * double sine does the same job and these lanes are rare enough that its cost doesn't matter.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+__device__ float sin_large(float theta)
+{
+    return static_cast<float>(sin(static_cast<double>(theta)));
+}
+
+/**
+ * Check if an input is close enough to zero that sine is the input, the same as below_identity_limit. The bits are
+ * compared as integers so denormals are caught even when the device flushes them.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   True if the magnitude is below the identity limit.
+ */
+__device__ bool below_identity_limit(float theta)
+{
+    return (__float_as_uint(theta) & 0x7fffffffu) < __float_as_uint(constants.identity_limit);
+}
+
+/**
+ * Check if an input is NaN or infinity, the same as not_finite.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   True if theta isn't finite.
+ */
+__device__ bool not_finite(float theta)
+{
+    return (__float_as_uint(theta) & 0x7fffffffu) >= 0x7f800000u;
+}
+
+/**
+ * Replace the inputs special_sine handles with zero, the same as ordinary_inputs, so they never reach sin_large.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Input, or zero if it is special.
+ */
+__device__ float ordinary_input(float theta)
+{
+    return (below_identity_limit(theta) || not_finite(theta)) ? 0.0f : theta;
+}
+
+/**
+ * Overwrite the result of the general path for special inputs, the same as special_sine. Near zero sine is the input,
+ * keeping the sign of zero, and sine of NaN or infinity is NaN.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @param result
+ *   Result of the general path for ordinary_input(theta).
+ *
+ * @returns
+ *   Sine of input value.
+ */
+__device__ float special_sine(float theta, float result)
+{
+    const float near_zero = below_identity_limit(theta) ? theta : result;
+    return not_finite(theta) ? __int_as_float(0x7fc00000) : near_zero;
+}
+
+/**
+ * The same calculation as PolynomialKernel<7>.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+__device__ float sin_polynomial(float theta)
+{
+    const float x = ordinary_input(theta);
+
+    if (!(fabsf(x) <= constants.limit))
+    {
+        return sin_large(x);
+    }
+
+    const int quadrant = round_half_away(x * (2.0f / 3.14159265358979323846f));
+    const float k = static_cast<float>(quadrant);
+
+    float r = x - (k * constants.pi_over_2[0]);
+    r = r - (k * constants.pi_over_2[1]);
+    r = r - (k * constants.pi_over_2[2]);
+
+    const float r2 = r * r;
+
+    float s = constants.sin[3];
+    s = (s * r2) + constants.sin[2];
+    s = (s * r2) + constants.sin[1];
+    s = (r * constants.sin[0]) + ((r * r2) * s);
+
+    float c = constants.cos[4];
+    c = (c * r2) + constants.cos[3];
+    c = (c * r2) + constants.cos[2];
+    c = (c * r2) + constants.cos[1];
+    c = (r2 * c) + constants.cos[0];
+
+    // quadrants 1 and 3 are cos shaped, quadrants 2 and 3 are negated
+    const float result = (quadrant & 1) != 0 ? c : s;
+    return special_sine(theta, (quadrant & 2) != 0 ? -result : result);
+}
+
+/**
+ * The same calculation as TableKernel<4096, Interpolation::HERMITE>.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @param table
+ *   Device pointer to hermite table.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+__device__ float sin_table(float theta, const float *table)
+{
+    const float x = ordinary_input(theta);
+
+    if (!(fabsf(x) <= constants.limit))
+    {
+        return sin_large(x);
+    }
+
+    const float turns = static_cast<float>(round_half_away(x * (0.5f / 3.14159265358979323846f)));
+
+    float r = x - (turns * constants.two_pi[0]);
+    r = r - (turns * constants.two_pi[1]);
+    r = r - (turns * constants.two_pi[2]);
+
+    const float position = r * constants.table_scale;
+    const int truncated = static_cast<int>(position);
+    const int whole = position < static_cast<float>(truncated) ? truncated - 1 : truncated;
+    const float k = static_cast<float>(whole);
+    const float t = ((r - (k * constants.table_step[0])) - (k * constants.table_step[1])) * constants.table_scale;
+    const int index = (whole & static_cast<int>(table_size - 1u)) * 2;
+
+    const float p0 = __ldg(table + index);
+    const float m0 = __ldg(table + index + 1);
+    const float p1 = __ldg(table + index + 2);
+    const float m1 = __ldg(table + index + 3);
+
+    // hermite basis collected into powers of t
+    const float c2 = ((p1 - p0) * 3.0f) - (m0 * 2.0f) - m1;
+    const float c3 = ((p0 - p1) * 2.0f) + m0 + m1;
+
+    return special_sine(theta, p0 + (t * (m0 + (t * (c2 + (t * c3))))));
+}
+
+/**
+ * Evaluate a kernel.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @param table
+ *   Device pointer to hermite table.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+template <DeviceKernel K>
+__device__ float evaluate(float theta, const float *table)
+{
+    if constexpr (K == DeviceKernel::POLYNOMIAL_7)
+    {
+        return sin_polynomial(theta);
+    }
+    else
+    {
+        return sin_table(theta, table);
+    }
+}
+
+/**
+ * Merge the statistics of later elements into earlier ones, keeping the first input of the largest error.
+ *
+ * @param into
+ *   Statistics to merge into.
+ *
+ * @param other
+ *   Statistics to merge.
+ */
+__host__ __device__ void merge(Partial &into, const Partial &other)
+{
+    into.compared += other.compared;
+    into.nan_mismatches += other.nan_mismatches;
+    into.sum_error += other.sum_error;
+
+    if (other.max_error > into.max_error)
+    {
+        into.max_error = other.max_error;
+        into.max_error_input = other.max_error_input;
+    }
+}
+
+/**
+ * Calculate sine of every input.
+ *
+ * @param thetas
+ *   Inputs.
+ *
+ * @param results
+ *   Where to write results, may alias thetas.
+ *
+ * @param count
+ *   Number of inputs.
+ *
+ * @param table
+ *   Device pointer to hermite table.
+ */
+template <DeviceKernel K>
+__global__ void calculate_kernel(const float *thetas, float *results, std::size_t count, const float *table)
+{
+    const auto stride = static_cast<std::size_t>(gridDim.x) * blockDim.x;
+
+    for (auto i = (static_cast<std::size_t>(blockIdx.x) * blockDim.x) + threadIdx.x; i < count; i += stride)
+    {
+        results[i] = evaluate<K>(thetas[i], table);
+    }
+}
+
+/**
+ * Calculate sine of a range of bit patterns and reduce the errors against double sine to one Partial per block.
+ *
+ * @param first
+ *   First bit pattern.
+ *
+ * @param count
+ *   Number of bit patterns.
+ *
+ * @param table
+ *   Device pointer to hermite table.
+ *
+ * @param partials
+ *   Where to write the statistics of each block.
+ */
+template <DeviceKernel K>
+__global__ void sweep_kernel(std::uint64_t first, std::uint64_t count, const float *table, Partial *partials)
+{
+    const auto stride = static_cast<std::uint64_t>(gridDim.x) * blockDim.x;
+
+    auto local = Partial{};
+
+    for (auto i = (static_cast<std::uint64_t>(blockIdx.x) * blockDim.x) + threadIdx.x; i < count; i += stride)
+    {
+        const float theta = __uint_as_float(static_cast<unsigned int>(first + i));
+        const float result = evaluate<K>(theta, table);
+        const float reference = static_cast<float>(sin(static_cast<double>(theta)));
+
+        if (is_nan(result) || is_nan(reference))
+        {
+            if (is_nan(result) != is_nan(reference))
+            {
+                ++local.nan_mismatches;
+            }
+            else
+            {
+                ++local.compared;
+            }
+
+            continue;
+        }
+
+        const double error = fabs(static_cast<double>(result) - static_cast<double>(reference));
+
+        ++local.compared;
+        local.sum_error += error;
+
+        if (error > local.max_error)
+        {
+            local.max_error = error;
+            local.max_error_input = theta;
+        }
+    }
+
+    __shared__ Partial shared[block_threads];
+
+    shared[threadIdx.x] = local;
+    __syncthreads();
+
+    for (auto width = blockDim.x / 2u; width > 0u; width /= 2u)
+    {
+        if (threadIdx.x < width)
+        {
+            merge(shared[threadIdx.x], shared[threadIdx.x + width]);
+        }
+
+        __syncthreads();
+    }
+
+    if (threadIdx.x == 0u)
+    {
+        partials[blockIdx.x] = shared[0];
+    }
+}
+
+}
+
+namespace fs::device
+{
+
+std::string_view backend()
+{
+    return "cuda";
+}
+
+bool available()
+{
+    auto devices = 0;
+    return (cudaGetDeviceCount(&devices) == cudaSuccess) && (devices > 0);
+}
+
+Buffer::Buffer(std::size_t size)
+    : data_(nullptr)
+    , size_(size)
+{
+    check(cudaMalloc(&data_, size * sizeof(float)), "allocating buffer");
+}
+
+Buffer::~Buffer()
+{
+    if (data_ != nullptr)
+    {
+        cudaFree(data_);
+    }
+}
+
+Buffer::Buffer(Buffer &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0u))
+{
+}
+
+Buffer &Buffer::operator=(Buffer &&other) noexcept
+{
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+
+    return *this;
+}
+
+float *Buffer::data() noexcept
+{
+    return data_;
+}
+
+const float *Buffer::data() const noexcept
+{
+    return data_;
+}
+
+std::size_t Buffer::size() const noexcept
+{
+    return size_;
+}
+
+void Buffer::upload(std::span<const float> values)
+{
+    check(cudaMemcpy(data_, values.data(), values.size_bytes(), cudaMemcpyHostToDevice), "uploading");
+}
+
+void Buffer::download(std::span<float> values) const
+{
+    check(cudaMemcpy(values.data(), data_, values.size_bytes(), cudaMemcpyDeviceToHost), "downloading");
+}
+
+void calculate(DeviceKernel kernel, const float *thetas, float *results, std::size_t count)
+{
+    if (count == 0u)
+    {
+        return;
+    }
+
+    const auto *table = device_table();
+    const auto blocks = blocks_for(count);
+
+    switch (kernel)
+    {
+        case DeviceKernel::POLYNOMIAL_7:
+            calculate_kernel<DeviceKernel::POLYNOMIAL_7><<<blocks, block_threads>>>(thetas, results, count, table);
+            break;
+        case DeviceKernel::TABLE_4096_HERMITE:
+            calculate_kernel<DeviceKernel::TABLE_4096_HERMITE>
+                <<<blocks, block_threads>>>(thetas, results, count, table);
+            break;
+    }
+
+    check(cudaGetLastError(), "launching kernel");
+    check(cudaDeviceSynchronize(), "running kernel");
+}
+
+SweepErrors sweep(DeviceKernel kernel, std::uint64_t first, std::uint64_t count)
+{
+    if (count == 0u)
+    {
+        return {};
+    }
+
+    const auto *table = device_table();
+    const auto blocks = blocks_for(count);
+
+    Partial *partials = nullptr;
+    check(cudaMalloc(&partials, blocks * sizeof(Partial)), "allocating sweep partials");
+
+    auto host = std::vector<Partial>(blocks);
+
+    try
+    {
+        switch (kernel)
+        {
+            case DeviceKernel::POLYNOMIAL_7:
+                sweep_kernel<DeviceKernel::POLYNOMIAL_7><<<blocks, block_threads>>>(first, count, table, partials);
+                break;
+            case DeviceKernel::TABLE_4096_HERMITE:
+                sweep_kernel<DeviceKernel::TABLE_4096_HERMITE>
+                    <<<blocks, block_threads>>>(first, count, table, partials);
+                break;
+        }
+
+        check(cudaGetLastError(), "launching sweep");
+        check(
+            cudaMemcpy(host.data(), partials, blocks * sizeof(Partial), cudaMemcpyDeviceToHost), "downloading sweep");
+    }
+    catch (...)
+    {
+        cudaFree(partials);
+        throw;
+    }
+
+    cudaFree(partials);
+
+    auto total = Partial{};
+    for (const auto &partial : host)
+    {
+        merge(total, partial);
+    }
+
+    return {
+        .compared = total.compared,
+        .nan_mismatches = total.nan_mismatches,
+        .max_error = total.max_error,
+        .max_error_input = total.max_error_input,
+        .sum_error = total.sum_error};
+}
+
+}
@@ -0,0 +1,194 @@
+#include "device.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "calculator.h"
+#include "polynomial.h"
+#include "table_calculator.h"
+
+namespace
+{
+
+/**
+ * Get the host calculator for a device kernel.
+ *
+ * @param kernel
+ *   Kernel.
+ *
+ * @returns
+ *   Calculator running the same kernel, bound to the fastest variant for this cpu.
+ */
+const fs::Calculator &calculator_for(fs::device::DeviceKernel kernel)
+{
+    static const auto polynomial = fs::PolynomialCalculator<7u>{};
+    static const auto table = fs::TableCalculator<4096u, fs::Interpolation::HERMITE>{};
+
+    switch (kernel)
+    {
+        case fs::device::DeviceKernel::POLYNOMIAL_7: return polynomial;
+        case fs::device::DeviceKernel::TABLE_4096_HERMITE: return table;
+    }
+
+    return polynomial;
+}
+
+/**
+ * Check if a float is NaN by looking at its bits, so the check still works when built with fast maths.
+ *
+ * @param value
+ *   Value to check.
+ *
+ * @returns
+ *   True if value is NaN, otherwise false.
+ */
+bool is_nan(float value)
+{
+    return (std::bit_cast<std::uint32_t>(value) & 0x7fffffffu) > 0x7f800000u;
+}
+
+}
+
+namespace fs::device
+{
+
+std::string_view backend()
+{
+    return "host";
+}
+
+bool available()
+{
+    return true;
+}
+
+Buffer::Buffer(std::size_t size)
+    : data_(nullptr)
+    , size_(size)
+{
+    try
+    {
+        data_ = new float[size];
+    }
+    catch (const std::bad_alloc &)
+    {
+        throw std::runtime_error{"unable to allocate buffer of " + std::to_string(size) + " floats"};
+    }
+}
+
+Buffer::~Buffer()
+{
+    delete[] data_;
+}
+
+Buffer::Buffer(Buffer &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr))
+    , size_(std::exchange(other.size_, 0u))
+{
+}
+
+Buffer &Buffer::operator=(Buffer &&other) noexcept
+{
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+
+    return *this;
+}
+
+float *Buffer::data() noexcept
+{
+    return data_;
+}
+
+const float *Buffer::data() const noexcept
+{
+    return data_;
+}
+
+std::size_t Buffer::size() const noexcept
+{
+    return size_;
+}
+
+void Buffer::upload(std::span<const float> values)
+{
+    std::memcpy(data_, values.data(), values.size_bytes());
+}
+
+void Buffer::download(std::span<float> values) const
+{
+    std::memcpy(values.data(), data_, values.size_bytes());
+}
+
+void calculate(DeviceKernel kernel, const float *thetas, float *results, std::size_t count)
+{
+    calculator_for(kernel).calculate(std::span<const float>{thetas, count}, std::span<float>{results, count});
+}
+
+SweepErrors sweep(DeviceKernel kernel, std::uint64_t first, std::uint64_t count)
+{
+    constexpr auto block_size = std::size_t{4096u};
+
+    const auto &calculator = calculator_for(kernel);
+
+    auto thetas = std::vector<float>(block_size);
+    auto results = std::vector<float>(block_size);
+    auto errors = SweepErrors{};
+
+    for (auto block = std::uint64_t{0u}; block < count; block += block_size)
+    {
+        const auto size = static_cast<std::size_t>(std::min<std::uint64_t>(block_size, count - block));
+
+        for (auto i = std::size_t{0u}; i < size; ++i)
+        {
+            thetas[i] = std::bit_cast<float>(static_cast<std::uint32_t>(first + block + i));
+        }
+
+        calculator.calculate(std::span<const float>{thetas}.first(size), std::span<float>{results}.first(size));
+
+        for (auto i = std::size_t{0u}; i < size; ++i)
+        {
+            const auto reference = static_cast<float>(std::sin(static_cast<double>(thetas[i])));
+
+            if (is_nan(results[i]) || is_nan(reference))
+            {
+                if (is_nan(results[i]) != is_nan(reference))
+                {
+                    ++errors.nan_mismatches;
+                }
+                else
+                {
+                    ++errors.compared;
+                }
+
+                continue;
+            }
+
+            const auto error = std::fabs(static_cast<double>(results[i]) - static_cast<double>(reference));
+
+            ++errors.compared;
+            errors.sum_error += error;
+
+            if (error > errors.max_error)
+            {
+                errors.max_error = error;
+                errors.max_error_input = thetas[i];
+            }
+        }
+    }
+
+    return errors;
+}
+
+}
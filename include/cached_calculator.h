@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+
+#include "calculator.h"
+
+namespace fs
+{
+
+/**
+ * Hits and misses of a CachedCalculator.
+ */
+struct CacheStats
+{
+    /** Inputs answered from the cache. */
+    std::uint64_t hits = 0u;
+
+    /** Inputs passed on to the wrapped calculator. */
+    std::uint64_t misses = 0u;
+
+    /**
+     * Get the fraction of lookups which hit.
+     *
+     * @returns
+     *   Hit rate, zero if nothing was looked up.
+     */
+    double hit_rate() const noexcept
+    {
+        const auto lookups = hits + misses;
+        return lookups == 0u ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+    }
+};
+
+/**
+ * Calculator which remembers recent results of another in a small direct mapped cache keyed by the bits of the input,
+ * for workloads where the same few angles recur millions of times, such as quantised rotation steps. The default of
+ * eight entries fills one cache line.
+ *
+ * Every lookup updates the cache and the counters, so an instance must not be shared between threads. Give each thread
+ * its own, the cache is aligned to a cache line so instances never contend. The wrapped calculator is only read and can
+ * be shared.
+ *
+ * @tparam Entries
+ *   Number of entries, a power of two and at least two.
+ */
+template <std::size_t Entries = 8u>
+class CachedCalculator final : public Calculator
+{
+  public:
+    static_assert(std::has_single_bit(Entries) && (Entries >= 2u), "entries must be a power of two and at least two");
+
+    using Calculator::calculate;
+
+    /**
+     * Construct a new CachedCalculator with an empty cache.
+     *
+     * @param calculator
+     *   Calculator to wrap.
+     */
+    explicit CachedCalculator(std::shared_ptr<const Calculator> calculator) noexcept
+        : calculator_(std::move(calculator))
+        , entries_()
+        , stats_()
+    {
+        clear();
+    }
+
+    float calculate(float theta) const noexcept override
+    {
+        const auto key = std::bit_cast<std::uint32_t>(theta);
+        auto &entry = entries_[slot(key)];
+
+        if (entry.key == key)
+        {
+            ++stats_.hits;
+            return entry.value;
+        }
+
+        ++stats_.misses;
+        entry = {key, calculator_->calculate(theta)};
+
+        return entry.value;
+    }
+
+    /**
+     * Calculate sine of every input. The inputs are taken in blocks of 256, and the misses in each block are calculated
+     * together through the batch interface of the wrapped calculator. An input repeated within a block is calculated
+     * once and counted as a hit.
+     *
+     * @param thetas
+     *   Input values.
+     *
+     * @param results
+     *   Where to write the sine of each input, must be at least as large as thetas.
+     */
+    void calculate(std::span<const float> thetas, std::span<float> results) const noexcept override
+    {
+        constexpr auto block_size = std::size_t{256u};
+
+        std::array<float, block_size> pending;
+        std::array<float, block_size> calculated;
+        std::array<std::size_t, block_size> positions;
+        std::array<std::size_t, block_size> repeat_positions;
+        std::array<std::size_t, block_size> repeat_sources;
+
+        // index into pending of the miss each entry is waiting for, block_size if it isn't waiting
+        std::array<std::size_t, Entries> owners;
+
+        for (auto first = std::size_t{0u}; first < thetas.size(); first += block_size)
+        {
+            const auto size = std::min(block_size, thetas.size() - first);
+            auto misses = std::size_t{0u};
+            auto repeats = std::size_t{0u};
+
+            owners.fill(block_size);
+
+            for (auto i = first; i < first + size; ++i)
+            {
+                const auto key = std::bit_cast<std::uint32_t>(thetas[i]);
+                const auto index = slot(key);
+                auto &entry = entries_[index];
+
+                if (entry.key != key)
+                {
+                    entry.key = key;
+                    owners[index] = misses;
+                    pending[misses] = thetas[i];
+                    positions[misses] = i;
+                    ++misses;
+                }
+                else if (owners[index] == block_size)
+                {
+                    results[i] = entry.value;
+                }
+                else
+                {
+                    repeat_positions[repeats] = i;
+                    repeat_sources[repeats] = owners[index];
+                    ++repeats;
+                }
+            }
+
+            calculator_->calculate(std::span{pending}.first(misses), std::span{calculated}.first(misses));
+
+            // in order, so an entry claimed by more than one miss ends up with the value of the last
+            for (auto i = std::size_t{0u}; i < misses; ++i)
+            {
+                entries_[slot(std::bit_cast<std::uint32_t>(pending[i]))].value = calculated[i];
+                results[positions[i]] = calculated[i];
+            }
+
+            for (auto i = std::size_t{0u}; i < repeats; ++i)
+            {
+                results[repeat_positions[i]] = calculated[repeat_sources[i]];
+            }
+
+            stats_.hits += size - misses;
+            stats_.misses += misses;
+        }
+    }
+
+    /**
+     * Get the hits and misses since construction or the last reset.
+     *
+     * @returns
+     *   Counters.
+     */
+    CacheStats stats() const noexcept
+    {
+        return stats_;
+    }
+
+    /**
+     * Zero the counters, leaving the cache as it is.
+     */
+    void reset_stats() noexcept
+    {
+        stats_ = {};
+    }
+
+    /**
+     * Empty the cache, leaving the counters as they are.
+     */
+    void clear() noexcept
+    {
+        entries_.fill({empty_key, std::bit_cast<float>(empty_key)});
+    }
+
+  private:
+    /**
+     * A cached result.
+     */
+    struct Entry
+    {
+        /** Bits of the input. */
+        std::uint32_t key;
+
+        /** Sine of the input. */
+        float value;
+    };
+
+    /** Key of an empty entry, a NaN whose cached value is the same NaN, so an empty entry can never be wrong. */
+    static constexpr std::uint32_t empty_key = 0xffffffffu;
+
+    /**
+     * Get the entry an input is cached in.
+     *
+     * @param key
+     *   Bits of the input.
+     *
+     * @returns
+     *   Index of entry.
+     */
+    static std::size_t slot(std::uint32_t key) noexcept
+    {
+        // fibonacci hashing, multiples of a step differ mostly in their high bits which a mask would ignore
+        constexpr auto shift = 32u - static_cast<unsigned>(std::countr_zero(Entries));
+        return static_cast<std::size_t>((key * 0x9e3779b1u) >> shift);
+    }
+
+    /** Wrapped calculator. */
+    std::shared_ptr<const Calculator> calculator_;
+
+    /** Cached results. */
+    alignas(64) mutable std::array<Entry, Entries> entries_;
+
+    /** Counters. */
+    mutable CacheStats stats_;
+};
+
+}
@@ -1,12 +1,44 @@
 #pragma once
 
+#include <cstddef>
+#include <span>
+
 namespace fs
 {
 
-class Calculator
+/**
+ * Interface for calculating sine of values of type T.
+ */
+template <class T>
+class BasicCalculator
 {
   public:
-    virtual float calculate(float theta) const noexcept = 0;
+    /** Type of inputs and results. */
+    using value_type = T;
+
+    virtual ~BasicCalculator() = default;
+
+    virtual T calculate(T theta) const noexcept = 0;
+
+    /**
+     * Calculate sine of every input. The default implementation calls the scalar overload for each element,
+     * implementations should override this with a vectorised version.
+     *
+     * @param thetas
+     *   Input values.
+     *
+     * @param results
+     *   Where to write the sine of each input, must be at least as large as thetas.
+     */
+    virtual void calculate(std::span<const T> thetas, std::span<T> results) const noexcept
+    {
+        for (auto i = std::size_t{0u}; i < thetas.size(); ++i)
+        {
+            results[i] = calculate(thetas[i]);
+        }
+    }
 };
 
+using Calculator = BasicCalculator<float>;
+
 }
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+
+#include "kernel_calculator.h"
+#include "simd.h"
+
+namespace fs
+{
+
+/**
+ * Kernel for the Chebyshev polynomial expansions. This computes the same polynomials as the chebyshev_N_calculator
+ * functions so the scalar and batch results can be compared directly.
+ */
+template <std::size_t Order>
+struct ChebyshevKernel
+{
+    static_assert(Order <= 3u, "only orders zero to three are supported");
+
+    /**
+     * Evaluate the polynomial.
+     *
+     * @param theta
+     *   Input value, either a float or a vector of floats.
+     *
+     * @returns
+     *   Value of polynomial.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static T evaluate(T theta)
+    {
+        if constexpr (Order == 0u)
+        {
+            return T{} + 1.0f;
+        }
+        else if constexpr (Order == 1u)
+        {
+            return theta;
+        }
+        else if constexpr (Order == 2u)
+        {
+            return (2.0f * (theta * theta)) - 1.0f;
+        }
+        else
+        {
+            return theta * ((3.0f * (theta * theta)) - 3.0f);
+        }
+    }
+};
+
+template <std::size_t Order>
+using ChebyshevCalculator = KernelCalculator<ChebyshevKernel<Order>>;
+
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <limits>
+#include <numbers>
+
+#include "polynomial.h"
+#include "range_reduction.h"
+#include "simd.h"
+#include "sin_cos_calculator.h"
+#include "special_values.h"
+
+namespace fs
+{
+
+namespace detail
+{
+
+/**
+ * Evaluate the tail of a core polynomial with Horner's scheme, usable in constant expressions.
+ *
+ * @param coefficients
+ *   Coefficients, lowest power first, the first one is skipped.
+ *
+ * @param x
+ *   Value to evaluate at.
+ *
+ * @returns
+ *   Value of the polynomial formed by every coefficient after the first.
+ */
+template <class E, std::size_t N>
+constexpr E horner_tail(const std::array<E, N> &coefficients, E x)
+{
+    auto sum = coefficients[N - 1u];
+
+    for (auto i = N - 1u; i > 1u; --i)
+    {
+        sum = (sum * x) + coefficients[i - 1u];
+    }
+
+    return sum;
+}
+
+/**
+ * Reduce an argument to [-pi/4, pi/4] in constant expressions, with the same Cody-Waite split as reduce_cody_waite up
+ * to its limit and Payne-Hanek beyond it.
+ *
+ * @param theta
+ *   Input value, must be finite.
+ *
+ * @returns
+ *   Reduced argument.
+ */
+template <class E>
+constexpr Reduced<E> reduce_constant(E theta)
+{
+    using constants = reduction_constants<E>;
+
+    if (!((theta < E{0} ? -theta : theta) <= constants::limit))
+    {
+        const auto reduced = reduce_payne_hanek(theta);
+        return {static_cast<E>(reduced.remainder), static_cast<simd::bits_t<E>>(reduced.quadrant)};
+    }
+
+    constexpr auto two_over_pi = E{2} / std::numbers::pi_v<E>;
+
+    const auto scaled = theta * two_over_pi;
+    const auto quadrant = static_cast<simd::bits_t<E>>(scaled + (scaled < E{0} ? E{-0.5} : E{0.5}));
+    const auto k = static_cast<E>(quadrant);
+
+    auto remainder = theta - (k * constants::pi_over_2_a);
+    remainder = remainder - (k * constants::pi_over_2_b);
+    remainder = remainder - (k * constants::pi_over_2_c);
+
+    return {remainder, quadrant};
+}
+
+/**
+ * Get the magnitude of an input as an integer, so the special value checks work with fast maths like the runtime ones.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Bits of theta without the sign.
+ */
+template <class E>
+constexpr simd::int_for_t<E> magnitude_bits(E theta)
+{
+    return std::bit_cast<simd::int_for_t<E>>(theta) & std::numeric_limits<simd::int_for_t<E>>::max();
+}
+
+/**
+ * Check if an input is close enough to zero that sine is the input, the same as below_identity_limit.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   True if the magnitude is below identity_limit_v.
+ */
+template <class E>
+constexpr bool below_identity_limit_constant(E theta)
+{
+    return magnitude_bits(theta) < std::bit_cast<simd::int_for_t<E>>(identity_limit_v<E>);
+}
+
+/**
+ * Check if an input is NaN or infinity, the same as not_finite.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   True if theta isn't finite.
+ */
+template <class E>
+constexpr bool not_finite_constant(E theta)
+{
+    return magnitude_bits(theta) >= std::bit_cast<simd::int_for_t<E>>(std::numeric_limits<E>::infinity());
+}
+
+}
+
+/**
+ * Sine usable in constant expressions, so tables and constants can be built at compile time.
+ *
+ * This evaluates the same sine and cos cores as PolynomialKernel, from the same coefficients rounded to E, after the
+ * same range reduction, so a result matches what the kernel gives at runtime with Scheme::HORNER unless the compiler
+ * contracts the runtime multiply-adds. Special inputs give what special_sine gives. It is scalar and branches, so the
+ * kernel is still the one to call in loops.
+ *
+ * @tparam Kernel
+ *   PolynomialKernel whose coefficients are used, the lowest degree accurate to E by default.
+ *
+ * @param theta
+ *   Input value, either a float or a double.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+template <class E, class Kernel = typename PrecisionPolynomial<E>::kernel>
+constexpr E constexpr_sin(E theta)
+{
+    if (detail::not_finite_constant(theta))
+    {
+        return std::numeric_limits<E>::quiet_NaN();
+    }
+
+    if (detail::below_identity_limit_constant(theta))
+    {
+        return theta;
+    }
+
+    constexpr auto &sin_coefficients = Kernel::template sin_coefficients<E>;
+    constexpr auto &cos_coefficients = Kernel::template cos_coefficients<E>;
+
+    const auto reduced = detail::reduce_constant(theta);
+    const auto r = reduced.remainder;
+    const auto r2 = r * r;
+
+    // quadrants 1 and 3 are cos shaped, quadrants 2 and 3 are negated
+    const auto result = (reduced.quadrant & 1) != 0
+        ? (r2 * detail::horner_tail(cos_coefficients, r2)) + cos_coefficients[0]
+        : (r * sin_coefficients[0]) + ((r * r2) * detail::horner_tail(sin_coefficients, r2));
+
+    return (reduced.quadrant & 2) != 0 ? -result : result;
+}
+
+/**
+ * Sine and cos usable in constant expressions, sharing the range reduction and both cores like
+ * PolynomialKernel::evaluate_sin_cos.
+ *
+ * @tparam Kernel
+ *   PolynomialKernel whose coefficients are used, the lowest degree accurate to E by default.
+ *
+ * @param theta
+ *   Input value, either a float or a double.
+ *
+ * @returns
+ *   Sine and cos of input value.
+ */
+template <class E, class Kernel = typename PrecisionPolynomial<E>::kernel>
+constexpr SinCos<E> constexpr_sin_cos(E theta)
+{
+    if (detail::not_finite_constant(theta))
+    {
+        return {std::numeric_limits<E>::quiet_NaN(), std::numeric_limits<E>::quiet_NaN()};
+    }
+
+    if (detail::below_identity_limit_constant(theta))
+    {
+        return {theta, E{1}};
+    }
+
+    constexpr auto &sin_coefficients = Kernel::template sin_coefficients<E>;
+    constexpr auto &cos_coefficients = Kernel::template cos_coefficients<E>;
+
+    const auto reduced = detail::reduce_constant(theta);
+    const auto r = reduced.remainder;
+    const auto r2 = r * r;
+
+    const auto sin_r = (r * sin_coefficients[0]) + ((r * r2) * detail::horner_tail(sin_coefficients, r2));
+    const auto cos_r = (r2 * detail::horner_tail(cos_coefficients, r2)) + cos_coefficients[0];
+
+    const auto odd = (reduced.quadrant & 1) != 0;
+    const auto sin_result = odd ? cos_r : sin_r;
+    const auto cos_result = odd ? sin_r : cos_r;
+
+    // sine is negated in quadrants 2 and 3, cos in quadrants 1 and 2
+    return {
+        (reduced.quadrant & 2) != 0 ? -sin_result : sin_result,
+        ((reduced.quadrant + 1) & 2) != 0 ? -cos_result : cos_result};
+}
+
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdlib>
+#include <optional>
+#include <string_view>
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+namespace fs
+{
+
+/**
+ * Instruction sets that vector kernels are built for, ordered from slowest to fastest.
+ */
+enum class Isa
+{
+    GENERIC,
+    NEON,
+    AVX2,
+    AVX512
+};
+
+/**
+ * Get the name of an instruction set.
+ *
+ * @param isa
+ *   Instruction set.
+ *
+ * @returns
+ *   Name of instruction set.
+ */
+constexpr std::string_view to_string(Isa isa)
+{
+    switch (isa)
+    {
+        case Isa::GENERIC: return "generic";
+        case Isa::NEON: return "neon";
+        case Isa::AVX2: return "avx2";
+        case Isa::AVX512: return "avx512";
+    }
+
+    return "unknown";
+}
+
+/**
+ * Parse the name of an instruction set.
+ *
+ * @param name
+ *   Name as returned by to_string.
+ *
+ * @returns
+ *   Instruction set, or empty if name isn't recognised.
+ */
+constexpr std::optional<Isa> isa_from_string(std::string_view name)
+{
+    for (const auto isa : {Isa::GENERIC, Isa::NEON, Isa::AVX2, Isa::AVX512})
+    {
+        if (to_string(isa) == name)
+        {
+            return isa;
+        }
+    }
+
+    return std::nullopt;
+}
+
+/**
+ * Widest instruction set the current translation unit is compiled for, which is what code without a target attribute
+ * can use. This is generic unless the build enables more, for example with -march=native.
+ */
+inline constexpr Isa compiled_isa =
+#if defined(__AVX512F__)
+    Isa::AVX512;
+#elif defined(__AVX2__) && defined(__FMA__)
+    Isa::AVX2;
+#elif defined(__ARM_NEON)
+    Isa::NEON;
+#else
+    Isa::GENERIC;
+#endif
+
+/**
+ * Check if the cpu we are running on supports an instruction set. This queries the cpu (cpuid on x86, the auxiliary
+ * vector on aarch64 linux) every time it is called.
+ *
+ * @param isa
+ *   Instruction set to check.
+ *
+ * @returns
+ *   True if kernels built for isa can run on this cpu, otherwise false.
+ */
+inline bool cpu_supports(Isa isa)
+{
+    switch (isa)
+    {
+        case Isa::GENERIC: return true;
+#if defined(__x86_64__) || defined(__i386__)
+        case Isa::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+        case Isa::AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") &&
+                   __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c");
+#elif defined(__aarch64__) && defined(__linux__)
+        case Isa::NEON: return (::getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0u;
+#elif defined(__aarch64__)
+        case Isa::NEON: return true;
+#endif
+        default: return false;
+    }
+}
+
+/**
+ * Get the fastest instruction set supported by this cpu. This is worked out once, on first call.
+ *
+ * Setting the FS_ISA environment variable to the name of an instruction set limits the choice to that instruction set
+ * or slower, which is useful for comparing variants on a single machine.
+ *
+ * @returns
+ *   Instruction set kernels should be bound to.
+ */
+inline Isa selected_isa()
+{
+    static const auto selected = []
+    {
+        const auto *limit_name = std::getenv("FS_ISA");
+        const auto limit = limit_name == nullptr ? std::nullopt : isa_from_string(limit_name);
+
+        auto best = Isa::GENERIC;
+
+        for (const auto isa : {Isa::NEON, Isa::AVX2, Isa::AVX512})
+        {
+            if (cpu_supports(isa) && (!limit || (isa <= *limit)))
+            {
+                best = isa;
+            }
+        }
+
+        return best;
+    }();
+
+    return selected;
+}
+
+}
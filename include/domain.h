@@ -0,0 +1,84 @@
+#pragma once
+
+#include <numbers>
+
+#include "simd.h"
+
+namespace fs
+{
+
+/**
+ * Range of inputs a caller promises to stay within, so a kernel can skip some or all of its range reduction.
+ */
+enum class ReducedDomain
+{
+    /** [-pi/2, pi/2], where sine needs no reduction at all. */
+    HALF_PI,
+
+    /** [-pi, pi], one period centred on zero. */
+    PI,
+
+    /** [0, 2pi], one period starting at zero, typical of accumulated phases. */
+    TWO_PI
+};
+
+namespace detail
+{
+
+template <ReducedDomain D, class E>
+struct domain_bounds;
+
+template <class E>
+struct domain_bounds<ReducedDomain::HALF_PI, E>
+{
+    static constexpr E low = -std::numbers::pi_v<E> / E{2};
+    static constexpr E high = std::numbers::pi_v<E> / E{2};
+};
+
+template <class E>
+struct domain_bounds<ReducedDomain::PI, E>
+{
+    static constexpr E low = -std::numbers::pi_v<E>;
+    static constexpr E high = std::numbers::pi_v<E>;
+};
+
+template <class E>
+struct domain_bounds<ReducedDomain::TWO_PI, E>
+{
+    static constexpr E low = E{0};
+    static constexpr E high = E{2} * std::numbers::pi_v<E>;
+};
+
+}
+
+/**
+ * Smallest input in a domain, the bound rounded to E.
+ */
+template <ReducedDomain D, class E = float>
+inline constexpr E domain_low_v = detail::domain_bounds<D, E>::low;
+
+/**
+ * Largest input in a domain, the bound rounded to E.
+ */
+template <ReducedDomain D, class E = float>
+inline constexpr E domain_high_v = detail::domain_bounds<D, E>::high;
+
+/**
+ * Check if every lane of an input lies in a domain.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @returns
+ *   True if every lane is within the bounds, false if any is outside or NaN.
+ */
+template <ReducedDomain D, class T>
+FS_ALWAYS_INLINE bool in_domain(T theta)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+
+    // written as a test for being outside so NaN fails every comparison and is caught by the last one
+    return !simd::any((theta < domain_low_v<D, E>) | (theta > domain_high_v<D, E>) | (theta != theta));
+}
+
+}
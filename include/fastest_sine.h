@@ -0,0 +1,25 @@
+#pragma once
+
+// everything a consumer of the sine library needs, the kernels are all header only so they inline into the caller
+
+#include "cached_calculator.h"
+#include "calculator.h"
+#include "chebyshev_calculator.h"
+#include "constexpr_sine.h"
+#include "cpu_features.h"
+#include "domain.h"
+#include "grid_generator.h"
+#include "kernel_calculator.h"
+#include "maclaurin_calculator.h"
+#include "phase.h"
+#include "polynomial.h"
+#include "precision.h"
+#include "range_reduction.h"
+#include "remez.h"
+#include "scalar_calculators.h"
+#include "simd.h"
+#include "sin_reduced.h"
+#include "sine_kernel.h"
+#include "sin_cos_calculator.h"
+#include "special_values.h"
+#include "table_calculator.h"
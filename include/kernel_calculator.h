@@ -0,0 +1,159 @@
+#pragma once
+
+#include <span>
+
+#include "calculator.h"
+#include "cpu_features.h"
+#include "precision.h"
+#include "simd.h"
+#include "sine_kernel.h"
+
+namespace fs
+{
+
+namespace detail
+{
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Batch evaluation of a kernel using AVX-512, 16 float or 8 double lanes at a time.
+ *
+ * @param thetas
+ *   Input values.
+ *
+ * @param results
+ *   Where to write results.
+ */
+template <class Kernel, class T>
+FS_TARGET_AVX512 void batch_avx512(std::span<const T> thetas, std::span<T> results)
+{
+    simd::transform<64u / sizeof(compute_t<T>), Kernel>(thetas, results);
+}
+
+/**
+ * Batch evaluation of a kernel using AVX2 and FMA, 8 float or 4 double lanes at a time.
+ *
+ * @param thetas
+ *   Input values.
+ *
+ * @param results
+ *   Where to write results.
+ */
+template <class Kernel, class T>
+FS_TARGET_AVX2 void batch_avx2(std::span<const T> thetas, std::span<T> results)
+{
+    simd::transform<32u / sizeof(compute_t<T>), Kernel>(thetas, results);
+}
+
+#endif
+
+/**
+ * Batch evaluation of a kernel using the baseline vector instructions of the target, 4 float or 2 double lanes at a
+ * time. This is SSE2 on x86-64 and NEON on aarch64.
+ *
+ * @param thetas
+ *   Input values.
+ *
+ * @param results
+ *   Where to write results.
+ */
+template <class Kernel, class T>
+void batch_generic(std::span<const T> thetas, std::span<T> results)
+{
+    simd::transform<16u / sizeof(compute_t<T>), Kernel>(thetas, results);
+}
+
+/**
+ * Signature of a batch kernel over values of type T.
+ */
+template <class T>
+using BatchFunction = void (*)(std::span<const T>, std::span<T>);
+
+/**
+ * Get the batch evaluation of a kernel built for an instruction set.
+ *
+ * @param isa
+ *   Instruction set, must be supported on the current cpu.
+ *
+ * @returns
+ *   Batch function for isa, or the generic version if there isn't one for isa on this target.
+ */
+template <class Kernel, class T>
+BatchFunction<T> batch_for(Isa isa)
+{
+    switch (isa)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case Isa::AVX512: return batch_avx512<Kernel, T>;
+        case Isa::AVX2: return batch_avx2<Kernel, T>;
+#endif
+        default: return batch_generic<Kernel, T>;
+    }
+}
+
+}
+
+/**
+ * Calculator built from a kernel type, so the same formula is used for the scalar and vectorised paths. The batch path
+ * is bound to a variant built for a specific instruction set when the calculator is constructed.
+ *
+ * Kernel must be a SineKernel whose evaluate also accepts scalars and vectors of the type T is calculated in. Types
+ * narrower than float, such as half and bfloat16, are widened to float to calculate and rounded back.
+ */
+template <SineKernel Kernel, class T = float>
+class KernelCalculator final : public BasicCalculator<T>
+{
+  public:
+    using BasicCalculator<T>::calculate;
+
+    /**
+     * Construct a new KernelCalculator bound to the fastest variant for this cpu.
+     */
+    KernelCalculator()
+        : KernelCalculator(selected_isa())
+    {
+    }
+
+    /**
+     * Construct a new KernelCalculator bound to a specific variant.
+     *
+     * @param isa
+     *   Instruction set of variant, must be supported by the current cpu.
+     */
+    explicit KernelCalculator(Isa isa)
+        : isa_(isa)
+        , batch_(detail::batch_for<Kernel, T>(isa))
+    {
+    }
+
+    /**
+     * Get the instruction set of the variant bound to the batch path.
+     *
+     * @returns
+     *   Bound instruction set.
+     */
+    Isa isa() const noexcept
+    {
+        return isa_;
+    }
+
+    T calculate(T theta) const noexcept override
+    {
+        return static_cast<T>(Kernel::evaluate(static_cast<compute_t<T>>(theta)));
+    }
+
+    void calculate(std::span<const T> thetas, std::span<T> results) const noexcept override
+    {
+        batch_(thetas, results);
+    }
+
+  private:
+    /** Instruction set of bound variant. */
+    Isa isa_;
+
+    /** Bound batch function. */
+    detail::BatchFunction<T> batch_;
+};
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+
+#include "kernel_calculator.h"
+#include "simd.h"
+
+namespace fs
+{
+
+/**
+ * Kernel for sine with a number of expansions of the Maclaurin series. This computes the same polynomial as the
+ * maclaurin_N_calculator functions but in Horner form, so there are no calls to std::pow.
+ */
+template <std::size_t Terms>
+struct MaclaurinKernel
+{
+    static_assert((Terms >= 1u) && (Terms <= 4u), "only one to four terms are supported");
+
+    /**
+     * Evaluate the series.
+     *
+     * @param theta
+     *   Input value, either a float or a vector of floats.
+     *
+     * @returns
+     *   Sine of input value.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static T evaluate(T theta)
+    {
+        if constexpr (Terms == 1u)
+        {
+            return theta;
+        }
+        else
+        {
+            // coefficients of theta^3, theta^5 and theta^7
+            constexpr float coefficients[] = {-1.0f / 6.0f, 1.0f / 120.0f, -1.0f / 5040.0f};
+
+            const T theta2 = theta * theta;
+            T sum = T{} + coefficients[Terms - 2u];
+
+            for (auto i = Terms - 2u; i > 0u; --i)
+            {
+                sum = (sum * theta2) + coefficients[i - 1u];
+            }
+
+            return theta + ((theta * theta2) * sum);
+        }
+    }
+};
+
+template <std::size_t Terms>
+using MaclaurinCalculator = KernelCalculator<MaclaurinKernel<Terms>>;
+
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+#include "cpu_features.h"
+#include "simd.h"
+
+namespace fs
+{
+
+/**
+ * Phase of an oscillator as a fraction of a turn, where 2^32 is a full turn. A phase accumulator wrapping around is
+ * already an exact range reduction, so kernels taking a phase skip the reduction a float angle needs.
+ */
+using Phase = std::uint32_t;
+
+/**
+ * Fixed point sample in [-1, 1) with 15 fractional bits.
+ */
+using q15 = std::int16_t;
+
+/**
+ * Fixed point sample in [-1, 1) with 31 fractional bits.
+ */
+using q31 = std::int32_t;
+
+/**
+ * A kernel with a static evaluate_phase function template, taking the type to calculate in as its first template
+ * argument and accepting both a Phase and a vector of them.
+ */
+template <class K>
+concept PhaseKernel = requires(Phase phase, simd::vec<Phase, 4u> phases) {
+    { K::template evaluate_phase<float>(phase) } -> std::same_as<float>;
+    { K::template evaluate_phase<simd::vec<float, 4u>>(phases) } -> std::same_as<simd::vec<float, 4u>>;
+};
+
+namespace detail
+{
+
+/**
+ * Type a phase kernel calculates in for a result type, Q31 needs more bits than a float has.
+ */
+template <class R>
+using phase_compute_t = std::conditional_t<std::is_same_v<R, q31>, double, float>;
+
+/**
+ * Convert calculated sines to a result type, fixed point results are rounded to nearest and saturated so a sine of
+ * exactly one gives the largest positive value.
+ *
+ * @tparam R
+ *   Result type, float, q15 or q31.
+ *
+ * @param value
+ *   Sine, either a float, a double or a vector of either.
+ *
+ * @returns
+ *   Result, a vector of R if value is a vector.
+ */
+template <class R, class T>
+FS_ALWAYS_INLINE simd::rebind_t<T, R> to_result(T value)
+{
+    if constexpr (std::is_same_v<R, float>)
+    {
+        return simd::convert<simd::rebind_t<T, R>>(value);
+    }
+    else
+    {
+        using E = typename simd::lane_traits<T>::element_type;
+        using Wide = simd::rebind_t<T, std::int32_t>;
+
+        constexpr auto scale = static_cast<E>(std::uint64_t{1u} << ((sizeof(R) * 8u) - 1u));
+
+        const T scaled = value * scale;
+        const T clamped = simd::select(
+            scaled > (scale - E{1}),
+            simd::broadcast<T>(scale - E{1}),
+            simd::select(scaled < -scale, simd::broadcast<T>(-scale), scaled));
+        const T rounding = simd::select(clamped < E{0}, simd::broadcast<T>(E{-0.5}), simd::broadcast<T>(E{0.5}));
+
+        return simd::convert<simd::rebind_t<T, R>>(simd::convert<Wide>(clamped + rounding));
+    }
+}
+
+/**
+ * Apply a phase kernel to every phase, N lanes at a time. A partial final vector is padded with zeros.
+ *
+ * @param phases
+ *   Phases.
+ *
+ * @param results
+ *   Where to write results, must be at least as large as phases.
+ */
+template <std::size_t N, class Kernel, class R>
+FS_ALWAYS_INLINE void phase_transform(std::span<const Phase> phases, std::span<R> results)
+{
+    using P = simd::vec<Phase, N>;
+    using T = simd::vec<phase_compute_t<R>, N>;
+
+    const auto count = phases.size();
+    auto i = std::size_t{0u};
+
+    for (; i + N <= count; i += N)
+    {
+        const T sine = Kernel::template evaluate_phase<T>(simd::load<P>(phases.data() + i));
+        simd::store(results.data() + i, to_result<R>(sine));
+    }
+
+    if (i < count)
+    {
+        const auto remaining = count - i;
+
+        Phase padded[N] = {};
+        std::memcpy(padded, phases.data() + i, remaining * sizeof(Phase));
+
+        R out[N] = {};
+        const T sine = Kernel::template evaluate_phase<T>(simd::load<P>(padded));
+        simd::store(out, to_result<R>(sine));
+        std::memcpy(results.data() + i, out, remaining * sizeof(R));
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Batch evaluation of a phase kernel using AVX-512, 16 float or 8 double lanes at a time.
+ *
+ * @param phases
+ *   Phases.
+ *
+ * @param results
+ *   Where to write results.
+ */
+template <class Kernel, class R>
+FS_TARGET_AVX512 void phase_batch_avx512(std::span<const Phase> phases, std::span<R> results)
+{
+    phase_transform<64u / sizeof(phase_compute_t<R>), Kernel>(phases, results);
+}
+
+/**
+ * Batch evaluation of a phase kernel using AVX2 and FMA, 8 float or 4 double lanes at a time.
+ *
+ * @param phases
+ *   Phases.
+ *
+ * @param results
+ *   Where to write results.
+ */
+template <class Kernel, class R>
+FS_TARGET_AVX2 void phase_batch_avx2(std::span<const Phase> phases, std::span<R> results)
+{
+    phase_transform<32u / sizeof(phase_compute_t<R>), Kernel>(phases, results);
+}
+
+#endif
+
+/**
+ * Batch evaluation of a phase kernel using the baseline vector instructions of the target, 4 float or 2 double lanes
+ * at a time.
+ *
+ * @param phases
+ *   Phases.
+ *
+ * @param results
+ *   Where to write results.
+ */
+template <class Kernel, class R>
+void phase_batch_generic(std::span<const Phase> phases, std::span<R> results)
+{
+    phase_transform<16u / sizeof(phase_compute_t<R>), Kernel>(phases, results);
+}
+
+/**
+ * Signature of a batch phase kernel with results of type R.
+ */
+template <class R>
+using PhaseBatchFunction = void (*)(std::span<const Phase>, std::span<R>);
+
+/**
+ * Get the batch evaluation of a phase kernel built for an instruction set.
+ *
+ * @param isa
+ *   Instruction set, must be supported on the current cpu.
+ *
+ * @returns
+ *   Batch function for isa, or the generic version if there isn't one for isa on this target.
+ */
+template <class Kernel, class R>
+PhaseBatchFunction<R> phase_batch_for(Isa isa)
+{
+    switch (isa)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case Isa::AVX512: return phase_batch_avx512<Kernel, R>;
+        case Isa::AVX2: return phase_batch_avx2<Kernel, R>;
+#endif
+        default: return phase_batch_generic<Kernel, R>;
+    }
+}
+
+}
+
+/**
+ * Evaluate sine of a phase, with no indirection so the call inlines into the caller's loop.
+ *
+ * @tparam K
+ *   Kernel to evaluate.
+ *
+ * @tparam R
+ *   Result type, float, q15 or q31. Q31 results are calculated in double, the others in float.
+ *
+ * @param phase
+ *   Phase, where 2^32 is a full turn.
+ *
+ * @returns
+ *   Sine of phase.
+ */
+template <PhaseKernel K, class R = float>
+FS_ALWAYS_INLINE R sin_phase(Phase phase)
+{
+    return detail::to_result<R>(K::template evaluate_phase<detail::phase_compute_t<R>>(phase));
+}
+
+/**
+ * Calculator of sine from phases, for oscillators and numerically controlled oscillators which keep their phase as an
+ * integer. The batch path is bound to a variant built for a specific instruction set when the calculator is
+ * constructed, the same as KernelCalculator.
+ *
+ * @tparam Kernel
+ *   Kernel to evaluate.
+ *
+ * @tparam R
+ *   Result type, float, q15 or q31.
+ */
+template <PhaseKernel Kernel, class R = float>
+class PhaseCalculator final
+{
+  public:
+    static_assert(
+        std::is_same_v<R, float> || std::is_same_v<R, q15> || std::is_same_v<R, q31>,
+        "results must be float, q15 or q31");
+
+    using value_type = R;
+
+    /**
+     * Construct a new PhaseCalculator bound to the fastest variant for this cpu.
+     */
+    PhaseCalculator()
+        : PhaseCalculator(selected_isa())
+    {
+    }
+
+    /**
+     * Construct a new PhaseCalculator bound to a specific variant.
+     *
+     * @param isa
+     *   Instruction set of variant, must be supported by the current cpu.
+     */
+    explicit PhaseCalculator(Isa isa)
+        : isa_(isa)
+        , batch_(detail::phase_batch_for<Kernel, R>(isa))
+    {
+    }
+
+    /**
+     * Get the instruction set of the variant bound to the batch path.
+     *
+     * @returns
+     *   Bound instruction set.
+     */
+    Isa isa() const noexcept
+    {
+        return isa_;
+    }
+
+    /**
+     * Calculate sine of a phase.
+     *
+     * @param phase
+     *   Phase, where 2^32 is a full turn.
+     *
+     * @returns
+     *   Sine of phase.
+     */
+    R calculate(Phase phase) const noexcept
+    {
+        return sin_phase<Kernel, R>(phase);
+    }
+
+    /**
+     * Calculate sine of every phase.
+     *
+     * @param phases
+     *   Phases, where 2^32 is a full turn.
+     *
+     * @param results
+     *   Where to write results, must be at least as large as phases.
+     */
+    void calculate(std::span<const Phase> phases, std::span<R> results) const noexcept
+    {
+        batch_(phases, results);
+    }
+
+  private:
+    /** Instruction set of bound variant. */
+    Isa isa_;
+
+    /** Bound batch function. */
+    detail::PhaseBatchFunction<R> batch_;
+};
+
+}
@@ -0,0 +1,531 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+
+#include "domain.h"
+#include "kernel_calculator.h"
+#include "precision.h"
+#include "range_reduction.h"
+#include "remez.h"
+#include "simd.h"
+#include "special_values.h"
+#include "sin_cos_calculator.h"
+
+namespace fs
+{
+
+/**
+ * How a polynomial is evaluated.
+ */
+enum class Scheme
+{
+    /** Nested multiply-adds, fewest operations but each one depends on the previous. */
+    HORNER,
+
+    /** Pairs of terms combined in a tree, more operations but a shorter dependency chain. */
+    ESTRIN
+};
+
+namespace polynomial
+{
+
+/**
+ * Evaluate a polynomial with Estrin's scheme.
+ *
+ * @param coefficients
+ *   Coefficients, lowest power first.
+ *
+ * @param x
+ *   Value to evaluate at.
+ *
+ * @returns
+ *   Value of polynomial.
+ */
+template <class T, class C, std::size_t N>
+FS_ALWAYS_INLINE T estrin(const std::array<C, N> &coefficients, T x)
+{
+    if constexpr (N == 1u)
+    {
+        return simd::broadcast<T>(0.0f) + coefficients[0];
+    }
+    else
+    {
+        std::array<T, (N + 1u) / 2u> pairs{};
+
+        for (auto i = 0u; i < N / 2u; ++i)
+        {
+            pairs[i] = (x * coefficients[(2u * i) + 1u]) + coefficients[2u * i];
+        }
+
+        if constexpr ((N % 2u) == 1u)
+        {
+            pairs[N / 2u] = simd::broadcast<T>(0.0f) + coefficients[N - 1u];
+        }
+
+        return estrin(pairs, x * x);
+    }
+}
+
+/**
+ * Evaluate a polynomial.
+ *
+ * @param coefficients
+ *   Coefficients, lowest power first.
+ *
+ * @param x
+ *   Value to evaluate at.
+ *
+ * @returns
+ *   Value of polynomial.
+ */
+template <Scheme S, class T, class C, std::size_t N>
+FS_ALWAYS_INLINE T evaluate(const std::array<C, N> &coefficients, T x)
+{
+    if constexpr (S == Scheme::ESTRIN)
+    {
+        return estrin(coefficients, x);
+    }
+    else
+    {
+        auto sum = simd::broadcast<T>(coefficients[N - 1u]);
+
+        for (auto i = N - 1u; i > 0u; --i)
+        {
+            sum = (sum * x) + coefficients[i - 1u];
+        }
+
+        return sum;
+    }
+}
+
+/**
+ * Remove the first coefficient of a polynomial.
+ *
+ * @param coefficients
+ *   Coefficients.
+ *
+ * @returns
+ *   All but the first coefficient.
+ */
+template <class C, std::size_t N>
+constexpr std::array<C, N - 1u> drop_first(const std::array<C, N> &coefficients)
+{
+    std::array<C, N - 1u> result{};
+
+    for (auto i = 1u; i < N; ++i)
+    {
+        result[i - 1u] = coefficients[i];
+    }
+
+    return result;
+}
+
+/**
+ * Round coefficients to the precision a kernel calculates in.
+ *
+ * @tparam E
+ *   Type to round to.
+ *
+ * @param coefficients
+ *   Coefficients.
+ *
+ * @returns
+ *   Rounded coefficients.
+ */
+template <class E, class C, std::size_t N>
+constexpr std::array<E, N> cast(const std::array<C, N> &coefficients)
+{
+    std::array<E, N> result{};
+
+    for (auto i = 0u; i < N; ++i)
+    {
+        result[i] = static_cast<E>(coefficients[i]);
+    }
+
+    return result;
+}
+
+}
+
+/**
+ * Coefficients for the sine and cos cores from the Taylor series, these are only accurate close to zero.
+ *
+ * sin is in terms of r, r^3, ... r^Degree and cos is in terms of 1, r^2, ... r^(Degree + 1).
+ */
+template <std::size_t Degree>
+struct TaylorCoefficients
+{
+    static constexpr std::array<double, (Degree + 1u) / 2u> sin = []
+    {
+        std::array<double, (Degree + 1u) / 2u> result{};
+
+        auto term = 1.0;
+        for (auto i = 0u; i < result.size(); ++i)
+        {
+            result[i] = term;
+            term /= -static_cast<double>(((2u * i) + 2u) * ((2u * i) + 3u));
+        }
+
+        return result;
+    }();
+
+    static constexpr std::array<double, (Degree + 3u) / 2u> cos = []
+    {
+        std::array<double, (Degree + 3u) / 2u> result{};
+
+        auto term = 1.0;
+        for (auto i = 0u; i < result.size(); ++i)
+        {
+            result[i] = term;
+            term /= -static_cast<double>(((2u * i) + 1u) * ((2u * i) + 2u));
+        }
+
+        return result;
+    }();
+};
+
+/**
+ * Polynomial sine kernel with full range reduction.
+ *
+ * The argument is reduced to [-pi/4, pi/4] with Cody-Waite reduction, falling back to Payne-Hanek for larger
+ * magnitudes, and the quadrant picks between a sine and a cos polynomial. Degree is the degree of the sine polynomial,
+ * the cos polynomial is one degree higher, so it directly trades accuracy for latency. The default coefficients are
+ * minimax fits, remez::minimal_degree gives the lowest degree that meets an error budget.
+ *
+ * The kernel can be evaluated in float or double, the coefficients and reduction constants are rounded to whichever it
+ * is called with.
+ *
+ * Inputs near zero, including denormals, give the input and NaN or infinity give NaN. Both are blended in without a
+ * branch, so they never reach the polynomial or the per lane fallback for large arguments.
+ */
+template <
+    std::size_t Degree,
+    Scheme S = Scheme::HORNER,
+    class Coefficients = remez::MinimaxCoefficients<Degree>>
+struct PolynomialKernel
+{
+    static_assert(((Degree % 2u) == 1u) && (Degree >= 3u), "degree must be odd and at least three");
+
+    /** Coefficients of the sine core rounded to E, shared with constexpr_sin so both round the same way. */
+    template <class E>
+    static constexpr auto sin_coefficients = polynomial::cast<E>(Coefficients::sin);
+
+    /** Coefficients of the cos core rounded to E. */
+    template <class E>
+    static constexpr auto cos_coefficients = polynomial::cast<E>(Coefficients::cos);
+
+    /**
+     * Sine of an already reduced argument.
+     *
+     * @param r
+     *   Argument in [-pi/4, pi/4].
+     *
+     * @returns
+     *   Sine of argument.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static T sin_core(T r)
+    {
+        using E = typename simd::lane_traits<T>::element_type;
+
+        constexpr auto &coefficients = sin_coefficients<E>;
+        static constexpr auto tail = polynomial::drop_first(coefficients);
+
+        const T r2 = r * r;
+        return (r * coefficients[0]) + ((r * r2) * polynomial::evaluate<S>(tail, r2));
+    }
+
+    /**
+     * Cos of an already reduced argument.
+     *
+     * @param r
+     *   Argument in [-pi/4, pi/4].
+     *
+     * @returns
+     *   Cos of argument.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static T cos_core(T r)
+    {
+        using E = typename simd::lane_traits<T>::element_type;
+
+        constexpr auto &coefficients = cos_coefficients<E>;
+        static constexpr auto tail = polynomial::drop_first(coefficients);
+
+        const T r2 = r * r;
+        return (r2 * polynomial::evaluate<S>(tail, r2)) + coefficients[0];
+    }
+
+    /**
+     * Combine the cores for a reduced argument.
+     *
+     * @param reduced
+     *   Reduced argument.
+     *
+     * @returns
+     *   Sine of the original argument.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static T from_reduced(const Reduced<T> &reduced)
+    {
+        const T sin_r = sin_core(reduced.remainder);
+        const T cos_r = cos_core(reduced.remainder);
+
+        // quadrants 1 and 3 are cos shaped, quadrants 2 and 3 are negated
+        const T result = simd::select((reduced.quadrant & 1) != 0, cos_r, sin_r);
+        return simd::select((reduced.quadrant & 2) != 0, -result, result);
+    }
+
+    /**
+     * Combine the cores for a reduced argument into both sine and cos.
+     *
+     * @param reduced
+     *   Reduced argument.
+     *
+     * @returns
+     *   Sine and cos of the original argument.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static SinCos<T> sin_cos_from_reduced(const Reduced<T> &reduced)
+    {
+        const T sin_r = sin_core(reduced.remainder);
+        const T cos_r = cos_core(reduced.remainder);
+
+        const auto odd = (reduced.quadrant & 1) != 0;
+        const T sin_result = simd::select(odd, cos_r, sin_r);
+        const T cos_result = simd::select(odd, sin_r, cos_r);
+
+        // sine is negated in quadrants 2 and 3, cos in quadrants 1 and 2
+        return {
+            simd::select((reduced.quadrant & 2) != 0, -sin_result, sin_result),
+            simd::select(((reduced.quadrant + 1) & 2) != 0, -cos_result, cos_result)};
+    }
+
+    /**
+     * Sine of an argument too large for Cody-Waite reduction.
+     *
+     * @param theta
+     *   Input value, either a float or a double.
+     *
+     * @returns
+     *   Sine of input value.
+     */
+    template <class E>
+    static E evaluate_large(E theta)
+    {
+        if (!(simd::abs(theta) <= std::numeric_limits<E>::max()))
+        {
+            return std::numeric_limits<E>::quiet_NaN();
+        }
+
+        const auto reduced = reduce_payne_hanek(theta);
+        return from_reduced(
+            Reduced<E>{static_cast<E>(reduced.remainder), static_cast<simd::bits_t<E>>(reduced.quadrant)});
+    }
+
+    /**
+     * Sine and cos of an argument too large for Cody-Waite reduction.
+     *
+     * @param theta
+     *   Input value, either a float or a double.
+     *
+     * @returns
+     *   Sine and cos of input value.
+     */
+    template <class E>
+    static SinCos<E> evaluate_large_sin_cos(E theta)
+    {
+        if (!(simd::abs(theta) <= std::numeric_limits<E>::max()))
+        {
+            return {std::numeric_limits<E>::quiet_NaN(), std::numeric_limits<E>::quiet_NaN()};
+        }
+
+        const auto reduced = reduce_payne_hanek(theta);
+        return sin_cos_from_reduced(
+            Reduced<E>{static_cast<E>(reduced.remainder), static_cast<simd::bits_t<E>>(reduced.quadrant)});
+    }
+
+    /**
+     * Evaluate sine.
+     *
+     * @param theta
+     *   Input value, either a float, a double or a vector of either.
+     *
+     * @returns
+     *   Sine of input value.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static T evaluate(T theta)
+    {
+        using L = simd::lane_traits<T>;
+
+        const auto large = finite_beyond_cody_waite(theta);
+
+        auto result = from_reduced(reduce_cody_waite(cody_waite_inputs(theta)));
+
+        if (simd::any(large)) [[unlikely]]
+        {
+            if constexpr (L::is_vector)
+            {
+                for (auto i = 0u; i < L::lanes; ++i)
+                {
+                    if (large[i] != 0)
+                    {
+                        result[i] = evaluate_large(theta[i]);
+                    }
+                }
+            }
+            else
+            {
+                result = evaluate_large(theta);
+            }
+        }
+
+        return special_sine(theta, result);
+    }
+
+    /**
+     * Evaluate sine of an input known to lie in a domain, without the check for large arguments. On [-pi/2, pi/2]
+     * there is no reduction at all, a single sine polynomial two degrees higher is fitted over the whole domain, which
+     * is cheaper than evaluating both cores and selecting between them. Near pi/2 the last terms cancel, so float
+     * results there are within two ulps rather than one. The wider domains still need the quadrant.
+     *
+     * @tparam D
+     *   Domain theta lies in.
+     *
+     * @param theta
+     *   Input value, either a float, a double or a vector of either.
+     *
+     * @returns
+     *   Sine of input value.
+     */
+    template <ReducedDomain D, class T>
+    FS_ALWAYS_INLINE static T evaluate_in(T theta)
+    {
+        if constexpr (D == ReducedDomain::HALF_PI)
+        {
+            using E = typename simd::lane_traits<T>::element_type;
+
+            static constexpr auto coefficients = polynomial::cast<E>(remez::HalfPiCoefficients<Degree + 2u>::sin);
+            static constexpr auto tail = polynomial::drop_first(coefficients);
+
+            const T theta2 = theta * theta;
+            return (theta * coefficients[0]) + ((theta * theta2) * polynomial::evaluate<S>(tail, theta2));
+        }
+        else
+        {
+            return from_reduced(reduce_cody_waite(theta));
+        }
+    }
+
+    /**
+     * Evaluate sine of a phase, where 2^32 is a full turn. The top two bits rounded are the quadrant and the rest a
+     * signed remainder of at most an eighth of a turn, so the reduction is exact and only the scale to radians rounds.
+     *
+     * @tparam T
+     *   Type to calculate in, either a float, a double or a vector of either.
+     *
+     * @param phase
+     *   Phase, either a std::uint32_t or a vector of them with as many lanes as T.
+     *
+     * @returns
+     *   Sine of phase.
+     */
+    template <class T, class P>
+    FS_ALWAYS_INLINE static T evaluate_phase(P phase)
+    {
+        using E = typename simd::lane_traits<T>::element_type;
+        using Remainder = simd::rebind_t<P, std::int32_t>;
+
+        constexpr auto radians_per_step = static_cast<E>(2.0 * std::numbers::pi / 4294967296.0);
+
+        // a phase just below a full turn rounds to quadrant 4, which selects the same as quadrant 0
+        const P quadrant = (phase + (std::uint32_t{1u} << 29u)) >> 30u;
+        const Remainder remainder = simd::convert<Remainder>(phase - (quadrant << 30u));
+
+        return from_reduced(
+            Reduced<T>{simd::convert<T>(remainder) * radians_per_step, simd::convert<simd::bits_t<T>>(quadrant)});
+    }
+
+    /**
+     * Evaluate sine and cos, sharing the range reduction and both polynomial cores.
+     *
+     * @param theta
+     *   Input value, either a float, a double or a vector of either.
+     *
+     * @returns
+     *   Sine and cos of input value.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static SinCos<T> evaluate_sin_cos(T theta)
+    {
+        using L = simd::lane_traits<T>;
+
+        const auto large = finite_beyond_cody_waite(theta);
+
+        auto result = sin_cos_from_reduced(reduce_cody_waite(cody_waite_inputs(theta)));
+
+        if (simd::any(large)) [[unlikely]]
+        {
+            if constexpr (L::is_vector)
+            {
+                for (auto i = 0u; i < L::lanes; ++i)
+                {
+                    if (large[i] != 0)
+                    {
+                        const auto lane = evaluate_large_sin_cos(theta[i]);
+                        result.sin[i] = lane.sin;
+                        result.cos[i] = lane.cos;
+                    }
+                }
+            }
+            else
+            {
+                result = evaluate_large_sin_cos(theta);
+            }
+        }
+
+        return {special_sine(theta, result.sin), special_cos(theta, result.cos)};
+    }
+};
+
+/**
+ * Lowest degree polynomial kernel accurate to a quarter of an ulp of T before the result is rounded.
+ *
+ * T is any type with precision_traits. A compile time Remez fit can't get far enough below 1e-16 to pick a minimax
+ * polynomial for double, so double uses the Taylor series instead, which is converged to well under an ulp at degree 15
+ * on [-pi/4, pi/4].
+ */
+template <class T>
+struct PrecisionPolynomial
+{
+    static constexpr auto degree = remez::minimal_degree(epsilon_v<T> / 4.0, remez::ErrorMetric::RELATIVE);
+
+    using kernel = PolynomialKernel<degree>;
+};
+
+template <>
+struct PrecisionPolynomial<double>
+{
+    static constexpr auto degree = std::size_t{15u};
+
+    using kernel = PolynomialKernel<degree, Scheme::HORNER, TaylorCoefficients<degree>>;
+};
+
+template <std::size_t Degree, Scheme S = Scheme::HORNER>
+using PolynomialCalculator = KernelCalculator<PolynomialKernel<Degree, S>>;
+
+template <std::size_t Degree, Scheme S = Scheme::HORNER>
+using PolynomialSinCosCalculator = KernelSinCosCalculator<PolynomialKernel<Degree, S>>;
+
+template <class T>
+using PrecisionPolynomialCalculator = KernelCalculator<typename PrecisionPolynomial<T>::kernel, T>;
+
+template <class T>
+using PrecisionPolynomialSinCosCalculator = KernelSinCosCalculator<typename PrecisionPolynomial<T>::kernel, T>;
+
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__FLT16_MANT_DIG__)
+#define FS_HAS_FLOAT16 1
+#endif
+
+namespace fs
+{
+
+#if defined(FS_HAS_FLOAT16)
+/**
+ * IEEE half precision float, only available when the compiler supports _Float16.
+ */
+using half = _Float16;
+#endif
+
+/**
+ * Brain float, the top 16 bits of a float. There is no arithmetic on it, values are converted to float to calculate
+ * with and rounded back to store.
+ */
+struct bfloat16
+{
+    /** Bits of value, sign, 8 exponent bits and 7 mantissa bits. */
+    std::uint16_t bits = 0u;
+
+    /**
+     * Construct a zero bfloat16.
+     */
+    constexpr bfloat16() = default;
+
+    /**
+     * Construct a bfloat16 by rounding a float to nearest even, NaNs stay NaNs.
+     *
+     * @param value
+     *   Value to round.
+     */
+    constexpr explicit bfloat16(float value)
+        : bits(round(std::bit_cast<std::uint32_t>(value)))
+    {
+    }
+
+    /**
+     * Widen to a float, which is exact.
+     *
+     * @returns
+     *   Value as a float.
+     */
+    constexpr explicit operator float() const
+    {
+        return std::bit_cast<float>(static_cast<std::uint32_t>(bits) << 16u);
+    }
+
+    /**
+     * Round the bits of a float to the bits of a bfloat16.
+     *
+     * @param value
+     *   Bits of float.
+     *
+     * @returns
+     *   Bits of nearest bfloat16, ties to even.
+     */
+    static constexpr std::uint16_t round(std::uint32_t value)
+    {
+        // truncating could turn a NaN with only low mantissa bits into infinity, so set a high mantissa bit instead
+        if ((value & 0x7fffffffu) > 0x7f800000u)
+        {
+            return static_cast<std::uint16_t>((value >> 16u) | 0x40u);
+        }
+
+        return static_cast<std::uint16_t>((value + 0x7fffu + ((value >> 16u) & 1u)) >> 16u);
+    }
+};
+
+/**
+ * Describes a floating point type kernels can be instantiated for.
+ */
+template <class T>
+struct precision_traits;
+
+template <>
+struct precision_traits<float>
+{
+    /** Type kernels calculate in. */
+    using compute_type = float;
+
+    /** Bits of mantissa, including the implicit bit. */
+    static constexpr int digits = 24;
+
+    /** Exponent of the smallest denormal. */
+    static constexpr int min_denormal_exponent = -149;
+
+    /** Name used in kernel names and reports. */
+    static constexpr std::string_view name = "float";
+};
+
+template <>
+struct precision_traits<double>
+{
+    using compute_type = double;
+    static constexpr int digits = 53;
+    static constexpr int min_denormal_exponent = -1074;
+    static constexpr std::string_view name = "double";
+};
+
+#if defined(FS_HAS_FLOAT16)
+template <>
+struct precision_traits<half>
+{
+    // there's little hardware arithmetic on half, and the conversions are cheap
+    using compute_type = float;
+    static constexpr int digits = 11;
+    static constexpr int min_denormal_exponent = -24;
+    static constexpr std::string_view name = "half";
+};
+#endif
+
+template <>
+struct precision_traits<bfloat16>
+{
+    using compute_type = float;
+    static constexpr int digits = 8;
+    static constexpr int min_denormal_exponent = -133;
+    static constexpr std::string_view name = "bfloat16";
+};
+
+/**
+ * Type kernels calculate values of type T in.
+ */
+template <class T>
+using compute_t = typename precision_traits<T>::compute_type;
+
+/**
+ * Distance from one to the next value of type T.
+ */
+template <class T>
+inline constexpr double epsilon_v = []
+{
+    auto epsilon = 1.0;
+    for (auto i = 1; i < precision_traits<T>::digits; ++i)
+    {
+        epsilon /= 2.0;
+    }
+    return epsilon;
+}();
+
+}
@@ -0,0 +1,363 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <type_traits>
+
+#include "simd.h"
+#include "special_values.h"
+
+namespace fs
+{
+
+/**
+ * An argument reduced to [-pi/4, pi/4] along with which quadrant it came from.
+ */
+template <class T>
+struct Reduced
+{
+    /** Remainder after removing the nearest multiple of pi/2. */
+    T remainder;
+
+    /** Multiple of pi/2 that was removed, only the bottom two bits are needed to pick a quadrant. */
+    simd::bits_t<T> quadrant;
+};
+
+namespace detail
+{
+
+/**
+ * Constants for Cody-Waite reduction in precision E. Each split has enough trailing zero bits in its first two parts
+ * that their products with any quadrant up to the limit are exact.
+ */
+template <class E>
+struct reduction_constants;
+
+template <>
+struct reduction_constants<float>
+{
+    static constexpr float limit = 8192.0f;
+    static constexpr float pi_over_2_a = 1.5703125f;
+    static constexpr float pi_over_2_b = 4.837512969970703125e-4f;
+    static constexpr float pi_over_2_c = 7.54978995489188216e-8f;
+    static constexpr float two_pi_a = 6.28125f;
+    static constexpr float two_pi_b = 1.93500518798828125e-3f;
+    static constexpr float two_pi_c = 3.01991598195675286e-7f;
+};
+
+template <>
+struct reduction_constants<double>
+{
+    static constexpr double limit = 1048576.0;
+    static constexpr double pi_over_2_a = 1.57079632673412561417e+00;
+    static constexpr double pi_over_2_b = 6.07710050630396597660e-11;
+    static constexpr double pi_over_2_c = 2.02226624879595063154e-21;
+    static constexpr double two_pi_a = 4.0 * pi_over_2_a;
+    static constexpr double two_pi_b = 4.0 * pi_over_2_b;
+    static constexpr double two_pi_c = 4.0 * pi_over_2_c;
+};
+
+}
+
+/**
+ * Largest magnitude that reduce_cody_waite gives an accurate result for in precision E. Past this the products of the
+ * quadrant and the split constants are no longer exact.
+ */
+template <class E>
+inline constexpr E cody_waite_limit_v = detail::reduction_constants<E>::limit;
+
+/**
+ * Largest magnitude that reduce_cody_waite gives an accurate result for in float.
+ */
+inline constexpr float cody_waite_limit = cody_waite_limit_v<float>;
+
+/**
+ * Check which lanes are too large for Cody-Waite reduction. The bits are compared as integers so NaN and infinity are
+ * also caught, even with fast maths.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @returns
+ *   Mask set for each lane with a magnitude above cody_waite_limit_v, or which isn't finite.
+ */
+template <class T>
+FS_ALWAYS_INLINE auto beyond_cody_waite(T theta)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    constexpr auto limit = std::bit_cast<simd::int_for_t<E>>(cody_waite_limit_v<E>);
+
+    return simd::to_bits(simd::abs(theta)) > limit;
+}
+
+/**
+ * Check which lanes are finite but too large for Cody-Waite reduction, the ones a kernel sends down its slow path. NaN
+ * and infinity are left to special_sine. This is one unsigned range compare on the magnitude.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @returns
+ *   Mask set for each finite lane with a magnitude above cody_waite_limit_v.
+ */
+template <class T>
+FS_ALWAYS_INLINE auto finite_beyond_cody_waite(T theta)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    using U = std::make_unsigned_t<simd::int_for_t<E>>;
+
+    constexpr auto low = std::bit_cast<U>(cody_waite_limit_v<E>) + 1u;
+    constexpr auto high = std::bit_cast<U>(std::numeric_limits<E>::infinity());
+
+    return (detail::unsigned_magnitude(theta) - low) < (high - low);
+}
+
+/**
+ * Replace every lane Cody-Waite reduction shouldn't see with zero, the special lanes below identity_limit_v or not
+ * finite and those beyond cody_waite_limit_v, so the general path never does arithmetic on a denormal, a NaN or an
+ * infinity. This is one unsigned range compare and one select, rather than one of each for the two kinds of lane.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @returns
+ *   Input with the lanes outside [identity_limit_v, cody_waite_limit_v] zeroed.
+ */
+template <class T>
+FS_ALWAYS_INLINE T cody_waite_inputs(T theta)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    using U = std::make_unsigned_t<simd::int_for_t<E>>;
+
+    constexpr auto low = std::bit_cast<U>(identity_limit_v<E>);
+    constexpr auto high = std::bit_cast<U>(cody_waite_limit_v<E>);
+
+    return simd::select((detail::unsigned_magnitude(theta) - low) > (high - low), T{}, theta);
+}
+
+/**
+ * Reduce an argument with Cody-Waite reduction, pi/2 is split into three parts so that the first two products with the
+ * quadrant are exact.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either, magnitude must not exceed cody_waite_limit_v.
+ *
+ * @returns
+ *   Reduced argument.
+ */
+template <class T>
+FS_ALWAYS_INLINE Reduced<T> reduce_cody_waite(T theta)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    using I = simd::bits_t<T>;
+    using constants = detail::reduction_constants<E>;
+
+    constexpr auto two_over_pi = E{2} / std::numbers::pi_v<E>;
+
+    const T scaled = theta * two_over_pi;
+    const T rounding = simd::select(scaled < E{0}, simd::broadcast<T>(E{-0.5}), simd::broadcast<T>(E{0.5}));
+    const I quadrant = simd::convert<I>(scaled + rounding);
+    const T k = simd::convert<T>(quadrant);
+
+    T remainder = theta - (k * constants::pi_over_2_a);
+    remainder = remainder - (k * constants::pi_over_2_b);
+    remainder = remainder - (k * constants::pi_over_2_c);
+
+    return {remainder, quadrant};
+}
+
+/**
+ * Reduce an argument to [-pi, pi] by removing the nearest multiple of 2pi, the split constants are the pi/2 ones scaled
+ * by four so the same products are exact.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either, magnitude must not exceed cody_waite_limit_v.
+ *
+ * @returns
+ *   Reduced argument.
+ */
+template <class T>
+FS_ALWAYS_INLINE T reduce_two_pi(T theta)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    using I = simd::bits_t<T>;
+    using constants = detail::reduction_constants<E>;
+
+    constexpr auto one_over_two_pi = E{0.5} / std::numbers::pi_v<E>;
+
+    const T scaled = theta * one_over_two_pi;
+    const T rounding = simd::select(scaled < E{0}, simd::broadcast<T>(E{-0.5}), simd::broadcast<T>(E{0.5}));
+    const T k = simd::convert<T>(simd::convert<I>(scaled + rounding));
+
+    T remainder = theta - (k * constants::two_pi_a);
+    remainder = remainder - (k * constants::two_pi_b);
+    return remainder - (k * constants::two_pi_c);
+}
+
+namespace detail
+{
+
+/**
+ * Binary expansion of 2/pi, 32 bits per word starting with the bit worth 2^-1. This covers every exponent of a double.
+ */
+inline constexpr std::uint32_t two_over_pi_bits[] = {
+    0xa2f9836e, 0x4e441529, 0xfc2757d1, 0xf534ddc0, 0xdb629599, 0x3c439041, 0xfe5163ab, 0xdebbc561,
+    0xb7246e3a, 0x424dd2e0, 0x06492eea, 0x09d1921c, 0xfe1deb1c, 0xb129a73e, 0xe88235f5, 0x2ebb4484,
+    0xe99c7026, 0xb45f7e41, 0x3991d639, 0x835339f4, 0x9c845f8b, 0xbdf9283b, 0x1ff897ff, 0xde05980f,
+    0xef2f118b, 0x5a0a6d1f, 0x6d367ecf, 0x27cb09b7, 0x4f463f66, 0x9e5fea2d, 0x7527bac7, 0xebe5f17b,
+    0x3d0739f7, 0x8a5292ea, 0x6bfb5fb1, 0x1f8d5d08, 0x56033046, 0xfc7b6bab, 0xf0cfbc20, 0x9af4361d};
+
+/**
+ * Get 32 consecutive bits of 2/pi.
+ *
+ * @param position
+ *   Position of the first bit, the bit worth 2^-1 is position 1. Positions less than one are the integer bits of 2/pi
+ *   and so are zero.
+ *
+ * @returns
+ *   Bits at [position, position + 32), with the first bit as the most significant.
+ */
+constexpr std::uint32_t two_over_pi_window(std::int32_t position)
+{
+    const auto offset = position - 1;
+
+    if (offset <= -32)
+    {
+        return 0u;
+    }
+
+    if (offset < 0)
+    {
+        return two_over_pi_bits[0] >> -offset;
+    }
+
+    const auto word = static_cast<std::size_t>(offset / 32);
+    const auto shift = offset % 32;
+
+    if (shift == 0)
+    {
+        return two_over_pi_bits[word];
+    }
+
+    return (two_over_pi_bits[word] << shift) | (two_over_pi_bits[word + 1u] >> (32 - shift));
+}
+
+}
+
+/**
+ * Payne-Hanek reduction of mantissa * 2^exponent.
+ *
+ * Only the 192 bits of 2/pi which can affect the result modulo 4 are used: the mantissa is multiplied by them with
+ * integer arithmetic, giving the result in 2.190 bit fixed point. That is enough for a double mantissa landing as close
+ * to a multiple of pi/2 as any double can to keep its remainder to full precision.
+ *
+ * @param mantissa
+ *   Integer mantissa, must be less than 2^53.
+ *
+ * @param exponent
+ *   Power of two the mantissa is scaled by, the value must be at least one.
+ *
+ * @returns
+ *   Reduced argument.
+ */
+constexpr Reduced<double> reduce_payne_hanek(std::uint64_t mantissa, std::int32_t exponent)
+{
+    // bits of 2/pi worth more than 2^(1 - exponent) only contribute multiples of four
+    const auto first = exponent - 1;
+
+    const std::uint32_t window[6] = {
+        detail::two_over_pi_window(first + 160),
+        detail::two_over_pi_window(first + 128),
+        detail::two_over_pi_window(first + 96),
+        detail::two_over_pi_window(first + 64),
+        detail::two_over_pi_window(first + 32),
+        detail::two_over_pi_window(first)};
+
+    const std::uint32_t digits[2] = {
+        static_cast<std::uint32_t>(mantissa & 0xffffffffu), static_cast<std::uint32_t>(mantissa >> 32u)};
+
+    // mantissa * window modulo 2^192, least significant word first
+    std::uint32_t product[6] = {};
+    for (auto i = 0u; i < 2u; ++i)
+    {
+        auto carry = std::uint64_t{0u};
+
+        for (auto j = 0u; i + j < 6u; ++j)
+        {
+            const auto sum = (static_cast<std::uint64_t>(digits[i]) * window[j]) + product[i + j] + carry;
+            product[i + j] = static_cast<std::uint32_t>(sum);
+            carry = sum >> 32u;
+        }
+    }
+
+    // top 64 bits are 2.62 fixed point, round to the nearest quadrant and keep the signed remainder, the next 64 bits
+    // only matter when the remainder is tiny
+    const auto high = (static_cast<std::uint64_t>(product[5]) << 32u) | product[4];
+    const auto low = (static_cast<std::uint64_t>(product[3]) << 32u) | product[2];
+    const auto quadrant = (high + (std::uint64_t{1u} << 61u)) >> 62u;
+    const auto fraction = static_cast<std::int64_t>(high - (quadrant << 62u));
+
+    constexpr auto pi_over_2_scaled = std::numbers::pi / 2.0 / 4611686018427387904.0;
+    constexpr auto low_scale = 1.0 / 18446744073709551616.0;
+
+    const auto remainder = static_cast<double>(fraction) + (static_cast<double>(low) * low_scale);
+
+    return {remainder * pi_over_2_scaled, static_cast<std::int64_t>(quadrant & 3u)};
+}
+
+/**
+ * Payne-Hanek reduction of a float.
+ *
+ * @param theta
+ *   Input value, must be finite and have a magnitude of at least one.
+ *
+ * @returns
+ *   Reduced argument.
+ */
+constexpr Reduced<double> reduce_payne_hanek(float theta)
+{
+    const auto bits = std::bit_cast<std::uint32_t>(theta);
+    const auto mantissa = (bits & 0x7fffffu) | 0x800000u;
+    const auto exponent = static_cast<std::int32_t>((bits >> 23u) & 0xffu) - 150;
+
+    auto reduced = reduce_payne_hanek(mantissa, exponent);
+
+    if ((bits >> 31u) != 0u)
+    {
+        reduced.remainder = -reduced.remainder;
+        reduced.quadrant = -reduced.quadrant & 3;
+    }
+
+    return reduced;
+}
+
+/**
+ * Payne-Hanek reduction of a double.
+ *
+ * @param theta
+ *   Input value, must be finite and have a magnitude of at least one.
+ *
+ * @returns
+ *   Reduced argument.
+ */
+constexpr Reduced<double> reduce_payne_hanek(double theta)
+{
+    const auto bits = std::bit_cast<std::uint64_t>(theta);
+    const auto mantissa = (bits & 0xfffffffffffffu) | 0x10000000000000u;
+    const auto exponent = static_cast<std::int32_t>((bits >> 52u) & 0x7ffu) - 1075;
+
+    auto reduced = reduce_payne_hanek(mantissa, exponent);
+
+    if ((bits >> 63u) != 0u)
+    {
+        reduced.remainder = -reduced.remainder;
+        reduced.quadrant = -reduced.quadrant & 3;
+    }
+
+    return reduced;
+}
+
+}
@@ -0,0 +1,693 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <numbers>
+
+namespace fs::remez
+{
+
+/**
+ * How the error of a fit is measured.
+ */
+enum class ErrorMetric
+{
+    /** |p(x) - f(x)| */
+    ABSOLUTE,
+
+    /** |p(x) - f(x)| / |f(x)| */
+    RELATIVE,
+
+    /** |p(x) - f(x)| in units in the last place of f(x) as a float. */
+    ULP
+};
+
+/**
+ * Function to approximate, sine is fitted with odd powers and cos with even powers.
+ */
+enum class Function
+{
+    SIN,
+    COS
+};
+
+/**
+ * Largest number of terms a fit can have.
+ */
+inline constexpr std::size_t max_terms = 12u;
+
+/**
+ * Result of fitting a polynomial.
+ */
+struct Fit
+{
+    /** Coefficients of x, x^3, x^5... for sine or 1, x^2, x^4... for cos. Only the first terms are used. */
+    std::array<double, max_terms> coefficients;
+
+    /** Number of coefficients. */
+    std::size_t terms;
+
+    /** Largest error over the interval, in the units of the metric used. */
+    double error;
+
+    /** Whether the error equioscillated before the iteration limit was hit. */
+    bool converged;
+};
+
+namespace detail
+{
+
+/**
+ * Absolute value, usable in constant expressions.
+ *
+ * @param x
+ *   Value.
+ *
+ * @returns
+ *   Absolute value.
+ */
+constexpr double absolute(double x)
+{
+    return x < 0.0 ? -x : x;
+}
+
+/**
+ * Sine from its Taylor series, summed until the terms stop contributing. Only intended for the small intervals used
+ * when fitting.
+ *
+ * @param x
+ *   Input value, should be in [-pi, pi].
+ *
+ * @returns
+ *   Sine of input value.
+ */
+constexpr double sin_series(double x)
+{
+    auto term = x;
+    auto sum = x;
+
+    for (auto i = 1u; (i < 64u) && (absolute(term) > 1e-300); ++i)
+    {
+        term *= -(x * x) / static_cast<double>((2u * i) * ((2u * i) + 1u));
+        sum += term;
+    }
+
+    return sum;
+}
+
+/**
+ * Cos from its Taylor series, summed until the terms stop contributing. Only intended for the small intervals used when
+ * fitting.
+ *
+ * @param x
+ *   Input value, should be in [-pi, pi].
+ *
+ * @returns
+ *   Cos of input value.
+ */
+constexpr double cos_series(double x)
+{
+    auto term = 1.0;
+    auto sum = 1.0;
+
+    for (auto i = 1u; (i < 64u) && (absolute(term) > 1e-300); ++i)
+    {
+        term *= -(x * x) / static_cast<double>(((2u * i) - 1u) * (2u * i));
+        sum += term;
+    }
+
+    return sum;
+}
+
+/**
+ * Size of a unit in the last place of a float with the same magnitude as a value.
+ *
+ * @param x
+ *   Value.
+ *
+ * @returns
+ *   Float ulp at x.
+ */
+constexpr double float_ulp(double x)
+{
+    x = absolute(x);
+
+    if (x < 1.1754943508222875e-38)
+    {
+        return 1.401298464324817e-45;
+    }
+
+    auto power = 1.0;
+    while (power * 2.0 <= x)
+    {
+        power *= 2.0;
+    }
+    while (power > x)
+    {
+        power /= 2.0;
+    }
+
+    return power / 8388608.0;
+}
+
+/**
+ * Value of the function being approximated.
+ *
+ * @param function
+ *   Function.
+ *
+ * @param x
+ *   Input value.
+ *
+ * @returns
+ *   Value of function.
+ */
+constexpr double target(Function function, double x)
+{
+    return function == Function::SIN ? sin_series(x) : cos_series(x);
+}
+
+/**
+ * Evaluate the i-th basis function.
+ *
+ * @param function
+ *   Function being approximated, picks between odd and even powers.
+ *
+ * @param i
+ *   Index of basis function.
+ *
+ * @param x
+ *   Input value.
+ *
+ * @returns
+ *   x^(2i + 1) for sine, x^(2i) for cos.
+ */
+constexpr double basis(Function function, std::size_t i, double x)
+{
+    auto result = function == Function::SIN ? x : 1.0;
+
+    for (auto j = 0u; j < i; ++j)
+    {
+        result *= x * x;
+    }
+
+    return result;
+}
+
+/**
+ * Evaluate a fitted polynomial.
+ *
+ * @param function
+ *   Function being approximated.
+ *
+ * @param coefficients
+ *   Coefficients.
+ *
+ * @param terms
+ *   Number of coefficients.
+ *
+ * @param x
+ *   Input value.
+ *
+ * @returns
+ *   Value of polynomial.
+ */
+constexpr double evaluate(
+    Function function,
+    const std::array<double, max_terms> &coefficients,
+    std::size_t terms,
+    double x)
+{
+    auto sum = 0.0;
+
+    for (auto i = terms; i > 0u; --i)
+    {
+        sum = (sum * x * x) + coefficients[i - 1u];
+    }
+
+    return function == Function::SIN ? sum * x : sum;
+}
+
+/**
+ * Weighted error of a polynomial at a point.
+ *
+ * @param function
+ *   Function being approximated.
+ *
+ * @param metric
+ *   How error is measured.
+ *
+ * @param coefficients
+ *   Coefficients.
+ *
+ * @param terms
+ *   Number of coefficients.
+ *
+ * @param x
+ *   Input value.
+ *
+ * @returns
+ *   Signed error in units of metric.
+ */
+constexpr double error_at(
+    Function function,
+    ErrorMetric metric,
+    const std::array<double, max_terms> &coefficients,
+    std::size_t terms,
+    double x)
+{
+    const auto expected = target(function, x);
+    const auto difference = evaluate(function, coefficients, terms, x) - expected;
+
+    switch (metric)
+    {
+        case ErrorMetric::ABSOLUTE: return difference;
+        case ErrorMetric::RELATIVE: return difference / absolute(expected);
+        case ErrorMetric::ULP: return difference / float_ulp(expected);
+    }
+
+    return difference;
+}
+
+/**
+ * Weight of the levelled error term at a point, the reciprocal of the scale used by error_at.
+ *
+ * @param function
+ *   Function being approximated.
+ *
+ * @param metric
+ *   How error is measured.
+ *
+ * @param x
+ *   Input value.
+ *
+ * @returns
+ *   Amount the levelled error is multiplied by at x.
+ */
+constexpr double error_scale(Function function, ErrorMetric metric, double x)
+{
+    switch (metric)
+    {
+        case ErrorMetric::ABSOLUTE: return 1.0;
+        case ErrorMetric::RELATIVE: return absolute(target(function, x));
+        case ErrorMetric::ULP: return float_ulp(target(function, x));
+    }
+
+    return 1.0;
+}
+
+/**
+ * Solve a linear system with Gaussian elimination and partial pivoting.
+ *
+ * @param matrix
+ *   Augmented matrix of size x (size + 1), destroyed by the solve.
+ *
+ * @param size
+ *   Number of unknowns.
+ *
+ * @returns
+ *   Solution.
+ */
+constexpr std::array<double, max_terms + 1u> solve(
+    std::array<std::array<double, max_terms + 2u>, max_terms + 1u> &matrix,
+    std::size_t size)
+{
+    for (auto column = 0u; column < size; ++column)
+    {
+        auto pivot = column;
+        for (auto row = column + 1u; row < size; ++row)
+        {
+            if (absolute(matrix[row][column]) > absolute(matrix[pivot][column]))
+            {
+                pivot = row;
+            }
+        }
+
+        const auto swapped = matrix[column];
+        matrix[column] = matrix[pivot];
+        matrix[pivot] = swapped;
+
+        for (auto row = column + 1u; row < size; ++row)
+        {
+            const auto factor = matrix[row][column] / matrix[column][column];
+            for (auto i = column; i <= size; ++i)
+            {
+                matrix[row][i] -= factor * matrix[column][i];
+            }
+        }
+    }
+
+    std::array<double, max_terms + 1u> solution{};
+    for (auto row = size; row > 0u; --row)
+    {
+        auto sum = matrix[row - 1u][size];
+        for (auto i = row; i < size; ++i)
+        {
+            sum -= matrix[row - 1u][i] * solution[i];
+        }
+        solution[row - 1u] = sum / matrix[row - 1u][row - 1u];
+    }
+
+    return solution;
+}
+
+/**
+ * Find the point of largest signed error in an interval with a golden section search.
+ *
+ * @param function
+ *   Function being approximated.
+ *
+ * @param metric
+ *   How error is measured.
+ *
+ * @param coefficients
+ *   Coefficients.
+ *
+ * @param terms
+ *   Number of coefficients.
+ *
+ * @param lower
+ *   Start of interval.
+ *
+ * @param upper
+ *   End of interval.
+ *
+ * @param sign
+ *   1 to find a maximum, -1 to find a minimum.
+ *
+ * @returns
+ *   Location of extremum.
+ */
+constexpr double refine_extremum(
+    Function function,
+    ErrorMetric metric,
+    const std::array<double, max_terms> &coefficients,
+    std::size_t terms,
+    double lower,
+    double upper,
+    double sign)
+{
+    constexpr auto ratio = 0.6180339887498949;
+
+    auto a = lower;
+    auto b = upper;
+    auto c = b - ratio * (b - a);
+    auto d = a + ratio * (b - a);
+    auto fc = sign * error_at(function, metric, coefficients, terms, c);
+    auto fd = sign * error_at(function, metric, coefficients, terms, d);
+
+    for (auto i = 0u; i < 40u; ++i)
+    {
+        if (fc > fd)
+        {
+            b = d;
+            d = c;
+            fd = fc;
+            c = b - ratio * (b - a);
+            fc = sign * error_at(function, metric, coefficients, terms, c);
+        }
+        else
+        {
+            a = c;
+            c = d;
+            fc = fd;
+            d = a + ratio * (b - a);
+            fd = sign * error_at(function, metric, coefficients, terms, d);
+        }
+    }
+
+    return (a + b) / 2.0;
+}
+
+}
+
+/**
+ * Fit a minimax polynomial to sine or cos with the Remez exchange algorithm. The whole fit can run at compile time.
+ *
+ * The reference starts at the Chebyshev nodes of the interval, so the first iteration is a Chebyshev interpolant, and
+ * is then exchanged for the extrema of the error until they equioscillate. The ULP metric has a weight that steps at
+ * every power of two, so it may stop at the iteration limit with a near minimax result.
+ *
+ * @param function
+ *   Function to approximate.
+ *
+ * @param terms
+ *   Number of terms, at most max_terms.
+ *
+ * @param lower
+ *   Start of interval, for sine this is raised slightly above zero as every odd polynomial is exact there.
+ *
+ * @param upper
+ *   End of interval.
+ *
+ * @param metric
+ *   How error is measured.
+ *
+ * @returns
+ *   Fitted polynomial.
+ */
+constexpr Fit fit(Function function, std::size_t terms, double lower, double upper, ErrorMetric metric)
+{
+    constexpr auto grid_size = 512u;
+
+    if ((function == Function::SIN) && (lower < upper * 1e-3))
+    {
+        lower = upper * 1e-3;
+    }
+
+    const auto points = terms + 1u;
+
+    std::array<double, max_terms + 1u> reference{};
+    for (auto i = 0u; i < points; ++i)
+    {
+        const auto angle = std::numbers::pi * static_cast<double>(i) / static_cast<double>(terms);
+        reference[i] = ((lower + upper) / 2.0) - (((upper - lower) / 2.0) * detail::cos_series(angle));
+    }
+
+    auto result = Fit{.coefficients = {}, .terms = terms, .error = 0.0, .converged = false};
+    auto best_error = -1.0;
+
+    for (auto iteration = 0u; iteration < 30u; ++iteration)
+    {
+        // solve for the polynomial whose error alternates with equal magnitude on the reference
+        std::array<std::array<double, max_terms + 2u>, max_terms + 1u> matrix{};
+        for (auto row = 0u; row < points; ++row)
+        {
+            const auto x = reference[row];
+            for (auto i = 0u; i < terms; ++i)
+            {
+                matrix[row][i] = detail::basis(function, i, x);
+            }
+            matrix[row][terms] = ((row % 2u) == 0u ? 1.0 : -1.0) * detail::error_scale(function, metric, x);
+            matrix[row][points] = detail::target(function, x);
+        }
+
+        const auto solution = detail::solve(matrix, points);
+
+        std::array<double, max_terms> coefficients{};
+        for (auto i = 0u; i < terms; ++i)
+        {
+            coefficients[i] = solution[i];
+        }
+
+        // find the extrema of the error, keeping the largest of each run with the same sign
+        std::array<double, grid_size + 1u> candidates{};
+        std::array<double, grid_size + 1u> values{};
+        auto count = 0u;
+
+        auto previous = detail::error_at(function, metric, coefficients, terms, lower);
+        auto current = detail::error_at(
+            function, metric, coefficients, terms, lower + ((upper - lower) / static_cast<double>(grid_size)));
+
+        for (auto i = 0u; i <= grid_size; ++i)
+        {
+            const auto step = (upper - lower) / static_cast<double>(grid_size);
+            const auto x = lower + (step * static_cast<double>(i));
+            const auto next =
+                i < grid_size ? detail::error_at(function, metric, coefficients, terms, x + step) : 0.0;
+            const auto value = i == 0u ? previous : current;
+
+            const auto is_end = (i == 0u) || (i == grid_size);
+            const auto is_peak = !is_end && (detail::absolute(value) >= detail::absolute(previous)) &&
+                                 (detail::absolute(value) >= detail::absolute(next)) &&
+                                 ((value > 0.0) == (previous > 0.0)) && ((value > 0.0) == (next > 0.0));
+
+            if ((is_end || is_peak) && (value != 0.0))
+            {
+                auto location = x;
+                auto extremum = value;
+
+                if (is_peak)
+                {
+                    const auto sign = value > 0.0 ? 1.0 : -1.0;
+                    location = detail::refine_extremum(
+                        function, metric, coefficients, terms, x - step, x + step, sign);
+                    extremum = detail::error_at(function, metric, coefficients, terms, location);
+                }
+
+                if ((count > 0u) && ((extremum > 0.0) == (values[count - 1u] > 0.0)))
+                {
+                    if (detail::absolute(extremum) > detail::absolute(values[count - 1u]))
+                    {
+                        candidates[count - 1u] = location;
+                        values[count - 1u] = extremum;
+                    }
+                }
+                else
+                {
+                    candidates[count] = location;
+                    values[count] = extremum;
+                    ++count;
+                }
+            }
+
+            if (i > 0u)
+            {
+                previous = current;
+                current = next;
+            }
+        }
+
+        // drop the smaller end until the reference is the right size
+        auto first = 0u;
+        while (count - first > points)
+        {
+            if (detail::absolute(values[first]) < detail::absolute(values[count - 1u]))
+            {
+                ++first;
+            }
+            else
+            {
+                --count;
+            }
+        }
+
+        auto max_error = 0.0;
+        auto min_error = -1.0;
+        for (auto i = first; i < count; ++i)
+        {
+            const auto magnitude = detail::absolute(values[i]);
+            max_error = magnitude > max_error ? magnitude : max_error;
+            min_error = (min_error < 0.0) || (magnitude < min_error) ? magnitude : min_error;
+        }
+
+        if ((best_error < 0.0) || (max_error < best_error))
+        {
+            best_error = max_error;
+            result.coefficients = coefficients;
+            result.error = max_error;
+        }
+
+        if (count - first < points)
+        {
+            break;
+        }
+
+        if ((max_error - min_error) <= (max_error * 1e-4))
+        {
+            result.converged = true;
+            break;
+        }
+
+        for (auto i = 0u; i < points; ++i)
+        {
+            reference[i] = candidates[first + i];
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Find the lowest degree sine polynomial, with its matching cos polynomial one degree higher, whose error on [0, pi/4]
+ * meets a budget. This is the degree to give to PolynomialKernel.
+ *
+ * @param budget
+ *   Largest acceptable error, in the units of metric.
+ *
+ * @param metric
+ *   How error is measured.
+ *
+ * @returns
+ *   Odd sine degree, or zero if no supported degree meets the budget.
+ */
+constexpr std::size_t minimal_degree(double budget, ErrorMetric metric)
+{
+    constexpr auto upper = std::numbers::pi / 4.0;
+
+    for (auto terms = 2u; terms + 1u <= max_terms; ++terms)
+    {
+        const auto sin_fit = fit(Function::SIN, terms, 0.0, upper, metric);
+        const auto cos_fit = fit(Function::COS, terms + 1u, 0.0, upper, metric);
+
+        if ((sin_fit.error <= budget) && (cos_fit.error <= budget))
+        {
+            return (2u * terms) - 1u;
+        }
+    }
+
+    return 0u;
+}
+
+/**
+ * Minimax coefficients for PolynomialKernel, fitted on [0, pi/4] at compile time. They are kept in double, the kernel
+ * rounds them to whichever precision it is instantiated for.
+ *
+ * sin is in terms of r, r^3, ... r^Degree and cos is in terms of 1, r^2, ... r^(Degree + 1).
+ */
+template <std::size_t Degree, ErrorMetric Metric = ErrorMetric::RELATIVE>
+struct MinimaxCoefficients
+{
+    static_assert((Degree % 2u) == 1u, "degree must be odd");
+    static_assert((Degree + 3u) / 2u <= max_terms, "degree is too high");
+
+    static constexpr auto sin_fit = fit(Function::SIN, (Degree + 1u) / 2u, 0.0, std::numbers::pi / 4.0, Metric);
+    static constexpr auto cos_fit = fit(Function::COS, (Degree + 3u) / 2u, 0.0, std::numbers::pi / 4.0, Metric);
+
+    static constexpr std::array<double, (Degree + 1u) / 2u> sin = []
+    {
+        std::array<double, (Degree + 1u) / 2u> result{};
+        for (auto i = 0u; i < result.size(); ++i)
+        {
+            result[i] = sin_fit.coefficients[i];
+        }
+        return result;
+    }();
+
+    static constexpr std::array<double, (Degree + 3u) / 2u> cos = []
+    {
+        std::array<double, (Degree + 3u) / 2u> result{};
+        for (auto i = 0u; i < result.size(); ++i)
+        {
+            result[i] = cos_fit.coefficients[i];
+        }
+        return result;
+    }();
+};
+
+/**
+ * Minimax coefficients for sine alone on [0, pi/2], for inputs which need no range reduction. Fitting over twice the
+ * interval of MinimaxCoefficients costs about one extra term for the same error.
+ *
+ * sin is in terms of r, r^3, ... r^Degree.
+ */
+template <std::size_t Degree, ErrorMetric Metric = ErrorMetric::RELATIVE>
+struct HalfPiCoefficients
+{
+    static_assert((Degree % 2u) == 1u, "degree must be odd");
+    static_assert((Degree + 1u) / 2u <= max_terms, "degree is too high");
+
+    static constexpr auto sin_fit = fit(Function::SIN, (Degree + 1u) / 2u, 0.0, std::numbers::pi / 2.0, Metric);
+
+    static constexpr std::array<double, (Degree + 1u) / 2u> sin = []
+    {
+        std::array<double, (Degree + 1u) / 2u> result{};
+        for (auto i = 0u; i < result.size(); ++i)
+        {
+            result[i] = sin_fit.coefficients[i];
+        }
+        return result;
+    }();
+};
+
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cmath>
+#include <tuple>
+
+namespace fs
+{
+
+// scalar reference implementations, written the obvious way with std::pow so the kernels computing the same
+// polynomials can be checked against them and their cost compared
+
+/**
+ * Baseline implementation using std::sin.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline float standard_calculator(float theta)
+{
+    return std::sin(theta);
+}
+
+/**
+ * Implementation of sine with one expansion of Maclaurin series expansion.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline float maclaurin_1_calculator(float theta)
+{
+    return theta;
+}
+
+/**
+ * Implementation of sine with two expansions of Maclaurin series expansion.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline float maclaurin_2_calculator(float theta)
+{
+    return theta - ((std::pow(theta, 3.0f) / 6.0f));
+}
+
+/**
+ * Implementation of sine with three expansions of Maclaurin series expansion.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline float maclaurin_3_calculator(float theta)
+{
+    return theta - (std::pow(theta, 3.0f) / 6.0f) + (std::pow(theta, 5.0f) / 120.0f);
+}
+
+/**
+ * Implementation of sine with four expansions of Maclaurin series expansion.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline float maclaurin_4_calculator(float theta)
+{
+    return theta - (std::pow(theta, 3.0f) / 6.0f) + (std::pow(theta, 5.0f) / 120.0f) -
+           (std::pow(theta, 7.0f) / 5040.0f);
+}
+
+/**
+ * This is the base case for the Chebyshev polynomial expansion, it just returns 1 so isn't really useful but is
+ * included for completeness.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline float chebyshev_0_calculator([[maybe_unused]] float theta)
+{
+    return 1.0f;
+}
+
+/**
+ * Implementation of sine with one expansion of Chebyshev polynomials.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline float chebyshev_1_calculator(float theta)
+{
+    return theta;
+}
+
+/**
+ * Implementation of sine with two expansions of Chebyshev polynomials.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline float chebyshev_2_calculator(float theta)
+{
+    return (2.0f * std::pow(theta, 2.0f)) - 1.0f;
+}
+
+/**
+ * Implementation of sine with three expansions of Chebyshev polynomials.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline float chebyshev_3_calculator(float theta)
+{
+    return (3.0f * std::pow(theta, 3.0f)) - (3.0f * theta);
+}
+
+/**
+ * Base implementation of calculating sine and cos, using std::sin and std::cos.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Tuple of sine and cos of input value.
+ */
+inline std::tuple<float, float> standard_sin_cos_calculator(float theta)
+{
+    return {std::sin(theta), std::cos(theta)};
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Implementation of sine using x87 instructions.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline float asm_calculator(float theta)
+{
+    float result;
+
+    asm(R"(flds %1
+           fsin
+           fstps %0)"
+        : "=m"(result)
+        : "m"(theta));
+
+    return result;
+}
+
+/**
+ * Implementation of sin and cos using one x87 instruction.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Tuple of sine and cos of input value.
+ */
+inline std::tuple<float, float> asm_sin_cos_calculator(float theta)
+{
+    float sine;
+    float cosine;
+
+    // fsincos leaves cos on top of the stack with sine below it
+    asm(R"(flds %2
+           fsincos
+           fstps %1
+           fstps %0)"
+        : "=m"(sine), "=m"(cosine)
+        : "m"(theta));
+
+    return {sine, cosine};
+}
+
+#endif
+
+}
@@ -0,0 +1,578 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "precision.h"
+
+// kernels are written once against generic vector types and then instantiated inside functions compiled for a specific
+// instruction set, everything in between has to be inlined for the wider registers to be used
+#define FS_ALWAYS_INLINE [[gnu::always_inline]] inline
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FS_TARGET_AVX2 [[gnu::target("avx2,fma,f16c")]]
+#define FS_TARGET_AVX512 [[gnu::target("avx512f,avx2,fma,f16c")]]
+#endif
+
+namespace fs::simd
+{
+
+/**
+ * Maps an element type and lane count to a vector type.
+ */
+template <class T, std::size_t N>
+struct vector_traits;
+
+template <std::size_t N>
+struct vector_traits<float, N>
+{
+    using type [[gnu::vector_size(N * sizeof(float))]] = float;
+};
+
+template <std::size_t N>
+struct vector_traits<double, N>
+{
+    using type [[gnu::vector_size(N * sizeof(double))]] = double;
+};
+
+#if defined(FS_HAS_FLOAT16)
+template <std::size_t N>
+struct vector_traits<half, N>
+{
+    using type [[gnu::vector_size(N * sizeof(half))]] = half;
+};
+#endif
+
+template <std::size_t N>
+struct vector_traits<std::uint16_t, N>
+{
+    using type [[gnu::vector_size(N * sizeof(std::uint16_t))]] = std::uint16_t;
+};
+
+template <std::size_t N>
+struct vector_traits<std::int16_t, N>
+{
+    using type [[gnu::vector_size(N * sizeof(std::int16_t))]] = std::int16_t;
+};
+
+template <std::size_t N>
+struct vector_traits<std::int32_t, N>
+{
+    using type [[gnu::vector_size(N * sizeof(std::int32_t))]] = std::int32_t;
+};
+
+template <std::size_t N>
+struct vector_traits<std::uint32_t, N>
+{
+    using type [[gnu::vector_size(N * sizeof(std::uint32_t))]] = std::uint32_t;
+};
+
+template <std::size_t N>
+struct vector_traits<std::int64_t, N>
+{
+    using type [[gnu::vector_size(N * sizeof(std::int64_t))]] = std::int64_t;
+};
+
+template <std::size_t N>
+struct vector_traits<std::uint64_t, N>
+{
+    using type [[gnu::vector_size(N * sizeof(std::uint64_t))]] = std::uint64_t;
+};
+
+/**
+ * Vector of N elements of type T.
+ */
+template <class T, std::size_t N>
+using vec = typename vector_traits<T, N>::type;
+
+/**
+ * Describes the lanes of a type, scalars are treated as a vector with a single lane.
+ */
+template <class T>
+struct lane_traits
+{
+    using element_type = T;
+    static constexpr std::size_t lanes = 1u;
+    static constexpr bool is_vector = false;
+};
+
+template <class T>
+    requires requires(T value) { value[0]; }
+struct lane_traits<T>
+{
+    using element_type = std::remove_cvref_t<decltype(std::declval<T>()[0])>;
+    static constexpr std::size_t lanes = sizeof(T) / sizeof(element_type);
+    static constexpr bool is_vector = true;
+};
+
+/**
+ * True if T is a vector type rather than a scalar.
+ */
+template <class T>
+inline constexpr bool is_vector_v = lane_traits<T>::is_vector;
+
+/**
+ * Type with the same number of lanes as T but with elements of type E, for scalars this is just E.
+ */
+template <class T, class E>
+using rebind_t = std::conditional_t<is_vector_v<T>, vec<E, lane_traits<T>::lanes>, E>;
+
+/**
+ * Signed integer the same width as a float type E, comparisons of vectors of E give masks of this type.
+ */
+template <class E>
+using int_for_t = std::conditional_t<sizeof(E) == sizeof(std::int64_t), std::int64_t, std::int32_t>;
+
+/**
+ * Type with the same lanes as the float or vector of floats T but with elements of the same width signed integer.
+ */
+template <class T>
+using bits_t = rebind_t<T, int_for_t<typename lane_traits<T>::element_type>>;
+
+/**
+ * Set every lane to the same value.
+ *
+ * @param value
+ *   Value for each lane.
+ *
+ * @returns
+ *   Value in every lane of T.
+ */
+template <class T>
+FS_ALWAYS_INLINE T broadcast(typename lane_traits<T>::element_type value)
+{
+    if constexpr (is_vector_v<T>)
+    {
+        T result;
+        for (auto i = 0u; i < lane_traits<T>::lanes; ++i)
+        {
+            result[i] = value;
+        }
+        return result;
+    }
+    else
+    {
+        return value;
+    }
+}
+
+/**
+ * Convert every lane to another element type, float to integer conversions truncate.
+ *
+ * @param value
+ *   Value to convert.
+ *
+ * @returns
+ *   Converted value.
+ */
+template <class To, class From>
+FS_ALWAYS_INLINE To convert(From value)
+{
+    if constexpr (is_vector_v<From>)
+    {
+        return __builtin_convertvector(value, To);
+    }
+    else
+    {
+        return static_cast<To>(value);
+    }
+}
+
+/**
+ * Pick between two values per lane.
+ *
+ * @param mask
+ *   Result of a comparison, for vectors each lane is either all ones or all zeros.
+ *
+ * @param if_true
+ *   Value for lanes where mask is set.
+ *
+ * @param if_false
+ *   Value for lanes where mask is clear.
+ *
+ * @returns
+ *   Selected values.
+ */
+template <class M, class T>
+FS_ALWAYS_INLINE T select(M mask, T if_true, T if_false)
+{
+    return mask ? if_true : if_false;
+}
+
+/**
+ * OR the top half of a vector into the bottom half.
+ *
+ * @param mask
+ *   Vector to fold.
+ *
+ * @returns
+ *   Vector of half the lanes.
+ */
+template <class M, std::size_t... Is>
+FS_ALWAYS_INLINE auto fold_halves(M mask, std::index_sequence<Is...>)
+{
+    return __builtin_shufflevector(mask, mask, Is...) | __builtin_shufflevector(mask, mask, (Is + sizeof...(Is))...);
+}
+
+/**
+ * Check if any lane of a mask is set. Vectors are reduced by repeatedly folding in half, which stays in vector
+ * registers rather than going through memory a lane at a time.
+ *
+ * @param mask
+ *   Result of a comparison.
+ *
+ * @returns
+ *   True if any lane is set, otherwise false.
+ */
+template <class M>
+FS_ALWAYS_INLINE bool any(M mask)
+{
+    if constexpr (!is_vector_v<M>)
+    {
+        return static_cast<bool>(mask);
+    }
+    else if constexpr (lane_traits<M>::lanes == 1u)
+    {
+        return mask[0] != 0;
+    }
+    else
+    {
+        return any(fold_halves(mask, std::make_index_sequence<lane_traits<M>::lanes / 2u>{}));
+    }
+}
+
+/**
+ * Load one table element per lane.
+ *
+ * @param table
+ *   Table to read from.
+ *
+ * @param index
+ *   Index to read for each lane, must be in bounds.
+ *
+ * @returns
+ *   Element at index in each lane.
+ */
+template <class T, class I>
+FS_ALWAYS_INLINE T gather(const typename lane_traits<T>::element_type *table, I index)
+{
+    if constexpr (is_vector_v<T>)
+    {
+        T result;
+        for (auto i = 0u; i < lane_traits<T>::lanes; ++i)
+        {
+            result[i] = table[index[i]];
+        }
+        return result;
+    }
+    else
+    {
+        return table[index];
+    }
+}
+
+/**
+ * Reinterpret the bits of a float or vector of floats as signed integers of the same width.
+ *
+ * @param value
+ *   Value to reinterpret.
+ *
+ * @returns
+ *   Bits of value.
+ */
+template <class T>
+FS_ALWAYS_INLINE bits_t<T> to_bits(T value)
+{
+    // the builtin rather than std::bit_cast, which isn't inlined in unoptimised builds and can't be called with wide
+    // vectors from a function built for a different instruction set
+    return __builtin_bit_cast(bits_t<T>, value);
+}
+
+/**
+ * Reinterpret signed integers as the bits of a float or vector of floats.
+ *
+ * @param bits
+ *   Bits to reinterpret.
+ *
+ * @returns
+ *   Float value.
+ */
+template <class T, class I>
+FS_ALWAYS_INLINE T from_bits(I bits)
+{
+    return __builtin_bit_cast(T, bits);
+}
+
+/**
+ * Absolute value of each lane, done by clearing the sign bit so it can't be changed by fast maths.
+ *
+ * @param value
+ *   Value.
+ *
+ * @returns
+ *   Absolute value.
+ */
+template <class T>
+FS_ALWAYS_INLINE T abs(T value)
+{
+    using I = int_for_t<typename lane_traits<T>::element_type>;
+    return from_bits<T>(to_bits(value) & std::numeric_limits<I>::max());
+}
+
+/**
+ * Load a vector from memory, there are no alignment requirements.
+ *
+ * @param source
+ *   Pointer to first element.
+ *
+ * @returns
+ *   Loaded vector.
+ */
+template <class V, class T>
+FS_ALWAYS_INLINE V load(const T *source)
+{
+    V value;
+    std::memcpy(&value, source, sizeof(value));
+    return value;
+}
+
+/**
+ * Store a vector to memory, there are no alignment requirements.
+ *
+ * @param destination
+ *   Pointer to write first element to.
+ *
+ * @param value
+ *   Vector to store.
+ */
+template <class V, class T>
+FS_ALWAYS_INLINE void store(T *destination, const V &value)
+{
+    // bfloat16 is trivially copyable but not trivial, which is enough for a byte copy
+    std::memcpy(static_cast<void *>(destination), &value, sizeof(value));
+}
+
+/**
+ * Load N values of a storage type and widen them to the vector type V kernels calculate in.
+ *
+ * @param source
+ *   Pointer to first value.
+ *
+ * @returns
+ *   Loaded vector.
+ */
+template <class V, class S>
+FS_ALWAYS_INLINE V load_as(const S *source)
+{
+    constexpr auto lanes = lane_traits<V>::lanes;
+
+    if constexpr (std::is_same_v<S, typename lane_traits<V>::element_type>)
+    {
+        return load<V>(source);
+    }
+    else if constexpr (std::is_same_v<S, bfloat16>)
+    {
+        // widening is just moving the bits to the top of each lane
+        return from_bits<V>(convert<vec<std::uint32_t, lanes>>(load<vec<std::uint16_t, lanes>>(source)) << 16u);
+    }
+    else
+    {
+        return convert<V>(load<vec<S, lanes>>(source));
+    }
+}
+
+/**
+ * Round a vector to a storage type and store it, there are no alignment requirements.
+ *
+ * @param destination
+ *   Pointer to write first value to.
+ *
+ * @param value
+ *   Vector to store.
+ */
+template <class S, class V>
+FS_ALWAYS_INLINE void store_as(S *destination, const V &value)
+{
+    constexpr auto lanes = lane_traits<V>::lanes;
+
+    if constexpr (std::is_same_v<S, typename lane_traits<V>::element_type>)
+    {
+        store(destination, value);
+    }
+    else if constexpr (std::is_same_v<S, bfloat16>)
+    {
+        // same rounding as the scalar bfloat16 constructor, a lane at a time would be much slower
+        using U = vec<std::uint32_t, lanes>;
+
+        const auto bits = __builtin_bit_cast(U, value);
+        const auto rounded = (bits + 0x7fffu + ((bits >> 16u) & 1u)) >> 16u;
+        const auto nan = (bits >> 16u) | 0x40u;
+        const auto result = select((bits & 0x7fffffffu) > 0x7f800000u, nan, rounded);
+
+        store(destination, convert<vec<std::uint16_t, lanes>>(result));
+    }
+    else
+    {
+        store(destination, convert<vec<S, lanes>>(value));
+    }
+}
+
+/**
+ * Apply a kernel to every input, N lanes at a time. A partial final vector is padded with zeros so every element goes
+ * through the same vector code.
+ *
+ * Kernel must provide an always inlined static evaluate function which accepts a vector of N of the type S is
+ * calculated in. Inputs stored in a narrower type are widened to that type and the results rounded back.
+ *
+ * @tparam S
+ *   Type inputs and results are stored as.
+ *
+ * @param thetas
+ *   Inputs.
+ *
+ * @param results
+ *   Where to write outputs, must be at least as large as thetas.
+ */
+template <std::size_t N, class Kernel, class S>
+FS_ALWAYS_INLINE void transform(std::span<const S> thetas, std::span<S> results)
+{
+    using V = vec<compute_t<S>, N>;
+
+    const auto count = thetas.size();
+    auto i = std::size_t{0u};
+
+    for (; i + N <= count; i += N)
+    {
+        store_as(results.data() + i, Kernel::evaluate(load_as<V>(thetas.data() + i)));
+    }
+
+    if (i < count)
+    {
+        const auto remaining = count - i;
+
+        S padded[N] = {};
+        std::memcpy(padded, thetas.data() + i, remaining * sizeof(S));
+
+        store_as(padded, Kernel::evaluate(load_as<V>(padded)));
+        std::memcpy(results.data() + i, padded, remaining * sizeof(S));
+    }
+}
+
+/**
+ * Interleave lanes from two vectors.
+ *
+ * @param a
+ *   Vector for the even lanes.
+ *
+ * @param b
+ *   Vector for the odd lanes.
+ *
+ * @returns
+ *   Vector of the same width, a[First], b[First], a[First + 1], b[First + 1]...
+ */
+template <std::size_t First, class V, std::size_t... Is>
+FS_ALWAYS_INLINE V interleave(V a, V b, std::index_sequence<Is...>)
+{
+    constexpr auto lanes = lane_traits<V>::lanes;
+    return __builtin_shufflevector(a, b, (((Is % 2u) == 0u) ? (First + (Is / 2u)) : (lanes + First + (Is / 2u)))...);
+}
+
+/**
+ * Apply a sine and cos kernel to every input, N lanes at a time, writing the results to two outputs.
+ *
+ * Kernel must provide an always inlined static evaluate_sin_cos function which accepts a vector of N of the type S is
+ * calculated in and returns a value with sin and cos members.
+ *
+ * @tparam S
+ *   Type inputs and results are stored as.
+ *
+ * @param thetas
+ *   Inputs.
+ *
+ * @param sines
+ *   Where to write sines, must be at least as large as thetas.
+ *
+ * @param cosines
+ *   Where to write cosines, must be at least as large as thetas.
+ */
+template <std::size_t N, class Kernel, class S>
+FS_ALWAYS_INLINE void transform_sin_cos(std::span<const S> thetas, std::span<S> sines, std::span<S> cosines)
+{
+    using V = vec<compute_t<S>, N>;
+
+    const auto count = thetas.size();
+    auto i = std::size_t{0u};
+
+    for (; i + N <= count; i += N)
+    {
+        const auto result = Kernel::evaluate_sin_cos(load_as<V>(thetas.data() + i));
+        store_as(sines.data() + i, result.sin);
+        store_as(cosines.data() + i, result.cos);
+    }
+
+    if (i < count)
+    {
+        const auto remaining = count - i;
+
+        S padded[N] = {};
+        std::memcpy(padded, thetas.data() + i, remaining * sizeof(S));
+
+        const auto result = Kernel::evaluate_sin_cos(load_as<V>(padded));
+
+        store_as(padded, result.sin);
+        std::memcpy(sines.data() + i, padded, remaining * sizeof(S));
+        store_as(padded, result.cos);
+        std::memcpy(cosines.data() + i, padded, remaining * sizeof(S));
+    }
+}
+
+/**
+ * Apply a sine and cos kernel to every input, N lanes at a time, writing the results as interleaved sine and cos pairs.
+ *
+ * @tparam S
+ *   Type inputs and results are stored as.
+ *
+ * @param thetas
+ *   Inputs.
+ *
+ * @param results
+ *   Where to write pairs, must be at least twice as large as thetas.
+ */
+template <std::size_t N, class Kernel, class S>
+FS_ALWAYS_INLINE void transform_sin_cos_interleaved(std::span<const S> thetas, std::span<S> results)
+{
+    using V = vec<compute_t<S>, N>;
+
+    const auto count = thetas.size();
+    auto i = std::size_t{0u};
+
+    for (; i + N <= count; i += N)
+    {
+        const auto result = Kernel::evaluate_sin_cos(load_as<V>(thetas.data() + i));
+        store_as(results.data() + (2u * i), interleave<0u>(result.sin, result.cos, std::make_index_sequence<N>{}));
+        store_as(
+            results.data() + (2u * i) + N, interleave<N / 2u>(result.sin, result.cos, std::make_index_sequence<N>{}));
+    }
+
+    if (i < count)
+    {
+        const auto remaining = count - i;
+
+        S padded[2u * N] = {};
+        std::memcpy(padded, thetas.data() + i, remaining * sizeof(S));
+
+        const auto result = Kernel::evaluate_sin_cos(load_as<V>(padded));
+
+        store_as(padded, interleave<0u>(result.sin, result.cos, std::make_index_sequence<N>{}));
+        store_as(padded + N, interleave<N / 2u>(result.sin, result.cos, std::make_index_sequence<N>{}));
+        std::memcpy(results.data() + (2u * i), padded, 2u * remaining * sizeof(S));
+    }
+}
+
+}
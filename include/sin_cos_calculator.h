@@ -0,0 +1,329 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <tuple>
+
+#include "cpu_features.h"
+#include "precision.h"
+#include "simd.h"
+
+namespace fs
+{
+
+/**
+ * Sine and cos of the same argument.
+ */
+template <class T>
+struct SinCos
+{
+    T sin;
+    T cos;
+};
+
+/**
+ * Interface for calculating sine and cos of values of type T together.
+ */
+template <class T>
+class BasicSinCosCalculator
+{
+  public:
+    /** Type of inputs and results. */
+    using value_type = T;
+
+    virtual ~BasicSinCosCalculator() = default;
+
+    /**
+     * Calculate sine and cos of an input.
+     *
+     * @param theta
+     *   Input value.
+     *
+     * @returns
+     *   Sine and cos of input value.
+     */
+    virtual std::tuple<T, T> calculate(T theta) const noexcept = 0;
+
+    /**
+     * Calculate sine and cos of every input into separate outputs. The default implementation calls the scalar overload
+     * for each element, implementations should override this with a vectorised version.
+     *
+     * @param thetas
+     *   Input values.
+     *
+     * @param sines
+     *   Where to write the sine of each input, must be at least as large as thetas.
+     *
+     * @param cosines
+     *   Where to write the cos of each input, must be at least as large as thetas.
+     */
+    virtual void calculate(std::span<const T> thetas, std::span<T> sines, std::span<T> cosines)
+        const noexcept
+    {
+        for (auto i = std::size_t{0u}; i < thetas.size(); ++i)
+        {
+            std::tie(sines[i], cosines[i]) = calculate(thetas[i]);
+        }
+    }
+
+    /**
+     * Calculate sine and cos of every input as interleaved pairs. The default implementation calls the scalar overload
+     * for each element, implementations should override this with a vectorised version.
+     *
+     * @param thetas
+     *   Input values.
+     *
+     * @param results
+     *   Where to write the sine and cos of each input one after the other, must be at least twice as large as thetas.
+     */
+    virtual void calculate(std::span<const T> thetas, std::span<T> results) const noexcept
+    {
+        for (auto i = std::size_t{0u}; i < thetas.size(); ++i)
+        {
+            std::tie(results[2u * i], results[(2u * i) + 1u]) = calculate(thetas[i]);
+        }
+    }
+};
+
+using SinCosCalculator = BasicSinCosCalculator<float>;
+
+namespace detail
+{
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * Batch sine and cos of a kernel into separate outputs using AVX-512, 16 float or 8 double lanes at a time.
+ *
+ * @param thetas
+ *   Input values.
+ *
+ * @param sines
+ *   Where to write sines.
+ *
+ * @param cosines
+ *   Where to write cosines.
+ */
+template <class Kernel, class T>
+FS_TARGET_AVX512 void batch_sin_cos_avx512(std::span<const T> thetas, std::span<T> sines, std::span<T> cosines)
+{
+    simd::transform_sin_cos<64u / sizeof(compute_t<T>), Kernel>(thetas, sines, cosines);
+}
+
+/**
+ * Batch sine and cos of a kernel into separate outputs using AVX2 and FMA, 8 float or 4 double lanes at a time.
+ *
+ * @param thetas
+ *   Input values.
+ *
+ * @param sines
+ *   Where to write sines.
+ *
+ * @param cosines
+ *   Where to write cosines.
+ */
+template <class Kernel, class T>
+FS_TARGET_AVX2 void batch_sin_cos_avx2(std::span<const T> thetas, std::span<T> sines, std::span<T> cosines)
+{
+    simd::transform_sin_cos<32u / sizeof(compute_t<T>), Kernel>(thetas, sines, cosines);
+}
+
+/**
+ * Batch interleaved sine and cos of a kernel using AVX-512, 16 float or 8 double lanes at a time.
+ *
+ * @param thetas
+ *   Input values.
+ *
+ * @param results
+ *   Where to write pairs.
+ */
+template <class Kernel, class T>
+FS_TARGET_AVX512 void batch_sin_cos_interleaved_avx512(std::span<const T> thetas, std::span<T> results)
+{
+    simd::transform_sin_cos_interleaved<64u / sizeof(compute_t<T>), Kernel>(thetas, results);
+}
+
+/**
+ * Batch interleaved sine and cos of a kernel using AVX2 and FMA, 8 float or 4 double lanes at a time.
+ *
+ * @param thetas
+ *   Input values.
+ *
+ * @param results
+ *   Where to write pairs.
+ */
+template <class Kernel, class T>
+FS_TARGET_AVX2 void batch_sin_cos_interleaved_avx2(std::span<const T> thetas, std::span<T> results)
+{
+    simd::transform_sin_cos_interleaved<32u / sizeof(compute_t<T>), Kernel>(thetas, results);
+}
+
+#endif
+
+/**
+ * Batch sine and cos of a kernel into separate outputs using the baseline vector instructions, 4 float or 2 double
+ * lanes at a time.
+ *
+ * @param thetas
+ *   Input values.
+ *
+ * @param sines
+ *   Where to write sines.
+ *
+ * @param cosines
+ *   Where to write cosines.
+ */
+template <class Kernel, class T>
+void batch_sin_cos_generic(std::span<const T> thetas, std::span<T> sines, std::span<T> cosines)
+{
+    simd::transform_sin_cos<16u / sizeof(compute_t<T>), Kernel>(thetas, sines, cosines);
+}
+
+/**
+ * Batch interleaved sine and cos of a kernel using the baseline vector instructions, 4 float or 2 double lanes at a
+ * time.
+ *
+ * @param thetas
+ *   Input values.
+ *
+ * @param results
+ *   Where to write pairs.
+ */
+template <class Kernel, class T>
+void batch_sin_cos_interleaved_generic(std::span<const T> thetas, std::span<T> results)
+{
+    simd::transform_sin_cos_interleaved<16u / sizeof(compute_t<T>), Kernel>(thetas, results);
+}
+
+/**
+ * Signature of a batch sine and cos kernel with separate outputs.
+ */
+template <class T>
+using SinCosBatchFunction = void (*)(std::span<const T>, std::span<T>, std::span<T>);
+
+/**
+ * Signature of a batch sine and cos kernel with interleaved output.
+ */
+template <class T>
+using InterleavedBatchFunction = void (*)(std::span<const T>, std::span<T>);
+
+/**
+ * Get the batch sine and cos of a kernel built for an instruction set.
+ *
+ * @param isa
+ *   Instruction set, must be supported on the current cpu.
+ *
+ * @returns
+ *   Batch function for isa, or the generic version if there isn't one for isa on this target.
+ */
+template <class Kernel, class T>
+SinCosBatchFunction<T> batch_sin_cos_for(Isa isa)
+{
+    switch (isa)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case Isa::AVX512: return batch_sin_cos_avx512<Kernel, T>;
+        case Isa::AVX2: return batch_sin_cos_avx2<Kernel, T>;
+#endif
+        default: return batch_sin_cos_generic<Kernel, T>;
+    }
+}
+
+/**
+ * Get the batch interleaved sine and cos of a kernel built for an instruction set.
+ *
+ * @param isa
+ *   Instruction set, must be supported on the current cpu.
+ *
+ * @returns
+ *   Batch function for isa, or the generic version if there isn't one for isa on this target.
+ */
+template <class Kernel, class T>
+InterleavedBatchFunction<T> batch_sin_cos_interleaved_for(Isa isa)
+{
+    switch (isa)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        case Isa::AVX512: return batch_sin_cos_interleaved_avx512<Kernel, T>;
+        case Isa::AVX2: return batch_sin_cos_interleaved_avx2<Kernel, T>;
+#endif
+        default: return batch_sin_cos_interleaved_generic<Kernel, T>;
+    }
+}
+
+}
+
+/**
+ * SinCosCalculator built from a kernel type, the batch paths are bound to variants built for a specific instruction set
+ * when the calculator is constructed.
+ *
+ * Kernel must provide an always inlined static evaluate_sin_cos function template that accepts both scalars and vectors
+ * of the type T is calculated in and returns a SinCos.
+ */
+template <class Kernel, class T = float>
+class KernelSinCosCalculator final : public BasicSinCosCalculator<T>
+{
+  public:
+    using BasicSinCosCalculator<T>::calculate;
+
+    /**
+     * Construct a new KernelSinCosCalculator bound to the fastest variant for this cpu.
+     */
+    KernelSinCosCalculator()
+        : KernelSinCosCalculator(selected_isa())
+    {
+    }
+
+    /**
+     * Construct a new KernelSinCosCalculator bound to a specific variant.
+     *
+     * @param isa
+     *   Instruction set of variant, must be supported by the current cpu.
+     */
+    explicit KernelSinCosCalculator(Isa isa)
+        : isa_(isa)
+        , batch_(detail::batch_sin_cos_for<Kernel, T>(isa))
+        , interleaved_(detail::batch_sin_cos_interleaved_for<Kernel, T>(isa))
+    {
+    }
+
+    /**
+     * Get the instruction set of the variant bound to the batch paths.
+     *
+     * @returns
+     *   Bound instruction set.
+     */
+    Isa isa() const noexcept
+    {
+        return isa_;
+    }
+
+    std::tuple<T, T> calculate(T theta) const noexcept override
+    {
+        const auto result = Kernel::evaluate_sin_cos(static_cast<compute_t<T>>(theta));
+        return {static_cast<T>(result.sin), static_cast<T>(result.cos)};
+    }
+
+    void calculate(std::span<const T> thetas, std::span<T> sines, std::span<T> cosines)
+        const noexcept override
+    {
+        batch_(thetas, sines, cosines);
+    }
+
+    void calculate(std::span<const T> thetas, std::span<T> results) const noexcept override
+    {
+        interleaved_(thetas, results);
+    }
+
+  private:
+    /** Instruction set of bound variants. */
+    Isa isa_;
+
+    /** Bound batch function with separate outputs. */
+    detail::SinCosBatchFunction<T> batch_;
+
+    /** Bound batch function with interleaved output. */
+    detail::InterleavedBatchFunction<T> interleaved_;
+};
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cassert>
+#include <concepts>
+
+#include "domain.h"
+#include "polynomial.h"
+#include "simd.h"
+#include "sine_kernel.h"
+
+namespace fs
+{
+
+/**
+ * A sine kernel which can also be evaluated on inputs known to lie in a ReducedDomain, through a static evaluate_in
+ * function template taking the domain as its first template argument.
+ */
+template <class K>
+concept ReducibleKernel = SineKernel<K> && requires(float theta, simd::vec<float, 4u> thetas) {
+    { K::template evaluate_in<ReducedDomain::PI>(theta) } -> std::same_as<float>;
+    { K::template evaluate_in<ReducedDomain::PI>(thetas) } -> std::same_as<simd::vec<float, 4u>>;
+};
+
+/**
+ * Evaluate sine of an input the caller guarantees is in a domain, doing only as much range reduction as the domain
+ * needs. Inputs outside the domain give meaningless results, builds without NDEBUG check every input and assert.
+ *
+ * @tparam D
+ *   Domain every input lies in.
+ *
+ * @tparam K
+ *   Kernel to evaluate.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+template <ReducedDomain D, ReducibleKernel K = PolynomialKernel<7u>, class T>
+FS_ALWAYS_INLINE T sin_reduced(T theta)
+{
+    assert(in_domain<D>(theta) && "input outside the domain given to sin_reduced");
+    return K::template evaluate_in<D>(theta);
+}
+
+/**
+ * Kernel which evaluates another on a restricted domain, so the restricted version can be used anywhere a SineKernel
+ * can, such as KernelCalculator. The same debug checks as sin_reduced apply.
+ */
+template <ReducibleKernel K, ReducedDomain D>
+struct DomainKernel
+{
+    /** Domain every input must lie in. */
+    static constexpr ReducedDomain domain = D;
+
+    /**
+     * Evaluate sine.
+     *
+     * @param theta
+     *   Input value in the domain, either a float, a double or a vector of either.
+     *
+     * @returns
+     *   Sine of input value.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static T evaluate(T theta)
+    {
+        return sin_reduced<D, K>(theta);
+    }
+};
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <span>
+
+#include "cpu_features.h"
+#include "precision.h"
+#include "simd.h"
+
+namespace fs
+{
+
+/**
+ * A sine kernel: a type with a static evaluate function template that accepts both a float and a vector of floats.
+ * Every kernel in this library is one, and they can be called directly instead of through the Calculator interface so
+ * the call inlines into the caller.
+ */
+template <class K>
+concept SineKernel = requires(float theta, simd::vec<float, 4u> thetas) {
+    { K::evaluate(theta) } -> std::same_as<float>;
+    { K::evaluate(thetas) } -> std::same_as<simd::vec<float, 4u>>;
+};
+
+/**
+ * Lanes of E in the widest vectors the current translation unit is compiled for.
+ */
+template <class E>
+inline constexpr std::size_t compiled_lanes_v =
+    (compiled_isa == Isa::AVX512 ? 64u : (compiled_isa == Isa::AVX2 ? 32u : 16u)) / sizeof(E);
+
+/**
+ * Evaluate a kernel on one input, with no indirection so the caller's loop can be inlined and vectorised.
+ *
+ * @tparam K
+ *   Kernel to evaluate.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+template <SineKernel K, class T>
+FS_ALWAYS_INLINE T evaluate(T theta)
+{
+    return static_cast<T>(K::evaluate(static_cast<compute_t<T>>(theta)));
+}
+
+/**
+ * Evaluate a kernel on every input, with the vector width chosen at compile time from the instruction sets the caller
+ * is built for. Unlike the batch interface of KernelCalculator there is no dispatch at all, so this can be inlined
+ * into the caller, but without -march or similar it only uses the baseline vector instructions.
+ *
+ * @tparam K
+ *   Kernel to evaluate.
+ *
+ * @param thetas
+ *   Input values.
+ *
+ * @param results
+ *   Where to write results, must be at least as large as thetas.
+ */
+template <SineKernel K, class T>
+void evaluate(std::span<const T> thetas, std::span<T> results)
+{
+    simd::transform<compiled_lanes_v<compute_t<T>>, K>(thetas, results);
+}
+
+}
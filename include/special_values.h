@@ -0,0 +1,168 @@
+#pragma once
+
+#include <bit>
+#include <limits>
+#include <type_traits>
+
+#include "simd.h"
+
+namespace fs
+{
+
+/**
+ * Largest magnitude below which sine rounds to the input and cos rounds to one in precision E, the cubic term of sine
+ * and the square term of cos are both under a quarter of an ulp.
+ */
+template <class E>
+inline constexpr E identity_limit_v = E{1} / E{8192};
+
+template <>
+inline constexpr double identity_limit_v<double> = 1.0 / 134217728.0;
+
+/**
+ * Check which lanes are close enough to zero that sine is the input, this catches zeros and denormals. The bits are
+ * compared as integers so the check works with fast maths and never touches a denormal.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @returns
+ *   Mask set for each lane with a magnitude below identity_limit_v.
+ */
+template <class T>
+FS_ALWAYS_INLINE auto below_identity_limit(T theta)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    constexpr auto limit = std::bit_cast<simd::int_for_t<E>>(identity_limit_v<E>);
+
+    return simd::to_bits(simd::abs(theta)) < limit;
+}
+
+/**
+ * Check which lanes are NaN or infinity, compared as integers so the check works with fast maths.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @returns
+ *   Mask set for each lane which isn't finite.
+ */
+template <class T>
+FS_ALWAYS_INLINE auto not_finite(T theta)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    constexpr auto infinity = std::bit_cast<simd::int_for_t<E>>(std::numeric_limits<E>::infinity());
+
+    return simd::to_bits(simd::abs(theta)) >= infinity;
+}
+
+namespace detail
+{
+
+/**
+ * Get the magnitude of each lane as unsigned integer bits, so a range of magnitudes can be checked with one compare.
+ * Subtracting the bits of the bottom of the range wraps the lanes below it round to the top, so every lane outside
+ * the range compares above its width.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @returns
+ *   Bits of theta without the sign, as unsigned integers.
+ */
+template <class T>
+FS_ALWAYS_INLINE auto unsigned_magnitude(T theta)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    using U = std::make_unsigned_t<simd::int_for_t<E>>;
+
+    return simd::from_bits<simd::rebind_t<T, U>>(simd::to_bits(simd::abs(theta)));
+}
+
+}
+
+/**
+ * Check which lanes special_sine handles, those below identity_limit_v and those which aren't finite, with a single
+ * unsigned range compare. GCC scalarises two compares ORed together for AVX-512, one compare stays in a mask register.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @returns
+ *   Mask set for each special lane.
+ */
+template <class T>
+FS_ALWAYS_INLINE auto special_inputs(T theta)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    using U = std::make_unsigned_t<simd::int_for_t<E>>;
+
+    constexpr auto limit = std::bit_cast<U>(identity_limit_v<E>);
+    constexpr auto infinity = std::bit_cast<U>(std::numeric_limits<E>::infinity());
+
+    return (detail::unsigned_magnitude(theta) - limit) >= (infinity - limit);
+}
+
+/**
+ * Overwrite the result of the general path for the lanes special_inputs picks out. Near zero sine is the input, keeping
+ * the sign of zero, and sine of NaN or infinity is NaN. Which of the two a lane gets is picked with integer operations,
+ * so there is only the one mask from special_inputs.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @param result
+ *   Result of the general path with the special lanes zeroed.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+template <class T>
+FS_ALWAYS_INLINE T special_sine(T theta, T result)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    using U = std::make_unsigned_t<simd::int_for_t<E>>;
+
+    // of the special lanes only NaN and infinity have the top exponent bit set, shifting it down to the quiet bit turns
+    // infinity into NaN and leaves the small lanes as they are
+    constexpr auto shift = (sizeof(U) * 8u) - std::numeric_limits<E>::digits;
+    constexpr auto quiet = std::bit_cast<U>(std::numeric_limits<E>::quiet_NaN()) &
+                           ~std::bit_cast<U>(std::numeric_limits<E>::infinity());
+
+    const auto bits = simd::from_bits<simd::rebind_t<T, U>>(simd::to_bits(theta));
+    const auto special = simd::from_bits<T>(bits | ((bits >> shift) & quiet));
+
+    return simd::select(special_inputs(theta), special, result);
+}
+
+/**
+ * Overwrite the result of the general path for the lanes special_inputs picks out, the same as special_sine. Near
+ * zero cos is one.
+ *
+ * @param theta
+ *   Input value, either a float, a double or a vector of either.
+ *
+ * @param result
+ *   Result of the general path with the special lanes zeroed.
+ *
+ * @returns
+ *   Cos of input value.
+ */
+template <class T>
+FS_ALWAYS_INLINE T special_cos(T theta, T result)
+{
+    using E = typename simd::lane_traits<T>::element_type;
+    using I = simd::int_for_t<E>;
+
+    // the top exponent bit spread over the lane picks NaN for NaN and infinity, the bits of one are a subset of NaN
+    constexpr auto one = std::bit_cast<I>(E{1});
+    constexpr auto nan = std::bit_cast<I>(std::numeric_limits<E>::quiet_NaN());
+    static_assert((one | nan) == nan, "one must be a subset of the quiet NaN");
+
+    const auto top_exponent = (simd::to_bits(theta) << 1) >> ((sizeof(I) * 8u) - 1u);
+    const auto special = simd::from_bits<T>(one | (top_exponent & nan));
+
+    return simd::select(special_inputs(theta), special, result);
+}
+
+}
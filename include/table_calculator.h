@@ -0,0 +1,286 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+
+#include "constexpr_sine.h"
+#include "domain.h"
+#include "kernel_calculator.h"
+#include "range_reduction.h"
+#include "simd.h"
+#include "special_values.h"
+
+namespace fs
+{
+
+/**
+ * How values between table entries are found.
+ */
+enum class Interpolation
+{
+    /** Straight line to the next entry, using a slope stored alongside each entry. */
+    LINEAR,
+
+    /** Cubic through this entry and the next, using the value and derivative stored for each. */
+    HERMITE
+};
+
+/**
+ * Kernel for sine from a table of one period.
+ *
+ * The argument is reduced to [-pi, pi] and scaled to a table position, the table is built at compile time and holds two
+ * floats per entry so the table is 8 * Size bytes: 256 entries is 2KB, 1024 is 8KB and 4096 is 32KB, which all fit in
+ * L1 on current cpus. Evaluating in double uses a separate table of doubles, twice the size.
+ *
+ * Inputs near zero, including denormals, give the input and NaN or infinity give NaN, the same as PolynomialKernel.
+ */
+template <std::size_t Size, Interpolation I = Interpolation::LINEAR>
+struct TableKernel
+{
+    static_assert(std::has_single_bit(Size) && (Size >= 16u), "size must be a power of two and at least sixteen");
+
+    /** Number of entries, hermite interpolation needs a copy of the first entry at the end. */
+    static constexpr std::size_t entries = I == Interpolation::LINEAR ? Size : Size + 1u;
+
+    /** Distance between entries. */
+    static constexpr double step = 2.0 * std::numbers::pi / static_cast<double>(Size);
+
+    /** Scale from a reduced argument to a table position, rounded to E. */
+    template <class E>
+    static constexpr E position_scale = static_cast<E>(1.0 / step);
+
+    /**
+     * Leading part of the step, with few enough bits that its product with any entry number is exact in E, so t stays
+     * accurate near the top of the table.
+     */
+    template <class E>
+    static constexpr E step_a = static_cast<E>(static_cast<double>(static_cast<std::int64_t>(step * 4096.0)) / 4096.0);
+
+    /** Remainder of the step after step_a, rounded to E. */
+    template <class E>
+    static constexpr E step_b = static_cast<E>(step - static_cast<double>(step_a<E>));
+
+    /**
+     * For each entry the value and either the difference to the next value or the derivative scaled by the step,
+     * calculated in double with constexpr_sin_cos and rounded to E.
+     */
+    template <class E>
+    static constexpr std::array<E, 2u * entries> table_for = []
+    {
+        std::array<E, 2u * entries> result{};
+
+        for (auto i = 0u; i < entries; ++i)
+        {
+            const auto angle = step * static_cast<double>(i % Size);
+            const auto value = constexpr_sin_cos(angle);
+
+            result[2u * i] = static_cast<E>(value.sin);
+
+            if constexpr (I == Interpolation::LINEAR)
+            {
+                const auto next = constexpr_sin(step * static_cast<double>((i + 1u) % Size));
+                result[(2u * i) + 1u] = static_cast<E>(next - value.sin);
+            }
+            else
+            {
+                result[(2u * i) + 1u] = static_cast<E>(value.cos * step);
+            }
+        }
+
+        return result;
+    }();
+
+    /** Table used when evaluating in float. */
+    static constexpr const auto &table = table_for<float>;
+
+    /** Size of the float table in bytes. */
+    static constexpr std::size_t footprint = sizeof(table);
+
+    /**
+     * Interpolate from a table entry.
+     *
+     * @param index
+     *   Index of the value of the entry in each lane, twice the entry number.
+     *
+     * @param t
+     *   Position past the entry in units of the step, in [0, 1).
+     *
+     * @returns
+     *   Interpolated sine.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static T interpolate(simd::bits_t<T> index, T t)
+    {
+        using E = typename simd::lane_traits<T>::element_type;
+
+        constexpr auto &values = table_for<E>;
+
+        const T p0 = simd::gather<T>(values.data(), index);
+        const T m0 = simd::gather<T>(values.data(), index + 1);
+
+        if constexpr (I == Interpolation::LINEAR)
+        {
+            return p0 + (t * m0);
+        }
+        else
+        {
+            const T p1 = simd::gather<T>(values.data(), index + 2);
+            const T m1 = simd::gather<T>(values.data(), index + 3);
+
+            // hermite basis collected into powers of t
+            const T c2 = ((p1 - p0) * E{3}) - (m0 * E{2}) - m1;
+            const T c3 = ((p0 - p1) * E{2}) + m0 + m1;
+
+            return p0 + (t * (m0 + (t * (c2 + (t * c3)))));
+        }
+    }
+
+    /**
+     * Look up an already reduced argument.
+     *
+     * @param r
+     *   Argument in [-pi, pi].
+     *
+     * @returns
+     *   Sine of argument.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static T lookup(T r)
+    {
+        using E = typename simd::lane_traits<T>::element_type;
+        using Index = simd::bits_t<T>;
+
+        constexpr auto scale = position_scale<E>;
+
+        constexpr auto mask = static_cast<simd::int_for_t<E>>(Size - 1u);
+
+        const T position = r * scale;
+        const Index truncated = simd::convert<Index>(position);
+        const Index whole = simd::select(position < simd::convert<T>(truncated), truncated - 1, truncated);
+        const T k = simd::convert<T>(whole);
+        const T t = ((r - (k * step_a<E>)) - (k * step_b<E>)) * scale;
+
+        return interpolate((whole & mask) * 2, t);
+    }
+
+    /**
+     * Look up a phase, where 2^32 is a full turn. The top bits of the phase are the entry and the rest the position
+     * past it, so there is no reduction and no rounding before the table is read.
+     *
+     * @tparam T
+     *   Type to calculate in, either a float, a double or a vector of either.
+     *
+     * @param phase
+     *   Phase, either a std::uint32_t or a vector of them with as many lanes as T.
+     *
+     * @returns
+     *   Sine of phase.
+     */
+    template <class T, class P>
+    FS_ALWAYS_INLINE static T evaluate_phase(P phase)
+    {
+        using E = typename simd::lane_traits<T>::element_type;
+
+        constexpr auto shift = 32u - static_cast<unsigned>(std::countr_zero(Size));
+        constexpr auto fraction_mask = (std::uint32_t{1u} << shift) - 1u;
+        constexpr auto fraction_scale = static_cast<E>(1.0 / static_cast<double>(std::uint64_t{1u} << shift));
+
+        const T t = simd::convert<T>(phase & fraction_mask) * fraction_scale;
+        return interpolate(simd::convert<simd::bits_t<T>>(phase >> shift) * 2, t);
+    }
+
+    /**
+     * Sine of an argument too large for Cody-Waite reduction.
+     *
+     * @param theta
+     *   Input value, either a float or a double.
+     *
+     * @returns
+     *   Sine of input value.
+     */
+    template <class E>
+    static E evaluate_large(E theta)
+    {
+        if (!(simd::abs(theta) <= std::numeric_limits<E>::max()))
+        {
+            return std::numeric_limits<E>::quiet_NaN();
+        }
+
+        const auto reduced = reduce_payne_hanek(theta);
+
+        auto angle = reduced.remainder + (static_cast<double>(reduced.quadrant) * (std::numbers::pi / 2.0));
+        if (angle > std::numbers::pi)
+        {
+            angle -= 2.0 * std::numbers::pi;
+        }
+
+        return lookup(static_cast<E>(angle));
+    }
+
+    /**
+     * Evaluate sine.
+     *
+     * @param theta
+     *   Input value, either a float, a double or a vector of either.
+     *
+     * @returns
+     *   Sine of input value.
+     */
+    template <class T>
+    FS_ALWAYS_INLINE static T evaluate(T theta)
+    {
+        using L = simd::lane_traits<T>;
+
+        const auto large = finite_beyond_cody_waite(theta);
+
+        auto result = lookup(reduce_two_pi(cody_waite_inputs(theta)));
+
+        if (simd::any(large)) [[unlikely]]
+        {
+            if constexpr (L::is_vector)
+            {
+                for (auto i = 0u; i < L::lanes; ++i)
+                {
+                    if (large[i] != 0)
+                    {
+                        result[i] = evaluate_large(theta[i]);
+                    }
+                }
+            }
+            else
+            {
+                result = evaluate_large(theta);
+            }
+        }
+
+        return special_sine(theta, result);
+    }
+
+    /**
+     * Evaluate sine of an input known to lie in a domain. The table position wraps at a period, so every domain is
+     * looked up directly with no reduction or check for large arguments.
+     *
+     * @tparam D
+     *   Domain theta lies in.
+     *
+     * @param theta
+     *   Input value, either a float, a double or a vector of either.
+     *
+     * @returns
+     *   Sine of input value.
+     */
+    template <ReducedDomain D, class T>
+    FS_ALWAYS_INLINE static T evaluate_in(T theta)
+    {
+        return lookup(theta);
+    }
+};
+
+template <std::size_t Size, Interpolation I = Interpolation::LINEAR, class T = float>
+using TableCalculator = KernelCalculator<TableKernel<Size, I>, T>;
+
+}
@@ -0,0 +1,533 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "calculator.h"
+#include "output.h"
+#include "sweep.h"
+#include "thread_pool.h"
+
+namespace fs::harness
+{
+
+/**
+ * Options controlling an exhaustive accuracy check over float bit patterns.
+ */
+struct AccuracyOptions
+{
+    /** First bit pattern to check. */
+    std::uint64_t first = 0u;
+
+    /** Number of bit patterns to check. */
+    std::uint64_t count = std::uint64_t{1u} << 32u;
+
+    /** Number of bit patterns in each unit of work, rounded down to a power of two no larger than a binade. */
+    std::uint64_t chunk_size = std::uint64_t{1u} << 20u;
+
+    /** Number of inputs calculated at once. */
+    std::size_t block_size = 4096u;
+};
+
+/**
+ * Number of bins in an ulp histogram. Bin zero is errors below half an ulp, bin one is below one ulp and each bin after
+ * that doubles, with the last bin holding everything larger.
+ */
+inline constexpr std::size_t ulp_histogram_bins = 24u;
+
+/**
+ * Get the histogram bin for an ulp error.
+ *
+ * @param ulps
+ *   Error in ulps, must not be NaN.
+ *
+ * @returns
+ *   Bin index.
+ */
+inline std::size_t ulp_bin(double ulps)
+{
+    if (ulps < 0.5)
+    {
+        return 0u;
+    }
+
+    auto bin = std::size_t{1u};
+    for (auto limit = 1.0; (ulps >= limit) && (bin + 1u < ulp_histogram_bins); limit *= 2.0)
+    {
+        ++bin;
+    }
+
+    return bin;
+}
+
+/**
+ * Get the lower bound of a histogram bin.
+ *
+ * @param bin
+ *   Bin index.
+ *
+ * @returns
+ *   Smallest ulp error in bin.
+ */
+inline double ulp_bin_lower(std::size_t bin)
+{
+    return bin == 0u ? 0.0 : std::ldexp(1.0, static_cast<int>(bin) - 2);
+}
+
+/**
+ * Calculate the distance between a float result and a higher precision reference, in units in the last place of the
+ * reference rounded to float.
+ *
+ * @param result
+ *   Calculated value.
+ *
+ * @param reference
+ *   Reference value.
+ *
+ * @returns
+ *   Error in ulps, zero if both are NaN and NaN if only one is or if the result is not finite but the reference is.
+ */
+inline double ulp_error(float result, double reference)
+{
+    const auto result_nan = is_nan(result);
+    const auto reference_nan = is_nan(reference);
+
+    if (result_nan || reference_nan)
+    {
+        return result_nan == reference_nan ? 0.0 : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    const auto difference = std::fabs(static_cast<double>(result) - reference);
+    if (difference == 0.0)
+    {
+        return 0.0;
+    }
+
+    if (!(difference <= std::numeric_limits<double>::max()))
+    {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    // a float ulp is 2^-23 of the power of two at or below the value, and never smaller than the smallest denormal
+    auto exponent = -149 + 24;
+    if (reference != 0.0)
+    {
+        std::frexp(reference, &exponent);
+    }
+    const auto ulp = std::ldexp(1.0, std::max(exponent - 24, -149));
+
+    return difference / ulp;
+}
+
+/**
+ * Calculate the error of a result relative to the magnitude of its reference.
+ *
+ * @param absolute
+ *   Absolute error of result.
+ *
+ * @param reference
+ *   Reference value.
+ *
+ * @returns
+ *   Relative error, zero if both are zero and infinity if only the reference is.
+ */
+inline double relative_error(double absolute, double reference)
+{
+    if (absolute == 0.0)
+    {
+        return 0.0;
+    }
+
+    return reference == 0.0 ? std::numeric_limits<double>::infinity() : absolute / std::fabs(reference);
+}
+
+/**
+ * Running statistics of ulp error, along with the largest absolute and relative errors, kept without storing any per
+ * sample data.
+ */
+struct UlpStats
+{
+    /** Number of results compared. */
+    std::uint64_t compared = 0u;
+
+    /** Number of results where only one of the calculator and reference was NaN, or the result was infinite. */
+    std::uint64_t mismatches = 0u;
+
+    /** Largest error seen, in ulps. */
+    double max_ulp = 0.0;
+
+    /** Input which produced max_ulp. */
+    float max_ulp_input = 0.0f;
+
+    /** Sum of all errors. */
+    double sum_ulp = 0.0;
+
+    /** Sum of the squares of all errors. */
+    double sum_squared_ulp = 0.0;
+
+    /** Count of errors in each ulp_bin. */
+    std::array<std::uint64_t, ulp_histogram_bins> histogram = {};
+
+    /** Largest absolute error seen. */
+    double max_absolute = 0.0;
+
+    /** Largest error relative to the magnitude of the reference. */
+    double max_relative = 0.0;
+
+    /**
+     * Get the mean error.
+     *
+     * @returns
+     *   Mean error in ulps.
+     */
+    double mean_ulp() const
+    {
+        return compared == 0u ? 0.0 : sum_ulp / static_cast<double>(compared);
+    }
+
+    /**
+     * Get the root mean square error.
+     *
+     * @returns
+     *   RMS error in ulps.
+     */
+    double rms_ulp() const
+    {
+        return compared == 0u ? 0.0 : std::sqrt(sum_squared_ulp / static_cast<double>(compared));
+    }
+
+    /**
+     * Add a single error.
+     *
+     * @param input
+     *   Input that produced the error.
+     *
+     * @param ulps
+     *   Error in ulps, NaN indicates a mismatch.
+     *
+     * @param absolute
+     *   Absolute error, ignored for a mismatch.
+     *
+     * @param relative
+     *   Relative error, ignored for a mismatch.
+     */
+    void add(float input, double ulps, double absolute, double relative)
+    {
+        if (is_nan(ulps))
+        {
+            ++mismatches;
+            return;
+        }
+
+        ++compared;
+        sum_ulp += ulps;
+        sum_squared_ulp += ulps * ulps;
+        ++histogram[ulp_bin(ulps)];
+        max_absolute = std::max(max_absolute, absolute);
+        max_relative = std::max(max_relative, relative);
+
+        if (ulps > max_ulp)
+        {
+            max_ulp = ulps;
+            max_ulp_input = input;
+        }
+    }
+
+    /**
+     * Merge in statistics from a later part of a check. Merging in order gives the same result regardless of how the
+     * check was split up.
+     *
+     * @param other
+     *   Statistics to merge.
+     */
+    void merge(const UlpStats &other)
+    {
+        compared += other.compared;
+        mismatches += other.mismatches;
+        sum_ulp += other.sum_ulp;
+        sum_squared_ulp += other.sum_squared_ulp;
+
+        for (auto i = 0u; i < histogram.size(); ++i)
+        {
+            histogram[i] += other.histogram[i];
+        }
+
+        max_absolute = std::max(max_absolute, other.max_absolute);
+        max_relative = std::max(max_relative, other.max_relative);
+
+        if (other.max_ulp > max_ulp)
+        {
+            max_ulp = other.max_ulp;
+            max_ulp_input = other.max_ulp_input;
+        }
+    }
+};
+
+/**
+ * Result of an accuracy check.
+ */
+struct AccuracyResult
+{
+    /** Statistics over every input checked. */
+    UlpStats total;
+
+    /** Statistics for each binade, indexed by the biased exponent of the input so both signs share a binade. */
+    std::array<UlpStats, 256u> binades;
+};
+
+namespace detail
+{
+
+/**
+ * Check a range of float bit patterns across a thread pool, using the supplied function to calculate each block.
+ *
+ * Chunks are aligned so none crosses a binade, which means each chunk only needs one set of statistics. They are merged
+ * in order so the results are the same for any number of threads.
+ *
+ * @param calculate_block
+ *   Function called with the inputs of a block and where to write the results.
+ *
+ * @param reference
+ *   Function giving the higher precision result to compare against.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for check.
+ *
+ * @returns
+ *   Combined result of check.
+ */
+template <class CalculateBlock, class Ref>
+AccuracyResult check_blocks(
+    CalculateBlock calculate_block,
+    Ref reference,
+    ThreadPool &pool,
+    const AccuracyOptions &options)
+{
+    constexpr auto binade_size = std::uint64_t{1u} << 23u;
+
+    const auto chunk_size = std::bit_floor(std::clamp<std::uint64_t>(options.chunk_size, 1u, binade_size));
+    const auto block_size = std::max<std::size_t>(options.block_size, 1u);
+    const auto end = options.first + options.count;
+
+    // chunk boundaries are multiples of chunk_size, the first and last may be partial
+    const auto first_chunk = options.first / chunk_size;
+    const auto chunk_count =
+        options.count == 0u ? std::size_t{0u} : static_cast<std::size_t>(((end - 1u) / chunk_size) - first_chunk + 1u);
+
+    auto chunk_stats = std::vector<UlpStats>(chunk_count);
+
+    pool.parallel_for(
+        chunk_count,
+        [&](std::size_t chunk, std::size_t)
+        {
+            auto thetas = std::vector<float>(block_size);
+            auto results = std::vector<float>(block_size);
+
+            const auto chunk_first = std::max(options.first, (first_chunk + chunk) * chunk_size);
+            const auto chunk_end = std::min(end, (first_chunk + chunk + 1u) * chunk_size);
+
+            for (auto block_first = chunk_first; block_first < chunk_end; block_first += block_size)
+            {
+                const auto size =
+                    static_cast<std::size_t>(std::min<std::uint64_t>(block_size, chunk_end - block_first));
+                const auto in = std::span{thetas}.first(size);
+                const auto out = std::span{results}.first(size);
+
+                for (auto i = std::size_t{0u}; i < size; ++i)
+                {
+                    in[i] = std::bit_cast<float>(static_cast<std::uint32_t>(block_first + i));
+                }
+
+                calculate_block(std::span<const float>{in}, out);
+
+                for (auto i = std::size_t{0u}; i < size; ++i)
+                {
+                    const auto expected = static_cast<double>(reference(in[i]));
+                    const auto absolute = std::fabs(static_cast<double>(out[i]) - expected);
+
+                    chunk_stats[chunk].add(
+                        in[i], ulp_error(out[i], expected), absolute, relative_error(absolute, expected));
+                }
+            }
+        });
+
+    auto result = AccuracyResult{};
+
+    for (auto chunk = std::size_t{0u}; chunk < chunk_count; ++chunk)
+    {
+        const auto pattern = static_cast<std::uint32_t>((first_chunk + chunk) * chunk_size);
+        const auto binade = (pattern >> 23u) & 0xffu;
+
+        result.binades[binade].merge(chunk_stats[chunk]);
+        result.total.merge(chunk_stats[chunk]);
+    }
+
+    return result;
+}
+
+}
+
+/**
+ * Reference sine for accuracy checks, computed in double precision.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+inline double reference_sin(float theta)
+{
+    return std::sin(static_cast<double>(theta));
+}
+
+/**
+ * Check the ulp error of a function over a range of float bit patterns.
+ *
+ * @param calculator
+ *   Function to check.
+ *
+ * @param reference
+ *   Function giving the higher precision result to compare against.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for check.
+ *
+ * @returns
+ *   Combined result of check.
+ */
+template <std::invocable<float> F, class Ref>
+AccuracyResult check_accuracy(F calculator, Ref reference, ThreadPool &pool, const AccuracyOptions &options = {})
+{
+    return detail::check_blocks(
+        [&](std::span<const float> thetas, std::span<float> results)
+        {
+            for (auto i = std::size_t{0u}; i < thetas.size(); ++i)
+            {
+                results[i] = calculator(thetas[i]);
+            }
+        },
+        reference,
+        pool,
+        options);
+}
+
+/**
+ * Check the ulp error of a Calculator over a range of float bit patterns, using its batch interface.
+ *
+ * @param calculator
+ *   Calculator to check.
+ *
+ * @param reference
+ *   Function giving the higher precision result to compare against.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for check.
+ *
+ * @returns
+ *   Combined result of check.
+ */
+template <class Ref>
+AccuracyResult check_accuracy(
+    const Calculator &calculator,
+    Ref reference,
+    ThreadPool &pool,
+    const AccuracyOptions &options = {})
+{
+    return detail::check_blocks(
+        [&calculator](std::span<const float> thetas, std::span<float> results)
+        { calculator.calculate(thetas, results); },
+        reference,
+        pool,
+        options);
+}
+
+/** Step between the inputs written by write_data. */
+inline constexpr auto data_interval = 0.00001f;
+
+/**
+ * Number of samples written by write_data, found by running the same accumulation so the sample points match exactly.
+ *
+ * @returns
+ *   Number of samples.
+ */
+inline std::size_t data_sample_count()
+{
+    auto count = std::size_t{0u};
+    auto f = 0.0f;
+
+    do
+    {
+        ++count;
+        f += data_interval;
+    } while (f <= 2.0f * std::numbers::pi_v<float>);
+
+    return count;
+}
+
+/**
+ * Calculate the difference between a reference and a supplied function over one period, write each difference out to
+ * a binary file.
+ *
+ * @param file_name
+ *   Name of file to write diffs to.
+ *
+ * @param calculator
+ *   Function to compare with reference.
+ *
+ * @param reference
+ *   Function to compare against.
+ *
+ * @param format
+ *   How to write the file.
+ *
+ * @returns
+ *   Largest difference written.
+ *
+ * @throws std::system_error
+ *   If the file can't be written.
+ */
+template <std::invocable<float> F, class Ref>
+double write_data(const std::string &file_name, F calculator, Ref reference, OutputFormat format)
+{
+    static const auto count = data_sample_count();
+
+    // differences go straight into the mapped file rather than through a write per float
+    auto out = OutputFile{file_name, count, format};
+    const auto data = out.data();
+
+    auto max_error = 0.0;
+    auto f = 0.0f;
+
+    for (auto &r : data)
+    {
+        r = std::fabs(calculator(f) - reference(f));
+        max_error = std::max(max_error, static_cast<double>(r));
+        f += data_interval;
+    }
+
+    out.close();
+
+    return max_error;
+}
+
+}
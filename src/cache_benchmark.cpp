@@ -0,0 +1,265 @@
+#include "cache_benchmark.h"
+
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numbers>
+#include <random>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "calculator.h"
+#include "cpu_features.h"
+#include "kernel_calculator.h"
+#include "polynomial.h"
+#include "registry.h"
+#include "scalar_calculators.h"
+
+namespace
+{
+
+/** Seed for every distribution, so runs can be compared. */
+constexpr auto seed = std::uint32_t{0x5eed5eedu};
+
+/**
+ * Draw angles uniformly from [-pi, pi), the worst case for a cache.
+ *
+ * @param count
+ *   Number of angles.
+ *
+ * @returns
+ *   Angles.
+ */
+std::vector<float> uniform_angles(std::size_t count)
+{
+    auto engine = std::mt19937{seed};
+    auto distribution = std::uniform_real_distribution<float>{-std::numbers::pi_v<float>, std::numbers::pi_v<float>};
+
+    auto angles = std::vector<float>(count);
+    for (auto &angle : angles)
+    {
+        angle = distribution(engine);
+    }
+
+    return angles;
+}
+
+/**
+ * Draw angles from a whole number of steps around the circle, using a weight for each step.
+ *
+ * @param count
+ *   Number of angles.
+ *
+ * @param weights
+ *   Relative weight of each step, the number of weights is the number of steps.
+ *
+ * @returns
+ *   Angles.
+ */
+std::vector<float> step_angles(std::size_t count, const std::vector<double> &weights)
+{
+    auto engine = std::mt19937{seed};
+    auto distribution = std::discrete_distribution<std::size_t>{weights.begin(), weights.end()};
+
+    const auto step = 2.0 * std::numbers::pi / static_cast<double>(weights.size());
+
+    auto angles = std::vector<float>(count);
+    for (auto &angle : angles)
+    {
+        angle = static_cast<float>((static_cast<double>(distribution(engine)) * step) - std::numbers::pi);
+    }
+
+    return angles;
+}
+
+/**
+ * Draw angles uniformly from [-pi, pi), each repeated a number of times in a row, like a signal held between updates.
+ *
+ * @param count
+ *   Number of angles.
+ *
+ * @param run
+ *   Number of times each angle is repeated.
+ *
+ * @returns
+ *   Angles.
+ */
+std::vector<float> repeated_angles(std::size_t count, std::size_t run)
+{
+    auto angles = uniform_angles(count);
+    for (auto i = std::size_t{0u}; i < count; ++i)
+    {
+        angles[i] = angles[i - (i % run)];
+    }
+
+    return angles;
+}
+
+/**
+ * Time a loop over every input.
+ *
+ * @param label
+ *   What the loop calculates with.
+ *
+ * @param compute
+ *   Function taking the inputs and where to write the results.
+ *
+ * @param inputs
+ *   Inputs.
+ *
+ * @param expected
+ *   Results of the uncached calculator to compare against, or empty to not compare.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter.
+ *
+ * @returns
+ *   Timing of loop and the results it wrote.
+ */
+template <class F>
+std::pair<fs::harness::CacheRun, std::vector<float>> run_loop(
+    std::string label,
+    F compute,
+    std::span<const float> inputs,
+    std::span<const float> expected,
+    bool use_cycle_counter)
+{
+    auto results = std::vector<float>(inputs.size());
+    auto mismatches = std::size_t{0u};
+
+    const auto timing = fs::harness::time_and_check(
+        [&](std::span<float> out) { compute(inputs, out); },
+        std::span{results},
+        use_cycle_counter,
+        [&](std::size_t i, float result)
+        {
+            if ((i < expected.size()) &&
+                (std::bit_cast<std::uint32_t>(result) != std::bit_cast<std::uint32_t>(expected[i])))
+            {
+                ++mismatches;
+            }
+        });
+
+    return {
+        fs::harness::CacheRun{.label = std::move(label), .timing = timing, .stats = {}, .mismatches = mismatches},
+        std::move(results)};
+}
+
+/**
+ * Time a calculator over some inputs, then the same calculator behind a cache one input at a time and through the
+ * batch path.
+ *
+ * @param name
+ *   Name of calculator.
+ *
+ * @param calculator
+ *   Calculator to wrap.
+ *
+ * @param inputs
+ *   Inputs.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter.
+ *
+ * @param runs
+ *   Where to add the three runs.
+ */
+void run_calculator(
+    const std::string &name,
+    const std::shared_ptr<const fs::Calculator> &calculator,
+    std::span<const float> inputs,
+    bool use_cycle_counter,
+    std::vector<fs::harness::CacheRun> &runs)
+{
+    auto [uncached, expected] = run_loop(
+        name,
+        [&](std::span<const float> in, std::span<float> out) { calculator->calculate(in, out); },
+        inputs,
+        {},
+        use_cycle_counter);
+    runs.push_back(std::move(uncached));
+
+    // the one at a time path of a calculator can round differently from its batch path
+    auto expected_scalar = std::vector<float>(inputs.size());
+    for (auto i = std::size_t{0u}; i < inputs.size(); ++i)
+    {
+        expected_scalar[i] = calculator->calculate(inputs[i]);
+    }
+
+    {
+        const auto cached = fs::CachedCalculator<>{calculator};
+        auto run = run_loop(
+                       "cached " + name,
+                       [&](std::span<const float> in, std::span<float> out)
+                       {
+                           for (auto i = std::size_t{0u}; i < in.size(); ++i)
+                           {
+                               out[i] = cached.calculate(in[i]);
+                           }
+                       },
+                       inputs,
+                       expected_scalar,
+                       use_cycle_counter)
+                       .first;
+        run.stats = cached.stats();
+        runs.push_back(std::move(run));
+    }
+
+    {
+        const auto cached = fs::CachedCalculator<>{calculator};
+        auto run = run_loop(
+                       "cached " + name + " batch",
+                       [&](std::span<const float> in, std::span<float> out) { cached.calculate(in, out); },
+                       inputs,
+                       expected,
+                       use_cycle_counter)
+                       .first;
+        run.stats = cached.stats();
+        runs.push_back(std::move(run));
+    }
+}
+
+}
+
+namespace fs::harness
+{
+
+std::vector<CacheDistribution> benchmark_cache(const CacheOptions &options)
+{
+    const auto use_cycle_counter = options.use_cycle_counter && has_cycle_counter();
+
+    auto zipf = std::vector<double>(64u);
+    for (auto i = std::size_t{0u}; i < zipf.size(); ++i)
+    {
+        zipf[i] = 1.0 / static_cast<double>(i + 1u);
+    }
+
+    auto distributions = std::vector<std::pair<std::string, std::vector<float>>>{};
+    distributions.emplace_back("uniform", uniform_angles(options.count));
+    distributions.emplace_back("8 steps", step_angles(options.count, std::vector<double>(8u, 1.0)));
+    distributions.emplace_back("zipf over 64 steps", step_angles(options.count, zipf));
+    distributions.emplace_back("runs of 16", repeated_angles(options.count, 16u));
+
+    const auto isa = selected_isa();
+    const auto standard = std::make_shared<const detail::FunctionCalculator<standard_calculator>>();
+    const auto polynomial = std::make_shared<const KernelCalculator<PolynomialKernel<7u>>>(isa);
+
+    auto results = std::vector<CacheDistribution>{};
+
+    for (const auto &[name, inputs] : distributions)
+    {
+        auto &result = results.emplace_back(name);
+
+        run_calculator("standard", standard, inputs, use_cycle_counter, result.runs);
+        run_calculator(
+            "polynomial_7 " + std::string{to_string(isa)}, polynomial, inputs, use_cycle_counter, result.runs);
+    }
+
+    return results;
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "cached_calculator.h"
+#include "timing.h"
+
+namespace fs::harness
+{
+
+/**
+ * Options for measuring CachedCalculator on skewed inputs.
+ */
+struct CacheOptions
+{
+    /** Number of inputs drawn from each distribution. */
+    std::size_t count = std::size_t{1u} << 22u;
+
+    /** Whether to also read the cpu cycle counter. */
+    bool use_cycle_counter = true;
+};
+
+/**
+ * Result of one loop of the cache benchmark.
+ */
+struct CacheRun
+{
+    /** What the loop calculates with. */
+    std::string label;
+
+    /** Time for the whole loop. */
+    Timing timing;
+
+    /** Hits and misses, zero for the uncached loops. */
+    CacheStats stats;
+
+    /** Number of results whose bits differ from the same path of the uncached calculator, which should be zero. */
+    std::size_t mismatches = 0u;
+};
+
+/**
+ * Results of the cache benchmark over one distribution of inputs.
+ */
+struct CacheDistribution
+{
+    /** Name of distribution. */
+    std::string name;
+
+    /**
+     * Three loops for each wrapped calculator, its own batch path, a cache of one line one input at a time and the same
+     * cache through its batch path, in that order.
+     */
+    std::vector<CacheRun> runs;
+};
+
+/**
+ * Time std::sin and the vector polynomial with and without a CachedCalculator in front of them, over uniform inputs and
+ * over inputs where a few angles recur, such as a fixed number of rotation steps. Each cached loop starts from an
+ * empty cache.
+ *
+ * @param options
+ *   Inputs to time over.
+ *
+ * @returns
+ *   Result of each distribution.
+ */
+std::vector<CacheDistribution> benchmark_cache(const CacheOptions &options);
+
+}
@@ -0,0 +1,165 @@
+#include "device_benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "device.h"
+#include "thread_pool.h"
+
+namespace
+{
+
+/**
+ * Time a function once.
+ *
+ * @param function
+ *   Function to time.
+ *
+ * @param elements
+ *   Number of elements the function calculates.
+ *
+ * @returns
+ *   Timing of function.
+ */
+template <class F>
+fs::harness::Timing time_once(F function, std::size_t elements)
+{
+    const auto use_cycle_counter = fs::harness::has_cycle_counter();
+
+    const auto start_cycles = use_cycle_counter ? fs::harness::read_cycle_counter() : 0u;
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    function();
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    const auto end_cycles = use_cycle_counter ? fs::harness::read_cycle_counter() : 0u;
+
+    auto timing = fs::harness::Timing{};
+    timing.total = end - start;
+    timing.cycles = end_cycles - start_cycles;
+    timing.elements = elements;
+
+    return timing;
+}
+
+/**
+ * Sweep a device kernel. The CUDA backend spreads each sweep across the device, but the host fallback calculates on
+ * the calling thread, so for it the range is split into chunks swept across the pool and merged in order, giving the
+ * same errors for any number of threads.
+ *
+ * @param kernel
+ *   Kernel to sweep.
+ *
+ * @param first
+ *   First bit pattern.
+ *
+ * @param count
+ *   Number of bit patterns.
+ *
+ * @param pool
+ *   Thread pool to run the host fallback on.
+ *
+ * @returns
+ *   Errors of sweep.
+ */
+fs::harness::ErrorStats sweep_device(
+    fs::device::DeviceKernel kernel,
+    std::uint64_t first,
+    std::uint64_t count,
+    fs::harness::ThreadPool &pool)
+{
+    const auto chunk_size =
+        fs::device::backend() == "host" ? std::uint64_t{1u} << 20u : std::max<std::uint64_t>(count, 1u);
+    const auto chunk_count = static_cast<std::size_t>((count + chunk_size - 1u) / chunk_size);
+
+    auto chunk_errors = std::vector<fs::harness::ErrorStats>(chunk_count);
+
+    pool.parallel_for(
+        chunk_count,
+        [&](std::size_t chunk, std::size_t)
+        {
+            const auto chunk_first = first + (chunk * chunk_size);
+            const auto errors =
+                fs::device::sweep(kernel, chunk_first, std::min(chunk_size, first + count - chunk_first));
+
+            chunk_errors[chunk] = {
+                .compared = errors.compared,
+                .nan_mismatches = errors.nan_mismatches,
+                .max_error = errors.max_error,
+                .max_error_input = errors.max_error_input,
+                .sum_error = errors.sum_error};
+        });
+
+    auto errors = fs::harness::ErrorStats{};
+    for (const auto &chunk : chunk_errors)
+    {
+        errors.merge(chunk);
+    }
+
+    return errors;
+}
+
+}
+
+namespace fs::harness
+{
+
+std::vector<DeviceRun> benchmark_device(const DeviceOptions &options, ThreadPool &pool)
+{
+    const auto inputs = spread_inputs(options.sweep_first, options.sweep_count, options.count);
+    auto results = std::vector<float>(inputs.size());
+
+    auto thetas = device::Buffer{inputs.size()};
+    auto outputs = device::Buffer{inputs.size()};
+
+    auto runs = std::vector<DeviceRun>{};
+
+    for (const auto kernel : device::all_kernels)
+    {
+        auto run = DeviceRun{
+            .name = std::string{device::to_string(kernel)},
+            .compute = {},
+            .with_transfer = {},
+            .sweep_time = std::chrono::nanoseconds{0},
+            .errors = {}};
+
+        const auto calculate = [&] { device::calculate(kernel, thetas.data(), outputs.data(), inputs.size()); };
+
+        // the first launch pays for setting up the device and copying the kernel constants
+        thetas.upload(inputs);
+        calculate();
+
+        run.compute = time_once(calculate, inputs.size());
+        run.with_transfer = time_once(
+            [&]
+            {
+                thetas.upload(inputs);
+                calculate();
+                outputs.download(results);
+            },
+            inputs.size());
+
+        escape(results.data());
+
+        if (options.sweep)
+        {
+            const auto start = std::chrono::high_resolution_clock::now();
+            run.errors = sweep_device(kernel, options.sweep_first, options.sweep_count, pool);
+            const auto end = std::chrono::high_resolution_clock::now();
+
+            run.sweep_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+        }
+
+        runs.push_back(std::move(run));
+    }
+
+    return runs;
+}
+
+}
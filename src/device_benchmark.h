@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "sweep.h"
+#include "thread_pool.h"
+#include "timing.h"
+
+namespace fs::harness
+{
+
+/**
+ * Options for timing the device backend.
+ */
+struct DeviceOptions
+{
+    /** Number of inputs in the bulk run. */
+    std::size_t count = std::size_t{1u} << 24u;
+
+    /** First float bit pattern of the sweep, the bulk inputs are also spread over the sweep range. */
+    std::uint64_t sweep_first = 0u;
+
+    /** Number of float bit patterns in the sweep. */
+    std::uint64_t sweep_count = std::uint64_t{1u} << 32u;
+
+    /** Whether to also sweep each kernel on the device. */
+    bool sweep = true;
+};
+
+/**
+ * Result of running one kernel on the device backend.
+ */
+struct DeviceRun
+{
+    /** Name of kernel. */
+    std::string name;
+
+    /** Time to calculate the bulk inputs once they are on the device. */
+    Timing compute;
+
+    /** Time to copy the bulk inputs to the device, calculate, and copy the results back. */
+    Timing with_transfer;
+
+    /** Time to sweep, zero if not swept. */
+    std::chrono::nanoseconds sweep_time = std::chrono::nanoseconds{0};
+
+    /** Errors of the sweep against sine in double. */
+    ErrorStats errors;
+};
+
+/**
+ * Run every device kernel over preloaded inputs, timing the calculation with and without the copies to and from the
+ * device, then sweep each one with the errors reduced on the device. The difference between the two timings shows how
+ * much work must already be on the device for offloading to pay off.
+ *
+ * @param options
+ *   What to run.
+ *
+ * @param pool
+ *   Thread pool the host fallback sweeps on.
+ *
+ * @returns
+ *   Result for each kernel.
+ *
+ * @throws std::runtime_error
+ *   If the device fails.
+ */
+std::vector<DeviceRun> benchmark_device(const DeviceOptions &options, ThreadPool &pool);
+
+}
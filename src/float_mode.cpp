@@ -0,0 +1,70 @@
+#include "float_mode.h"
+
+#include <cstdint>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/** MXCSR bits for flush to zero and denormals are zero. */
+constexpr auto flush_bits = 0x8040u;
+
+#elif defined(__aarch64__)
+
+/** FPCR bit for flush to zero, which on arm64 also treats denormal inputs as zero. */
+constexpr auto flush_bits = std::uint64_t{1u} << 24u;
+
+#endif
+
+}
+
+namespace fs::harness
+{
+
+std::string_view to_string(FlushMode mode)
+{
+    switch (mode)
+    {
+        case FlushMode::KEEP: return "keep";
+        case FlushMode::OFF: return "off";
+        case FlushMode::ON: return "on";
+        case FlushMode::BOTH: return "both";
+    }
+
+    return "unknown";
+}
+
+bool flush_denormals_supported()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool set_flush_denormals(bool enabled)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    const auto csr = _mm_getcsr();
+    _mm_setcsr(enabled ? (csr | flush_bits) : (csr & ~flush_bits));
+
+    return (csr & flush_bits) == flush_bits;
+#elif defined(__aarch64__)
+    const auto fpcr = __builtin_aarch64_get_fpcr64();
+    __builtin_aarch64_set_fpcr64(enabled ? (fpcr | flush_bits) : (fpcr & ~flush_bits));
+
+    return (fpcr & flush_bits) != 0u;
+#else
+    static_cast<void>(enabled);
+    return false;
+#endif
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string_view>
+
+namespace fs::harness
+{
+
+/**
+ * How the harness sets flush to zero and denormals are zero on the threads that time benchmarks.
+ */
+enum class FlushMode
+{
+    /** Leave the mode the process started with, fast maths builds start with both set. */
+    KEEP,
+
+    /** Clear both. */
+    OFF,
+
+    /** Set both. */
+    ON,
+
+    /** Time every benchmark with both cleared and again with both set. */
+    BOTH
+};
+
+/**
+ * Get the name of a flush mode.
+ *
+ * @param mode
+ *   Flush mode.
+ *
+ * @returns
+ *   Name of mode.
+ */
+std::string_view to_string(FlushMode mode);
+
+/**
+ * Check if the target lets the harness flush denormals, SSE on x86 has both flags and the FZ bit on arm64 covers both.
+ *
+ * @returns
+ *   True if set_flush_denormals has any effect.
+ */
+bool flush_denormals_supported();
+
+/**
+ * Set or clear flush to zero and denormals are zero for the calling thread. Denormal results and inputs of float
+ * instructions are then treated as zero, which skips the microcode assists some cpus take for them.
+ *
+ * @param enabled
+ *   Whether to flush denormals.
+ *
+ * @returns
+ *   Whether denormals were flushed before the call.
+ */
+bool set_flush_denormals(bool enabled);
+
+}
@@ -0,0 +1,92 @@
+#include "grid_benchmark.h"
+
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cpu_features.h"
+#include "grid_generator.h"
+#include "scalar_calculators.h"
+
+namespace
+{
+
+/**
+ * Time computing a grid, then compare every point to the reference.
+ *
+ * @param label
+ *   How the grid is computed.
+ *
+ * @param compute
+ *   Function filling a span with the sine of each grid point.
+ *
+ * @param options
+ *   Grid to compute.
+ *
+ * @returns
+ *   Timing and errors of compute.
+ */
+template <class F>
+fs::harness::GridRun run_grid(std::string label, F compute, const fs::harness::GridOptions &options)
+{
+    auto results = std::vector<float>(options.count);
+    auto errors = fs::harness::ErrorStats{};
+    auto standard_errors = fs::harness::ErrorStats{};
+
+    const auto timing = fs::harness::time_and_check(
+        compute,
+        std::span{results},
+        options.use_cycle_counter && fs::harness::has_cycle_counter(),
+        [&](std::size_t i, float result)
+        {
+            const auto theta = static_cast<long double>(options.start) +
+                               (static_cast<long double>(i) * static_cast<long double>(options.step));
+            const auto error = std::fabs(static_cast<long double>(result) - std::sin(theta));
+
+            errors.add(static_cast<float>(theta), static_cast<double>(error));
+
+            const auto point = static_cast<float>(options.start + (static_cast<double>(i) * options.step));
+            standard_errors.add(point, fs::harness::absolute_error(result, fs::standard_calculator(point)));
+        });
+
+    return fs::harness::GridRun{
+        .label = std::move(label),
+        .timing = timing,
+        .errors = errors,
+        .standard_errors = standard_errors};
+}
+
+}
+
+namespace fs::harness
+{
+
+std::vector<GridRun> benchmark_grid(const GridOptions &options)
+{
+    const auto generator = GridGenerator<float>{};
+
+    auto runs = std::vector<GridRun>{};
+
+    runs.push_back(run_grid(
+        "grid generate " + std::string{to_string(generator.isa())},
+        [&](std::span<float> results) { generator.generate(options.start, options.step, results); },
+        options));
+    runs.push_back(run_grid(
+        "grid standard per point",
+        [&](std::span<float> results)
+        {
+            for (auto i = std::size_t{0u}; i < results.size(); ++i)
+            {
+                const auto theta = options.start + (static_cast<double>(i) * options.step);
+                results[i] = standard_calculator(static_cast<float>(theta));
+            }
+        },
+        options));
+
+    return runs;
+}
+
+}
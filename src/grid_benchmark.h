@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "accuracy.h"
+#include "sweep.h"
+#include "timing.h"
+
+namespace fs::harness
+{
+
+/**
+ * Options for timing sine over an evenly spaced grid.
+ */
+struct GridOptions
+{
+    /** First grid point. */
+    double start = 0.0;
+
+    /** Distance between grid points, the same step write_data takes. */
+    double step = data_interval;
+
+    /** Number of grid points. */
+    std::size_t count = std::size_t{1u} << 22u;
+
+    /** Whether to also read the cpu cycle counter. */
+    bool use_cycle_counter = true;
+};
+
+/**
+ * Result of computing the grid one way.
+ */
+struct GridRun
+{
+    /** How the grid was computed. */
+    std::string label;
+
+    /** Time to compute the whole grid. */
+    Timing timing;
+
+    /** Error of every point against the sine of the exact grid point. */
+    ErrorStats errors;
+
+    /** Error of every point against standard_calculator at the grid point rounded to float. */
+    ErrorStats standard_errors;
+};
+
+/**
+ * Compute sine over a grid with GridGenerator and with std::sin at each point, timing both and comparing every point
+ * to a long double reference at the exact grid point. Rounding each point to float before calling std::sin is part of
+ * the per point cost and error, as it is for callers who accumulate the argument in float. Every point is also compared
+ * to standard_calculator at the rounded point, which is what replacing a per point loop would change.
+ *
+ * @param options
+ *   Grid to compute.
+ *
+ * @returns
+ *   Result of the generator followed by the result of std::sin.
+ */
+std::vector<GridRun> benchmark_grid(const GridOptions &options);
+
+}
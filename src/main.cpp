@@ -1,300 +1,1160 @@
 #include <iostream>
 
+#include <algorithm>
 #include <bit>
 #include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <fstream>
 #include <limits>
+#include <memory>
 #include <numbers>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
 #include <tuple>
+#include <utility>
+#include <vector>
 
-using namespace std::chrono_literals;
+#include "accuracy.h"
+#include "cache_benchmark.h"
+#include "chebyshev_calculator.h"
+#include "cpu_features.h"
+#include "device.h"
+#include "device_benchmark.h"
+#include "float_mode.h"
+#include "domain.h"
+#include "grid_benchmark.h"
+#include "maclaurin_calculator.h"
+#include "options.h"
+#include "output.h"
+#include "perf_counters.h"
+#include "phase.h"
+#include "polynomial.h"
+#include "precision.h"
+#include "registry.h"
+#include "results.h"
+#include "runner.h"
+#include "scalar_calculators.h"
+#include "scaling_benchmark.h"
+#include "selector.h"
+#include "statistics.h"
+#include "sweep.h"
+#include "table_calculator.h"
+#include "thread_pool.h"
+#include "timing.h"
+#include "transform.h"
+#include "workload.h"
+#include "x87_benchmark.h"
 
 namespace
 {
 
 /**
- * Baseline implementation using std::sin.
+ * Print the result of sweeping a calculator.
  *
- * @param theta
- *   Input value.
+ * @param name
+ *   Name of calculator.
  *
- * @returns
- *   Sine of input value.
+ * @param result
+ *   Result to print.
  */
-float standard_calculator(float theta)
+void print_sweep(const std::string &name, const fs::harness::SweepResult &result)
 {
-    return std::sin(theta);
+    const auto &timing = result.timing;
+
+    std::cout << name << ": " << timing.total.count() << "ns (";
+
+    if (timing.below_baseline())
+    {
+        std::cout << "below baseline";
+    }
+    else
+    {
+        std::cout << timing.ns_per_element() << " ns/element";
+
+        if (timing.cycles != 0u)
+        {
+            std::cout << ", " << timing.cycles_per_element() << " cycles/element";
+        }
+    }
+
+    std::cout << ", " << result.elements_per_second() << " elements/s on " << result.threads << " threads"
+              << ", max error " << result.errors.max_error << ", mean error " << result.errors.mean_error() << ")\n";
 }
 
 /**
- * Implementation of sine using x87 instructions.
+ * Check whether a sweep only covers inputs which a kernel's declared error bound holds for, those in both the accuracy
+ * data period and the kernel's domain.
  *
- * @param theta
- *   Input value.
+ * @param kernel
+ *   Kernel being swept.
+ *
+ * @param first
+ *   First float bit pattern of the sweep.
+ *
+ * @param count
+ *   Number of bit patterns in the sweep.
  *
  * @returns
- *   Sine of input value.
+ *   True if the bound applies to every input of the sweep.
  */
-float asm_calculator(float theta)
+bool sweep_within_bound(const fs::harness::Kernel &kernel, std::uint64_t first, std::uint64_t count)
 {
-    float result;
-
-    asm(R"(flds %1
-           fsin
-           fstps %0)"
-        : "=m"(result)
-        : "m"(theta));
+    // positive floats order the same as their bits, so the ends of the sweep bound every input in it
+    const auto last = first + count - 1u;
+    if ((count == 0u) || (last > std::bit_cast<std::uint32_t>(2.0f * std::numbers::pi_v<float>)))
+    {
+        return false;
+    }
 
-    return result;
+    return (std::bit_cast<float>(static_cast<std::uint32_t>(first)) >= kernel.low) &&
+           (std::bit_cast<float>(static_cast<std::uint32_t>(last)) <= kernel.high);
 }
 
 /**
- * Implementation of sine with one expansion of Maclaurin series expansion.
+ * Print the summary of every repetition of a benchmark.
  *
- * @param theta
- *   Input value.
- *
- * @returns
- *   Sine of input value.
+ * @param summary
+ *   Summary of ns/element.
  */
-float maclaurin_1_calculator(float theta)
+void print_summary(const fs::harness::Summary &summary)
 {
-    return theta;
+    std::cout << "  median " << summary.median << " ns/element, p5 " << summary.p5 << ", p95 " << summary.p95
+              << ", MAD " << summary.mad << " over " << summary.samples << " repetitions\n";
 }
 
 /**
- * Implementation of sine with two expansions of Maclaurin series expansion.
+ * Print the result of timing a benchmark in one mode, using the median of the repetitions.
  *
- * @param theta
- *   Input value.
- *
- * @returns
- *   Sine of input value.
+ * @param run
+ *   Result to print.
  */
-float maclaurin_2_calculator(float theta)
+void print_mode(const fs::harness::ModeRun &run)
 {
-    return theta - ((std::pow(theta, 3.0f) / 6.0f));
+    std::cout << "  " << (run.mode == fs::harness::TimingMode::LATENCY ? "latency" : "reciprocal throughput") << " ";
+
+    // a clamped zero would read as free, not as a baseline that was more than the whole run
+    if (run.below_baseline == run.ns_per_element.samples)
+    {
+        std::cout << "below baseline";
+    }
+    else
+    {
+        std::cout << run.ns_per_element.median << " ns";
+
+        if (run.cycles_per_element.samples != 0u)
+        {
+            std::cout << ", " << run.cycles_per_element.median << " cycles";
+        }
+
+        if (run.below_baseline != 0u)
+        {
+            std::cout << ", below baseline in " << run.below_baseline << " of " << run.ns_per_element.samples
+                      << " repetitions";
+        }
+    }
+
+    std::cout << "\n";
+
+    if (run.counters.empty())
+    {
+        return;
+    }
+
+    const auto print_value = [](const std::optional<double> &value)
+    {
+        if (value)
+        {
+            std::cout << *value;
+        }
+        else
+        {
+            std::cout << "n/a";
+        }
+    };
+
+    std::cout << "    per element:";
+
+    for (const auto counter : fs::harness::all_counters)
+    {
+        std::cout << " " << fs::harness::to_string(counter) << " ";
+        print_value(run.counters.per_element(counter));
+    }
+
+    std::cout << ", ipc ";
+    print_value(run.counters.ipc());
+    std::cout << "\n";
 }
 
 /**
- * Implementation of sine with three expansions of Maclaurin series expansion.
- *
- * @param theta
- *   Input value.
+ * Print the comparison of a benchmark against an earlier run.
  *
- * @returns
- *   Sine of input value.
+ * @param comparison
+ *   Comparison to print.
  */
-float maclaurin_3_calculator(float theta)
+void print_comparison(const fs::harness::Comparison &comparison)
 {
-    return theta - (std::pow(theta, 3.0f) / 6.0f) + (std::pow(theta, 5.0f) / 120.0f);
+    std::cout << "  vs baseline " << comparison.baseline_median << " ns/element: " << std::showpos
+              << (comparison.relative_change * 100.0) << std::noshowpos << "%, p " << comparison.p_value << ", "
+              << fs::harness::to_string(comparison.change) << "\n";
 }
 
 /**
- * Implementation of sine with four expansions of Maclaurin series expansion.
+ * Print the result of computing a grid.
  *
- * @param theta
- *   Input value.
- *
- * @returns
- *   Sine of input value.
+ * @param run
+ *   Result to print.
  */
-float maclaurin_4_calculator(float theta)
+void print_grid(const fs::harness::GridRun &run)
 {
-    return theta - (std::pow(theta, 3.0f) / 6.0f) + (std::pow(theta, 5.0f) / 120.0f) -
-           (std::pow(theta, 7.0f) / 5040.0f);
+    const auto &timing = run.timing;
+
+    std::cout << run.label << ": " << timing.ns_per_element() << " ns/element";
+
+    if (timing.cycles != 0u)
+    {
+        std::cout << ", " << timing.cycles_per_element() << " cycles/element";
+    }
+
+    std::cout << ", max error " << run.errors.max_error << " at " << run.errors.max_error_input << ", mean error "
+              << run.errors.mean_error() << ", against standard per point max error " << run.standard_errors.max_error
+              << " at " << run.standard_errors.max_error_input << ", mean error " << run.standard_errors.mean_error()
+              << " over " << timing.elements << " points\n";
 }
 
 /**
- * This is the base case for the Chebyshev polynomial expansion, it just returns 1 so isn't really useful but is
- * included for completeness.
+ * Get the headline time of a benchmark, from the sweep if it was run and otherwise from the first timing mode.
  *
- * @param theta
- *   Input value.
+ * @param run
+ *   Result of benchmark.
  *
  * @returns
- *   Sine of input value.
+ *   Median ns/element, zero if nothing was timed.
  */
-float chebyshev_0_calculator(float theta)
+double ns_per_element(const fs::harness::BenchmarkRun &run)
 {
-    return 1.0f;
+    if (!run.repetitions.empty())
+    {
+        return run.representative().timing.ns_per_element();
+    }
+
+    return run.modes.empty() ? 0.0 : run.modes.front().ns_per_element.median;
 }
 
 /**
- * Implementation of sine with one expansion of Chebyshev polynomials.
+ * Print the result of one loop of the x87 benchmark.
  *
- * @param theta
- *   Input value.
+ * @param run
+ *   Result to print.
  *
- * @returns
- *   Sine of input value.
+ * @param reference
+ *   Loop to compare the time against, or null for none.
  */
-float chebyshev_1_calculator(float theta)
+void print_mixed(const fs::harness::MixedRun &run, const fs::harness::MixedRun *reference)
 {
-    return theta;
+    const auto &timing = run.timing;
+
+    std::cout << run.label << ": " << timing.ns_per_element() << " ns/element";
+
+    if (timing.cycles != 0u)
+    {
+        std::cout << ", " << timing.cycles_per_element() << " cycles/element";
+    }
+
+    if ((reference != nullptr) && (reference != &run) && (reference->timing.ns_per_element() > 0.0))
+    {
+        std::cout << ", " << (timing.ns_per_element() / reference->timing.ns_per_element()) << " times "
+                  << reference->label;
+    }
+
+    std::cout << ", max error " << run.errors.max_error << " at " << run.errors.max_error_input << "\n";
 }
 
 /**
- * Implementation of sine with two expansions of Chebyshev polynomials.
+ * Print the result of one loop of the cache benchmark.
  *
- * @param theta
- *   Input value.
+ * @param run
+ *   Result to print.
  *
- * @returns
- *   Sine of input value.
+ * @param reference
+ *   Uncached loop to compare the time against, or the run itself for none.
  */
-float chebyshev_2_calculator(float theta)
+void print_cached(const fs::harness::CacheRun &run, const fs::harness::CacheRun &reference)
 {
-    return (2.0f * std::pow(theta, 2.0f)) - 1.0f;
+    const auto &timing = run.timing;
+
+    std::cout << run.label << ": " << timing.ns_per_element() << " ns/element";
+
+    if (timing.cycles != 0u)
+    {
+        std::cout << ", " << timing.cycles_per_element() << " cycles/element";
+    }
+
+    if (&reference != &run)
+    {
+        if (reference.timing.ns_per_element() > 0.0)
+        {
+            std::cout << ", " << (timing.ns_per_element() / reference.timing.ns_per_element()) << " times "
+                      << reference.label;
+        }
+
+        std::cout << ", hit rate " << run.stats.hit_rate() << ", " << run.mismatches << " mismatches";
+    }
+
+    std::cout << "\n";
 }
 
 /**
- * Implementation of sine with three expansions of Chebyshev polynomials.
+ * Print the results of the scaling benchmark for one kernel, followed by the thread count it scaled best to.
  *
- * @param theta
- *   Input value.
- *
- * @returns
- *   Sine of input value.
+ * @param result
+ *   Result to print.
  */
-float chebyshev_3_calculator(float theta)
+void print_scaling(const fs::harness::ScalingResult &result)
 {
-    return (3.0f * std::pow(theta, 3.0f)) - (3.0f * theta);
+    std::cout << result.name << "\n";
+
+    const auto *fastest = static_cast<const fs::harness::ScalingRun *>(nullptr);
+
+    for (const auto &run : result.runs)
+    {
+        std::cout << "  " << run.threads << " threads" << (run.pinned ? " pinned" : "") << ", "
+                  << fs::harness::to_string(run.placement) << " buffers";
+
+        if (run.nodes != 0u)
+        {
+            std::cout << " on " << run.nodes << (run.nodes == 1u ? " node" : " nodes");
+        }
+
+        std::cout << ": " << std::chrono::duration<double, std::milli>(run.total).count() << " ms, speedup "
+                  << run.speedup << ", efficiency " << run.efficiency() << ", " << run.bytes_per_second() / 1e9
+                  << " GB/s\n";
+
+        if ((fastest == nullptr) || (run.speedup > fastest->speedup))
+        {
+            fastest = &run;
+        }
+    }
+
+    if (fastest != nullptr)
+    {
+        std::cout << "  best speedup " << fastest->speedup << " at " << fastest->threads << " threads with "
+                  << fs::harness::to_string(fastest->placement) << " buffers\n";
+    }
 }
 
 /**
- * Base implementation of calculating sine and cosm, using std::sin and std::cos.
- *
- * @param theta
- *   Input value.
+ * Print the result of running a kernel on the device backend.
  *
- * @returns
- *   Tuple of sine and cos of input value.
+ * @param run
+ *   Result to print.
  */
-std::tuple<float, float> standard_sin_cos_calculator(float theta)
+void print_device(const fs::harness::DeviceRun &run)
 {
-    return {std::sin(theta), std::cos(theta)};
+    std::cout << run.name << " on " << fs::device::backend() << ": " << run.compute.ns_per_element()
+              << " ns/element on device, " << run.with_transfer.ns_per_element() << " ns/element with transfer over "
+              << run.compute.elements << " inputs\n";
+
+    if (run.sweep_time.count() == 0)
+    {
+        return;
+    }
+
+    const auto seconds = std::chrono::duration<double>(run.sweep_time).count();
+
+    std::cout << "  sweep " << run.sweep_time.count() << "ns ("
+              << (static_cast<double>(run.errors.compared + run.errors.nan_mismatches) / seconds)
+              << " elements/s, max error " << run.errors.max_error << " at " << run.errors.max_error_input
+              << ", mean error " << run.errors.mean_error() << " over " << run.errors.compared << " inputs";
+
+    if (run.errors.nan_mismatches != 0u)
+    {
+        std::cout << ", " << run.errors.nan_mismatches << " nan mismatches";
+    }
+
+    std::cout << ")\n";
 }
 
 /**
- * Implementation of sin and cos using one x87 instruction.
+ * Print ulp statistics on a single line.
  *
- * @param theta
- *   Input value.
+ * @param label
+ *   Label for statistics.
  *
- * @returns
- *   Tuple of sine and cos of input value.
+ * @param stats
+ *   Statistics to print.
  */
-std::tuple<float, float> asm_sin_cos_calculator(float theta)
+void print_ulp_stats(const std::string &label, const fs::harness::UlpStats &stats)
 {
-    float r1;
-    float r2;
+    std::cout << label << ": max " << stats.max_ulp << " ulp at " << stats.max_ulp_input << ", mean "
+              << stats.mean_ulp() << ", rms " << stats.rms_ulp() << " over " << stats.compared << " inputs";
 
-    asm(R"(flds %2
-           fsincos
-           fstps %0
-           fstps %1)"
-        : "=m"(r1), "=m"(r2)
-        : "m"(theta));
+    if (stats.mismatches != 0u)
+    {
+        std::cout << ", " << stats.mismatches << " mismatches";
+    }
 
-    return {r1, r2};
+    std::cout << "\n";
 }
 
 /**
- * Time how long it takes for a function to calculate every possible float.
+ * Print the result of an accuracy check, with the histogram and a line for each binade that was checked.
  *
- * @param calculator
- *   Function to time.
+ * @param name
+ *   Name of calculator.
  *
- * @returns
- *   Number of nanoseconds spend executing function for all floats.
+ * @param result
+ *   Result to print.
  */
-template <class F>
-std::chrono::nanoseconds time_calculations(F calculator)
+void print_accuracy(const std::string &name, const fs::harness::AccuracyResult &result)
 {
-    auto time = 0ns;
+    print_ulp_stats(name, result.total);
 
-    for (std::size_t i = 0u; i < std::numeric_limits<std::uint32_t>::max(); ++i)
+    for (auto bin = 0u; bin < fs::harness::ulp_histogram_bins; ++bin)
     {
-        const auto n = static_cast<std::uint32_t>(i);
-        const auto f = std::bit_cast<float>(n);
+        if (result.total.histogram[bin] != 0u)
+        {
+            std::cout << "  >= " << fs::harness::ulp_bin_lower(bin) << " ulp: " << result.total.histogram[bin] << "\n";
+        }
+    }
 
-        const auto start = std::chrono::high_resolution_clock::now();
-        const volatile auto r = calculator(f);
-        const auto end = std::chrono::high_resolution_clock::now();
+    for (auto binade = 0; binade < static_cast<int>(result.binades.size()); ++binade)
+    {
+        const auto &stats = result.binades[binade];
 
-        time += end - start;
+        if ((stats.compared + stats.mismatches) != 0u)
+        {
+            print_ulp_stats("  binade " + std::to_string(binade - 127), stats);
+        }
     }
+}
 
-    return time;
+/**
+ * Print the measurements of a kernel over a domain.
+ *
+ * @param entry
+ *   Measurements to print.
+ */
+void print_selection_entry(const fs::harness::SelectionEntry &entry)
+{
+    std::cout << "  " << entry.name << ": " << entry.ns_per_element << " ns/element, max error " << entry.max_absolute
+              << " absolute, " << entry.max_relative << " relative, " << entry.max_ulp << " ulp\n";
 }
 
+// lowest degree with a relative error of at most 1e-6 before rounding the coefficients to float
+constexpr auto budget_degree = fs::remez::minimal_degree(1e-6, fs::remez::ErrorMetric::RELATIVE);
+
 /**
- * Calculate the difference between the base line function and a supplied function, write each difference out to a
- * binary file.
+ * Register the polynomial, table and sine and cos kernels instantiated for a type other than float.
  *
- * @param file_name
- *   Name of file to write diffs to.
+ * @param registry
+ *   Registry to add kernels to.
+ */
+template <class T>
+void register_precision_kernels(fs::harness::Registry &registry)
+{
+    const auto suffix = "_" + std::string{fs::precision_traits<T>::name};
+    const auto degree = std::to_string(fs::PrecisionPolynomial<T>::degree);
+
+    // 4096 cubic segments interpolate to around 1.5e-14, which only shows in double
+    constexpr auto table_bound = std::max(fs::epsilon_v<T>, 2e-14);
+
+    registry.add_calculator(
+        "polynomial_" + degree + suffix, std::make_unique<fs::PrecisionPolynomialCalculator<T>>(), fs::epsilon_v<T>);
+    registry.add_calculator(
+        "table_4096_hermite" + suffix,
+        std::make_unique<fs::TableCalculator<4096u, fs::Interpolation::HERMITE, T>>(),
+        table_bound);
+    registry.add_sin_cos_calculator(
+        "polynomial_" + degree + "_sincos" + suffix,
+        std::make_unique<fs::PrecisionPolynomialSinCosCalculator<T>>(),
+        fs::epsilon_v<T>);
+}
+
+/**
+ * Register every kernel the harness knows about.
  *
- * @param calculator
- *   Function to compare with baseline.
+ * @param registry
+ *   Registry to add kernels to.
  */
-void write_data(const std::string &file_name, float (*calculator)(float))
+void register_kernels(fs::harness::Registry &registry)
 {
-    std::ofstream out{file_name, std::ios::out | std::ios::binary};
+    constexpr auto unbounded = std::numeric_limits<double>::infinity();
+
+    registry.add_function<fs::standard_calculator>("standard", 0.0);
+#if defined(__x86_64__) || defined(__i386__)
+    registry.add_function<fs::asm_calculator>("asm", 1.2e-7);
+#endif
+
+    registry.add_function<fs::maclaurin_1_calculator>(
+        "maclaurin_1", 6.3, std::make_unique<fs::MaclaurinCalculator<1u>>());
+    registry.add_function<fs::maclaurin_2_calculator>(
+        "maclaurin_2", 36.0, std::make_unique<fs::MaclaurinCalculator<2u>>());
+    registry.add_function<fs::maclaurin_3_calculator>(
+        "maclaurin_3", 47.0, std::make_unique<fs::MaclaurinCalculator<3u>>());
+    registry.add_function<fs::maclaurin_4_calculator>(
+        "maclaurin_4", 31.0, std::make_unique<fs::MaclaurinCalculator<4u>>());
+
+    // these aren't approximations of sine so there is nothing to hold them to
+    registry.add_function<fs::chebyshev_0_calculator>(
+        "chebyshev_0", unbounded, std::make_unique<fs::ChebyshevCalculator<0u>>());
+    registry.add_function<fs::chebyshev_1_calculator>(
+        "chebyshev_1", unbounded, std::make_unique<fs::ChebyshevCalculator<1u>>());
+    registry.add_function<fs::chebyshev_2_calculator>(
+        "chebyshev_2", unbounded, std::make_unique<fs::ChebyshevCalculator<2u>>());
+    registry.add_function<fs::chebyshev_3_calculator>(
+        "chebyshev_3", unbounded, std::make_unique<fs::ChebyshevCalculator<3u>>());
 
-    static const float interval = 0.00001f;
-    auto f = 0.0f;
+    registry.add_calculator("polynomial_5", std::make_unique<fs::PolynomialCalculator<5u>>(), 1.2e-6);
+    registry.add_kernel<fs::PolynomialKernel<7u>>("polynomial_7", 1.2e-7);
+    registry.add_calculator("polynomial_9", std::make_unique<fs::PolynomialCalculator<9u>>(), 1.2e-7);
+    registry.add_calculator(
+        "polynomial_9_estrin", std::make_unique<fs::PolynomialCalculator<9u, fs::Scheme::ESTRIN>>(), 1.2e-7);
+    using TaylorKernel = fs::PolynomialKernel<7u, fs::Scheme::HORNER, fs::TaylorCoefficients<7u>>;
+    registry.add_calculator("polynomial_7_taylor", std::make_unique<fs::KernelCalculator<TaylorKernel>>(), 4e-7);
+    registry.add_calculator("polynomial_budget", std::make_unique<fs::PolynomialCalculator<budget_degree>>(), 1e-6);
 
-    do
+    // the same kernel pinned to each instruction set, for comparing the variants on one machine
+    for (const auto isa : {fs::Isa::GENERIC, fs::Isa::AVX2, fs::Isa::AVX512})
     {
-        const auto r = std::fabs(calculator(f) - standard_calculator(f));
-        out.write(reinterpret_cast<const char *>(&r), sizeof(r));
+        registry.add_calculator(
+            "polynomial_7_" + std::string{fs::to_string(isa)},
+            std::make_unique<fs::PolynomialCalculator<7u>>(isa),
+            1.2e-7,
+            isa);
+    }
+
+    // the same kernels on inputs already known to be in range, for the cost of full range reduction
+    registry.add_domain_kernel<fs::PolynomialKernel<7u>, fs::ReducedDomain::HALF_PI>("polynomial_7_half_pi", 1.2e-7);
+    registry.add_domain_kernel<fs::PolynomialKernel<7u>, fs::ReducedDomain::PI>("polynomial_7_pi", 1.2e-7);
+    registry.add_domain_kernel<fs::PolynomialKernel<7u>, fs::ReducedDomain::TWO_PI>("polynomial_7_two_pi", 1.2e-7);
+
+    registry.add_calculator("table_256", std::make_unique<fs::TableCalculator<256u>>(), 8e-5);
+    registry.add_kernel<fs::TableKernel<1024u>>("table_1024", 5e-6);
+    registry.add_domain_kernel<fs::TableKernel<1024u>, fs::ReducedDomain::PI>("table_1024_pi", 5e-6);
+    registry.add_domain_kernel<fs::TableKernel<1024u>, fs::ReducedDomain::TWO_PI>("table_1024_two_pi", 5e-6);
+    registry.add_calculator("table_4096", std::make_unique<fs::TableCalculator<4096u>>(), 4e-7);
+    registry.add_calculator(
+        "table_256_hermite",
+        std::make_unique<fs::TableCalculator<256u, fs::Interpolation::HERMITE>>(),
+        2.4e-7);
+    registry.add_calculator(
+        "table_1024_hermite",
+        std::make_unique<fs::TableCalculator<1024u, fs::Interpolation::HERMITE>>(),
+        2.4e-7);
+    registry.add_calculator(
+        "table_4096_hermite",
+        std::make_unique<fs::TableCalculator<4096u, fs::Interpolation::HERMITE>>(),
+        2.4e-7);
+
+    // phase accumulator inputs, fixed point results saturate a sine of one to one lsb below it
+    registry.add_phase_kernel<fs::PolynomialKernel<7u>, float>("polynomial_7_phase", 1.2e-7);
+    registry.add_phase_kernel<fs::PolynomialKernel<7u>, fs::q15>("polynomial_7_phase_q15", 3.1e-5);
+    registry.add_phase_kernel<fs::PolynomialKernel<7u>, fs::q31>("polynomial_7_phase_q31", 4e-9);
+    registry.add_phase_kernel<fs::TableKernel<1024u>, float>("table_1024_phase", 5e-6);
+    registry.add_phase_kernel<fs::TableKernel<1024u>, fs::q15>("table_1024_phase_q15", 3.5e-5);
 
-        f += interval;
-    } while (f <= 2.0f * std::numbers::pi_v<float>);
+    registry.add_sin_cos_function<fs::standard_sin_cos_calculator>("standard_sincos", 0.0);
+#if defined(__x86_64__) || defined(__i386__)
+    registry.add_sin_cos_function<fs::asm_sin_cos_calculator>("asm_sincos", 1.2e-7);
+#endif
+    registry.add_sin_cos_calculator(
+        "polynomial_7_sincos", std::make_unique<fs::PolynomialSinCosCalculator<7u>>(), 1.2e-7);
 
-    std::cout << file_name << " written\n";
+    register_precision_kernels<double>(registry);
+#if defined(FS_HAS_FLOAT16)
+    register_precision_kernels<fs::half>(registry);
+#endif
+    register_precision_kernels<fs::bfloat16>(registry);
+}
+
+/**
+ * Parse the command line, reporting a bad argument along with the usage.
+ *
+ * @param argc
+ *   Number of arguments.
+ *
+ * @param argv
+ *   Arguments, the first is the program name.
+ *
+ * @returns
+ *   Parsed options, empty if the arguments were bad.
+ */
+std::optional<fs::harness::Options> read_options(int argc, char **argv)
+{
+    try
+    {
+        return fs::harness::parse_options(argc, argv);
+    }
+    catch (const std::invalid_argument &error)
+    {
+        std::cerr << error.what() << "\n" << fs::harness::usage();
+        return std::nullopt;
+    }
 }
 
 }
 
-int main()
+int main(int argc, char **argv)
 {
+    const auto parsed = read_options(argc, argv);
+    if (!parsed)
+    {
+        return 1;
+    }
+
+    const auto &harness_options = *parsed;
+
+    // read up front so a bad path doesn't waste a run
+    auto baseline = std::vector<fs::harness::StoredResult>{};
+    if (!harness_options.compare.empty())
+    {
+        try
+        {
+            baseline = fs::harness::read_results(harness_options.compare);
+        }
+        catch (const std::runtime_error &error)
+        {
+            std::cerr << error.what() << "\n";
+            return 1;
+        }
+    }
+
+    auto registry = fs::harness::Registry{fs::standard_calculator, fs::standard_sin_cos_calculator};
+    register_kernels(registry);
+
+    const auto kernels = registry.select(harness_options.only, harness_options.skip);
+
+    if (kernels.empty())
+    {
+        std::cerr << "no kernels match the filters, registered kernels are:\n";
+        for (const auto *kernel : registry.kernels())
+        {
+            std::cerr << "  " << kernel->name << "\n";
+        }
+        return 1;
+    }
+
+    if (harness_options.select)
+    {
+        const auto &tolerance = *harness_options.select;
+
+        auto pool = fs::harness::ThreadPool{harness_options.threads, harness_options.pin};
+
+        auto selector_options = fs::harness::SelectorOptions{};
+        selector_options.cache_path = harness_options.selection_cache;
+        selector_options.runner.warmup = harness_options.warmup;
+        selector_options.runner.repetitions = harness_options.repetitions;
+
+        try
+        {
+            auto selector = fs::harness::Selector{kernels, pool, selector_options};
+
+            std::cout << "candidates over [" << tolerance.domain.low << ", " << tolerance.domain.high << "]:\n";
+            for (const auto &entry : selector.entries(tolerance.domain))
+            {
+                print_selection_entry(entry);
+            }
+
+            const auto selection = selector.select(tolerance);
+            if (!selection)
+            {
+                std::cout << "no kernel has a max " << fs::harness::to_string(tolerance.metric) << " error within "
+                          << tolerance.bound << "\n";
+                return 1;
+            }
+
+            std::cout << "selected " << selection->entry.name << ", max " << fs::harness::to_string(tolerance.metric)
+                      << " error " << selection->entry.error(tolerance.metric) << " within " << tolerance.bound << "\n";
+        }
+        catch (const std::system_error &error)
+        {
+            std::cerr << error.what() << "\n";
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // stdout may be the data, so everything here is reported on stderr
+    if (!harness_options.transform.empty())
+    {
+        const auto *kernel = kernels.front();
+
+        if ((kernels.size() != 1u) || !kernel->transform)
+        {
+            std::cerr << "--transform needs --only to select exactly one sine kernel\n";
+            return 1;
+        }
+
+        if (!fs::cpu_supports(kernel->isa))
+        {
+            std::cerr << kernel->name << " needs " << fs::to_string(kernel->isa) << ", which this cpu doesn't have\n";
+            return 1;
+        }
+
+        auto pool = fs::harness::ThreadPool{harness_options.threads, harness_options.pin};
+
+        auto transform_options = fs::harness::TransformOptions{};
+        transform_options.input = harness_options.transform;
+        transform_options.output = harness_options.transform_output;
+
+        try
+        {
+            const auto result = fs::harness::transform(kernel->transform, pool, transform_options);
+
+            std::cerr << kernel->name << " calculated " << result.elements << " floats in "
+                      << std::chrono::duration<double>(result.total).count() << " s, "
+                      << result.bytes_per_second() / 1e9 << " GB/s " << (result.mapped ? "mapped" : "streamed")
+                      << "\n";
+        }
+        catch (const std::system_error &error)
+        {
+            std::cerr << error.what() << "\n";
+            return 1;
+        }
+
+        return 0;
+    }
+
+    // kernels pinned to an instruction set this cpu doesn't have would fault
+    auto runnable = std::vector<const fs::harness::Kernel *>{};
+    for (const auto *kernel : kernels)
+    {
+        if (fs::cpu_supports(kernel->isa))
+        {
+            runnable.push_back(kernel);
+        }
+        else
+        {
+            std::cout << "skipping " << kernel->name << ", cpu doesn't support " << fs::to_string(kernel->isa) << "\n";
+        }
+    }
+
     std::cout << "starting accuracy tests\n";
 
-    write_data("asm_accuracy", asm_calculator);
-    write_data("maclaurin_0_accuracy", maclaurin_0_calculator);
-    write_data("maclaurin_1_accuracy", maclaurin_1_calculator);
-    write_data("maclaurin_2_accuracy", maclaurin_2_calculator);
-    write_data("maclaurin_3_accuracy", maclaurin_3_calculator);
-    write_data("chebyshev_0_accuracy", chebyshev_0_calculator);
-    write_data("chebyshev_1_accuracy", chebyshev_1_calculator);
-    write_data("chebyshev_2_accuracy", chebyshev_2_calculator);
-    write_data("chebyshev_3_accuracy", chebyshev_3_calculator);
+    auto over_bound = std::vector<std::string>{};
+
+    for (const auto *kernel : runnable)
+    {
+        if (!kernel->write_data)
+        {
+            continue;
+        }
+
+        const auto file_name = kernel->name + "_accuracy";
+        const auto max_error = kernel->write_data(file_name, harness_options.output);
+
+        std::cout << file_name << " written, max error " << max_error << "\n";
+
+        if (!(max_error <= kernel->error_bound))
+        {
+            std::cout << "  exceeds declared bound of " << kernel->error_bound << "\n";
+            over_bound.push_back(kernel->name);
+        }
+    }
+
+    std::cout << "polynomial_budget degree: " << budget_degree << "\n";
 
     std::cout << "accuracy tests done\n\n";
 
+    auto pool = fs::harness::ThreadPool{harness_options.threads, harness_options.pin};
+
+    if (harness_options.ulp_count != 0u)
+    {
+        std::cout << "starting ulp checks\n";
+
+        auto ulp_options = fs::harness::AccuracyOptions{};
+        ulp_options.first = harness_options.ulp_first;
+        ulp_options.count = harness_options.ulp_count;
+
+        for (const auto *kernel : runnable)
+        {
+            if (kernel->check_accuracy)
+            {
+                print_accuracy(kernel->name, kernel->check_accuracy(pool, ulp_options));
+            }
+        }
+
+        std::cout << "ulp checks done\n\n";
+    }
+
+    if (harness_options.grid_count != 0u)
+    {
+        std::cout << "starting grid benchmark\n";
+
+        auto grid_options = fs::harness::GridOptions{};
+        grid_options.count = harness_options.grid_count;
+
+        for (const auto &run : fs::harness::benchmark_grid(grid_options))
+        {
+            print_grid(run);
+        }
+
+        std::cout << "grid benchmark done\n\n";
+    }
+
+    if (harness_options.x87_count != 0u)
+    {
+        auto x87_options = fs::harness::X87Options{};
+        x87_options.count = harness_options.x87_count;
+
+        const auto x87 = fs::harness::benchmark_x87(x87_options);
+
+        if (x87.mixed.empty())
+        {
+            std::cout << "skipping x87 benchmark, the target has no x87\n\n";
+        }
+        else
+        {
+            std::cout << "starting x87 benchmark\n";
+
+            for (const auto &run : x87.alone)
+            {
+                print_mixed(run, &x87.alone.back());
+            }
+            for (const auto &run : x87.mixed)
+            {
+                print_mixed(run, &x87.mixed.back());
+            }
+
+            std::cout << "x87 benchmark done\n\n";
+        }
+    }
+
+    if (harness_options.cache_count != 0u)
+    {
+        auto cache_options = fs::harness::CacheOptions{};
+        cache_options.count = harness_options.cache_count;
+
+        std::cout << "starting cache benchmark\n";
+
+        for (const auto &distribution : fs::harness::benchmark_cache(cache_options))
+        {
+            std::cout << distribution.name << "\n";
+
+            // each wrapped calculator has its uncached loop first, then the two cached ones
+            for (auto i = std::size_t{0u}; i < distribution.runs.size(); ++i)
+            {
+                print_cached(distribution.runs[i], distribution.runs[i - (i % 3u)]);
+            }
+        }
+
+        std::cout << "cache benchmark done\n\n";
+    }
+
+    if (harness_options.scaling_count != 0u)
+    {
+        auto scaling_options = fs::harness::ScalingOptions{};
+        scaling_options.count = harness_options.scaling_count;
+        scaling_options.max_threads = harness_options.threads;
+        scaling_options.pin = harness_options.pin;
+        scaling_options.warmup = harness_options.warmup;
+        scaling_options.repetitions = harness_options.repetitions;
+        scaling_options.workload = harness_options.workload;
+        scaling_options.sweep_first = harness_options.sweep_first;
+        scaling_options.sweep_count = harness_options.sweep_count;
+
+        std::cout << "starting scaling benchmark over " << scaling_options.count << " "
+                  << fs::harness::to_string(harness_options.workload) << " inputs, " << fs::harness::numa_node_count()
+                  << " NUMA nodes\n";
+
+        try
+        {
+            for (const auto &result : fs::harness::benchmark_scaling(runnable, scaling_options))
+            {
+                print_scaling(result);
+            }
+        }
+        catch (const std::runtime_error &error)
+        {
+            std::cerr << error.what() << "\n";
+            return 1;
+        }
+
+        std::cout << "scaling benchmark done\n\n";
+    }
+
+    if (harness_options.device_count != 0u)
+    {
+        std::cout << "starting device benchmark on " << fs::device::backend() << "\n";
+
+        if (fs::device::available())
+        {
+            auto device_options = fs::harness::DeviceOptions{};
+            device_options.count = harness_options.device_count;
+            device_options.sweep_first = harness_options.sweep_first;
+            device_options.sweep_count = harness_options.sweep_count;
+            device_options.sweep = harness_options.sweep_mode;
+
+            try
+            {
+                for (const auto &run : fs::harness::benchmark_device(device_options, pool))
+                {
+                    print_device(run);
+                }
+            }
+            catch (const std::runtime_error &error)
+            {
+                std::cerr << error.what() << "\n";
+                return 1;
+            }
+        }
+        else
+        {
+            std::cout << "no device available\n";
+        }
+
+        std::cout << "device benchmark done\n\n";
+    }
+
+    auto results = std::unique_ptr<fs::harness::ResultsFile>{};
+    if (!harness_options.results.empty())
+    {
+        auto metadata = fs::harness::collect_metadata();
+        metadata.workload = fs::harness::to_string(harness_options.workload);
+
+        try
+        {
+            results = std::make_unique<fs::harness::ResultsFile>(
+                harness_options.results, harness_options.results_format, std::move(metadata));
+        }
+        catch (const std::system_error &error)
+        {
+            std::cerr << error.what() << "\n";
+            return 1;
+        }
+    }
+
     std::cout << "starting performance tests\n";
 
-    std::cout << "standard: " << time_calculations(standard_calculator).count() << "ns\n";
-    std::cout << "asm: " << time_calculations(asm_calculator).count() << "ns\n";
-    std::cout << "maclaruin_0: " << time_calculations(maclaurin_0_calculator).count() << "ns\n";
-    std::cout << "maclaruin_1: " << time_calculations(maclaurin_1_calculator).count() << "ns\n";
-    std::cout << "maclaruin_2: " << time_calculations(maclaurin_2_calculator).count() << "ns\n";
-    std::cout << "maclaruin_3: " << time_calculations(maclaurin_3_calculator).count() << "ns\n";
-    std::cout << "chebyshev_0: " << time_calculations(chebyshev_0_calculator).count() << "ns\n";
-    std::cout << "chebyshev_1: " << time_calculations(chebyshev_1_calculator).count() << "ns\n";
-    std::cout << "chebyshev_2: " << time_calculations(chebyshev_2_calculator).count() << "ns\n";
-    std::cout << "chebyshev_3: " << time_calculations(chebyshev_3_calculator).count() << "ns\n";
+    auto options = fs::harness::SweepOptions{};
+    options.first = harness_options.sweep_first;
+    options.count = harness_options.sweep_count;
+    options.baseline = fs::harness::calibrate_baseline({});
+    options.batch_baseline = fs::harness::calibrate_batch_baseline({});
+
+    auto runner = fs::harness::RunnerOptions{};
+    runner.warmup = harness_options.warmup;
+    runner.repetitions = harness_options.repetitions;
+
+    auto modes = std::vector<fs::harness::TimingMode>{};
+    if (harness_options.latency_mode)
+    {
+        modes.push_back(fs::harness::TimingMode::LATENCY);
+    }
+    if (harness_options.throughput_mode)
+    {
+        modes.push_back(fs::harness::TimingMode::THROUGHPUT);
+    }
+
+    // made up front so generating or reading the inputs is never part of a timing
+    auto buffer = std::optional<fs::harness::InputBuffer>{};
+    try
+    {
+        buffer.emplace(fs::harness::make_workload(
+            harness_options.workload,
+            harness_options.sweep_first,
+            harness_options.sweep_count,
+            modes.empty() ? 0u : harness_options.stream_size));
+    }
+    catch (const std::runtime_error &error)
+    {
+        std::cerr << error.what() << "\n";
+        return 1;
+    }
+    const auto stream = std::as_const(*buffer).span();
+
+    auto mode_options = fs::harness::ModeOptions{};
+    mode_options.inputs = stream;
+    mode_options.use_cycle_counter = fs::harness::has_cycle_counter();
+
+    auto counters = std::unique_ptr<fs::harness::PerfCounters>{};
+    if (harness_options.counters && !modes.empty())
+    {
+        counters = std::make_unique<fs::harness::PerfCounters>();
+        mode_options.counters = counters.get();
+    }
+
+    if (!modes.empty())
+    {
+        mode_options.latency_baseline = fs::harness::calibrate_latency_baseline(stream, mode_options.use_cycle_counter);
+        mode_options.throughput_baseline =
+            fs::harness::calibrate_throughput_baseline(stream, mode_options.use_cycle_counter);
+        mode_options.batch_latency_baseline =
+            fs::harness::calibrate_batch_latency_baseline(stream, mode_options.use_cycle_counter);
+        mode_options.batch_throughput_baseline =
+            fs::harness::calibrate_batch_throughput_baseline(stream, mode_options.use_cycle_counter);
+    }
+
+    std::cout << "loop overhead: " << options.baseline.ns_per_element << " ns/element, "
+              << options.baseline.cycles_per_element << " cycles/element, batch overhead "
+              << options.batch_baseline.ns_per_element << " ns/element, " << options.batch_baseline.cycles_per_element
+              << " cycles/element\n";
+    if (!modes.empty())
+    {
+        std::cout << "chain overhead: " << mode_options.latency_baseline.ns_per_element << " ns/element, "
+                  << mode_options.latency_baseline.cycles_per_element << " cycles/element, stream overhead "
+                  << mode_options.throughput_baseline.ns_per_element << " ns/element, "
+                  << mode_options.throughput_baseline.cycles_per_element << " cycles/element over " << stream.size()
+                  << " " << fs::harness::to_string(harness_options.workload) << " inputs\n";
+        std::cout << "batch chain overhead: " << mode_options.batch_latency_baseline.ns_per_element << " ns/element, "
+                  << mode_options.batch_latency_baseline.cycles_per_element << " cycles/element, batch stream overhead "
+                  << mode_options.batch_throughput_baseline.ns_per_element << " ns/element, "
+                  << mode_options.batch_throughput_baseline.cycles_per_element << " cycles/element\n";
+    }
+    if (counters != nullptr)
+    {
+        if (!counters->available())
+        {
+            std::cout << "hardware counters unavailable, " << counters->error() << "\n";
+        }
+        else if (!counters->error().empty())
+        {
+            std::cout << "some hardware counters unavailable, " << counters->error() << "\n";
+        }
+    }
+    std::cout << "batch kernel variant: " << fs::to_string(fs::selected_isa()) << "\n";
+    std::cout << "table footprints: " << fs::TableKernel<256u>::footprint << ", "
+              << fs::TableKernel<1024u>::footprint << ", " << fs::TableKernel<4096u>::footprint << " bytes\n";
+    std::cout << pool.size() << " threads" << (pool.pinned() ? " pinned" : "") << ", " << runner.warmup
+              << " warmup runs, " << runner.repetitions << " repetitions\n";
+
+    // empty means leave the mode alone
+    auto flush_settings = std::vector<std::optional<bool>>{};
+    switch (fs::harness::flush_denormals_supported() ? harness_options.flush : fs::harness::FlushMode::KEEP)
+    {
+        case fs::harness::FlushMode::KEEP: flush_settings = {std::nullopt}; break;
+        case fs::harness::FlushMode::OFF: flush_settings = {false}; break;
+        case fs::harness::FlushMode::ON: flush_settings = {true}; break;
+        case fs::harness::FlushMode::BOTH: flush_settings = {false, true}; break;
+    }
+
+    if (!fs::harness::flush_denormals_supported() && (harness_options.flush != fs::harness::FlushMode::KEEP))
+    {
+        std::cout << "flushing denormals is not supported on this target, keeping the float mode\n";
+    }
+    else
+    {
+        std::cout << "flush to zero and denormals are zero: " << fs::harness::to_string(harness_options.flush) << "\n";
+    }
+
+    auto regressions = std::vector<std::string>{};
+
+    for (const auto *kernel : runnable)
+    {
+        const auto bounded = harness_options.sweep_mode &&
+                             sweep_within_bound(*kernel, harness_options.sweep_first, harness_options.sweep_count);
+
+        for (const auto &benchmark : kernel->benchmarks)
+        {
+            // time without flushing when both are asked for, to report the ratio
+            auto unflushed = std::optional<double>{};
+
+            for (const auto flush : flush_settings)
+            {
+                if (flush)
+                {
+                    pool.on_every_worker([&](std::size_t) { fs::harness::set_flush_denormals(*flush); });
+                }
+
+                const auto label = benchmark.label + (flush.value_or(false) ? " ftz" : "");
+
+                auto run = fs::harness::BenchmarkRun{};
+
+                if (harness_options.sweep_mode)
+                {
+                    run = fs::harness::run_benchmark(benchmark, pool, options, runner);
+                    print_sweep(label, run.representative());
+
+                    const auto max_error = run.repetitions.front().errors.max_error;
+                    if (bounded && !(max_error <= kernel->error_bound))
+                    {
+                        std::cout << "  exceeds declared bound of " << kernel->error_bound << "\n";
+                        over_bound.push_back(label);
+                    }
+
+                    if (run.repetitions.size() > 1u)
+                    {
+                        print_summary(run.ns_per_element);
+                    }
+                }
+                else
+                {
+                    std::cout << label << ":\n";
+                }
+
+                for (const auto mode : modes)
+                {
+                    run.modes.push_back(fs::harness::run_mode(benchmark, mode, mode_options, runner));
+                    print_mode(run.modes.back());
+                }
+
+                const auto previous = std::ranges::find(baseline, label, &fs::harness::StoredResult::benchmark);
+                if (harness_options.sweep_mode && (previous != baseline.end()))
+                {
+                    const auto comparison = fs::harness::compare(previous->samples, run.samples());
+                    print_comparison(comparison);
 
-    std::cout << "standard sincos: " << time_calculations(standard_sin_cos_calculator).count() << "ns\n";
-    std::cout << "asm sincos: " << time_calculations(asm_sin_cos_calculator).count() << "ns\n";
+                    if (comparison.change == fs::harness::Change::REGRESSION)
+                    {
+                        regressions.push_back(label);
+                    }
+                }
+
+                if (results != nullptr)
+                {
+                    results->add(kernel->name, label, benchmark.variant, run);
+                }
+
+                if (flush && !*flush)
+                {
+                    unflushed = ns_per_element(run);
+                }
+                else if (flush && unflushed && (*unflushed > 0.0))
+                {
+                    std::cout << "  flushing denormals: " << (ns_per_element(run) / *unflushed) << " times unflushed\n";
+                }
+            }
+        }
+    }
+
+    if (results != nullptr)
+    {
+        results->close();
+    }
 
     std::cout << "performance tests done\n\n";
 
+    if (!over_bound.empty())
+    {
+        std::cout << over_bound.size() << " results exceed the declared error bound of their kernel\n";
+        for (const auto &label : over_bound)
+        {
+            std::cout << "  " << label << "\n";
+        }
+    }
+
+    if (!harness_options.compare.empty())
+    {
+        std::cout << regressions.size() << " significant regressions against " << harness_options.compare << "\n";
+        for (const auto &label : regressions)
+        {
+            std::cout << "  " << label << "\n";
+        }
+
+        if (!regressions.empty())
+        {
+            return 2;
+        }
+    }
+
+    if (!over_bound.empty())
+    {
+        return 3;
+    }
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,707 @@
+#include "options.h"
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+
+/**
+ * Parse an unsigned integer argument value.
+ *
+ * @param name
+ *   Name of argument, used in error messages.
+ *
+ * @param value
+ *   Value to parse.
+ *
+ * @returns
+ *   Parsed value.
+ *
+ * @throws std::invalid_argument
+ *   If value is not an unsigned integer.
+ */
+std::size_t parse_unsigned(std::string_view name, std::string_view value)
+{
+    auto result = std::size_t{0u};
+    const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+
+    if ((error != std::errc{}) || (end != value.data() + value.size()))
+    {
+        throw std::invalid_argument{"invalid value for " + std::string{name} + ": " + std::string{value}};
+    }
+
+    return result;
+}
+
+/**
+ * Parse a range of float bit patterns, either all for every float, binade:N for the positive floats with unbiased
+ * exponent N (-127 for denormals) or range:FIRST:COUNT for a range of bit patterns.
+ *
+ * @param name
+ *   Name of argument, used in error messages.
+ *
+ * @param value
+ *   Value to parse.
+ *
+ * @param first
+ *   Where to store the first bit pattern of the range.
+ *
+ * @param count
+ *   Where to store the number of bit patterns in the range.
+ *
+ * @throws std::invalid_argument
+ *   If value is not a valid range.
+ */
+void parse_range(std::string_view name, std::string_view value, std::uint64_t &first, std::uint64_t &count)
+{
+    constexpr auto binade_prefix = std::string_view{"binade:"};
+    constexpr auto range_prefix = std::string_view{"range:"};
+    constexpr auto pattern_count = std::uint64_t{1u} << 32u;
+
+    if (value == "all")
+    {
+        first = 0u;
+        count = pattern_count;
+    }
+    else if (value.starts_with(binade_prefix))
+    {
+        const auto exponent_text = value.substr(binade_prefix.size());
+        auto exponent = 0;
+        const auto [end, error] =
+            std::from_chars(exponent_text.data(), exponent_text.data() + exponent_text.size(), exponent);
+
+        if ((error != std::errc{}) || (end != exponent_text.data() + exponent_text.size()) || (exponent < -127) ||
+            (exponent > 127))
+        {
+            throw std::invalid_argument{"invalid value for " + std::string{name} + ": " + std::string{value}};
+        }
+
+        first = static_cast<std::uint64_t>(exponent + 127) << 23u;
+        count = std::uint64_t{1u} << 23u;
+    }
+    else if (value.starts_with(range_prefix))
+    {
+        const auto range = value.substr(range_prefix.size());
+        const auto separator = range.find(':');
+
+        if (separator == std::string_view::npos)
+        {
+            throw std::invalid_argument{"invalid value for " + std::string{name} + ": " + std::string{value}};
+        }
+
+        first = parse_unsigned(name, range.substr(0u, separator));
+        count = parse_unsigned(name, range.substr(separator + 1u));
+
+        if ((first > pattern_count) || (count > pattern_count - first))
+        {
+            throw std::invalid_argument{"range out of bounds for " + std::string{name} + ": " + std::string{value}};
+        }
+    }
+    else
+    {
+        throw std::invalid_argument{"invalid value for " + std::string{name} + ": " + std::string{value}};
+    }
+}
+
+/**
+ * Parse an output format argument value.
+ *
+ * @param name
+ *   Name of argument, used in error messages.
+ *
+ * @param value
+ *   Value to parse.
+ *
+ * @returns
+ *   Parsed value.
+ *
+ * @throws std::invalid_argument
+ *   If value is not a format supported by this build.
+ */
+fs::harness::OutputFormat parse_output_format(std::string_view name, std::string_view value)
+{
+    for (const auto format : {fs::harness::OutputFormat::RAW, fs::harness::OutputFormat::ZSTD})
+    {
+        if (value == fs::harness::to_string(format))
+        {
+            if (!fs::harness::output_supported(format))
+            {
+                throw std::invalid_argument{std::string{value} + " output is not supported by this build"};
+            }
+
+            return format;
+        }
+    }
+
+    throw std::invalid_argument{"invalid value for " + std::string{name} + ": " + std::string{value}};
+}
+
+/**
+ * Parse an on or off argument value.
+ *
+ * @param name
+ *   Name of argument, used in error messages.
+ *
+ * @param value
+ *   Value to parse.
+ *
+ * @returns
+ *   True for on, false for off.
+ *
+ * @throws std::invalid_argument
+ *   If value is neither.
+ */
+bool parse_switch(std::string_view name, std::string_view value)
+{
+    if ((value != "on") && (value != "off"))
+    {
+        throw std::invalid_argument{"invalid value for " + std::string{name} + ": " + std::string{value}};
+    }
+
+    return value == "on";
+}
+
+/**
+ * Parse a flush mode argument value.
+ *
+ * @param name
+ *   Name of argument, used in error messages.
+ *
+ * @param value
+ *   Value to parse.
+ *
+ * @returns
+ *   Parsed value.
+ *
+ * @throws std::invalid_argument
+ *   If value is not a flush mode.
+ */
+fs::harness::FlushMode parse_flush_mode(std::string_view name, std::string_view value)
+{
+    using fs::harness::FlushMode;
+
+    for (const auto mode : {FlushMode::KEEP, FlushMode::OFF, FlushMode::ON, FlushMode::BOTH})
+    {
+        if (value == fs::harness::to_string(mode))
+        {
+            return mode;
+        }
+    }
+
+    throw std::invalid_argument{"invalid value for " + std::string{name} + ": " + std::string{value}};
+}
+
+/**
+ * Parse a results format argument value.
+ *
+ * @param name
+ *   Name of argument, used in error messages.
+ *
+ * @param value
+ *   Value to parse.
+ *
+ * @returns
+ *   Parsed value.
+ *
+ * @throws std::invalid_argument
+ *   If value is not a results format.
+ */
+fs::harness::ResultsFormat parse_results_format(std::string_view name, std::string_view value)
+{
+    for (const auto format : {fs::harness::ResultsFormat::JSON, fs::harness::ResultsFormat::CSV})
+    {
+        if (value == fs::harness::to_string(format))
+        {
+            return format;
+        }
+    }
+
+    throw std::invalid_argument{"invalid value for " + std::string{name} + ": " + std::string{value}};
+}
+
+/**
+ * Parse a comma separated list of kernel name patterns, appending them to a list.
+ *
+ * @param name
+ *   Name of argument, used in error messages.
+ *
+ * @param value
+ *   Value to parse.
+ *
+ * @param patterns
+ *   List to append to.
+ *
+ * @throws std::invalid_argument
+ *   If value contains an empty pattern.
+ */
+void parse_patterns(std::string_view name, std::string_view value, std::vector<std::string> &patterns)
+{
+    while (true)
+    {
+        const auto separator = value.find(',');
+        const auto pattern = value.substr(0u, separator);
+
+        if (pattern.empty())
+        {
+            throw std::invalid_argument{"empty pattern for " + std::string{name}};
+        }
+
+        patterns.emplace_back(pattern);
+
+        if (separator == std::string_view::npos)
+        {
+            break;
+        }
+
+        value.remove_prefix(separator + 1u);
+    }
+}
+
+/**
+ * Parse a comma separated list of benchmark modes, replacing the default of every mode.
+ *
+ * @param name
+ *   Name of argument, used in error messages.
+ *
+ * @param value
+ *   Value to parse.
+ *
+ * @param options
+ *   Options to set the modes of.
+ *
+ * @throws std::invalid_argument
+ *   If value contains anything other than sweep, latency and throughput.
+ */
+void parse_modes(std::string_view name, std::string_view value, fs::harness::Options &options)
+{
+    auto modes = std::vector<std::string>{};
+    parse_patterns(name, value, modes);
+
+    options.sweep_mode = false;
+    options.latency_mode = false;
+    options.throughput_mode = false;
+
+    for (const auto &mode : modes)
+    {
+        if (mode == "sweep")
+        {
+            options.sweep_mode = true;
+        }
+        else if (mode == "latency")
+        {
+            options.latency_mode = true;
+        }
+        else if (mode == "throughput")
+        {
+            options.throughput_mode = true;
+        }
+        else
+        {
+            throw std::invalid_argument{"invalid value for " + std::string{name} + ": " + mode};
+        }
+    }
+}
+
+/**
+ * Parse a tolerance, METRIC:BOUND for a bound over [-pi, pi] or METRIC:BOUND:LOW:HIGH, where the metric is absolute,
+ * relative or ulp.
+ *
+ * @param name
+ *   Name of argument, used in error messages.
+ *
+ * @param value
+ *   Value to parse.
+ *
+ * @returns
+ *   Parsed tolerance.
+ *
+ * @throws std::invalid_argument
+ *   If value is not a valid tolerance.
+ */
+fs::harness::Tolerance parse_tolerance(std::string_view name, std::string_view value)
+{
+    const auto invalid = std::invalid_argument{"invalid value for " + std::string{name} + ": " + std::string{value}};
+
+    auto parts = std::vector<std::string_view>{};
+    for (auto rest = value;;)
+    {
+        const auto separator = rest.find(':');
+        parts.push_back(rest.substr(0u, separator));
+
+        if (separator == std::string_view::npos)
+        {
+            break;
+        }
+
+        rest.remove_prefix(separator + 1u);
+    }
+
+    if ((parts.size() != 2u) && (parts.size() != 4u))
+    {
+        throw invalid;
+    }
+
+    const auto parse = [&invalid](std::string_view text, auto &number)
+    {
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+        if ((error != std::errc{}) || (end != text.data() + text.size()))
+        {
+            throw invalid;
+        }
+    };
+
+    auto tolerance = fs::harness::Tolerance{};
+
+    if (parts[0] == "absolute")
+    {
+        tolerance.metric = fs::remez::ErrorMetric::ABSOLUTE;
+    }
+    else if (parts[0] == "relative")
+    {
+        tolerance.metric = fs::remez::ErrorMetric::RELATIVE;
+    }
+    else if (parts[0] == "ulp")
+    {
+        tolerance.metric = fs::remez::ErrorMetric::ULP;
+    }
+    else
+    {
+        throw invalid;
+    }
+
+    parse(parts[1], tolerance.bound);
+
+    if (parts.size() == 4u)
+    {
+        parse(parts[2], tolerance.domain.low);
+        parse(parts[3], tolerance.domain.high);
+    }
+
+    if (!(tolerance.bound >= 0.0) || !std::isfinite(tolerance.domain.low) || !std::isfinite(tolerance.domain.high) ||
+        !(tolerance.domain.low <= tolerance.domain.high))
+    {
+        throw invalid;
+    }
+
+    return tolerance;
+}
+
+/**
+ * Parse a workload, spread, uniform, gaussian[:SIGMA], large[:MAX], denormal[:FRACTION] or trace:PATH.
+ *
+ * @param name
+ *   Name of argument, used in error messages.
+ *
+ * @param value
+ *   Value to parse.
+ *
+ * @returns
+ *   Parsed workload.
+ *
+ * @throws std::invalid_argument
+ *   If value is not a valid workload.
+ */
+fs::harness::Workload parse_workload(std::string_view name, std::string_view value)
+{
+    using fs::harness::WorkloadKind;
+
+    const auto invalid = std::invalid_argument{"invalid value for " + std::string{name} + ": " + std::string{value}};
+
+    const auto separator = value.find(':');
+    const auto kind_name = value.substr(0u, separator);
+    const auto argument = separator == std::string_view::npos ? std::string_view{} : value.substr(separator + 1u);
+
+    auto workload = fs::harness::Workload{};
+
+    for (const auto kind :
+         {WorkloadKind::SPREAD,
+          WorkloadKind::UNIFORM,
+          WorkloadKind::GAUSSIAN,
+          WorkloadKind::LARGE,
+          WorkloadKind::DENORMAL,
+          WorkloadKind::TRACE})
+    {
+        if (kind_name == fs::harness::to_string(kind))
+        {
+            workload.kind = kind;
+            break;
+        }
+
+        if (kind == WorkloadKind::TRACE)
+        {
+            throw invalid;
+        }
+    }
+
+    switch (workload.kind)
+    {
+        case WorkloadKind::GAUSSIAN: workload.parameter = 1.0; break;
+        case WorkloadKind::LARGE: workload.parameter = 1e6; break;
+        case WorkloadKind::DENORMAL: workload.parameter = 0.5; break;
+        default: break;
+    }
+
+    if (workload.kind == WorkloadKind::TRACE)
+    {
+        if (argument.empty())
+        {
+            throw invalid;
+        }
+
+        workload.path = argument;
+        return workload;
+    }
+
+    if (separator == std::string_view::npos)
+    {
+        return workload;
+    }
+
+    const auto [end, error] = std::from_chars(argument.data(), argument.data() + argument.size(), workload.parameter);
+    if ((error != std::errc{}) || (end != argument.data() + argument.size()))
+    {
+        throw invalid;
+    }
+
+    auto valid = false;
+    switch (workload.kind)
+    {
+        case WorkloadKind::GAUSSIAN: valid = (workload.parameter > 0.0) && std::isfinite(workload.parameter); break;
+        // magnitudes start at pi and must stay below the largest float
+        case WorkloadKind::LARGE:
+            valid = (workload.parameter > std::numbers::pi) && (workload.parameter <= 3e38);
+            break;
+        case WorkloadKind::DENORMAL: valid = (workload.parameter >= 0.0) && (workload.parameter <= 1.0); break;
+        default: break;
+    }
+
+    if (!valid)
+    {
+        throw invalid;
+    }
+
+    return workload;
+}
+
+}
+
+namespace fs::harness
+{
+
+Options parse_options(int argc, const char *const *argv)
+{
+    auto options = Options{};
+
+    for (auto i = 1; i < argc; ++i)
+    {
+        const auto argument = std::string_view{argv[i]};
+
+        // every option takes a value
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument{"missing value for " + std::string{argument}};
+        }
+
+        const auto value = std::string_view{argv[++i]};
+
+        if (argument == "--threads")
+        {
+            options.threads = parse_unsigned(argument, value);
+        }
+        else if (argument == "--output")
+        {
+            options.output = parse_output_format(argument, value);
+        }
+        else if (argument == "--ulp")
+        {
+            parse_range(argument, value, options.ulp_first, options.ulp_count);
+        }
+        else if (argument == "--sweep")
+        {
+            parse_range(argument, value, options.sweep_first, options.sweep_count);
+        }
+        else if (argument == "--warmup")
+        {
+            options.warmup = parse_unsigned(argument, value);
+        }
+        else if (argument == "--repetitions")
+        {
+            options.repetitions = parse_unsigned(argument, value);
+            if (options.repetitions == 0u)
+            {
+                throw std::invalid_argument{"invalid value for " + std::string{argument} + ": " + std::string{value}};
+            }
+        }
+        else if (argument == "--modes")
+        {
+            parse_modes(argument, value, options);
+        }
+        else if (argument == "--stream-size")
+        {
+            options.stream_size = parse_unsigned(argument, value);
+            if (options.stream_size == 0u)
+            {
+                throw std::invalid_argument{"invalid value for " + std::string{argument} + ": " + std::string{value}};
+            }
+        }
+        else if (argument == "--workload")
+        {
+            options.workload = parse_workload(argument, value);
+        }
+        else if (argument == "--grid")
+        {
+            options.grid_count = parse_unsigned(argument, value);
+        }
+        else if (argument == "--x87")
+        {
+            options.x87_count = parse_unsigned(argument, value);
+        }
+        else if (argument == "--cache")
+        {
+            options.cache_count = parse_unsigned(argument, value);
+        }
+        else if (argument == "--scaling")
+        {
+            options.scaling_count = parse_unsigned(argument, value);
+        }
+        else if (argument == "--device")
+        {
+            options.device_count = parse_unsigned(argument, value);
+        }
+        else if (argument == "--counters")
+        {
+            options.counters = parse_switch(argument, value);
+        }
+        else if (argument == "--pin")
+        {
+            options.pin = parse_switch(argument, value);
+        }
+        else if (argument == "--ftz")
+        {
+            options.flush = parse_flush_mode(argument, value);
+        }
+        else if (argument == "--compare")
+        {
+            options.compare = value;
+        }
+        else if (argument == "--only")
+        {
+            parse_patterns(argument, value, options.only);
+        }
+        else if (argument == "--skip")
+        {
+            parse_patterns(argument, value, options.skip);
+        }
+        else if (argument == "--results")
+        {
+            options.results = value;
+        }
+        else if (argument == "--results-format")
+        {
+            options.results_format = parse_results_format(argument, value);
+        }
+        else if (argument == "--select")
+        {
+            options.select = parse_tolerance(argument, value);
+        }
+        else if (argument == "--selection-cache")
+        {
+            options.selection_cache = value;
+        }
+        else if (argument == "--transform")
+        {
+            options.transform = value;
+        }
+        else if (argument == "--transform-output")
+        {
+            options.transform_output = value;
+        }
+        else
+        {
+            throw std::invalid_argument{"unknown option: " + std::string{argument}};
+        }
+    }
+
+    return options;
+}
+
+std::string usage()
+{
+    return "usage: sine_harness [options]\n"
+           "  --threads N    number of threads for sweeps, 0 for all hardware threads (default 0)\n"
+           "  --output FMT   format of accuracy data, raw or zstd when built with USE_ZSTD (default raw)\n"
+           "  --ulp RANGE    check ulp error of every float in RANGE, one of all, binade:N or range:FIRST:COUNT\n"
+           "                 (default off)\n"
+           "  --sweep RANGE  float bit patterns to time each benchmark over, in the same form as --ulp (default all)\n"
+           "  --warmup N     untimed runs over the first 2^24 patterns of the sweep before each benchmark (default 1)\n"
+           "  --repetitions N\n"
+           "                 timed runs of each benchmark, summarised by median, p5, p95 and MAD (default 1)\n"
+           "  --modes MODES  comma separated list of how to time each benchmark, sweep across the thread pool,\n"
+           "                 latency as a chain where each input waits for the previous result and throughput over\n"
+           "                 independent inputs, both on one thread (default sweep,latency,throughput)\n"
+           "  --stream-size N\n"
+           "                 inputs preloaded for latency and throughput (default 2^22)\n"
+           "  --workload KIND\n"
+           "                 how the latency and throughput inputs are made, spread over the sweep range,\n"
+           "                 uniform over [-pi, pi], gaussian[:SIGMA] around 0 (default 1), large[:MAX] with\n"
+           "                 magnitudes log uniform over [pi, MAX] (default 1e6), denormal[:FRACTION] with that\n"
+           "                 fraction denormal and the rest uniform (default 0.5) or trace:PATH replaying a file\n"
+           "                 of raw floats (default spread)\n"
+           "  --grid N       points in the grid benchmark, sine from 0 in steps of 1e-5 by rotation compared with\n"
+           "                 std::sin at each point, 0 skips it (default 2^22)\n"
+           "  --x87 N        inputs in the x87 benchmark, fsin timed alone and as part of a vectorised loop against\n"
+           "                 register only scalar and vector polynomials, 0 skips it (default 2^22)\n"
+           "  --cache N      inputs from each distribution in the cache benchmark, std::sin and polynomial_7 timed\n"
+           "                 with and without a one line cache of results over uniform and repetitive inputs, 0 skips\n"
+           "                 it (default 2^22)\n"
+           "  --scaling N    inputs split between the threads in the scaling benchmark, every batch kernel timed\n"
+           "                 with one thread and doubling up to --threads, each thread pinned with its buffers on\n"
+           "                 its own NUMA node, reporting speedup, efficiency and GB/s, 0 skips it (default 2^24)\n"
+           "  --device N     inputs spread over the sweep range for timing the device backend with and without\n"
+           "                 transfers, each device kernel is also swept over the range when sweep is one of the\n"
+           "                 modes, 0 skips it (default 2^24)\n"
+           "  --counters on|off\n"
+           "                 read cycles, instructions, branch misses, L1D misses and FP assists around the latency\n"
+           "                 and throughput modes with perf_event_open, skipped if not permitted (default on)\n"
+           "  --pin on|off   pin each sweep thread to its own cpu (default on)\n"
+           "  --ftz keep|off|on|both\n"
+           "                 flush to zero and denormals are zero on every benchmark thread, keep leaves the mode the\n"
+           "                 process started with, both times every benchmark without and then with it and reports\n"
+           "                 the ratio (default keep)\n"
+           "  --compare PATH compare against a results file from an earlier run and flag significant changes, exits\n"
+           "                 with 2 if anything regressed, needs at least 4 repetitions in both runs (default off)\n"
+           "  --only GLOBS   only run kernels with a name matching one of a comma separated list of patterns, where *\n"
+           "                 matches any characters and ? matches one, may be given more than once (default all)\n"
+           "  --skip GLOBS   don't run kernels with a name matching one of a comma separated list of patterns, may be\n"
+           "                 given more than once (default none)\n"
+           "  --results PATH write a record for every benchmark along with details of the build and machine to PATH\n"
+           "                 (default off)\n"
+           "  --results-format FMT\n"
+           "                 format of results file, json or csv (default json)\n"
+           "  --select METRIC:BOUND[:LOW:HIGH]\n"
+           "                 instead of benchmarking, pick the fastest kernel selected by --only whose largest\n"
+           "                 absolute, relative or ulp error over every float in [LOW, HIGH] is at most BOUND, the\n"
+           "                 domain defaults to [-pi, pi] (default off)\n"
+           "  --selection-cache PATH\n"
+           "                 where --select caches the errors and throughput it measures, empty to not cache\n"
+           "                 (default selection_table.csv)\n"
+           "  --transform PATH\n"
+           "                 instead of benchmarking, calculate sine of every float in the raw file PATH, - for\n"
+           "                 stdin, with the one kernel selected by --only across the thread pool (default off)\n"
+           "  --transform-output PATH\n"
+           "                 where to write the results of --transform, - for stdout (default in place, or stdout\n"
+           "                 when the input is not a file)\n"
+           "exits with 3 if the max error of a kernel in the accuracy tests, or in a sweep which stays inside\n"
+           "[0, 2pi] and the kernel's domain, is over the bound it was registered with\n";
+}
+
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "float_mode.h"
+#include "output.h"
+#include "results.h"
+#include "selector.h"
+#include "workload.h"
+
+namespace fs::harness
+{
+
+/**
+ * Command line options for the harness.
+ */
+struct Options
+{
+    /** Number of threads to sweep with, zero means use all hardware threads. */
+    std::size_t threads = 0u;
+
+    /** How accuracy data files are written. */
+    OutputFormat output = OutputFormat::RAW;
+
+    /** First float bit pattern to check the ulp error of. */
+    std::uint64_t ulp_first = 0u;
+
+    /** Number of float bit patterns to check the ulp error of, zero skips the check. */
+    std::uint64_t ulp_count = 0u;
+
+    /** First float bit pattern to time benchmarks over. */
+    std::uint64_t sweep_first = 0u;
+
+    /** Number of float bit patterns to time benchmarks over. */
+    std::uint64_t sweep_count = std::uint64_t{1u} << 32u;
+
+    /** Number of untimed runs before each benchmark. */
+    std::size_t warmup = 1u;
+
+    /** Number of timed runs of each benchmark. */
+    std::size_t repetitions = 1u;
+
+    /** Whether to time each benchmark by sweeping bit patterns across the thread pool. */
+    bool sweep_mode = true;
+
+    /** Whether to time each benchmark as a dependent chain, giving its latency. */
+    bool latency_mode = true;
+
+    /** Whether to time each benchmark over independent preloaded inputs, giving its reciprocal throughput. */
+    bool throughput_mode = true;
+
+    /** Number of points in the grid benchmark, zero skips it. */
+    std::size_t grid_count = std::size_t{1u} << 22u;
+
+    /** Number of inputs in the x87 benchmark, zero skips it. */
+    std::size_t x87_count = std::size_t{1u} << 22u;
+
+    /** Number of inputs from each distribution in the cache benchmark, zero skips it. */
+    std::size_t cache_count = std::size_t{1u} << 22u;
+
+    /** Number of inputs split between the threads in the scaling benchmark, zero skips it. */
+    std::size_t scaling_count = std::size_t{1u} << 24u;
+
+    /** Number of inputs in the device benchmark, zero skips it. */
+    std::size_t device_count = std::size_t{1u} << 24u;
+
+    /** Number of inputs preloaded for the latency and throughput modes. */
+    std::size_t stream_size = std::size_t{1u} << 22u;
+
+    /** How the inputs for the latency and throughput modes are made. */
+    Workload workload = {};
+
+    /** Whether to read hardware performance counters around the latency and throughput modes. */
+    bool counters = true;
+
+    /** Whether to pin sweep threads to cpus. */
+    bool pin = true;
+
+    /** How to set flush to zero and denormals are zero on the threads timing benchmarks. */
+    FlushMode flush = FlushMode::KEEP;
+
+    /** Path of results file to compare against, empty skips the comparison. */
+    std::string compare;
+
+    /** Glob patterns of kernels to run, empty runs every kernel. */
+    std::vector<std::string> only;
+
+    /** Glob patterns of kernels not to run. */
+    std::vector<std::string> skip;
+
+    /** Path to write benchmark results to, empty writes no results file. */
+    std::string results;
+
+    /** How the results file is written. */
+    ResultsFormat results_format = ResultsFormat::JSON;
+
+    /** Tolerance to pick the fastest kernel for instead of running benchmarks, empty runs benchmarks. */
+    std::optional<Tolerance> select;
+
+    /** Path of the selection table cache, empty to not cache. */
+    std::string selection_cache = "selection_table.csv";
+
+    /** Path of raw floats to calculate sine of instead of running benchmarks, - for stdin, empty runs benchmarks. */
+    std::string transform;
+
+    /** Where to write the sine of transform, - for stdout, empty to overwrite it in place. */
+    std::string transform_output;
+};
+
+/**
+ * Parse command line arguments.
+ *
+ * @param argc
+ *   Number of arguments.
+ *
+ * @param argv
+ *   Arguments, the first is the program name.
+ *
+ * @returns
+ *   Parsed options.
+ *
+ * @throws std::invalid_argument
+ *   If an argument is not recognised or has a bad value.
+ */
+Options parse_options(int argc, const char *const *argv);
+
+/**
+ * Get a description of the command line options.
+ *
+ * @returns
+ *   Usage text.
+ */
+std::string usage();
+
+}
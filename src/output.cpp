@@ -0,0 +1,271 @@
+#include "output.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(FS_USE_ZSTD)
+#include <zstd.h>
+#endif
+
+namespace
+{
+
+/**
+ * Throw the current errno as an exception.
+ *
+ * @param what
+ *   Description of what failed.
+ *
+ * @throws std::system_error
+ *   Always.
+ */
+[[noreturn]] void throw_errno(const std::string &what)
+{
+    throw std::system_error{errno, std::generic_category(), what};
+}
+
+/**
+ * Close a file after a failure and throw the errno of the failure.
+ *
+ * @param descriptor
+ *   File to close.
+ *
+ * @param what
+ *   Description of what failed.
+ *
+ * @throws std::system_error
+ *   Always.
+ */
+[[noreturn]] void close_and_throw(int descriptor, const std::string &what)
+{
+    const auto error = errno;
+    ::close(descriptor);
+    throw std::system_error{error, std::generic_category(), what};
+}
+
+/**
+ * Compress data with zstd and write it to a file.
+ *
+ * @param descriptor
+ *   File to write to.
+ *
+ * @param bytes
+ *   Data to compress.
+ *
+ * @param path
+ *   Path of file, used in error messages.
+ *
+ * @throws std::system_error
+ *   If compressing or writing fails, or this build doesn't support zstd.
+ */
+void compress(int descriptor, std::span<const std::byte> bytes, const std::string &path)
+{
+#if defined(FS_USE_ZSTD)
+    const auto context = std::unique_ptr<::ZSTD_CCtx, decltype(&::ZSTD_freeCCtx)>{::ZSTD_createCCtx(), ::ZSTD_freeCCtx};
+    auto output = std::vector<std::byte>(::ZSTD_CStreamOutSize());
+
+    // feed the compressor in large chunks so the writes are large too
+    constexpr auto chunk_size = std::size_t{1u} << 24u;
+
+    for (auto offset = std::size_t{0u}; offset < bytes.size(); offset += chunk_size)
+    {
+        const auto length = std::min(chunk_size, bytes.size() - offset);
+        const auto last = offset + length == bytes.size();
+
+        auto input = ::ZSTD_inBuffer{bytes.data() + offset, length, 0u};
+        auto finished = false;
+
+        while (!finished)
+        {
+            auto buffer = ::ZSTD_outBuffer{output.data(), output.size(), 0u};
+            const auto remaining =
+                ::ZSTD_compressStream2(context.get(), &buffer, &input, last ? ZSTD_e_end : ZSTD_e_continue);
+
+            if (::ZSTD_isError(remaining) != 0u)
+            {
+                throw std::system_error{
+                    std::make_error_code(std::errc::io_error),
+                    "failed to compress " + path + ": " + ::ZSTD_getErrorName(remaining)};
+            }
+
+            fs::harness::write_all(descriptor, {output.data(), buffer.pos}, path);
+
+            finished = last ? (remaining == 0u) : (input.pos == input.size);
+        }
+    }
+#else
+    static_cast<void>(descriptor);
+    static_cast<void>(bytes);
+    throw std::system_error{std::make_error_code(std::errc::not_supported), "zstd is not supported, " + path};
+#endif
+}
+
+}
+
+namespace fs::harness
+{
+
+std::string_view to_string(OutputFormat format)
+{
+    switch (format)
+    {
+        case OutputFormat::RAW: return "raw";
+        case OutputFormat::ZSTD: return "zstd";
+    }
+
+    return "unknown";
+}
+
+bool output_supported(OutputFormat format)
+{
+#if defined(FS_USE_ZSTD)
+    return (format == OutputFormat::RAW) || (format == OutputFormat::ZSTD);
+#else
+    return format == OutputFormat::RAW;
+#endif
+}
+
+void write_all(int descriptor, std::span<const std::byte> bytes, const std::string &path)
+{
+    while (!bytes.empty())
+    {
+        const auto written = ::write(descriptor, bytes.data(), bytes.size());
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            throw_errno("failed to write " + path);
+        }
+
+        bytes = bytes.subspan(static_cast<std::size_t>(written));
+    }
+}
+
+OutputFile::OutputFile(const std::string &path, std::size_t count, OutputFormat format)
+    : path_(format == OutputFormat::ZSTD ? path + ".zst" : path)
+    , format_(format)
+    , data_(nullptr)
+    , count_(count)
+    , descriptor_(-1)
+{
+    if (!output_supported(format))
+    {
+        throw std::system_error{
+            std::make_error_code(std::errc::not_supported),
+            std::string{to_string(format)} + " output is not supported by this build"};
+    }
+
+    descriptor_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (descriptor_ < 0)
+    {
+        throw_errno("failed to open " + path_);
+    }
+
+    const auto size = count_ * sizeof(float);
+    if (size == 0u)
+    {
+        return;
+    }
+
+    void *mapping = MAP_FAILED;
+
+    if (format_ == OutputFormat::RAW)
+    {
+        // preallocate so filling the mapping can't fail part way through with SIGBUS
+        if (::posix_fallocate(descriptor_, 0, static_cast<off_t>(size)) != 0)
+        {
+            if (::ftruncate(descriptor_, static_cast<off_t>(size)) != 0)
+            {
+                close_and_throw(descriptor_, "failed to size " + path_);
+            }
+        }
+
+        mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor_, 0);
+    }
+    else
+    {
+        mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+
+    if (mapping == MAP_FAILED)
+    {
+        close_and_throw(descriptor_, "failed to map " + path_);
+    }
+
+    data_ = static_cast<float *>(mapping);
+}
+
+OutputFile::~OutputFile()
+{
+    try
+    {
+        close();
+    }
+    catch (const std::system_error &)
+    {
+        // nothing can be reported from a destructor, call close explicitly to see errors
+    }
+}
+
+std::span<float> OutputFile::data() const
+{
+    return {data_, count_};
+}
+
+void OutputFile::close()
+{
+    if (descriptor_ < 0)
+    {
+        return;
+    }
+
+    const auto descriptor = descriptor_;
+    const auto size = count_ * sizeof(float);
+    descriptor_ = -1;
+
+    // always release the mapping and descriptor, even if compressing fails
+    const auto release = [&]
+    {
+        if (data_ != nullptr)
+        {
+            ::munmap(data_, size);
+            data_ = nullptr;
+        }
+
+        return ::close(descriptor);
+    };
+
+    try
+    {
+        if ((format_ == OutputFormat::ZSTD) && (data_ != nullptr))
+        {
+            compress(descriptor, {reinterpret_cast<const std::byte *>(data_), size}, path_);
+        }
+    }
+    catch (...)
+    {
+        release();
+        throw;
+    }
+
+    if (release() != 0)
+    {
+        throw_errno("failed to close " + path_);
+    }
+}
+
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace fs::harness
+{
+
+/**
+ * How data files are written.
+ */
+enum class OutputFormat
+{
+    /** Native floats with no header, loadable directly with np.memmap. */
+    RAW,
+
+    /** Raw data compressed with zstd, only available when built with USE_ZSTD. */
+    ZSTD
+};
+
+/**
+ * Get the name of an output format.
+ *
+ * @param format
+ *   Format.
+ *
+ * @returns
+ *   Name of format.
+ */
+std::string_view to_string(OutputFormat format);
+
+/**
+ * Check if an output format is available in this build.
+ *
+ * @param format
+ *   Format.
+ *
+ * @returns
+ *   True if files can be written in format, otherwise false.
+ */
+bool output_supported(OutputFormat format);
+
+/**
+ * Write all of a buffer to a file, retrying short writes.
+ *
+ * @param descriptor
+ *   File to write to.
+ *
+ * @param bytes
+ *   Data to write.
+ *
+ * @param path
+ *   Path of file, used in error messages.
+ *
+ * @throws std::system_error
+ *   If the write fails.
+ */
+void write_all(int descriptor, std::span<const std::byte> bytes, const std::string &path);
+
+/**
+ * A file of floats which is filled in place and written out once.
+ *
+ * Raw files are preallocated and memory mapped, so filling the data is the write and the page cache does the I/O in
+ * large blocks. Compressed files are filled in an anonymous mapping and streamed through zstd in large chunks when the
+ * file is closed, with .zst appended to the name.
+ */
+class OutputFile
+{
+  public:
+    /**
+     * Construct a new OutputFile.
+     *
+     * @param path
+     *   Path of file to create, any existing file is replaced.
+     *
+     * @param count
+     *   Number of floats in the file.
+     *
+     * @param format
+     *   How to write the file, must be supported.
+     *
+     * @throws std::system_error
+     *   If the file or mapping can't be created.
+     */
+    OutputFile(const std::string &path, std::size_t count, OutputFormat format);
+
+    ~OutputFile();
+
+    OutputFile(const OutputFile &) = delete;
+    OutputFile &operator=(const OutputFile &) = delete;
+
+    /**
+     * Get the data to fill.
+     *
+     * @returns
+     *   Data of file.
+     */
+    std::span<float> data() const;
+
+    /**
+     * Finish writing the file and release the mapping, called by the destructor if not called explicitly.
+     *
+     * @throws std::system_error
+     *   If the data can't be written.
+     */
+    void close();
+
+  private:
+    /** Path of file being written. */
+    std::string path_;
+
+    /** How the file is written. */
+    OutputFormat format_;
+
+    /** Mapped data. */
+    float *data_;
+
+    /** Number of floats in data. */
+    std::size_t count_;
+
+    /** Descriptor of raw file, -1 if there isn't one. */
+    int descriptor_;
+};
+
+}
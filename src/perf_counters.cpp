@@ -0,0 +1,320 @@
+#include "perf_counters.h"
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace
+{
+
+#if defined(__linux__)
+
+/**
+ * Get the raw event which counts floating point assists on this cpu. There is no generic perf event for this, so it
+ * is only known for Intel cores: FP_ASSIST.ANY from Sandy Bridge to the Skylake derivatives and ASSISTS.FP from Ice
+ * Lake on.
+ *
+ * @returns
+ *   Raw event config, empty if the cpu has no known assist event.
+ */
+std::optional<std::uint64_t> fp_assist_event()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    auto eax = 0u;
+    auto ebx = 0u;
+    auto ecx = 0u;
+    auto edx = 0u;
+
+    // vendor string is split across ebx, edx and ecx in that order
+    if ((__get_cpuid(0u, &eax, &ebx, &ecx, &edx) == 0) || (ebx != 0x756e6547u) || (edx != 0x49656e69u) ||
+        (ecx != 0x6c65746eu))
+    {
+        return std::nullopt;
+    }
+
+    if (__get_cpuid(1u, &eax, &ebx, &ecx, &edx) == 0)
+    {
+        return std::nullopt;
+    }
+
+    const auto family = (eax >> 8u) & 0xfu;
+    const auto model = ((eax >> 4u) & 0xfu) | (((eax >> 16u) & 0xfu) << 4u);
+
+    if (family != 6u)
+    {
+        return std::nullopt;
+    }
+
+    constexpr auto assists_fp_models = std::array<unsigned, 18u>{
+        0x6a, 0x6c, 0x7d, 0x7e, 0x8c, 0x8d, 0x8f, 0x97, 0x9a, 0xa7, 0xaa, 0xac, 0xad, 0xae, 0xb7, 0xba, 0xbf, 0xcf};
+
+    for (const auto newer : assists_fp_models)
+    {
+        if (model == newer)
+        {
+            return 0x02c1u;
+        }
+    }
+
+    return 0x1ecau;
+#else
+    return std::nullopt;
+#endif
+}
+
+/**
+ * Open a counter for the calling thread, disabled until started.
+ *
+ * @param type
+ *   Perf event type.
+ *
+ * @param config
+ *   Perf event config.
+ *
+ * @returns
+ *   File descriptor of counter, or -1 with errno set if it couldn't be opened.
+ */
+int open_counter(std::uint32_t type, std::uint64_t config)
+{
+    auto attributes = ::perf_event_attr{};
+    attributes.size = sizeof(attributes);
+    attributes.type = type;
+    attributes.config = config;
+    attributes.disabled = 1u;
+    attributes.exclude_kernel = 1u;
+    attributes.exclude_hv = 1u;
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+/**
+ * Open the counter for an event.
+ *
+ * @param counter
+ *   Event to count.
+ *
+ * @returns
+ *   File descriptor of counter, or -1 with errno set if it couldn't be opened.
+ */
+int open_counter(fs::harness::Counter counter)
+{
+    switch (counter)
+    {
+        case fs::harness::Counter::CYCLES: return open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        case fs::harness::Counter::INSTRUCTIONS: return open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        case fs::harness::Counter::BRANCH_MISSES: return open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+        case fs::harness::Counter::L1D_MISSES:
+            return open_counter(
+                PERF_TYPE_HW_CACHE,
+                PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8u) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u));
+        case fs::harness::Counter::FP_ASSISTS:
+        {
+            const auto event = fp_assist_event();
+            if (!event)
+            {
+                errno = ENOENT;
+                return -1;
+            }
+
+            return open_counter(PERF_TYPE_RAW, *event);
+        }
+    }
+
+    errno = EINVAL;
+    return -1;
+}
+
+#endif
+
+}
+
+namespace fs::harness
+{
+
+std::string_view to_string(Counter counter)
+{
+    switch (counter)
+    {
+        case Counter::CYCLES: return "cycles";
+        case Counter::INSTRUCTIONS: return "instructions";
+        case Counter::BRANCH_MISSES: return "branch_misses";
+        case Counter::L1D_MISSES: return "l1d_misses";
+        case Counter::FP_ASSISTS: return "fp_assists";
+    }
+
+    return "unknown";
+}
+
+bool CounterValues::empty() const
+{
+    for (const auto &count : counts)
+    {
+        if (count)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::optional<double> CounterValues::per_element(Counter counter) const
+{
+    const auto &count = counts[static_cast<std::size_t>(counter)];
+    if (!count || (elements == 0u))
+    {
+        return std::nullopt;
+    }
+
+    return *count / static_cast<double>(elements);
+}
+
+std::optional<double> CounterValues::ipc() const
+{
+    const auto &cycles = counts[static_cast<std::size_t>(Counter::CYCLES)];
+    const auto &instructions = counts[static_cast<std::size_t>(Counter::INSTRUCTIONS)];
+
+    if (!cycles || !instructions || (*cycles == 0.0))
+    {
+        return std::nullopt;
+    }
+
+    return *instructions / *cycles;
+}
+
+CounterValues &CounterValues::operator+=(const CounterValues &other)
+{
+    for (auto i = std::size_t{0u}; i < counter_count; ++i)
+    {
+        counts[i] = (counts[i] && other.counts[i]) ? std::optional{*counts[i] + *other.counts[i]} : std::nullopt;
+    }
+
+    elements += other.elements;
+
+    return *this;
+}
+
+PerfCounters::PerfCounters()
+    : fds_()
+    , error_()
+{
+    fds_.fill(-1);
+
+#if defined(__linux__)
+    for (const auto counter : all_counters)
+    {
+        const auto fd = open_counter(counter);
+        if ((fd < 0) && error_.empty())
+        {
+            error_ = std::string{to_string(counter)} + ": " + std::strerror(errno);
+            if ((errno == EACCES) || (errno == EPERM))
+            {
+                error_ += " (see /proc/sys/kernel/perf_event_paranoid)";
+            }
+        }
+
+        fds_[static_cast<std::size_t>(counter)] = fd;
+    }
+#else
+    error_ = "hardware counters are only supported on linux";
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(__linux__)
+    for (const auto fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::available() const
+{
+    for (const auto fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+const std::string &PerfCounters::error() const
+{
+    return error_;
+}
+
+void PerfCounters::start()
+{
+#if defined(__linux__)
+    for (const auto fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+CounterValues PerfCounters::stop(std::uint64_t elements)
+{
+    auto values = CounterValues{.counts = {}, .elements = elements};
+
+#if defined(__linux__)
+    for (const auto fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+
+    for (auto i = std::size_t{0u}; i < counter_count; ++i)
+    {
+        if (fds_[i] < 0)
+        {
+            continue;
+        }
+
+        // value, time enabled, time running
+        std::uint64_t data[3] = {};
+        if ((::read(fds_[i], data, sizeof(data)) != static_cast<::ssize_t>(sizeof(data))) || (data[2] == 0u))
+        {
+            continue;
+        }
+
+        values.counts[i] = static_cast<double>(data[0]) * (static_cast<double>(data[1]) / static_cast<double>(data[2]));
+    }
+#endif
+
+    return values;
+}
+
+}
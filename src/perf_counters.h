@@ -0,0 +1,167 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace fs::harness
+{
+
+/**
+ * Hardware event counted around a kernel run.
+ */
+enum class Counter
+{
+    /** Core clock cycles, unlike the cycle counter these follow the current clock speed. */
+    CYCLES,
+
+    /** Instructions retired. */
+    INSTRUCTIONS,
+
+    /** Mispredicted branches retired. */
+    BRANCH_MISSES,
+
+    /** Level 1 data cache read misses. */
+    L1D_MISSES,
+
+    /** Floating point operations that needed microcode assistance, such as denormal inputs or outputs. */
+    FP_ASSISTS
+};
+
+/** Number of counters. */
+inline constexpr auto counter_count = std::size_t{5u};
+
+/** Every counter, in the order they are reported. */
+inline constexpr auto all_counters = std::array<Counter, counter_count>{
+    Counter::CYCLES,
+    Counter::INSTRUCTIONS,
+    Counter::BRANCH_MISSES,
+    Counter::L1D_MISSES,
+    Counter::FP_ASSISTS};
+
+/**
+ * Get the name of a counter.
+ *
+ * @param counter
+ *   Counter.
+ *
+ * @returns
+ *   Name of counter.
+ */
+std::string_view to_string(Counter counter);
+
+/**
+ * Counts read over one or more kernel runs.
+ */
+struct CounterValues
+{
+    /** Count of each event, in the order of all_counters, empty if the event couldn't be counted. */
+    std::array<std::optional<double>, counter_count> counts = {};
+
+    /** Number of elements calculated while counting. */
+    std::uint64_t elements = 0u;
+
+    /**
+     * Check if anything was counted.
+     *
+     * @returns
+     *   True if at least one event was counted, otherwise false.
+     */
+    bool empty() const;
+
+    /**
+     * Get the count of an event per element calculated.
+     *
+     * @param counter
+     *   Event to get.
+     *
+     * @returns
+     *   Count per element, empty if the event wasn't counted.
+     */
+    std::optional<double> per_element(Counter counter) const;
+
+    /**
+     * Get the instructions retired per core cycle.
+     *
+     * @returns
+     *   Instructions per cycle, empty if either event wasn't counted.
+     */
+    std::optional<double> ipc() const;
+
+    /**
+     * Add the counts of further runs.
+     *
+     * @param other
+     *   Counts to add, events missing from either are missing from the result.
+     *
+     * @returns
+     *   Reference to this.
+     */
+    CounterValues &operator+=(const CounterValues &other);
+};
+
+/**
+ * Hardware performance counters for the calling thread, read with perf_event_open on linux.
+ *
+ * Each event is opened on its own so an event the cpu or kernel doesn't support only loses that event. Counts are
+ * scaled by the fraction of time each event was actually on the pmu, in case the kernel had to multiplex them. Only
+ * user space is counted so the counters can be read with the default perf_event_paranoid setting.
+ */
+class PerfCounters
+{
+  public:
+    /**
+     * Construct a new PerfCounters, opening every event that can be opened. This never fails, check available() to
+     * see if anything can be counted.
+     */
+    PerfCounters();
+
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    /**
+     * Check if any event can be counted.
+     *
+     * @returns
+     *   True if at least one event was opened, otherwise false.
+     */
+    bool available() const;
+
+    /**
+     * Get why events couldn't be opened.
+     *
+     * @returns
+     *   Description of the first failure, empty if every event was opened.
+     */
+    const std::string &error() const;
+
+    /**
+     * Reset and start every opened event.
+     */
+    void start();
+
+    /**
+     * Stop every opened event and read the counts.
+     *
+     * @param elements
+     *   Number of elements calculated since start.
+     *
+     * @returns
+     *   Counts since start.
+     */
+    CounterValues stop(std::uint64_t elements);
+
+  private:
+    /** File descriptor of each event, -1 if it couldn't be opened. */
+    std::array<int, counter_count> fds_;
+
+    /** Description of the first failure. */
+    std::string error_;
+};
+
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "phase.h"
+#include "sweep.h"
+#include "thread_pool.h"
+#include "timing.h"
+
+namespace fs::harness
+{
+
+/**
+ * Get the angle of a phase.
+ *
+ * @param phase
+ *   Phase, where 2^32 is a full turn.
+ *
+ * @returns
+ *   Angle in radians, in [0, 2pi).
+ */
+inline double phase_radians(Phase phase)
+{
+    return static_cast<double>(phase) * (2.0 * std::numbers::pi / 4294967296.0);
+}
+
+/**
+ * Get the phase nearest an angle, so the usual float inputs can be used for latency and throughput runs.
+ *
+ * @param theta
+ *   Angle in radians.
+ *
+ * @returns
+ *   Phase of angle, zero if it isn't finite.
+ */
+inline Phase to_phase(float theta)
+{
+    const auto turns = static_cast<double>(theta) / (2.0 * std::numbers::pi);
+    if (!std::isfinite(turns))
+    {
+        return 0u;
+    }
+
+    // the product can round up to a whole turn, which wraps to zero when narrowed
+    return static_cast<Phase>(static_cast<std::uint64_t>((turns - std::floor(turns)) * 4294967296.0));
+}
+
+/**
+ * Get the value of a phase kernel result.
+ *
+ * @param result
+ *   Result, float, q15 or q31.
+ *
+ * @returns
+ *   Value of result, in [-1, 1) for fixed point results.
+ */
+template <class R>
+double phase_result_value(R result)
+{
+    if constexpr (std::is_same_v<R, float>)
+    {
+        return static_cast<double>(result);
+    }
+    else
+    {
+        return std::ldexp(static_cast<double>(result), -static_cast<int>((sizeof(R) * 8u) - 1u));
+    }
+}
+
+/**
+ * Sweep a range of phases across a thread pool, timing a batch function a block at a time and comparing it to sine
+ * calculated in double. The range is the same one float bit patterns are swept over, so the default sweep of all 2^32
+ * patterns checks every phase.
+ *
+ * @tparam R
+ *   Result type, float, q15 or q31.
+ *
+ * @param calculate_block
+ *   Function taking a span of phases and a span of results.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for sweep, the range is in phases.
+ *
+ * @returns
+ *   Combined result of sweep, with errors in the value of the results and inputs as angles in radians.
+ */
+template <class R, class CalculateBlock>
+SweepResult sweep_phases(CalculateBlock calculate_block, ThreadPool &pool, const SweepOptions &options)
+{
+    const auto use_cycle_counter = options.use_cycle_counter && has_cycle_counter();
+
+    return detail::sweep_blocks<Phase, R>(
+        [&](std::uint64_t first, std::span<Phase> in, std::span<R> out, Timing &timing)
+        {
+            for (auto i = std::size_t{0u}; i < in.size(); ++i)
+            {
+                in[i] = static_cast<Phase>(first + i);
+            }
+
+            time_batch_call(calculate_block, std::span<const Phase>{in}, out, use_cycle_counter, timing);
+        },
+        [](std::uint64_t, std::span<const Phase> in, std::span<const R> out, ErrorStats &errors)
+        {
+            for (auto i = std::size_t{0u}; i < in.size(); ++i)
+            {
+                const auto radians = phase_radians(in[i]);
+                const auto value = phase_result_value(out[i]);
+
+                // the reference is never NaN, so any NaN result is a mismatch
+                const auto error = is_nan(value) ? value : std::fabs(value - std::sin(radians));
+                errors.add(static_cast<float>(radians), error);
+            }
+        },
+        pool,
+        detail::batch_sweep_options(options));
+}
+
+/**
+ * Time a batch phase function in either mode, subtracting the batch baseline. Latency feeds the bits of each result
+ * into the next phase the same way as time_batch_latency.
+ *
+ * @tparam R
+ *   Result type, float, q15 or q31.
+ *
+ * @param calculate_block
+ *   Function taking a span of phases and a span of results.
+ *
+ * @param mode
+ *   Mode to time in.
+ *
+ * @param inputs
+ *   Angles, converted to phases before timing starts.
+ *
+ * @param options
+ *   Options for timing.
+ *
+ * @returns
+ *   Timing of calculator.
+ */
+template <class R, class CalculateBlock>
+Timing time_phase_mode(
+    CalculateBlock calculate_block,
+    TimingMode mode,
+    std::span<const float> inputs,
+    const StreamOptions &options)
+{
+    using Bits = std::conditional_t<sizeof(R) == sizeof(std::uint16_t), std::uint16_t, std::uint32_t>;
+
+    auto phases = std::vector<Phase>(inputs.size());
+    std::ranges::transform(inputs, phases.begin(), to_phase);
+
+    const auto batch_options = detail::batch_stream_options(options);
+
+    if (mode == TimingMode::LATENCY)
+    {
+        const auto mask = opaque_zero();
+        Phase phase[1] = {};
+        R output[1] = {};
+
+        auto timing = start_run(batch_options);
+        const auto start = std::chrono::high_resolution_clock::now();
+
+        for (const auto next : phases)
+        {
+            phase[0] = next | (static_cast<Phase>(std::bit_cast<Bits>(output[0])) & mask);
+            calculate_block(std::span<const Phase>{phase}, std::span<R>{output});
+        }
+
+        timing = finish_run(batch_options, timing, start, phases.size());
+
+        escape(output);
+
+        return timing;
+    }
+
+    auto outputs = std::vector<R>(phases.size());
+
+    auto timing = start_run(batch_options);
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    calculate_block(std::span<const Phase>{phases}, std::span{outputs});
+
+    timing = finish_run(batch_options, timing, start, phases.size());
+
+    escape(outputs.data());
+
+    return timing;
+}
+
+}
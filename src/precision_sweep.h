@@ -0,0 +1,420 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "accuracy.h"
+#include "precision.h"
+#include "sweep.h"
+#include "thread_pool.h"
+#include "timing.h"
+
+namespace fs::harness
+{
+
+/**
+ * True if every value of T is swept rather than a range of float bit patterns, which is the case for 16 bit types as
+ * all 2^16 of them take less time than a single float binade.
+ */
+template <class T>
+inline constexpr bool exhaustive_v = sizeof(T) == sizeof(std::uint16_t);
+
+/**
+ * Range of bit patterns swept for a type.
+ */
+struct PatternRange
+{
+    /** First bit pattern. */
+    std::uint64_t first = 0u;
+
+    /** Number of bit patterns. */
+    std::uint64_t count = 0u;
+};
+
+/**
+ * Get the bit patterns to sweep for a type.
+ *
+ * @param first
+ *   First float bit pattern asked for.
+ *
+ * @param count
+ *   Number of float bit patterns asked for.
+ *
+ * @returns
+ *   Every bit pattern of T if it is swept exhaustively, otherwise the float bit patterns asked for.
+ */
+template <class T>
+PatternRange pattern_range(std::uint64_t first, std::uint64_t count)
+{
+    if constexpr (exhaustive_v<T>)
+    {
+        return {.first = 0u, .count = std::uint64_t{1u} << 16u};
+    }
+    else
+    {
+        return {.first = first, .count = count};
+    }
+}
+
+/**
+ * Get the input for a bit pattern. 16 bit types use the pattern as their own bits, double widens the float with that
+ * pattern so a double sweep covers the same values as a float one.
+ *
+ * @param pattern
+ *   Bit pattern.
+ *
+ * @returns
+ *   Input value.
+ */
+template <class T>
+T value_at(std::uint64_t pattern)
+{
+    if constexpr (exhaustive_v<T>)
+    {
+        return std::bit_cast<T>(static_cast<std::uint16_t>(pattern));
+    }
+    else
+    {
+        return static_cast<T>(std::bit_cast<float>(static_cast<std::uint32_t>(pattern)));
+    }
+}
+
+/**
+ * Widen a value to long double, exactly.
+ *
+ * @param value
+ *   Value to widen.
+ *
+ * @returns
+ *   Value as a long double.
+ */
+template <class T>
+long double widen(T value)
+{
+    return static_cast<long double>(static_cast<compute_t<T>>(value));
+}
+
+/**
+ * Get the binade of a bit pattern, indexed by the biased float exponent of its value so every type shares the binade
+ * numbering of AccuracyResult. Denormals of the narrower types all count as binade zero along with float denormals.
+ *
+ * @param pattern
+ *   Bit pattern.
+ *
+ * @returns
+ *   Binade index.
+ */
+template <class T>
+std::size_t binade_of(std::uint64_t pattern)
+{
+    if constexpr (std::is_same_v<T, bfloat16>)
+    {
+        return static_cast<std::size_t>((pattern >> 7u) & 0xffu);
+    }
+    else if constexpr (exhaustive_v<T>)
+    {
+        // half, with a 5 bit exponent biased by 15
+        const auto exponent = static_cast<std::size_t>((pattern >> 10u) & 0x1fu);
+        return exponent == 0u ? 0u : (exponent == 0x1fu ? 0xffu : exponent - 15u + 127u);
+    }
+    else
+    {
+        return static_cast<std::size_t>((pattern >> 23u) & 0xffu);
+    }
+}
+
+/**
+ * Number of consecutive bit patterns in a binade of a type.
+ */
+template <class T>
+inline constexpr auto binade_patterns_v =
+    std::is_same_v<T, bfloat16> ? std::uint64_t{1u} << 7u
+                                : (exhaustive_v<T> ? std::uint64_t{1u} << 10u : std::uint64_t{1u} << 23u);
+
+/**
+ * Reference sine for sweeps of any type, computed in long double.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+template <class T>
+long double reference_sin_as(T theta)
+{
+    return std::sin(widen(theta));
+}
+
+/**
+ * Reference cos for sweeps of any type, computed in long double.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Cos of input value.
+ */
+template <class T>
+long double reference_cos_as(T theta)
+{
+    return std::cos(widen(theta));
+}
+
+/**
+ * Calculate the absolute error between a result of any type and a long double reference.
+ *
+ * @param result
+ *   Calculated value.
+ *
+ * @param reference
+ *   Reference value.
+ *
+ * @returns
+ *   Absolute error, zero if both are NaN and NaN if only one is.
+ */
+template <class T>
+double absolute_error_as(T result, long double reference)
+{
+    const auto result_nan = is_nan(static_cast<compute_t<T>>(result));
+    const auto reference_nan = is_nan(static_cast<double>(reference));
+
+    if (result_nan || reference_nan)
+    {
+        return result_nan == reference_nan ? 0.0 : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    return static_cast<double>(std::fabs(widen(result) - reference));
+}
+
+/**
+ * Calculate the distance between a result and a long double reference, in units in the last place of the reference
+ * rounded to T.
+ *
+ * @param result
+ *   Calculated value.
+ *
+ * @param reference
+ *   Reference value.
+ *
+ * @returns
+ *   Error in ulps, zero if both are NaN and NaN if only one is or if the result is not finite but the reference is.
+ */
+template <class T>
+double ulp_error_as(T result, long double reference)
+{
+    using traits = precision_traits<T>;
+
+    const auto difference = absolute_error_as(result, reference);
+    if (is_nan(difference) || (difference == 0.0))
+    {
+        return difference;
+    }
+
+    if (!(difference <= std::numeric_limits<double>::max()))
+    {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    // an ulp is 2^(1 - digits) of the power of two at or below the value, and never smaller than the smallest denormal
+    auto exponent = traits::min_denormal_exponent + traits::digits;
+    if (reference != 0.0L)
+    {
+        std::frexp(reference, &exponent);
+    }
+    const auto ulp = std::ldexp(1.0, std::max(exponent - traits::digits, traits::min_denormal_exponent));
+
+    return difference / ulp;
+}
+
+/**
+ * Convert the inputs used for latency and throughput runs to a type. Types swept exhaustively get every one of their
+ * values spread across the stream instead, most floats would round to zero or infinity.
+ *
+ * @param inputs
+ *   Float inputs.
+ *
+ * @returns
+ *   Inputs of type T, the same number as inputs.
+ */
+template <class T>
+std::vector<T> stream_values(std::span<const float> inputs)
+{
+    auto values = std::vector<T>(inputs.size());
+
+    for (auto i = std::size_t{0u}; i < inputs.size(); ++i)
+    {
+        if constexpr (exhaustive_v<T>)
+        {
+            values[i] = value_at<T>((static_cast<std::uint64_t>(i) << 16u) / inputs.size());
+        }
+        else
+        {
+            values[i] = static_cast<T>(inputs[i]);
+        }
+    }
+
+    return values;
+}
+
+/**
+ * Sweep the bit patterns of a type across a thread pool, timing a batch function a block at a time and comparing it to
+ * a long double reference.
+ *
+ * @tparam T
+ *   Type calculated, 16 bit types sweep every value and ignore the range in options.
+ *
+ * @tparam Outputs
+ *   Number of outputs per input, one for sine or two for sines followed by cosines.
+ *
+ * @param calculate_block
+ *   Function taking a span of inputs and a span of Outputs times as many outputs.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for sweep.
+ *
+ * @returns
+ *   Combined result of sweep.
+ */
+template <class T, std::size_t Outputs = 1u, class CalculateBlock>
+SweepResult sweep_values(CalculateBlock calculate_block, ThreadPool &pool, const SweepOptions &options)
+{
+    const auto range = pattern_range<T>(options.first, options.count);
+    const auto use_cycle_counter = options.use_cycle_counter && has_cycle_counter();
+
+    auto values_options = detail::batch_sweep_options(options);
+    values_options.first = range.first;
+    values_options.count = range.count;
+
+    // all 2^16 values are only a few blocks, smaller chunks keep every thread busy
+    if constexpr (exhaustive_v<T>)
+    {
+        values_options.chunk_size = std::min<std::uint64_t>(options.chunk_size, 4096u);
+    }
+
+    return detail::sweep_blocks<T, T, Outputs>(
+        [&](std::uint64_t first, std::span<T> in, std::span<T> out, Timing &timing)
+        {
+            for (auto i = std::size_t{0u}; i < in.size(); ++i)
+            {
+                in[i] = value_at<T>(first + i);
+            }
+
+            time_batch_call(calculate_block, std::span<const T>{in}, out, use_cycle_counter, timing);
+        },
+        [](std::uint64_t, std::span<const T> in, std::span<const T> out, ErrorStats &errors)
+        {
+            for (auto i = std::size_t{0u}; i < in.size(); ++i)
+            {
+                auto error = absolute_error_as(out[i], reference_sin_as(in[i]));
+
+                if constexpr (Outputs == 2u)
+                {
+                    const auto cos_error = absolute_error_as(out[in.size() + i], reference_cos_as(in[i]));
+                    error = is_nan(cos_error) ? cos_error : std::max(error, cos_error);
+                }
+
+                errors.add(static_cast<float>(widen(in[i])), error);
+            }
+        },
+        pool,
+        values_options);
+}
+
+/**
+ * Check the ulp error of a batch function over the bit patterns of a type, in ulps of that type.
+ *
+ * Chunks are aligned so none crosses a binade of T, the same as check_accuracy does for floats.
+ *
+ * @tparam T
+ *   Type calculated, 16 bit types check every value and ignore the range in options.
+ *
+ * @param calculate_block
+ *   Function called with the inputs of a block and where to write the results.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for check.
+ *
+ * @returns
+ *   Combined result of check.
+ */
+template <class T, class CalculateBlock>
+AccuracyResult check_values(CalculateBlock calculate_block, ThreadPool &pool, const AccuracyOptions &options)
+{
+    const auto range = pattern_range<T>(options.first, options.count);
+    const auto chunk_size = std::bit_floor(std::clamp<std::uint64_t>(options.chunk_size, 1u, binade_patterns_v<T>));
+    const auto block_size = std::max<std::size_t>(options.block_size, 1u);
+    const auto end = range.first + range.count;
+
+    // chunk boundaries are multiples of chunk_size, the first and last may be partial
+    const auto first_chunk = range.first / chunk_size;
+    const auto chunk_count =
+        range.count == 0u ? std::size_t{0u} : static_cast<std::size_t>(((end - 1u) / chunk_size) - first_chunk + 1u);
+
+    auto chunk_stats = std::vector<UlpStats>(chunk_count);
+
+    pool.parallel_for(
+        chunk_count,
+        [&](std::size_t chunk, std::size_t)
+        {
+            auto thetas = std::vector<T>(block_size);
+            auto results = std::vector<T>(block_size);
+
+            const auto chunk_first = std::max(range.first, (first_chunk + chunk) * chunk_size);
+            const auto chunk_end = std::min(end, (first_chunk + chunk + 1u) * chunk_size);
+
+            for (auto block_first = chunk_first; block_first < chunk_end; block_first += block_size)
+            {
+                const auto size =
+                    static_cast<std::size_t>(std::min<std::uint64_t>(block_size, chunk_end - block_first));
+                const auto in = std::span{thetas}.first(size);
+                const auto out = std::span{results}.first(size);
+
+                for (auto i = std::size_t{0u}; i < size; ++i)
+                {
+                    in[i] = value_at<T>(block_first + i);
+                }
+
+                calculate_block(std::span<const T>{in}, out);
+
+                for (auto i = std::size_t{0u}; i < size; ++i)
+                {
+                    const auto expected = reference_sin_as(in[i]);
+                    const auto absolute = absolute_error_as(out[i], expected);
+
+                    chunk_stats[chunk].add(
+                        static_cast<float>(widen(in[i])),
+                        ulp_error_as(out[i], expected),
+                        absolute,
+                        relative_error(absolute, static_cast<double>(expected)));
+                }
+            }
+        });
+
+    auto result = AccuracyResult{};
+
+    for (auto chunk = std::size_t{0u}; chunk < chunk_count; ++chunk)
+    {
+        const auto binade = binade_of<T>((first_chunk + chunk) * chunk_size);
+
+        result.binades[binade].merge(chunk_stats[chunk]);
+        result.total.merge(chunk_stats[chunk]);
+    }
+
+    return result;
+}
+
+}
@@ -0,0 +1,212 @@
+#include "registry.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fs::harness
+{
+
+bool glob_match(std::string_view pattern, std::string_view name)
+{
+    auto p = std::size_t{0u};
+    auto n = std::size_t{0u};
+
+    // position of the last * seen and the name position it is currently matched up to, so a failed match can backtrack
+    // by letting the * swallow one more character
+    auto star = std::string_view::npos;
+    auto star_name = std::size_t{0u};
+
+    while (n < name.size())
+    {
+        if ((p < pattern.size()) && ((pattern[p] == '?') || (pattern[p] == name[n])))
+        {
+            ++p;
+            ++n;
+        }
+        else if ((p < pattern.size()) && (pattern[p] == '*'))
+        {
+            star = p++;
+            star_name = n;
+        }
+        else if (star != std::string_view::npos)
+        {
+            p = star + 1u;
+            n = ++star_name;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while ((p < pattern.size()) && (pattern[p] == '*'))
+    {
+        ++p;
+    }
+
+    return p == pattern.size();
+}
+
+bool is_selected(std::string_view name, const std::vector<std::string> &only, const std::vector<std::string> &skip)
+{
+    const auto matches = [name](const std::string &pattern) { return glob_match(pattern, name); };
+
+    return (only.empty() || std::ranges::any_of(only, matches)) && std::ranges::none_of(skip, matches);
+}
+
+Registry::Registry(SinReference sin_reference, SinCosReference sin_cos_reference)
+    : sin_reference_(sin_reference)
+    , sin_cos_reference_(sin_cos_reference)
+    , kernels_()
+{
+}
+
+Kernel &Registry::add_calculator(
+    std::string name,
+    std::shared_ptr<const Calculator> calculator,
+    double error_bound,
+    Isa isa,
+    std::string variant)
+{
+    const auto shared = std::move(calculator);
+    const auto reference = sin_reference_;
+
+    auto &kernel = add(std::move(name), isa, error_bound);
+
+    kernel.write_data = [shared, reference](const std::string &file_name, OutputFormat format)
+    {
+        return harness::write_data(
+            file_name, [&calculator = *shared](float theta) { return calculator.calculate(theta); }, reference, format);
+    };
+    kernel.check_accuracy = [shared](ThreadPool &pool, const AccuracyOptions &options)
+    { return harness::check_accuracy(*shared, reference_sin, pool, options); };
+
+    add_batch_benchmark(kernel, shared, std::move(variant));
+
+    return kernel;
+}
+
+Kernel &Registry::add_sin_cos_calculator(
+    std::string name,
+    std::shared_ptr<const SinCosCalculator> calculator,
+    double error_bound,
+    Isa isa,
+    std::string variant)
+{
+    const auto shared = std::move(calculator);
+    const auto reference = sin_cos_reference_;
+
+    auto &kernel = add(std::move(name), isa, error_bound);
+
+    kernel.benchmarks.push_back(
+        {kernel.name,
+         "scalar",
+         [shared, reference](ThreadPool &pool, const SweepOptions &options)
+         { return sweep(*shared, reference, pool, options); },
+         [shared](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+         {
+             return time_mode(
+                 [&calculator = *shared](float theta) { return calculator.calculate(theta); },
+                 mode,
+                 inputs,
+                 options);
+         }});
+    kernel.benchmarks.push_back(
+        {kernel.name + " batch",
+         variant,
+         [shared, reference](ThreadPool &pool, const SweepOptions &options)
+         { return sweep_batch(*shared, reference, pool, options, SinCosLayout::SPLIT); },
+         [shared](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+         {
+             return time_batch_mode<2u>(
+                 [&calculator = *shared](std::span<const float> in, std::span<float> out)
+                 { calculator.calculate(in, out.first(in.size()), out.subspan(in.size(), in.size())); },
+                 mode,
+                 inputs,
+                 options);
+         }});
+    kernel.benchmarks.push_back(
+        {kernel.name + " interleaved batch",
+         variant,
+         [shared, reference](ThreadPool &pool, const SweepOptions &options)
+         { return sweep_batch(*shared, reference, pool, options, SinCosLayout::INTERLEAVED); },
+         [shared](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+         {
+             return time_batch_mode<2u>(
+                 [&calculator = *shared](std::span<const float> in, std::span<float> out)
+                 { calculator.calculate(in, out); },
+                 mode,
+                 inputs,
+                 options);
+         }});
+
+    return kernel;
+}
+
+std::vector<const Kernel *> Registry::kernels() const
+{
+    return select({}, {});
+}
+
+std::vector<const Kernel *> Registry::select(const std::vector<std::string> &only, const std::vector<std::string> &skip)
+    const
+{
+    auto selected = std::vector<const Kernel *>{};
+
+    for (const auto &kernel : kernels_)
+    {
+        if (is_selected(kernel->name, only, skip))
+        {
+            selected.push_back(kernel.get());
+        }
+    }
+
+    return selected;
+}
+
+Kernel &Registry::add(std::string name, Isa isa, double error_bound)
+{
+    if (std::ranges::any_of(kernels_, [&name](const auto &kernel) { return kernel->name == name; }))
+    {
+        throw std::invalid_argument{"kernel registered twice: " + name};
+    }
+
+    auto kernel = std::make_unique<Kernel>();
+    kernel->name = std::move(name);
+    kernel->isa = isa;
+    kernel->error_bound = error_bound;
+
+    return *kernels_.emplace_back(std::move(kernel));
+}
+
+void Registry::add_batch_benchmark(Kernel &kernel, std::shared_ptr<const Calculator> calculator, std::string variant)
+{
+    const auto reference = sin_reference_;
+
+    kernel.transform = [calculator](std::span<const float> in, std::span<float> out)
+    { calculator->calculate(in, out); };
+    kernel.calculator = calculator;
+    kernel.benchmarks.push_back(
+        {kernel.name + " batch",
+         std::move(variant),
+         [calculator, reference](ThreadPool &pool, const SweepOptions &options)
+         { return sweep_batch(*calculator, reference, pool, options); },
+         [calculator](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+         {
+             return time_batch_mode(
+                 [&calculator = *calculator](std::span<const float> in, std::span<float> out)
+                 { calculator.calculate(in, out); },
+                 mode,
+                 inputs,
+                 options);
+         }});
+}
+
+}
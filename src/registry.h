@@ -0,0 +1,908 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "accuracy.h"
+#include "calculator.h"
+#include "cpu_features.h"
+#include "domain.h"
+#include "kernel_calculator.h"
+#include "output.h"
+#include "phase.h"
+#include "phase_sweep.h"
+#include "precision_sweep.h"
+#include "sin_reduced.h"
+#include "sine_kernel.h"
+#include "sin_cos_calculator.h"
+#include "sweep.h"
+#include "thread_pool.h"
+#include "timing.h"
+#include "transform.h"
+
+namespace fs::harness
+{
+
+/**
+ * A single timed run of a kernel through one of its entry points.
+ */
+struct Benchmark
+{
+    /** Label printed with the result. */
+    std::string label;
+
+    /** Which code path is timed, scalar for one element at a time or the instruction set of a batch variant. */
+    std::string variant;
+
+    /** Sweep the entry point. */
+    std::function<SweepResult(ThreadPool &, const SweepOptions &)> run;
+
+    /** Time the entry point on the calling thread over preloaded inputs. */
+    std::function<Timing(TimingMode, std::span<const float>, const StreamOptions &)> time;
+};
+
+/**
+ * A kernel known to the harness, with everything needed to write its accuracy data, check it and time it.
+ */
+struct Kernel
+{
+    /** Name used for filtering, output files and results. */
+    std::string name;
+
+    /** Instruction set the kernel needs, kernels the cpu doesn't support are skipped. */
+    Isa isa = Isa::GENERIC;
+
+    /** Declared largest absolute error against the reference over the accuracy data period, infinity if unbounded. */
+    double error_bound = std::numeric_limits<double>::infinity();
+
+    /** Smallest input the kernel accepts, kernels restricted to a domain give meaningless results outside it. */
+    float low = -std::numeric_limits<float>::infinity();
+
+    /** Largest input the kernel accepts. */
+    float high = std::numeric_limits<float>::infinity();
+
+    /** Write accuracy data and return the largest error, empty for kernels which don't calculate sine alone. */
+    std::function<double(const std::string &, OutputFormat)> write_data;
+
+    /** Check ulp error against a higher precision reference, empty for kernels which don't calculate sine alone. */
+    std::function<AccuracyResult(ThreadPool &, const AccuracyOptions &)> check_accuracy;
+
+    /**
+     * Calculate sine of every input through the fastest entry point, where the results may be the same span as the
+     * inputs, empty for kernels which don't calculate sine alone.
+     */
+    TransformFunction transform;
+
+    /** The kernel through the Calculator interface, null for kernels which don't calculate sine alone in float. */
+    std::shared_ptr<const Calculator> calculator;
+
+    /** Timed runs, in the order they are performed. */
+    std::vector<Benchmark> benchmarks;
+};
+
+namespace detail
+{
+
+/**
+ * Function object calling a free function, so it can be passed around by value and every call is a direct call.
+ */
+template <auto Function>
+struct Call
+{
+    FS_ALWAYS_INLINE auto operator()(float theta) const
+    {
+        return Function(theta);
+    }
+};
+
+/**
+ * Calculator calling a free function, so kernels registered as functions can be handed out as a Calculator.
+ */
+template <auto Function>
+class FunctionCalculator final : public Calculator
+{
+  public:
+    using Calculator::calculate;
+
+    float calculate(float theta) const noexcept override
+    {
+        return Function(theta);
+    }
+};
+
+/**
+ * Restrict a range of bit patterns to the non-negative floats in a domain. Sweeping the negative half too would need a
+ * second range, and the kernels are close enough to odd that it would show nothing new.
+ *
+ * @param first
+ *   First bit pattern.
+ *
+ * @param count
+ *   Number of bit patterns.
+ *
+ * @returns
+ *   First bit pattern and number of bit patterns in both the range and the domain, which may be none.
+ */
+template <ReducedDomain D>
+std::pair<std::uint64_t, std::uint64_t> restrict_patterns(std::uint64_t first, std::uint64_t count)
+{
+    constexpr auto end = std::uint64_t{std::bit_cast<std::uint32_t>(domain_high_v<D>)} + 1u;
+
+    const auto restricted_first = std::min(first, end);
+    return {restricted_first, std::min(first + count, end) - restricted_first};
+}
+
+/**
+ * Fold an input into a range, an input already inside it is kept and the rest are wrapped by the upper bound, so the
+ * usual inputs stay within what a restricted kernel accepts.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @param low
+ *   Smallest input in the range, either zero or the negated upper bound.
+ *
+ * @param high
+ *   Largest input in the range, must be positive and finite.
+ *
+ * @returns
+ *   Input in the range.
+ */
+inline float fold_input(float theta, float low, float high)
+{
+    if ((theta >= low) && (theta <= high))
+    {
+        return theta;
+    }
+
+    const auto magnitude = std::fmod(std::fabs(theta), high);
+    if (!std::isfinite(magnitude))
+    {
+        return 0.0f;
+    }
+
+    return (low < 0.0f) ? std::copysign(magnitude, theta) : magnitude;
+}
+
+/**
+ * Fold inputs into a domain with fold_input, so latency and throughput runs over the usual inputs stay within what a
+ * restricted kernel accepts.
+ *
+ * @param inputs
+ *   Inputs.
+ *
+ * @returns
+ *   Inputs in the domain, the same number as inputs.
+ */
+template <ReducedDomain D>
+std::vector<float> fold_inputs(std::span<const float> inputs)
+{
+    auto folded = std::vector<float>(inputs.size());
+
+    std::ranges::transform(
+        inputs, folded.begin(), [](float theta) { return fold_input(theta, domain_low_v<D>, domain_high_v<D>); });
+
+    return folded;
+}
+
+/**
+ * Calculator folding inputs into a domain before passing them to a calculator restricted to it, so code which only
+ * holds a Calculator can't trip the debug checks in sin_reduced. Inputs inside the domain are passed through unchanged.
+ */
+template <ReducedDomain D>
+class DomainCalculator final : public Calculator
+{
+  public:
+    /**
+     * Construct a new DomainCalculator.
+     *
+     * @param calculator
+     *   Calculator restricted to D.
+     */
+    explicit DomainCalculator(std::shared_ptr<const Calculator> calculator)
+        : calculator_(std::move(calculator))
+    {
+    }
+
+    float calculate(float theta) const noexcept override
+    {
+        return calculator_->calculate(fold_input(theta, domain_low_v<D>, domain_high_v<D>));
+    }
+
+    void calculate(std::span<const float> thetas, std::span<float> results) const noexcept override
+    {
+        std::ranges::transform(
+            thetas, results.begin(), [](float theta) { return fold_input(theta, domain_low_v<D>, domain_high_v<D>); });
+
+        calculator_->calculate(std::span<const float>{results.data(), thetas.size()}, results);
+    }
+
+  private:
+    /** Calculator restricted to D. */
+    std::shared_ptr<const Calculator> calculator_;
+};
+
+/**
+ * Get the variant name of a calculator timed through its batch interface.
+ *
+ * @param calculator
+ *   Calculator to get the variant of.
+ *
+ * @returns
+ *   Name of instruction set the calculator is bound to, or batch if it isn't bound to one.
+ */
+template <class C>
+std::string batch_variant(const C &calculator)
+{
+    if constexpr (requires { calculator.isa(); })
+    {
+        return std::string{to_string(calculator.isa())};
+    }
+    else
+    {
+        return "batch";
+    }
+}
+
+}
+
+/**
+ * Signature of the reference sine kernels are compared against.
+ */
+using SinReference = float (*)(float);
+
+/**
+ * Signature of the reference sine and cos kernels are compared against.
+ */
+using SinCosReference = std::tuple<float, float> (*)(float);
+
+/**
+ * Match a name against a shell style glob, where * matches any run of characters and ? matches any one character.
+ *
+ * @param pattern
+ *   Pattern to match.
+ *
+ * @param name
+ *   Name to test.
+ *
+ * @returns
+ *   True if the whole of name matches pattern, otherwise false.
+ */
+bool glob_match(std::string_view pattern, std::string_view name);
+
+/**
+ * Check if a name passes a set of filters.
+ *
+ * @param name
+ *   Name to test.
+ *
+ * @param only
+ *   Patterns of which at least one must match, if empty everything matches.
+ *
+ * @param skip
+ *   Patterns of which none may match.
+ *
+ * @returns
+ *   True if name is selected, otherwise false.
+ */
+bool is_selected(
+    std::string_view name,
+    const std::vector<std::string> &only,
+    const std::vector<std::string> &skip);
+
+/**
+ * Every kernel the harness can run, in registration order.
+ *
+ * Kernels are registered either as free functions, which are called directly so timing them costs no more than a call
+ * to the function itself, as Calculator implementations, which are timed through their batch interface, or as kernel
+ * types, which are timed through every way of calling them.
+ */
+class Registry
+{
+  public:
+    /**
+     * Construct a new Registry.
+     *
+     * @param sin_reference
+     *   Sine to compare kernels against.
+     *
+     * @param sin_cos_reference
+     *   Sine and cos to compare kernels against.
+     */
+    Registry(SinReference sin_reference, SinCosReference sin_cos_reference);
+
+    /**
+     * Register a free function which calculates sine, timed one element at a time.
+     *
+     * @param name
+     *   Name of kernel, must be unique.
+     *
+     * @param error_bound
+     *   Declared largest absolute error over the accuracy data period.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    template <auto Function>
+    Kernel &add_function(std::string name, double error_bound)
+    {
+        const auto reference = sin_reference_;
+
+        auto &kernel = add(std::move(name), Isa::GENERIC, error_bound);
+
+        kernel.write_data = [reference](const std::string &file_name, OutputFormat format)
+        { return harness::write_data(file_name, detail::Call<Function>{}, reference, format); };
+        kernel.check_accuracy = [](ThreadPool &pool, const AccuracyOptions &options)
+        { return harness::check_accuracy(detail::Call<Function>{}, reference_sin, pool, options); };
+        kernel.transform = [](std::span<const float> in, std::span<float> out)
+        { std::ranges::transform(in, out.begin(), detail::Call<Function>{}); };
+        kernel.calculator = std::make_shared<const detail::FunctionCalculator<Function>>();
+        kernel.benchmarks.push_back(
+            {kernel.name,
+             "scalar",
+             [reference](ThreadPool &pool, const SweepOptions &options)
+             { return sweep(detail::Call<Function>{}, reference, pool, options); },
+             [](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+             { return time_mode(detail::Call<Function>{}, mode, inputs, options); }});
+
+        return kernel;
+    }
+
+    /**
+     * Register a free function which calculates sine along with a vectorised version of the same kernel, timed one
+     * element at a time and through the batch interface.
+     *
+     * @param name
+     *   Name of kernel, must be unique.
+     *
+     * @param error_bound
+     *   Declared largest absolute error over the accuracy data period.
+     *
+     * @param batch
+     *   Vectorised version of the kernel.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    template <auto Function, std::derived_from<Calculator> C>
+    Kernel &add_function(std::string name, double error_bound, std::unique_ptr<C> batch)
+    {
+        auto &kernel = add_function<Function>(std::move(name), error_bound);
+        auto variant = detail::batch_variant(*batch);
+
+        add_batch_benchmark(kernel, std::move(batch), std::move(variant));
+
+        return kernel;
+    }
+
+    /**
+     * Register a Calculator, timed through its batch interface. Calculators of types other than float are swept and
+     * checked in their own type against a long double reference and have no accuracy data.
+     *
+     * @param name
+     *   Name of kernel, must be unique.
+     *
+     * @param calculator
+     *   Calculator to register.
+     *
+     * @param error_bound
+     *   Declared largest absolute error over the accuracy data period.
+     *
+     * @param isa
+     *   Instruction set the calculator needs.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    template <class C>
+        requires std::derived_from<C, BasicCalculator<typename C::value_type>>
+    Kernel &add_calculator(std::string name, std::unique_ptr<C> calculator, double error_bound, Isa isa = Isa::GENERIC)
+    {
+        using T = typename C::value_type;
+
+        auto variant = detail::batch_variant(*calculator);
+
+        if constexpr (std::is_same_v<T, float>)
+        {
+            return add_calculator(std::move(name), std::move(calculator), error_bound, isa, std::move(variant));
+        }
+        else
+        {
+            return add_precision_calculator<T>(
+                std::move(name), std::move(calculator), error_bound, isa, std::move(variant));
+        }
+    }
+
+    /**
+     * Register a kernel type, timed through each way of calling it so the cost of the abstraction shows: through the
+     * virtual scalar interface of a KernelCalculator, directly with the call inlined, through the batch interface with
+     * one virtual call per batch to the variant for this cpu, and through evaluate with the width fixed at compile
+     * time.
+     *
+     * @tparam K
+     *   Kernel to register.
+     *
+     * @param name
+     *   Name of kernel, must be unique.
+     *
+     * @param error_bound
+     *   Declared largest absolute error over the accuracy data period.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    template <SineKernel K>
+    Kernel &add_kernel(std::string name, double error_bound)
+    {
+        const auto calculator = std::make_shared<const KernelCalculator<K>>();
+        const auto reference = sin_reference_;
+
+        auto &kernel =
+            add_calculator(std::move(name), calculator, error_bound, Isa::GENERIC, detail::batch_variant(*calculator));
+
+        // called through the interface, as it would be by code that only holds a Calculator
+        const auto virtual_call = [interface = std::shared_ptr<const Calculator>{calculator}](float theta)
+        { return interface->calculate(theta); };
+        const auto static_call = [](float theta) { return fs::evaluate<K>(theta); };
+        const auto static_batch = [](std::span<const float> in, std::span<float> out) { fs::evaluate<K>(in, out); };
+
+        kernel.benchmarks.push_back(
+            {kernel.name + " virtual",
+             "scalar",
+             [virtual_call, reference](ThreadPool &pool, const SweepOptions &options)
+             { return sweep(virtual_call, reference, pool, options); },
+             [virtual_call](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+             { return time_mode(virtual_call, mode, inputs, options); }});
+        kernel.benchmarks.push_back(
+            {kernel.name + " static",
+             "scalar",
+             [static_call, reference](ThreadPool &pool, const SweepOptions &options)
+             { return sweep(static_call, reference, pool, options); },
+             [static_call](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+             { return time_mode(static_call, mode, inputs, options); }});
+        kernel.benchmarks.push_back(
+            {kernel.name + " static batch",
+             std::string{to_string(compiled_isa)},
+             [static_batch, reference](ThreadPool &pool, const SweepOptions &options)
+             { return sweep_batch(static_batch, reference, pool, options); },
+             [static_batch](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+             { return time_batch_mode(static_batch, mode, inputs, options); }});
+
+        return kernel;
+    }
+
+    /**
+     * Register a kernel type restricted to a domain, timed through the same entry points as add_kernel. Sweeps and
+     * accuracy checks are limited to the non-negative floats in the domain, and inputs for latency and throughput runs,
+     * the transform and the calculator are folded into it, so the debug checks in sin_reduced only fire for a real
+     * fault. Only [0, 2pi] covers the
+     * accuracy data period, kernels on the other domains have no accuracy data.
+     *
+     * @tparam K
+     *   Kernel to restrict.
+     *
+     * @tparam D
+     *   Domain to restrict it to.
+     *
+     * @param name
+     *   Name of kernel, must be unique.
+     *
+     * @param error_bound
+     *   Declared largest absolute error over the domain.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    template <ReducibleKernel K, ReducedDomain D>
+    Kernel &add_domain_kernel(std::string name, double error_bound)
+    {
+        auto &kernel = add_kernel<DomainKernel<K, D>>(std::move(name), error_bound);
+
+        kernel.low = domain_low_v<D>;
+        kernel.high = domain_high_v<D>;
+
+        if constexpr (D != ReducedDomain::TWO_PI)
+        {
+            kernel.write_data = {};
+        }
+
+        // every consumer of the plain entry points gets inputs folded into the domain
+        kernel.calculator = std::make_shared<const detail::DomainCalculator<D>>(std::move(kernel.calculator));
+        kernel.transform = [calculator = kernel.calculator](std::span<const float> in, std::span<float> out)
+        { calculator->calculate(in, out); };
+
+        kernel.check_accuracy =
+            [check = std::move(kernel.check_accuracy)](ThreadPool &pool, const AccuracyOptions &options)
+        {
+            auto restricted = options;
+            std::tie(restricted.first, restricted.count) = detail::restrict_patterns<D>(options.first, options.count);
+            return check(pool, restricted);
+        };
+
+        for (auto &benchmark : kernel.benchmarks)
+        {
+            benchmark.run = [run = std::move(benchmark.run)](ThreadPool &pool, const SweepOptions &options)
+            {
+                auto restricted = options;
+                std::tie(restricted.first, restricted.count) =
+                    detail::restrict_patterns<D>(options.first, options.count);
+                return run(pool, restricted);
+            };
+            benchmark.time = [time = std::move(benchmark.time)](
+                                 TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+            {
+                const auto folded = detail::fold_inputs<D>(inputs);
+                return time(mode, folded, options);
+            };
+        }
+
+        return kernel;
+    }
+
+    /**
+     * Register a kernel type evaluated on integer phases, timed one element at a time with the call inlined and through
+     * the batch interface of a PhaseCalculator. Sweeps take the range of bit patterns as phases and compare against
+     * sine in double, the kernel has no accuracy data or ulp check since its inputs aren't floats.
+     *
+     * @tparam K
+     *   Kernel to register.
+     *
+     * @tparam R
+     *   Result type, float, q15 or q31.
+     *
+     * @param name
+     *   Name of kernel, must be unique.
+     *
+     * @param error_bound
+     *   Declared largest absolute error of the value of the results over every phase.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    template <PhaseKernel K, class R>
+    Kernel &add_phase_kernel(std::string name, double error_bound)
+    {
+        const auto calculator = std::make_shared<const PhaseCalculator<K, R>>();
+
+        auto &kernel = add(std::move(name), Isa::GENERIC, error_bound);
+
+        const auto static_call = [](std::span<const Phase> in, std::span<R> out)
+        {
+            for (auto i = std::size_t{0u}; i < in.size(); ++i)
+            {
+                out[i] = fs::sin_phase<K, R>(in[i]);
+            }
+        };
+        const auto batch = [calculator](std::span<const Phase> in, std::span<R> out)
+        { calculator->calculate(in, out); };
+
+        kernel.benchmarks.push_back(
+            {kernel.name + " static",
+             "scalar",
+             [static_call](ThreadPool &pool, const SweepOptions &options)
+             { return sweep_phases<R>(static_call, pool, options); },
+             [static_call](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+             { return time_phase_mode<R>(static_call, mode, inputs, options); }});
+        kernel.benchmarks.push_back(
+            {kernel.name + " batch",
+             detail::batch_variant(*calculator),
+             [batch](ThreadPool &pool, const SweepOptions &options) { return sweep_phases<R>(batch, pool, options); },
+             [batch](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+             { return time_phase_mode<R>(batch, mode, inputs, options); }});
+
+        return kernel;
+    }
+
+    /**
+     * Register a free function which calculates sine and cos, timed one element at a time.
+     *
+     * @param name
+     *   Name of kernel, must be unique.
+     *
+     * @param error_bound
+     *   Declared largest absolute error of either result.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    template <auto Function>
+    Kernel &add_sin_cos_function(std::string name, double error_bound)
+    {
+        const auto reference = sin_cos_reference_;
+
+        auto &kernel = add(std::move(name), Isa::GENERIC, error_bound);
+
+        kernel.benchmarks.push_back(
+            {kernel.name,
+             "scalar",
+             [reference](ThreadPool &pool, const SweepOptions &options)
+             { return sweep(detail::Call<Function>{}, reference, pool, options); },
+             [](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+             { return time_mode(detail::Call<Function>{}, mode, inputs, options); }});
+
+        return kernel;
+    }
+
+    /**
+     * Register a SinCosCalculator, timed through its scalar interface and both batch layouts. Calculators of types
+     * other than float are only timed through the batch interface with separate outputs, in their own type.
+     *
+     * @param name
+     *   Name of kernel, must be unique.
+     *
+     * @param calculator
+     *   Calculator to register.
+     *
+     * @param error_bound
+     *   Declared largest absolute error of either result.
+     *
+     * @param isa
+     *   Instruction set the calculator needs.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    template <class C>
+        requires std::derived_from<C, BasicSinCosCalculator<typename C::value_type>>
+    Kernel &add_sin_cos_calculator(
+        std::string name,
+        std::unique_ptr<C> calculator,
+        double error_bound,
+        Isa isa = Isa::GENERIC)
+    {
+        using T = typename C::value_type;
+
+        auto variant = detail::batch_variant(*calculator);
+
+        if constexpr (std::is_same_v<T, float>)
+        {
+            return add_sin_cos_calculator(std::move(name), std::move(calculator), error_bound, isa, std::move(variant));
+        }
+        else
+        {
+            return add_precision_sin_cos_calculator<T>(
+                std::move(name), std::move(calculator), error_bound, isa, std::move(variant));
+        }
+    }
+
+    /**
+     * Get every registered kernel.
+     *
+     * @returns
+     *   Kernels in registration order.
+     */
+    std::vector<const Kernel *> kernels() const;
+
+    /**
+     * Get the registered kernels which pass a set of filters.
+     *
+     * @param only
+     *   Patterns of which at least one must match a kernel name, if empty every kernel matches.
+     *
+     * @param skip
+     *   Patterns of which none may match a kernel name.
+     *
+     * @returns
+     *   Selected kernels in registration order.
+     */
+    std::vector<const Kernel *> select(const std::vector<std::string> &only, const std::vector<std::string> &skip)
+        const;
+
+  private:
+    /**
+     * Add an empty kernel.
+     *
+     * @param name
+     *   Name of kernel.
+     *
+     * @param isa
+     *   Instruction set the kernel needs.
+     *
+     * @param error_bound
+     *   Declared largest absolute error.
+     *
+     * @returns
+     *   New kernel.
+     *
+     * @throws std::invalid_argument
+     *   If a kernel with the same name is already registered.
+     */
+    Kernel &add(std::string name, Isa isa, double error_bound);
+
+    /**
+     * Register a Calculator once its variant is known.
+     *
+     * @param name
+     *   Name of kernel.
+     *
+     * @param calculator
+     *   Calculator to register.
+     *
+     * @param error_bound
+     *   Declared largest absolute error.
+     *
+     * @param isa
+     *   Instruction set the calculator needs.
+     *
+     * @param variant
+     *   Variant of the batch interface.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    Kernel &add_calculator(
+        std::string name,
+        std::shared_ptr<const Calculator> calculator,
+        double error_bound,
+        Isa isa,
+        std::string variant);
+
+    /**
+     * Register a SinCosCalculator once its variant is known.
+     *
+     * @param name
+     *   Name of kernel.
+     *
+     * @param calculator
+     *   Calculator to register.
+     *
+     * @param error_bound
+     *   Declared largest absolute error.
+     *
+     * @param isa
+     *   Instruction set the calculator needs.
+     *
+     * @param variant
+     *   Variant of the batch interfaces.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    Kernel &add_sin_cos_calculator(
+        std::string name,
+        std::shared_ptr<const SinCosCalculator> calculator,
+        double error_bound,
+        Isa isa,
+        std::string variant);
+
+    /**
+     * Register a Calculator of a type other than float once its variant is known.
+     *
+     * @tparam T
+     *   Type calculated.
+     *
+     * @param name
+     *   Name of kernel.
+     *
+     * @param calculator
+     *   Calculator to register.
+     *
+     * @param error_bound
+     *   Declared largest absolute error.
+     *
+     * @param isa
+     *   Instruction set the calculator needs.
+     *
+     * @param variant
+     *   Variant of the batch interface.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    template <class T>
+    Kernel &add_precision_calculator(
+        std::string name,
+        std::shared_ptr<const BasicCalculator<T>> calculator,
+        double error_bound,
+        Isa isa,
+        std::string variant)
+    {
+        auto &kernel = add(std::move(name), isa, error_bound);
+
+        const auto batch = [calculator](std::span<const T> in, std::span<T> out) { calculator->calculate(in, out); };
+
+        kernel.check_accuracy = [batch](ThreadPool &pool, const AccuracyOptions &options)
+        { return check_values<T>(batch, pool, options); };
+        kernel.benchmarks.push_back(
+            {kernel.name + " batch",
+             std::move(variant),
+             [batch](ThreadPool &pool, const SweepOptions &options) { return sweep_values<T>(batch, pool, options); },
+             [batch](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+             {
+                 const auto values = stream_values<T>(inputs);
+                 return time_batch_mode(batch, mode, std::span<const T>{values}, options);
+             }});
+
+        return kernel;
+    }
+
+    /**
+     * Register a SinCosCalculator of a type other than float once its variant is known.
+     *
+     * @tparam T
+     *   Type calculated.
+     *
+     * @param name
+     *   Name of kernel.
+     *
+     * @param calculator
+     *   Calculator to register.
+     *
+     * @param error_bound
+     *   Declared largest absolute error.
+     *
+     * @param isa
+     *   Instruction set the calculator needs.
+     *
+     * @param variant
+     *   Variant of the batch interface.
+     *
+     * @returns
+     *   Registered kernel.
+     */
+    template <class T>
+    Kernel &add_precision_sin_cos_calculator(
+        std::string name,
+        std::shared_ptr<const BasicSinCosCalculator<T>> calculator,
+        double error_bound,
+        Isa isa,
+        std::string variant)
+    {
+        auto &kernel = add(std::move(name), isa, error_bound);
+
+        const auto batch = [calculator](std::span<const T> in, std::span<T> out)
+        { calculator->calculate(in, out.first(in.size()), out.subspan(in.size(), in.size())); };
+
+        kernel.benchmarks.push_back(
+            {kernel.name + " batch",
+             std::move(variant),
+             [batch](ThreadPool &pool, const SweepOptions &options)
+             { return sweep_values<T, 2u>(batch, pool, options); },
+             [batch](TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+             {
+                 const auto values = stream_values<T>(inputs);
+                 return time_batch_mode<2u>(batch, mode, std::span<const T>{values}, options);
+             }});
+
+        return kernel;
+    }
+
+    /**
+     * Add a benchmark of the batch interface of a calculator to a kernel.
+     *
+     * @param kernel
+     *   Kernel to add to.
+     *
+     * @param calculator
+     *   Calculator to time.
+     *
+     * @param variant
+     *   Variant of the batch interface.
+     */
+    void add_batch_benchmark(Kernel &kernel, std::shared_ptr<const Calculator> calculator, std::string variant);
+
+    /** Sine kernels are compared against. */
+    SinReference sin_reference_;
+
+    /** Sine and cos kernels are compared against. */
+    SinCosReference sin_cos_reference_;
+
+    /** Registered kernels, held by pointer so references to them stay valid as more are added. */
+    std::vector<std::unique_ptr<Kernel>> kernels_;
+};
+
+}
@@ -0,0 +1,994 @@
+#include "results.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "cpu_features.h"
+#include "perf_counters.h"
+
+#if !defined(FS_GIT_REVISION)
+#define FS_GIT_REVISION "unknown"
+#endif
+
+#if !defined(FS_BUILD_TYPE)
+#define FS_BUILD_TYPE ""
+#endif
+
+#if !defined(FS_COMPILER_FLAGS)
+#define FS_COMPILER_FLAGS ""
+#endif
+
+namespace
+{
+
+/**
+ * Format a number so it round trips and is valid in both JSON and CSV.
+ *
+ * @param value
+ *   Value to format.
+ *
+ * @returns
+ *   Shortest representation of value, or an empty string if it is not finite.
+ */
+std::string format_number(double value)
+{
+    // checked through the bits so it still works when built with fast maths
+    if ((std::bit_cast<std::uint64_t>(value) & 0x7ff0000000000000u) == 0x7ff0000000000000u)
+    {
+        return {};
+    }
+
+    char buffer[32];
+    const auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+    return error == std::errc{} ? std::string{buffer, end} : std::string{};
+}
+
+/**
+ * Quote a string for JSON.
+ *
+ * @param value
+ *   Value to quote.
+ *
+ * @returns
+ *   Value in double quotes with special characters escaped.
+ */
+std::string json_string(std::string_view value)
+{
+    constexpr auto hex = std::string_view{"0123456789abcdef"};
+
+    auto quoted = std::string{"\""};
+
+    for (const auto c : value)
+    {
+        switch (c)
+        {
+            case '"': quoted += "\\\""; break;
+            case '\\': quoted += "\\\\"; break;
+            case '\n': quoted += "\\n"; break;
+            case '\t': quoted += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20u)
+                {
+                    quoted += "\\u00";
+                    quoted += hex[static_cast<unsigned char>(c) >> 4u];
+                    quoted += hex[static_cast<unsigned char>(c) & 0xfu];
+                }
+                else
+                {
+                    quoted += c;
+                }
+        }
+    }
+
+    return quoted + "\"";
+}
+
+/**
+ * Format a number for JSON.
+ *
+ * @param value
+ *   Value to format.
+ *
+ * @returns
+ *   Number, or null if it is not finite.
+ */
+std::string json_number(double value)
+{
+    const auto formatted = format_number(value);
+    return formatted.empty() ? "null" : formatted;
+}
+
+/**
+ * Quote a string for CSV if it needs it.
+ *
+ * @param value
+ *   Value to quote.
+ *
+ * @returns
+ *   Value, in double quotes with quotes doubled if it contains a separator, quote or line break.
+ */
+std::string csv_string(std::string_view value)
+{
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos)
+    {
+        return std::string{value};
+    }
+
+    auto quoted = std::string{"\""};
+
+    for (const auto c : value)
+    {
+        quoted += c;
+        if (c == '"')
+        {
+            quoted += c;
+        }
+    }
+
+    return quoted + "\"";
+}
+
+/**
+ * Get the model name of the cpu from /proc/cpuinfo.
+ *
+ * @returns
+ *   Model name, or unknown if it can't be found.
+ */
+std::string cpu_model()
+{
+    auto cpuinfo = std::ifstream{"/proc/cpuinfo"};
+    auto line = std::string{};
+
+    while (std::getline(cpuinfo, line))
+    {
+        // x86 has model name, arm kernels have used both Model and Hardware
+        for (const auto key : {std::string_view{"model name"}, std::string_view{"Model"}, std::string_view{"Hardware"}})
+        {
+            if (!line.starts_with(key))
+            {
+                continue;
+            }
+
+            const auto separator = line.find(':');
+            if ((separator == std::string::npos) || (line.find_first_not_of(" \t", key.size()) != separator))
+            {
+                continue;
+            }
+
+            const auto start = line.find_first_not_of(" \t", separator + 1u);
+            return start == std::string::npos ? std::string{"unknown"} : line.substr(start);
+        }
+    }
+
+    return "unknown";
+}
+
+/**
+ * Get the name and version of the compiler the harness was built with.
+ *
+ * @returns
+ *   Compiler description.
+ */
+std::string compiler()
+{
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#else
+    return "unknown";
+#endif
+}
+
+/**
+ * Get the current time.
+ *
+ * @returns
+ *   Current time as UTC in ISO 8601 format.
+ */
+std::string now()
+{
+    const auto time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+    auto utc = std::tm{};
+    ::gmtime_r(&time, &utc);
+
+    char buffer[32];
+    const auto length = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+    return {buffer, length};
+}
+
+/**
+ * Minimal reader for the JSON written by ResultsFile, it accepts any valid JSON but only extracts what is asked for.
+ */
+class JsonReader
+{
+  public:
+    /**
+     * Construct a new JsonReader.
+     *
+     * @param text
+     *   JSON to read, must outlive the reader.
+     */
+    explicit JsonReader(std::string_view text)
+        : text_(text)
+        , position_(0u)
+    {
+    }
+
+    /**
+     * Read an object, calling a function for each member which must read the value.
+     *
+     * @param on_member
+     *   Called with each key.
+     *
+     * @throws std::runtime_error
+     *   If the next value is not an object.
+     */
+    template <class F>
+    void read_object(F on_member)
+    {
+        expect('{');
+        if (consume('}'))
+        {
+            return;
+        }
+
+        do
+        {
+            const auto key = read_string();
+            expect(':');
+            on_member(key);
+        } while (consume(','));
+
+        expect('}');
+    }
+
+    /**
+     * Read an array, calling a function for each element which must read the value.
+     *
+     * @param on_element
+     *   Called for each element.
+     *
+     * @throws std::runtime_error
+     *   If the next value is not an array.
+     */
+    template <class F>
+    void read_array(F on_element)
+    {
+        expect('[');
+        if (consume(']'))
+        {
+            return;
+        }
+
+        do
+        {
+            on_element();
+        } while (consume(','));
+
+        expect(']');
+    }
+
+    /**
+     * Read a string.
+     *
+     * @returns
+     *   String with escapes replaced, unicode escapes outside ascii are replaced with ?.
+     *
+     * @throws std::runtime_error
+     *   If the next value is not a string.
+     */
+    std::string read_string()
+    {
+        expect('"');
+
+        auto value = std::string{};
+
+        while (position_ < text_.size())
+        {
+            const auto c = text_[position_++];
+
+            if (c == '"')
+            {
+                return value;
+            }
+
+            if (c != '\\')
+            {
+                value += c;
+                continue;
+            }
+
+            if (position_ >= text_.size())
+            {
+                break;
+            }
+
+            switch (const auto escaped = text_[position_++]; escaped)
+            {
+                case 'n': value += '\n'; break;
+                case 't': value += '\t'; break;
+                case 'r': value += '\r'; break;
+                case 'b': value += '\b'; break;
+                case 'f': value += '\f'; break;
+                case 'u':
+                {
+                    auto code = 0u;
+                    const auto digits = text_.substr(position_, 4u);
+                    const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), code, 16);
+                    if ((error != std::errc{}) || (end != digits.data() + 4))
+                    {
+                        fail();
+                    }
+                    position_ += 4u;
+                    value += code < 0x80u ? static_cast<char>(code) : '?';
+                    break;
+                }
+                default: value += escaped; break;
+            }
+        }
+
+        fail();
+    }
+
+    /**
+     * Read a number, null is read as NaN.
+     *
+     * @returns
+     *   Number.
+     *
+     * @throws std::runtime_error
+     *   If the next value is not a number or null.
+     */
+    double read_number()
+    {
+        skip_space();
+
+        if (text_.substr(position_).starts_with("null"))
+        {
+            position_ += 4u;
+            return std::numeric_limits<double>::quiet_NaN();
+        }
+
+        auto value = 0.0;
+        const auto [end, error] = std::from_chars(text_.data() + position_, text_.data() + text_.size(), value);
+        if (error != std::errc{})
+        {
+            fail();
+        }
+
+        position_ = static_cast<std::size_t>(end - text_.data());
+        return value;
+    }
+
+    /**
+     * Read and discard a value of any type.
+     *
+     * @throws std::runtime_error
+     *   If the next value is not valid.
+     */
+    void skip_value()
+    {
+        skip_space();
+
+        if (position_ >= text_.size())
+        {
+            fail();
+        }
+
+        switch (text_[position_])
+        {
+            case '{': read_object([this](const std::string &) { skip_value(); }); break;
+            case '[': read_array([this] { skip_value(); }); break;
+            case '"': read_string(); break;
+            case 't': skip_literal("true"); break;
+            case 'f': skip_literal("false"); break;
+            default: read_number(); break;
+        }
+    }
+
+  private:
+    /**
+     * Throw an error for malformed input.
+     *
+     * @throws std::runtime_error
+     *   Always.
+     */
+    [[noreturn]] void fail() const
+    {
+        throw std::runtime_error{"malformed json at offset " + std::to_string(position_)};
+    }
+
+    /**
+     * Skip whitespace.
+     */
+    void skip_space()
+    {
+        constexpr auto space = std::string_view{" \t\r\n"};
+
+        while ((position_ < text_.size()) && (space.find(text_[position_]) != std::string_view::npos))
+        {
+            ++position_;
+        }
+    }
+
+    /**
+     * Consume a character if it is next.
+     *
+     * @param c
+     *   Character to consume.
+     *
+     * @returns
+     *   True if it was consumed, otherwise false.
+     */
+    bool consume(char c)
+    {
+        skip_space();
+
+        if ((position_ < text_.size()) && (text_[position_] == c))
+        {
+            ++position_;
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Consume a character which must be next.
+     *
+     * @param c
+     *   Character to consume.
+     *
+     * @throws std::runtime_error
+     *   If it isn't next.
+     */
+    void expect(char c)
+    {
+        if (!consume(c))
+        {
+            fail();
+        }
+    }
+
+    /**
+     * Consume a literal which must be next.
+     *
+     * @param literal
+     *   Literal to consume.
+     *
+     * @throws std::runtime_error
+     *   If it isn't next.
+     */
+    void skip_literal(std::string_view literal)
+    {
+        if (!text_.substr(position_).starts_with(literal))
+        {
+            fail();
+        }
+
+        position_ += literal.size();
+    }
+
+    /** Text being read. */
+    std::string_view text_;
+
+    /** Offset of next character to read. */
+    std::size_t position_;
+};
+
+/**
+ * Read the timings from a JSON results file.
+ *
+ * @param text
+ *   Contents of file.
+ *
+ * @returns
+ *   Timings of every benchmark.
+ *
+ * @throws std::runtime_error
+ *   If text is not valid.
+ */
+std::vector<fs::harness::StoredResult> read_json_results(std::string_view text)
+{
+    auto results = std::vector<fs::harness::StoredResult>{};
+    auto reader = JsonReader{text};
+
+    reader.read_object(
+        [&](const std::string &key)
+        {
+            if (key != "results")
+            {
+                reader.skip_value();
+                return;
+            }
+
+            reader.read_array(
+                [&]
+                {
+                    auto result = fs::harness::StoredResult{};
+                    auto single = std::numeric_limits<double>::quiet_NaN();
+
+                    reader.read_object(
+                        [&](const std::string &field)
+                        {
+                            if (field == "kernel")
+                            {
+                                result.kernel = reader.read_string();
+                            }
+                            else if (field == "benchmark")
+                            {
+                                result.benchmark = reader.read_string();
+                            }
+                            else if (field == "ns_per_element")
+                            {
+                                single = reader.read_number();
+                            }
+                            else if (field == "samples_ns_per_element")
+                            {
+                                reader.read_array([&] { result.samples.push_back(reader.read_number()); });
+                            }
+                            else
+                            {
+                                reader.skip_value();
+                            }
+                        });
+
+                    // files written before repetitions were recorded only have the one timing
+                    if (result.samples.empty())
+                    {
+                        result.samples.push_back(single);
+                    }
+
+                    results.push_back(std::move(result));
+                });
+        });
+
+    return results;
+}
+
+/**
+ * Split a line of CSV into fields, handling quoted fields.
+ *
+ * @param line
+ *   Line to split.
+ *
+ * @returns
+ *   Fields with quoting removed.
+ */
+std::vector<std::string> split_csv(std::string_view line)
+{
+    auto fields = std::vector<std::string>{1u};
+    auto quoted = false;
+
+    for (auto i = std::size_t{0u}; i < line.size(); ++i)
+    {
+        const auto c = line[i];
+
+        if (quoted)
+        {
+            if (c != '"')
+            {
+                fields.back() += c;
+            }
+            else if ((i + 1u < line.size()) && (line[i + 1u] == '"'))
+            {
+                fields.back() += c;
+                ++i;
+            }
+            else
+            {
+                quoted = false;
+            }
+        }
+        else if (c == '"')
+        {
+            quoted = true;
+        }
+        else if (c == ',')
+        {
+            fields.emplace_back();
+        }
+        else if (c != '\r')
+        {
+            fields.back() += c;
+        }
+    }
+
+    return fields;
+}
+
+/**
+ * Parse a number written by format_number.
+ *
+ * @param text
+ *   Text to parse.
+ *
+ * @returns
+ *   Number, or NaN if text is empty or not a number.
+ */
+double parse_number(std::string_view text)
+{
+    auto value = std::numeric_limits<double>::quiet_NaN();
+    std::from_chars(text.data(), text.data() + text.size(), value);
+    return value;
+}
+
+/**
+ * Read the timings from a CSV results file.
+ *
+ * @param text
+ *   Contents of file.
+ *
+ * @returns
+ *   Timings of every benchmark.
+ *
+ * @throws std::runtime_error
+ *   If text doesn't have the expected columns.
+ */
+std::vector<fs::harness::StoredResult> read_csv_results(std::string_view text)
+{
+    auto results = std::vector<fs::harness::StoredResult>{};
+    auto lines = std::vector<std::string_view>{};
+
+    for (auto start = std::size_t{0u}; start < text.size();)
+    {
+        const auto end = std::min(text.find('\n', start), text.size());
+        if (end > start)
+        {
+            lines.push_back(text.substr(start, end - start));
+        }
+        start = end + 1u;
+    }
+
+    if (lines.empty())
+    {
+        throw std::runtime_error{"missing csv header"};
+    }
+
+    const auto header = split_csv(lines.front());
+    const auto column = [&header](std::string_view name)
+    { return static_cast<std::size_t>(std::ranges::find(header, name) - header.begin()); };
+
+    const auto kernel = column("kernel");
+    const auto benchmark = column("benchmark");
+    const auto single = column("ns_per_element");
+    const auto samples = column("samples_ns_per_element");
+
+    if ((kernel == header.size()) || (benchmark == header.size()) || (single == header.size()))
+    {
+        throw std::runtime_error{"missing csv columns"};
+    }
+
+    for (const auto line : std::span{lines}.subspan(1u))
+    {
+        const auto fields = split_csv(line);
+        if (fields.size() != header.size())
+        {
+            throw std::runtime_error{"wrong number of csv fields"};
+        }
+
+        auto result =
+            fs::harness::StoredResult{.kernel = fields[kernel], .benchmark = fields[benchmark], .samples = {}};
+
+        if (samples != header.size())
+        {
+            const auto list = std::string_view{fields[samples]};
+            for (auto start = std::size_t{0u}; start < list.size();)
+            {
+                const auto end = std::min(list.find(';', start), list.size());
+                result.samples.push_back(parse_number(list.substr(start, end - start)));
+                start = end + 1u;
+            }
+        }
+
+        if (result.samples.empty())
+        {
+            result.samples.push_back(parse_number(fields[single]));
+        }
+
+        results.push_back(std::move(result));
+    }
+
+    return results;
+}
+
+/** Column names of a CSV file, in order. */
+constexpr std::string_view csv_header =
+    "kernel,benchmark,variant,threads,elements,total_ns,checked_wall_ns,ns_per_element,cycles_per_element,"
+    "elements_per_second,max_error,mean_error,repetitions,median_ns_per_element,p5_ns_per_element,p95_ns_per_element,"
+    "mad_ns_per_element,samples_ns_per_element,latency_ns_per_element,latency_cycles_per_element,"
+    "throughput_ns_per_element,throughput_cycles_per_element,latency_counter_cycles_per_element,"
+    "latency_counter_instructions_per_element,latency_counter_branch_misses_per_element,"
+    "latency_counter_l1d_misses_per_element,latency_counter_fp_assists_per_element,latency_counter_ipc,"
+    "throughput_counter_cycles_per_element,throughput_counter_instructions_per_element,"
+    "throughput_counter_branch_misses_per_element,throughput_counter_l1d_misses_per_element,"
+    "throughput_counter_fp_assists_per_element,throughput_counter_ipc,git_revision,compiler,build_type,compiler_flags,"
+    "fast_maths,cpu_model,isa,started,workload";
+
+}
+
+namespace fs::harness
+{
+
+std::string_view to_string(ResultsFormat format)
+{
+    switch (format)
+    {
+        case ResultsFormat::JSON: return "json";
+        case ResultsFormat::CSV: return "csv";
+    }
+
+    return "unknown";
+}
+
+std::vector<StoredResult> read_results(const std::string &path)
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    if (!file)
+    {
+        throw std::runtime_error{"failed to open " + path};
+    }
+
+    const auto text = std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    const auto first = text.find_first_not_of(" \t\r\n");
+
+    try
+    {
+        return (first != std::string::npos) && (text[first] == '{') ? read_json_results(text) : read_csv_results(text);
+    }
+    catch (const std::runtime_error &error)
+    {
+        throw std::runtime_error{"invalid results file " + path + ": " + error.what()};
+    }
+}
+
+RunMetadata collect_metadata()
+{
+    auto metadata = RunMetadata{};
+
+    metadata.git_revision = FS_GIT_REVISION;
+    metadata.compiler = compiler();
+    metadata.build_type = FS_BUILD_TYPE;
+    metadata.compiler_flags = FS_COMPILER_FLAGS;
+#if defined(__FAST_MATH__)
+    metadata.fast_maths = true;
+#endif
+    metadata.cpu_model = cpu_model();
+    metadata.isa = std::string{to_string(selected_isa())};
+    metadata.started = now();
+
+    return metadata;
+}
+
+ResultsFile::ResultsFile(const std::string &path, ResultsFormat format, RunMetadata metadata)
+    : path_(path)
+    , format_(format)
+    , metadata_(std::move(metadata))
+    , stream_(path)
+    , records_(0u)
+{
+    if (!stream_)
+    {
+        throw std::system_error{std::make_error_code(std::errc::io_error), "failed to open " + path_};
+    }
+
+    if (format_ == ResultsFormat::JSON)
+    {
+        stream_ << "{\n  \"metadata\": {\n"
+                << "    \"git_revision\": " << json_string(metadata_.git_revision) << ",\n"
+                << "    \"compiler\": " << json_string(metadata_.compiler) << ",\n"
+                << "    \"build_type\": " << json_string(metadata_.build_type) << ",\n"
+                << "    \"compiler_flags\": " << json_string(metadata_.compiler_flags) << ",\n"
+                << "    \"fast_maths\": " << (metadata_.fast_maths ? "true" : "false") << ",\n"
+                << "    \"cpu_model\": " << json_string(metadata_.cpu_model) << ",\n"
+                << "    \"isa\": " << json_string(metadata_.isa) << ",\n"
+                << "    \"started\": " << json_string(metadata_.started) << ",\n"
+                << "    \"workload\": " << json_string(metadata_.workload) << "\n"
+                << "  },\n  \"results\": [";
+    }
+    else
+    {
+        stream_ << csv_header << "\n";
+    }
+
+    stream_.flush();
+}
+
+ResultsFile::~ResultsFile()
+{
+    try
+    {
+        close();
+    }
+    catch (const std::system_error &)
+    {
+        // nothing can be reported from a destructor, call close explicitly to see errors
+    }
+}
+
+void ResultsFile::add(
+    std::string_view kernel,
+    std::string_view benchmark,
+    std::string_view variant,
+    const BenchmarkRun &run)
+{
+    constexpr auto missing = std::numeric_limits<double>::quiet_NaN();
+
+    const auto result = run.representative();
+    const auto &timing = result.timing;
+    const auto &summary = run.ns_per_element;
+    const auto samples = run.samples();
+
+    // cycles are only meaningful if the counter was read, and neither figure is if the run was below its baseline
+    const auto swept = !run.repetitions.empty();
+    const auto ns_per_element = swept && !timing.below_baseline() ? timing.ns_per_element() : missing;
+    const auto elements_per_second = swept ? result.elements_per_second() : missing;
+    const auto cycles = (timing.cycles == 0u) || timing.below_baseline() ? missing : timing.cycles_per_element();
+    const auto mean_error = result.errors.compared == 0u ? missing : result.errors.mean_error();
+    const auto max_error = result.errors.compared == 0u ? missing : result.errors.max_error;
+
+    // the wall time includes checking the results, so it's taken from the first repetition along with the errors
+    const auto checked_wall_ns = run.repetitions.empty() ? 0 : run.repetitions.front().wall_time.count();
+
+    // median of each mode, missing if it wasn't run or every repetition was below its baseline
+    auto latency_ns = missing;
+    auto latency_cycles = missing;
+    auto throughput_ns = missing;
+    auto throughput_cycles = missing;
+
+    // hardware counts per element of each mode followed by ipc, latency first
+    constexpr auto modes = std::array<std::string_view, 2u>{"latency", "throughput"};
+    auto counts = std::array<std::array<double, counter_count + 1u>, 2u>{};
+    for (auto &mode_counts : counts)
+    {
+        mode_counts.fill(missing);
+    }
+
+    for (const auto &mode : run.modes)
+    {
+        const auto latency = mode.mode == TimingMode::LATENCY;
+        auto &ns = latency ? latency_ns : throughput_ns;
+        auto &mode_cycles = latency ? latency_cycles : throughput_cycles;
+        auto &mode_counts = counts[latency ? 0u : 1u];
+
+        if (mode.below_baseline != mode.ns_per_element.samples)
+        {
+            ns = mode.ns_per_element.median;
+            mode_cycles = mode.cycles_per_element.samples == 0u ? missing : mode.cycles_per_element.median;
+        }
+
+        for (auto i = std::size_t{0u}; i < counter_count; ++i)
+        {
+            mode_counts[i] = mode.counters.per_element(all_counters[i]).value_or(missing);
+        }
+        mode_counts[counter_count] = mode.counters.ipc().value_or(missing);
+    }
+
+    if (format_ == ResultsFormat::JSON)
+    {
+        stream_ << (records_ == 0u ? "\n" : ",\n") << "    {"
+                << "\"kernel\": " << json_string(kernel) << ", "
+                << "\"benchmark\": " << json_string(benchmark) << ", "
+                << "\"variant\": " << json_string(variant) << ", "
+                << "\"threads\": " << result.threads << ", "
+                << "\"elements\": " << timing.elements << ", "
+                << "\"total_ns\": " << timing.total.count() << ", "
+                << "\"checked_wall_ns\": " << checked_wall_ns << ", "
+                << "\"ns_per_element\": " << json_number(ns_per_element) << ", "
+                << "\"cycles_per_element\": " << json_number(cycles) << ", "
+                << "\"elements_per_second\": " << json_number(elements_per_second) << ", "
+                << "\"max_error\": " << json_number(max_error) << ", "
+                << "\"mean_error\": " << json_number(mean_error) << ", "
+                << "\"repetitions\": " << summary.samples << ", "
+                << "\"median_ns_per_element\": " << json_number(summary.median) << ", "
+                << "\"p5_ns_per_element\": " << json_number(summary.p5) << ", "
+                << "\"p95_ns_per_element\": " << json_number(summary.p95) << ", "
+                << "\"mad_ns_per_element\": " << json_number(summary.mad) << ", "
+                << "\"samples_ns_per_element\": [";
+
+        for (auto i = std::size_t{0u}; i < samples.size(); ++i)
+        {
+            stream_ << (i == 0u ? "" : ", ") << json_number(samples[i]);
+        }
+
+        stream_ << "], "
+                << "\"latency_ns_per_element\": " << json_number(latency_ns) << ", "
+                << "\"latency_cycles_per_element\": " << json_number(latency_cycles) << ", "
+                << "\"throughput_ns_per_element\": " << json_number(throughput_ns) << ", "
+                << "\"throughput_cycles_per_element\": " << json_number(throughput_cycles);
+
+        for (auto mode = std::size_t{0u}; mode < modes.size(); ++mode)
+        {
+            for (auto i = std::size_t{0u}; i < counter_count; ++i)
+            {
+                stream_ << ", \"" << modes[mode] << "_counter_" << to_string(all_counters[i])
+                        << "_per_element\": " << json_number(counts[mode][i]);
+            }
+
+            stream_ << ", \"" << modes[mode] << "_counter_ipc\": " << json_number(counts[mode][counter_count]);
+        }
+
+        stream_ << "}";
+    }
+    else
+    {
+        stream_ << csv_string(kernel) << "," << csv_string(benchmark) << "," << csv_string(variant) << ","
+                << result.threads << "," << timing.elements << "," << timing.total.count() << ","
+                << checked_wall_ns << "," << format_number(ns_per_element) << "," << format_number(cycles)
+                << "," << format_number(elements_per_second) << ","
+                << format_number(max_error) << "," << format_number(mean_error) << "," << summary.samples << ","
+                << format_number(summary.median) << "," << format_number(summary.p5) << ","
+                << format_number(summary.p95) << "," << format_number(summary.mad) << ",";
+
+        for (auto i = std::size_t{0u}; i < samples.size(); ++i)
+        {
+            stream_ << (i == 0u ? "" : ";") << format_number(samples[i]);
+        }
+
+        stream_ << "," << format_number(latency_ns) << "," << format_number(latency_cycles) << ","
+                << format_number(throughput_ns) << "," << format_number(throughput_cycles);
+
+        for (const auto &mode_counts : counts)
+        {
+            for (const auto count : mode_counts)
+            {
+                stream_ << "," << format_number(count);
+            }
+        }
+
+        stream_ << "," << csv_string(metadata_.git_revision) << "," << csv_string(metadata_.compiler) << ","
+                << csv_string(metadata_.build_type) << "," << csv_string(metadata_.compiler_flags) << ","
+                << (metadata_.fast_maths ? "true" : "false") << "," << csv_string(metadata_.cpu_model) << ","
+                << csv_string(metadata_.isa) << "," << csv_string(metadata_.started) << ","
+                << csv_string(metadata_.workload) << "\n";
+    }
+
+    ++records_;
+
+    stream_.flush();
+    if (!stream_)
+    {
+        throw std::system_error{std::make_error_code(std::errc::io_error), "failed to write " + path_};
+    }
+}
+
+void ResultsFile::close()
+{
+    if (!stream_.is_open())
+    {
+        return;
+    }
+
+    if (format_ == ResultsFormat::JSON)
+    {
+        stream_ << (records_ == 0u ? "]\n}\n" : "\n  ]\n}\n");
+    }
+
+    stream_.close();
+    if (!stream_)
+    {
+        throw std::system_error{std::make_error_code(std::errc::io_error), "failed to write " + path_};
+    }
+}
+
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "runner.h"
+
+namespace fs::harness
+{
+
+/**
+ * How benchmark results are written.
+ */
+enum class ResultsFormat
+{
+    /** A single object holding the run metadata and an array of records. */
+    JSON,
+
+    /** A header line then one line per record, with the run metadata repeated on every line. */
+    CSV
+};
+
+/**
+ * Get the name of a results format.
+ *
+ * @param format
+ *   Format.
+ *
+ * @returns
+ *   Name of format.
+ */
+std::string_view to_string(ResultsFormat format);
+
+/**
+ * Description of the build and machine a run was made on, so results can be compared across releases and hardware.
+ */
+struct RunMetadata
+{
+    /** Revision of the source tree the harness was configured from. */
+    std::string git_revision;
+
+    /** Compiler name and version. */
+    std::string compiler;
+
+    /** CMake build type. */
+    std::string build_type;
+
+    /** Flags the harness was compiled with. */
+    std::string compiler_flags;
+
+    /** Whether the harness was built with USE_FAST_MATHS. */
+    bool fast_maths = false;
+
+    /** Model name of the cpu. */
+    std::string cpu_model;
+
+    /** Instruction set batch kernels are bound to by default. */
+    std::string isa;
+
+    /** Time the run started, as UTC in ISO 8601 format. */
+    std::string started;
+
+    /** How the latency and throughput inputs were made, in the form given to --workload. */
+    std::string workload;
+};
+
+/**
+ * Collect metadata for the current build and machine.
+ *
+ * @returns
+ *   Metadata of this run.
+ */
+RunMetadata collect_metadata();
+
+/**
+ * Timings of a benchmark read back from a results file.
+ */
+struct StoredResult
+{
+    /** Name of kernel. */
+    std::string kernel;
+
+    /** Label of benchmark. */
+    std::string benchmark;
+
+    /** ns/element of each repetition. */
+    std::vector<double> samples;
+};
+
+/**
+ * Read the timings from a results file written by an earlier run, the format is detected from the contents.
+ *
+ * @param path
+ *   Path of file.
+ *
+ * @returns
+ *   Timings of every benchmark in the file.
+ *
+ * @throws std::runtime_error
+ *   If the file can't be read or isn't a results file.
+ */
+std::vector<StoredResult> read_results(const std::string &path);
+
+/**
+ * A file of benchmark results, one record per timed run.
+ *
+ * Records are written and flushed as they are added, so a long run that is interrupted still leaves the results so
+ * far, although a JSON file will then be missing its closing brackets.
+ */
+class ResultsFile
+{
+  public:
+    /**
+     * Construct a new ResultsFile.
+     *
+     * @param path
+     *   Path of file to create, any existing file is replaced.
+     *
+     * @param format
+     *   How to write the file.
+     *
+     * @param metadata
+     *   Metadata of run.
+     *
+     * @throws std::system_error
+     *   If the file can't be created.
+     */
+    ResultsFile(const std::string &path, ResultsFormat format, RunMetadata metadata);
+
+    ~ResultsFile();
+
+    ResultsFile(const ResultsFile &) = delete;
+    ResultsFile &operator=(const ResultsFile &) = delete;
+
+    /**
+     * Write the result of a benchmark. The timings, elements/s among them, come from the repetition closest to the
+     * median. The errors and the wall time come from the first, which is the only one checked for accuracy, so the
+     * wall time includes the reference and is recorded as checked_wall_ns.
+     *
+     * @param kernel
+     *   Name of kernel.
+     *
+     * @param benchmark
+     *   Label of benchmark.
+     *
+     * @param variant
+     *   Which code path of the kernel was timed.
+     *
+     * @param run
+     *   Every repetition of the benchmark.
+     *
+     * @throws std::system_error
+     *   If the record can't be written.
+     */
+    void add(std::string_view kernel, std::string_view benchmark, std::string_view variant, const BenchmarkRun &run);
+
+    /**
+     * Finish writing the file, called by the destructor if not called explicitly.
+     *
+     * @throws std::system_error
+     *   If the file can't be written.
+     */
+    void close();
+
+  private:
+    /** Path of file being written. */
+    std::string path_;
+
+    /** How the file is written. */
+    ResultsFormat format_;
+
+    /** Metadata of run. */
+    RunMetadata metadata_;
+
+    /** Stream being written to. */
+    std::ofstream stream_;
+
+    /** Number of records written. */
+    std::size_t records_;
+};
+
+}
@@ -0,0 +1,167 @@
+#include "runner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace fs::harness
+{
+
+std::vector<double> BenchmarkRun::samples() const
+{
+    auto samples = std::vector<double>{};
+    samples.reserve(repetitions.size());
+
+    for (const auto &repetition : repetitions)
+    {
+        samples.push_back(repetition.timing.ns_per_element());
+    }
+
+    return samples;
+}
+
+SweepResult BenchmarkRun::representative() const
+{
+    if (repetitions.empty())
+    {
+        return {};
+    }
+
+    const auto closest = std::ranges::min_element(
+        repetitions,
+        {},
+        [this](const SweepResult &repetition)
+        { return std::fabs(repetition.timing.ns_per_element() - ns_per_element.median); });
+
+    auto result = *closest;
+    result.errors = repetitions.front().errors;
+
+    return result;
+}
+
+BenchmarkRun run_benchmark(
+    const Benchmark &benchmark,
+    ThreadPool &pool,
+    const SweepOptions &options,
+    const RunnerOptions &runner)
+{
+    auto warmup_options = options;
+    warmup_options.count = std::min(options.count, runner.warmup_count);
+    warmup_options.check_accuracy = false;
+
+    for (auto i = std::size_t{0u}; i < runner.warmup; ++i)
+    {
+        benchmark.run(pool, warmup_options);
+    }
+
+    // the reference usually costs more than the kernel, so only pay for checking it once
+    auto repeat_options = options;
+    repeat_options.check_accuracy = false;
+
+    auto run = BenchmarkRun{};
+
+    for (auto i = std::size_t{0u}; i < std::max<std::size_t>(runner.repetitions, 1u); ++i)
+    {
+        run.repetitions.push_back(benchmark.run(pool, i == 0u ? options : repeat_options));
+    }
+
+    const auto samples = run.samples();
+    run.ns_per_element = summarise(samples);
+
+    return run;
+}
+
+ModeRun run_mode(const Benchmark &benchmark, TimingMode mode, const ModeOptions &options, const RunnerOptions &runner)
+{
+    const auto latency = mode == TimingMode::LATENCY;
+
+    auto stream = StreamOptions{
+        .use_cycle_counter = options.use_cycle_counter,
+        .baseline = latency ? options.latency_baseline : options.throughput_baseline,
+        .batch_baseline = latency ? options.batch_latency_baseline : options.batch_throughput_baseline,
+        .counters = nullptr};
+
+    // the inputs are small enough to warm up over all of them, which also brings them into whatever cache they fit
+    for (auto i = std::size_t{0u}; i < runner.warmup; ++i)
+    {
+        benchmark.time(mode, options.inputs, stream);
+    }
+
+    const auto counting = (options.counters != nullptr) && options.counters->available();
+    stream.counters = counting ? options.counters : nullptr;
+
+    auto ns_samples = std::vector<double>{};
+    auto cycle_samples = std::vector<double>{};
+    auto counters = CounterValues{};
+    auto below_baseline = std::size_t{0u};
+
+    for (auto i = std::size_t{0u}; i < std::max<std::size_t>(runner.repetitions, 1u); ++i)
+    {
+        const auto timing = benchmark.time(mode, options.inputs, stream);
+
+        if (counting)
+        {
+            if (i == 0u)
+            {
+                counters = timing.counters;
+            }
+            else
+            {
+                counters += timing.counters;
+            }
+        }
+
+        if (timing.below_baseline())
+        {
+            ++below_baseline;
+        }
+
+        ns_samples.push_back(timing.ns_per_element());
+        if (options.use_cycle_counter)
+        {
+            cycle_samples.push_back(timing.cycles_per_element());
+        }
+    }
+
+    return {
+        .mode = mode,
+        .ns_per_element = summarise(ns_samples),
+        .cycles_per_element = summarise(cycle_samples),
+        .below_baseline = below_baseline,
+        .counters = counters};
+}
+
+std::string_view to_string(Change change)
+{
+    switch (change)
+    {
+        case Change::NONE: return "no significant change";
+        case Change::IMPROVEMENT: return "improvement";
+        case Change::REGRESSION: return "regression";
+    }
+
+    return "unknown";
+}
+
+Comparison compare(std::span<const double> baseline, std::span<const double> current)
+{
+    auto comparison = Comparison{};
+    comparison.baseline_median = summarise(baseline).median;
+    comparison.median = summarise(current).median;
+    comparison.relative_change = comparison.baseline_median == 0.0
+                                     ? 0.0
+                                     : (comparison.median - comparison.baseline_median) / comparison.baseline_median;
+    comparison.p_value = mann_whitney_p(baseline, current);
+
+    if ((comparison.p_value < significance_level) && (comparison.median != comparison.baseline_median))
+    {
+        comparison.change = comparison.median > comparison.baseline_median ? Change::REGRESSION : Change::IMPROVEMENT;
+    }
+
+    return comparison;
+}
+
+}
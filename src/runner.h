@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "perf_counters.h"
+#include "registry.h"
+#include "statistics.h"
+#include "sweep.h"
+#include "thread_pool.h"
+#include "timing.h"
+
+namespace fs::harness
+{
+
+/**
+ * Options controlling how many times each benchmark is run.
+ */
+struct RunnerOptions
+{
+    /** Number of untimed runs before the timed repetitions, to bring the clock up and the code and data into cache. */
+    std::size_t warmup = 1u;
+
+    /** Number of bit patterns swept by each warmup run, capped at the size of the sweep. */
+    std::uint64_t warmup_count = std::uint64_t{1u} << 24u;
+
+    /** Number of timed repetitions. */
+    std::size_t repetitions = 1u;
+};
+
+/**
+ * Options for timing benchmarks over preloaded inputs on the calling thread.
+ */
+struct ModeOptions
+{
+    /** Inputs to time over, the same for every benchmark so results are comparable. */
+    std::span<const float> inputs;
+
+    /** Whether to read the cycle counter. */
+    bool use_cycle_counter = true;
+
+    /** Overhead of the latency chain. */
+    Baseline latency_baseline = {};
+
+    /** Overhead of the throughput loop. */
+    Baseline throughput_baseline = {};
+
+    /** Overhead of the latency chain through a batch call. */
+    Baseline batch_latency_baseline = {};
+
+    /** Overhead of a batch throughput call. */
+    Baseline batch_throughput_baseline = {};
+
+    /** Hardware counters to read around each timed repetition, null to not count. */
+    PerfCounters *counters = nullptr;
+};
+
+/**
+ * Result of every repetition of a benchmark in one timing mode.
+ */
+struct ModeRun
+{
+    /** Mode timed. */
+    TimingMode mode = TimingMode::LATENCY;
+
+    /** Summary of the ns/element of each repetition. */
+    Summary ns_per_element;
+
+    /** Summary of the cycles/element of each repetition, empty if the cycle counter wasn't read. */
+    Summary cycles_per_element;
+
+    /** Number of repetitions which took less time than the baseline, their ns/element is clamped to zero. */
+    std::size_t below_baseline = 0u;
+
+    /** Hardware counts summed over every timed repetition, empty if they weren't read. */
+    CounterValues counters;
+};
+
+/**
+ * Result of every repetition of a benchmark.
+ */
+struct BenchmarkRun
+{
+    /** Result of each repetition in the order they were run, only the first is checked for accuracy. */
+    std::vector<SweepResult> repetitions;
+
+    /** Summary of the ns/element of each repetition. */
+    Summary ns_per_element;
+
+    /** Results of each timing mode that was run, in the order they were run. */
+    std::vector<ModeRun> modes;
+
+    /**
+     * Get the ns/element of each repetition.
+     *
+     * @returns
+     *   Samples in repetition order.
+     */
+    std::vector<double> samples() const;
+
+    /**
+     * Get the repetition to report on its own, timings come from the one closest to the median and errors come from
+     * the first as that is the only one checked.
+     *
+     * @returns
+     *   Representative result.
+     */
+    SweepResult representative() const;
+};
+
+/**
+ * Run a benchmark with warmup and repetitions.
+ *
+ * @param benchmark
+ *   Benchmark to run.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for each sweep.
+ *
+ * @param runner
+ *   How many times to run.
+ *
+ * @returns
+ *   Result of every repetition.
+ */
+BenchmarkRun run_benchmark(
+    const Benchmark &benchmark,
+    ThreadPool &pool,
+    const SweepOptions &options,
+    const RunnerOptions &runner);
+
+/**
+ * Time a benchmark in one mode over preloaded inputs on the calling thread, with the same warmup and repetitions as
+ * the sweep.
+ *
+ * @param benchmark
+ *   Benchmark to time.
+ *
+ * @param mode
+ *   Mode to time in.
+ *
+ * @param options
+ *   Inputs and overheads.
+ *
+ * @param runner
+ *   How many times to run.
+ *
+ * @returns
+ *   Summary of every repetition.
+ */
+ModeRun run_mode(const Benchmark &benchmark, TimingMode mode, const ModeOptions &options, const RunnerOptions &runner);
+
+/**
+ * Outcome of comparing a benchmark against an earlier run.
+ */
+enum class Change
+{
+    /** No statistically significant difference. */
+    NONE,
+
+    /** Significantly faster than the earlier run. */
+    IMPROVEMENT,
+
+    /** Significantly slower than the earlier run. */
+    REGRESSION
+};
+
+/**
+ * Get the name of a change.
+ *
+ * @param change
+ *   Change.
+ *
+ * @returns
+ *   Name of change.
+ */
+std::string_view to_string(Change change);
+
+/**
+ * Comparison of a benchmark against an earlier run.
+ */
+struct Comparison
+{
+    /** Median ns/element of the earlier run. */
+    double baseline_median = 0.0;
+
+    /** Median ns/element of this run. */
+    double median = 0.0;
+
+    /** Change in median relative to the earlier run, positive is slower. */
+    double relative_change = 0.0;
+
+    /** Mann-Whitney p value of the two sets of samples. */
+    double p_value = 1.0;
+
+    /** Outcome. */
+    Change change = Change::NONE;
+};
+
+/** p value below which a difference is treated as real rather than noise. */
+inline constexpr auto significance_level = 0.05;
+
+/**
+ * Compare the ns/element samples of two runs of a benchmark. Several repetitions are needed on both sides for any
+ * difference to be significant, four each is the smallest that can reach the significance level.
+ *
+ * @param baseline
+ *   Samples of earlier run.
+ *
+ * @param current
+ *   Samples of this run.
+ *
+ * @returns
+ *   Comparison of runs.
+ */
+Comparison compare(std::span<const double> baseline, std::span<const double> current);
+
+}
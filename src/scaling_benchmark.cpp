@@ -0,0 +1,371 @@
+#include "scaling_benchmark.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.h"
+#include "timing.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace
+{
+
+/**
+ * Read which NUMA node each cpu is on from sysfs.
+ *
+ * @returns
+ *   Node of each cpu, empty if the topology can't be read.
+ */
+std::map<int, int> cpu_nodes()
+{
+    auto nodes = std::map<int, int>{};
+
+    const auto root = std::filesystem::path{"/sys/devices/system/node"};
+    auto error = std::error_code{};
+
+    for (const auto &entry : std::filesystem::directory_iterator{root, error})
+    {
+        const auto name = entry.path().filename().string();
+        auto node = 0;
+
+        if (!name.starts_with("node") ||
+            (std::from_chars(name.data() + 4, name.data() + name.size(), node).ptr != name.data() + name.size()))
+        {
+            continue;
+        }
+
+        // a list of ranges such as 0-3,8-11
+        auto line = std::string{};
+        std::getline(std::ifstream{entry.path() / "cpulist"}, line);
+
+        for (auto rest = std::string_view{line}; !rest.empty();)
+        {
+            const auto comma = std::min(rest.find(','), rest.size());
+            const auto range = rest.substr(0u, comma);
+            rest.remove_prefix(std::min(comma + 1u, rest.size()));
+
+            auto first = 0;
+            const auto [end, parsed] = std::from_chars(range.data(), range.data() + range.size(), first);
+            if (parsed != std::errc{})
+            {
+                continue;
+            }
+
+            auto last = first;
+            if ((end != range.data() + range.size()) && (*end == '-'))
+            {
+                std::from_chars(end + 1, range.data() + range.size(), last);
+            }
+
+            for (auto cpu = first; cpu <= last; ++cpu)
+            {
+                nodes[cpu] = node;
+            }
+        }
+    }
+
+    return nodes;
+}
+
+/**
+ * Get the cpu the calling thread is running on, which is stable once it is pinned.
+ *
+ * @returns
+ *   Cpu index, empty if it can't be found.
+ */
+std::optional<int> current_cpu()
+{
+#if defined(__linux__)
+    const auto cpu = ::sched_getcpu();
+    if (cpu >= 0)
+    {
+        return cpu;
+    }
+#endif
+
+    return std::nullopt;
+}
+
+/**
+ * Get the thread counts to time, one and then doubling up to the most threads, which is always included.
+ *
+ * @param max_threads
+ *   Most threads.
+ *
+ * @returns
+ *   Thread counts in increasing order.
+ */
+std::vector<std::size_t> thread_counts(std::size_t max_threads)
+{
+    auto counts = std::vector<std::size_t>{};
+
+    for (auto threads = std::size_t{1u}; threads < max_threads; threads *= 2u)
+    {
+        counts.push_back(threads);
+    }
+
+    counts.push_back(max_threads);
+
+    return counts;
+}
+
+/**
+ * Input and output buffers of every worker.
+ */
+struct WorkerBuffers
+{
+    std::vector<std::optional<fs::harness::InputBuffer>> inputs;
+    std::vector<std::optional<fs::harness::InputBuffer>> outputs;
+};
+
+/**
+ * Allocate and first touch the buffers of every worker, copying each worker's inputs from its part of the source. For
+ * a kernel restricted to a domain the inputs are folded into it, so the debug checks in sin_reduced never fire and the
+ * fold isn't part of the timing.
+ *
+ * @param pool
+ *   Workers.
+ *
+ * @param source
+ *   Every input.
+ *
+ * @param placement
+ *   Which threads touch the buffers first.
+ *
+ * @param kernel
+ *   Kernel the buffers are for, only its domain is used.
+ *
+ * @returns
+ *   Buffers of every worker.
+ */
+WorkerBuffers place_buffers(
+    fs::harness::ThreadPool &pool,
+    std::span<const float> source,
+    fs::harness::BufferPlacement placement,
+    const fs::harness::Kernel &kernel)
+{
+    auto buffers = WorkerBuffers{};
+    buffers.inputs.resize(pool.size());
+    buffers.outputs.resize(pool.size());
+
+    const auto fill = [&](std::size_t worker)
+    {
+        const auto begin = (source.size() * worker) / pool.size();
+        const auto end = (source.size() * (worker + 1u)) / pool.size();
+
+        auto &input = buffers.inputs[worker].emplace(end - begin);
+        if (std::isfinite(kernel.high))
+        {
+            std::ranges::transform(
+                source.subspan(begin, end - begin),
+                input.span().begin(),
+                [&](float theta) { return fs::harness::detail::fold_input(theta, kernel.low, kernel.high); });
+        }
+        else
+        {
+            std::ranges::copy(source.subspan(begin, end - begin), input.span().begin());
+        }
+
+        auto &output = buffers.outputs[worker].emplace(end - begin);
+        std::ranges::fill(output.span(), 0.0f);
+    };
+
+    if (placement == fs::harness::BufferPlacement::LOCAL)
+    {
+        pool.on_every_worker(fill);
+    }
+    else
+    {
+        for (auto worker = std::size_t{0u}; worker < pool.size(); ++worker)
+        {
+            fill(worker);
+        }
+    }
+
+    return buffers;
+}
+
+/**
+ * Time every worker calculating its own buffer with a kernel.
+ *
+ * @param pool
+ *   Workers.
+ *
+ * @param buffers
+ *   Buffers of every worker.
+ *
+ * @param transform
+ *   Batch entry point of kernel.
+ *
+ * @param options
+ *   Number of passes.
+ *
+ * @returns
+ *   Wall time of the fastest pass.
+ */
+std::chrono::nanoseconds time_pass(
+    fs::harness::ThreadPool &pool,
+    WorkerBuffers &buffers,
+    const fs::harness::TransformFunction &transform,
+    const fs::harness::ScalingOptions &options)
+{
+    const auto pass = [&](std::size_t worker)
+    {
+        transform(std::as_const(*buffers.inputs[worker]).span(), buffers.outputs[worker]->span());
+        fs::harness::escape(buffers.outputs[worker]->span().data());
+    };
+
+    for (auto i = std::size_t{0u}; i < options.warmup; ++i)
+    {
+        pool.on_every_worker(pass);
+    }
+
+    auto fastest = std::chrono::nanoseconds::max();
+
+    for (auto i = std::size_t{0u}; i < std::max(options.repetitions, std::size_t{1u}); ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        pool.on_every_worker(pass);
+        const auto end = std::chrono::steady_clock::now();
+
+        fastest = std::min(fastest, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start));
+    }
+
+    return fastest;
+}
+
+}
+
+namespace fs::harness
+{
+
+std::string_view to_string(BufferPlacement placement)
+{
+    switch (placement)
+    {
+        case BufferPlacement::LOCAL: return "local";
+        case BufferPlacement::CENTRAL: return "central";
+    }
+
+    return "unknown";
+}
+
+std::vector<ScalingResult> benchmark_scaling(const std::vector<const Kernel *> &kernels, const ScalingOptions &options)
+{
+    const auto source = make_workload(options.workload, options.sweep_first, options.sweep_count, options.count);
+
+    const auto nodes = cpu_nodes();
+    const auto node_count = numa_node_count();
+
+    auto placements = std::vector<BufferPlacement>{BufferPlacement::LOCAL};
+    if (node_count > 1u)
+    {
+        placements.push_back(BufferPlacement::CENTRAL);
+    }
+
+    auto results = std::vector<ScalingResult>{};
+    for (const auto *kernel : kernels)
+    {
+        if (kernel->transform)
+        {
+            results.emplace_back(kernel->name);
+        }
+    }
+
+    const auto max_threads =
+        options.max_threads == 0u ? std::max(1u, std::thread::hardware_concurrency()) : options.max_threads;
+
+    for (const auto threads : thread_counts(max_threads))
+    {
+        auto pool = ThreadPool{threads, options.pin};
+
+        // workers only stay on one cpu, and so one node, when they are pinned
+        auto used = std::set<int>{};
+        if (pool.pinned() && !nodes.empty())
+        {
+            auto cpus = std::vector<std::optional<int>>(pool.size());
+            pool.on_every_worker([&](std::size_t worker) { cpus[worker] = current_cpu(); });
+
+            for (const auto cpu : cpus)
+            {
+                const auto node = cpu ? nodes.find(*cpu) : nodes.end();
+                if (node != nodes.end())
+                {
+                    used.insert(node->second);
+                }
+            }
+        }
+
+        for (const auto placement : placements)
+        {
+            // neighbouring kernels usually share a domain, so the buffers are only placed again when it changes
+            auto buffers = std::optional<WorkerBuffers>{};
+            auto domain = std::pair<float, float>{};
+
+            auto result = results.begin();
+            for (const auto *kernel : kernels)
+            {
+                if (!kernel->transform)
+                {
+                    continue;
+                }
+
+                if (!buffers || (domain != std::pair{kernel->low, kernel->high}))
+                {
+                    buffers.reset();
+                    buffers = place_buffers(pool, source.span(), placement, *kernel);
+                    domain = {kernel->low, kernel->high};
+                }
+
+                auto &run = result->runs.emplace_back();
+                run.threads = pool.size();
+                run.placement = placement;
+                run.nodes = used.size();
+                run.pinned = pool.pinned();
+                run.total = time_pass(pool, *buffers, kernel->transform, options);
+                run.elements = source.size();
+
+                // the first run is always one thread with local buffers
+                const auto &single = result->runs.front();
+                run.speedup = run.total.count() == 0
+                    ? 0.0
+                    : static_cast<double>(single.total.count()) / static_cast<double>(run.total.count());
+
+                ++result;
+            }
+        }
+    }
+
+    return results;
+}
+
+std::size_t numa_node_count()
+{
+    auto distinct = std::set<int>{};
+    for (const auto &[cpu, node] : cpu_nodes())
+    {
+        distinct.insert(node);
+    }
+
+    return distinct.size();
+}
+
+}
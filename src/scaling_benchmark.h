@@ -0,0 +1,164 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "registry.h"
+#include "workload.h"
+
+namespace fs::harness
+{
+
+/**
+ * Where the buffers of each worker in the scaling benchmark are placed.
+ */
+enum class BufferPlacement
+{
+    /** Each worker allocates and first touches its own buffers, so on Linux their pages land on the worker's node. */
+    LOCAL,
+
+    /** The calling thread first touches every buffer, so they all land on its node and other nodes read remotely. */
+    CENTRAL
+};
+
+/**
+ * Get the name of a buffer placement.
+ *
+ * @param placement
+ *   Buffer placement.
+ *
+ * @returns
+ *   Name of placement.
+ */
+std::string_view to_string(BufferPlacement placement);
+
+/**
+ * Options for timing batch kernels across thread counts.
+ */
+struct ScalingOptions
+{
+    /** Total number of inputs, split evenly between the workers so every thread count does the same work. */
+    std::size_t count = std::size_t{1u} << 24u;
+
+    /** Most threads to time with, zero means use all hardware threads. */
+    std::size_t max_threads = 0u;
+
+    /** Whether to pin each worker to its own cpu. */
+    bool pin = true;
+
+    /** Number of untimed passes before timing each kernel. */
+    std::size_t warmup = 1u;
+
+    /** Number of timed passes of each kernel, the fastest is kept. */
+    std::size_t repetitions = 1u;
+
+    /** How the inputs are made. */
+    Workload workload = {};
+
+    /** First float bit pattern of the spread workload. */
+    std::uint64_t sweep_first = 0u;
+
+    /** Number of float bit patterns of the spread workload. */
+    std::uint64_t sweep_count = std::uint64_t{1u} << 32u;
+};
+
+/**
+ * Result of timing one kernel at one thread count.
+ */
+struct ScalingRun
+{
+    /** Number of workers. */
+    std::size_t threads = 0u;
+
+    /** Where the buffers were placed. */
+    BufferPlacement placement = BufferPlacement::LOCAL;
+
+    /** Number of NUMA nodes the workers ran on, zero if it isn't known. */
+    std::size_t nodes = 0u;
+
+    /** Whether every worker was pinned to a cpu. */
+    bool pinned = false;
+
+    /** Wall time of the fastest pass over every input. */
+    std::chrono::nanoseconds total = std::chrono::nanoseconds{0};
+
+    /** Number of inputs in a pass. */
+    std::uint64_t elements = 0u;
+
+    /** Time of one thread with local buffers divided by this time. */
+    double speedup = 0.0;
+
+    /**
+     * Get the speedup for each thread, one if the kernel scales perfectly.
+     *
+     * @returns
+     *   Parallel efficiency.
+     */
+    double efficiency() const
+    {
+        return threads == 0u ? 0.0 : speedup / static_cast<double>(threads);
+    }
+
+    /**
+     * Get the rate of memory traffic, counting each input read and each result written once.
+     *
+     * @returns
+     *   Bytes per second.
+     */
+    double bytes_per_second() const
+    {
+        if (total.count() == 0)
+        {
+            return 0.0;
+        }
+
+        return static_cast<double>(elements * 2u * sizeof(float)) * 1e9 / static_cast<double>(total.count());
+    }
+};
+
+/**
+ * Results of the scaling benchmark for one kernel.
+ */
+struct ScalingResult
+{
+    /** Name of kernel. */
+    std::string name;
+
+    /** One run for each thread count and placement, in increasing thread count. */
+    std::vector<ScalingRun> runs;
+};
+
+/**
+ * Time the batch entry point of kernels with one thread, then doubling thread counts up to the most threads. Each
+ * worker calculates its own contiguous part of the inputs into its own buffer, so once the kernels run out of memory
+ * bandwidth adding threads stops helping. With more than one NUMA node every thread count is also timed with every
+ * buffer on the node of the calling thread, showing what local placement is worth. Kernels restricted to a domain are
+ * timed over the inputs folded into it.
+ *
+ * @param kernels
+ *   Kernels to time, those without a batch entry point are skipped.
+ *
+ * @param options
+ *   How to time them.
+ *
+ * @returns
+ *   Result of each kernel timed.
+ *
+ * @throws std::runtime_error
+ *   If the inputs can't be made.
+ */
+std::vector<ScalingResult> benchmark_scaling(const std::vector<const Kernel *> &kernels, const ScalingOptions &options);
+
+/**
+ * Get the number of NUMA nodes with cpus.
+ *
+ * @returns
+ *   Number of nodes, zero if the topology can't be read.
+ */
+std::size_t numa_node_count();
+
+}
@@ -0,0 +1,473 @@
+#include "selector.h"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "accuracy.h"
+#include "cpu_features.h"
+#include "results.h"
+#include "timing.h"
+
+namespace
+{
+
+/** First line of a selection table cache, changed whenever the layout of the file changes. */
+constexpr auto cache_version = std::string_view{"# fastest_sine selection table 1"};
+
+/** Prefix of the line holding the build and cpu the table was measured on. */
+constexpr auto cache_key_prefix = std::string_view{"# build "};
+
+/** Column names of a selection table cache. */
+constexpr auto cache_header = std::string_view{"kernel,low,high,max_absolute,max_relative,max_ulp,ns_per_element"};
+
+/**
+ * A run of consecutive float bit patterns.
+ */
+struct PatternRange
+{
+    /** First bit pattern. */
+    std::uint64_t first;
+
+    /** Number of bit patterns. */
+    std::uint64_t count;
+};
+
+/**
+ * Get the bit patterns of every float in a domain. Negative floats have the sign bit set and their patterns grow with
+ * magnitude, so a domain spanning zero is two runs.
+ *
+ * @param domain
+ *   Domain, must not be empty.
+ *
+ * @returns
+ *   Runs of bit patterns.
+ */
+std::vector<PatternRange> domain_patterns(const fs::harness::Domain &domain)
+{
+    const auto bits = [](float value) { return std::uint64_t{std::bit_cast<std::uint32_t>(value)}; };
+
+    auto ranges = std::vector<PatternRange>{};
+
+    if (std::signbit(domain.low))
+    {
+        const auto top = std::signbit(domain.high) ? domain.high : -0.0f;
+        ranges.push_back({bits(top), bits(domain.low) - bits(top) + 1u});
+    }
+
+    if (!std::signbit(domain.high))
+    {
+        const auto bottom = std::signbit(domain.low) ? 0.0f : domain.low;
+        ranges.push_back({bits(bottom), bits(domain.high) - bits(bottom) + 1u});
+    }
+
+    return ranges;
+}
+
+/**
+ * Get inputs spread evenly in value over a domain, which is how callers with a domain tend to pass them, rather than
+ * evenly over bit patterns which would crowd them around zero.
+ *
+ * @param domain
+ *   Domain to spread over.
+ *
+ * @param size
+ *   Number of inputs.
+ *
+ * @returns
+ *   Inputs in increasing order.
+ */
+std::vector<float> domain_inputs(const fs::harness::Domain &domain, std::size_t size)
+{
+    auto inputs = std::vector<float>(std::max<std::size_t>(size, 1u));
+    const auto step =
+        (static_cast<double>(domain.high) - static_cast<double>(domain.low)) / static_cast<double>(inputs.size());
+
+    for (auto i = std::size_t{0u}; i < inputs.size(); ++i)
+    {
+        inputs[i] = static_cast<float>(static_cast<double>(domain.low) + (step * static_cast<double>(i)));
+    }
+
+    return inputs;
+}
+
+/**
+ * Check a domain can be measured.
+ *
+ * @param domain
+ *   Domain to check.
+ *
+ * @throws std::invalid_argument
+ *   If the domain is empty or not finite.
+ */
+void validate(const fs::harness::Domain &domain)
+{
+    if (!std::isfinite(domain.low) || !std::isfinite(domain.high) || !(domain.low <= domain.high))
+    {
+        throw std::invalid_argument{
+            "invalid domain [" + std::to_string(domain.low) + ", " + std::to_string(domain.high) + "]"};
+    }
+}
+
+/**
+ * Get the benchmark a candidate's throughput is taken from, the batch interface if it has one as that is what the
+ * Calculator handed out uses.
+ *
+ * @param kernel
+ *   Candidate.
+ *
+ * @returns
+ *   Benchmark to time, null if the kernel has none.
+ */
+const fs::harness::Benchmark *timed_benchmark(const fs::harness::Kernel &kernel)
+{
+    const auto batch = std::ranges::find(kernel.benchmarks, kernel.name + " batch", &fs::harness::Benchmark::label);
+    if (batch != kernel.benchmarks.end())
+    {
+        return &*batch;
+    }
+
+    return kernel.benchmarks.empty() ? nullptr : &kernel.benchmarks.front();
+}
+
+/**
+ * Get the key identifying the build and cpu measurements are made on.
+ *
+ * @returns
+ *   Key, on a single line.
+ */
+std::string build_key()
+{
+    const auto metadata = fs::harness::collect_metadata();
+
+    auto key = metadata.git_revision + " | " + metadata.compiler + " | " + metadata.build_type + " | " +
+               metadata.compiler_flags + " | " + metadata.isa + " | " + metadata.cpu_model;
+    std::ranges::replace(key, '\n', ' ');
+
+    return key;
+}
+
+/**
+ * Format a number so it round trips.
+ *
+ * @param value
+ *   Value to format.
+ *
+ * @returns
+ *   Shortest representation of value.
+ */
+template <class T>
+std::string format_number(T value)
+{
+    char buffer[32];
+    const auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+
+    return error == std::errc{} ? std::string{buffer, end} : std::string{"nan"};
+}
+
+/**
+ * Parse a number written by format_number.
+ *
+ * @param text
+ *   Text to parse.
+ *
+ * @param value
+ *   Where to write the number.
+ *
+ * @returns
+ *   True if all of text is a number, otherwise false.
+ */
+template <class T>
+bool parse_number(std::string_view text, T &value)
+{
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return (error == std::errc{}) && (end == text.data() + text.size());
+}
+
+/**
+ * Parse a row of a selection table cache.
+ *
+ * @param line
+ *   Row to parse.
+ *
+ * @returns
+ *   Entry, or empty if the row is malformed.
+ */
+std::optional<fs::harness::SelectionEntry> parse_entry(std::string_view line)
+{
+    auto fields = std::vector<std::string_view>{};
+
+    for (auto start = std::size_t{0u};;)
+    {
+        const auto comma = line.find(',', start);
+        fields.push_back(line.substr(start, comma == std::string_view::npos ? comma : comma - start));
+
+        if (comma == std::string_view::npos)
+        {
+            break;
+        }
+
+        start = comma + 1u;
+    }
+
+    auto entry = fs::harness::SelectionEntry{};
+
+    if ((fields.size() != 7u) || fields[0].empty() || !parse_number(fields[1], entry.domain.low) ||
+        !parse_number(fields[2], entry.domain.high) || !parse_number(fields[3], entry.max_absolute) ||
+        !parse_number(fields[4], entry.max_relative) || !parse_number(fields[5], entry.max_ulp) ||
+        !parse_number(fields[6], entry.ns_per_element))
+    {
+        return std::nullopt;
+    }
+
+    entry.name = fields[0];
+
+    return entry;
+}
+
+/**
+ * Load a selection table cache.
+ *
+ * @param path
+ *   Path of cache.
+ *
+ * @param key
+ *   Key of this build and cpu.
+ *
+ * @returns
+ *   Entries, empty if there is no cache, it is malformed or it was measured on a different build or cpu.
+ */
+std::vector<fs::harness::SelectionEntry> load(const std::string &path, const std::string &key)
+{
+    auto file = std::ifstream{path};
+    auto line = std::string{};
+
+    if (!std::getline(file, line) || (line != cache_version) || !std::getline(file, line) ||
+        (line != std::string{cache_key_prefix} + key) || !std::getline(file, line) || (line != cache_header))
+    {
+        return {};
+    }
+
+    auto entries = std::vector<fs::harness::SelectionEntry>{};
+
+    while (std::getline(file, line))
+    {
+        auto entry = parse_entry(line);
+        if (!entry)
+        {
+            return {};
+        }
+
+        entries.push_back(std::move(*entry));
+    }
+
+    return entries;
+}
+
+}
+
+namespace fs::harness
+{
+
+std::string_view to_string(remez::ErrorMetric metric)
+{
+    switch (metric)
+    {
+        case remez::ErrorMetric::ABSOLUTE: return "absolute";
+        case remez::ErrorMetric::RELATIVE: return "relative";
+        case remez::ErrorMetric::ULP: return "ulp";
+    }
+
+    return "unknown";
+}
+
+double SelectionEntry::error(remez::ErrorMetric metric) const
+{
+    switch (metric)
+    {
+        case remez::ErrorMetric::ABSOLUTE: return max_absolute;
+        case remez::ErrorMetric::RELATIVE: return max_relative;
+        case remez::ErrorMetric::ULP: return max_ulp;
+    }
+
+    return std::numeric_limits<double>::infinity();
+}
+
+Selector::Selector(const std::vector<const Kernel *> &kernels, ThreadPool &pool, SelectorOptions options)
+    : candidates_()
+    , pool_(pool)
+    , options_(std::move(options))
+    , key_(build_key())
+    , table_()
+{
+    for (const auto *kernel : kernels)
+    {
+        if ((kernel->calculator != nullptr) && std::isfinite(kernel->error_bound) && cpu_supports(kernel->isa) &&
+            (timed_benchmark(*kernel) != nullptr))
+        {
+            candidates_.push_back(kernel);
+        }
+    }
+
+    if (!options_.cache_path.empty())
+    {
+        table_ = load(options_.cache_path, key_);
+    }
+}
+
+std::vector<SelectionEntry> Selector::entries(const Domain &domain)
+{
+    validate(domain);
+
+    auto entries = std::vector<SelectionEntry>{};
+    auto inputs = std::vector<float>{};
+    auto mode_options = std::optional<ModeOptions>{};
+    auto changed = false;
+
+    for (const auto *kernel : candidates_)
+    {
+        // kernels restricted to a narrower domain would be measured on inputs they don't accept
+        if ((domain.low < kernel->low) || (domain.high > kernel->high))
+        {
+            continue;
+        }
+
+        const auto cached = std::ranges::find_if(
+            table_,
+            [&](const SelectionEntry &entry) { return (entry.name == kernel->name) && (entry.domain == domain); });
+
+        if (cached != table_.end())
+        {
+            entries.push_back(*cached);
+            continue;
+        }
+
+        // the inputs and their overhead are shared by every kernel measured over the domain
+        if (!mode_options)
+        {
+            inputs = domain_inputs(domain, options_.stream_size);
+
+            mode_options.emplace();
+            mode_options->inputs = inputs;
+            mode_options->use_cycle_counter = false;
+            mode_options->throughput_baseline = calibrate_throughput_baseline(inputs, false);
+            mode_options->batch_throughput_baseline = calibrate_batch_throughput_baseline(inputs, false);
+        }
+
+        entries.push_back(measure(*kernel, domain, *mode_options));
+        table_.push_back(entries.back());
+        changed = true;
+    }
+
+    if (changed && !options_.cache_path.empty())
+    {
+        save();
+    }
+
+    return entries;
+}
+
+std::optional<Selection> Selector::select(const Tolerance &tolerance)
+{
+    auto best = std::optional<Selection>{};
+
+    for (const auto &entry : entries(tolerance.domain))
+    {
+        if (!(entry.error(tolerance.metric) <= tolerance.bound))
+        {
+            continue;
+        }
+
+        if (!best || (entry.ns_per_element < best->entry.ns_per_element))
+        {
+            const auto kernel = std::ranges::find(candidates_, entry.name, &Kernel::name);
+            best = Selection{entry, (*kernel)->calculator};
+        }
+    }
+
+    return best;
+}
+
+SelectionEntry Selector::measure(const Kernel &kernel, const Domain &domain, const ModeOptions &options) const
+{
+    auto stats = UlpStats{};
+
+    for (const auto &range : domain_patterns(domain))
+    {
+        auto accuracy = AccuracyOptions{};
+        accuracy.first = range.first;
+        accuracy.count = range.count;
+
+        stats.merge(check_accuracy(*kernel.calculator, reference_sin, pool_, accuracy).total);
+    }
+
+    auto entry = SelectionEntry{};
+    entry.name = kernel.name;
+    entry.domain = domain;
+
+    // a NaN or infinity anywhere in the domain fails every tolerance
+    if (stats.mismatches != 0u)
+    {
+        entry.max_absolute = std::numeric_limits<double>::infinity();
+        entry.max_relative = std::numeric_limits<double>::infinity();
+        entry.max_ulp = std::numeric_limits<double>::infinity();
+    }
+    else
+    {
+        entry.max_absolute = stats.max_absolute;
+        entry.max_relative = stats.max_relative;
+        entry.max_ulp = stats.max_ulp;
+    }
+
+    entry.ns_per_element =
+        run_mode(*timed_benchmark(kernel), TimingMode::THROUGHPUT, options, options_.runner).ns_per_element.median;
+
+    return entry;
+}
+
+void Selector::save() const
+{
+    // written aside and renamed over the cache so a reader never sees half a table
+    const auto temporary = options_.cache_path + ".tmp";
+
+    {
+        auto file = std::ofstream{temporary};
+
+        file << cache_version << "\n" << cache_key_prefix << key_ << "\n" << cache_header << "\n";
+
+        for (const auto &entry : table_)
+        {
+            file << entry.name << "," << format_number(entry.domain.low) << "," << format_number(entry.domain.high)
+                 << "," << format_number(entry.max_absolute) << "," << format_number(entry.max_relative) << ","
+                 << format_number(entry.max_ulp) << "," << format_number(entry.ns_per_element) << "\n";
+        }
+
+        file.close();
+
+        if (!file)
+        {
+            throw std::system_error{std::make_error_code(std::errc::io_error), "failed to write " + temporary};
+        }
+    }
+
+    if (std::rename(temporary.c_str(), options_.cache_path.c_str()) != 0)
+    {
+        throw std::system_error{errno, std::generic_category(), "failed to replace " + options_.cache_path};
+    }
+}
+
+}
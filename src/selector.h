@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "calculator.h"
+#include "registry.h"
+#include "remez.h"
+#include "runner.h"
+#include "thread_pool.h"
+
+namespace fs::harness
+{
+
+/**
+ * Closed range of inputs a caller will pass.
+ */
+struct Domain
+{
+    /** Smallest input. */
+    float low = -std::numbers::pi_v<float>;
+
+    /** Largest input. */
+    float high = std::numbers::pi_v<float>;
+
+    bool operator==(const Domain &) const = default;
+};
+
+/**
+ * What a caller needs from sine, for example an absolute error of at most 1e-4 over [-pi, pi].
+ */
+struct Tolerance
+{
+    /** Largest error allowed. */
+    double bound = 1e-4;
+
+    /** How error is measured. */
+    remez::ErrorMetric metric = remez::ErrorMetric::ABSOLUTE;
+
+    /** Inputs the bound must hold over. */
+    Domain domain = {};
+};
+
+/**
+ * Get the name of an error metric.
+ *
+ * @param metric
+ *   Metric.
+ *
+ * @returns
+ *   Name of metric.
+ */
+std::string_view to_string(remez::ErrorMetric metric);
+
+/**
+ * Measurements of one kernel over one domain, a row of the selection table.
+ */
+struct SelectionEntry
+{
+    /** Name of kernel. */
+    std::string name;
+
+    /** Domain measured over. */
+    Domain domain = {};
+
+    /** Largest absolute error over every float in the domain, infinity if any result was NaN or infinite. */
+    double max_absolute = 0.0;
+
+    /** Largest relative error over every float in the domain, infinity if any result was NaN or infinite. */
+    double max_relative = 0.0;
+
+    /** Largest ulp error over every float in the domain, infinity if any result was NaN or infinite. */
+    double max_ulp = 0.0;
+
+    /** Median reciprocal throughput over inputs spread evenly across the domain. */
+    double ns_per_element = 0.0;
+
+    /**
+     * Get the largest error in a metric.
+     *
+     * @param metric
+     *   Metric.
+     *
+     * @returns
+     *   Largest error.
+     */
+    double error(remez::ErrorMetric metric) const;
+};
+
+/**
+ * A kernel chosen to meet a tolerance.
+ */
+struct Selection
+{
+    /** Measurements of the kernel. */
+    SelectionEntry entry;
+
+    /** The kernel, ready to use. */
+    std::shared_ptr<const Calculator> calculator;
+};
+
+/**
+ * Options for measuring and caching the selection table.
+ */
+struct SelectorOptions
+{
+    /** Path of the selection table cache, empty keeps the table in memory only. */
+    std::string cache_path;
+
+    /** Number of inputs the throughput of each kernel is timed over. */
+    std::size_t stream_size = std::size_t{1u} << 16u;
+
+    /** How many times to time each kernel. */
+    RunnerOptions runner = {};
+};
+
+/**
+ * Picks the fastest kernel meeting an error tolerance over a domain.
+ *
+ * Each candidate is checked against the double reference over every float in the domain and timed for throughput over
+ * the domain, the first time the domain is asked for. Measurements are kept in a table which is cached on disk, keyed
+ * by the build and cpu so a cache from a different binary or machine is measured afresh rather than trusted.
+ */
+class Selector
+{
+  public:
+    /**
+     * Construct a new Selector, loading the cached selection table if there is one for this build and cpu.
+     *
+     * @param kernels
+     *   Candidates, kernels without a Calculator, with no declared error bound or needing an instruction set the cpu
+     *   doesn't have are never selected.
+     *
+     * @param pool
+     *   Pool to check accuracy with.
+     *
+     * @param options
+     *   Where the table is cached and how kernels are timed.
+     */
+    Selector(const std::vector<const Kernel *> &kernels, ThreadPool &pool, SelectorOptions options);
+
+    /**
+     * Get the measurements of every candidate accepting the whole of a domain, measuring any which aren't in the table
+     * and saving the table if it changed.
+     *
+     * @param domain
+     *   Domain to measure over.
+     *
+     * @returns
+     *   Measurements in candidate order.
+     *
+     * @throws std::invalid_argument
+     *   If the domain is empty or not finite.
+     *
+     * @throws std::system_error
+     *   If the table can't be saved.
+     */
+    std::vector<SelectionEntry> entries(const Domain &domain);
+
+    /**
+     * Get the fastest candidate which meets a tolerance.
+     *
+     * @param tolerance
+     *   Tolerance to meet.
+     *
+     * @returns
+     *   Fastest candidate meeting the tolerance, or empty if none do.
+     *
+     * @throws std::invalid_argument
+     *   If the domain is empty or not finite.
+     *
+     * @throws std::system_error
+     *   If the table can't be saved.
+     */
+    std::optional<Selection> select(const Tolerance &tolerance);
+
+  private:
+    /**
+     * Measure a candidate over a domain.
+     *
+     * @param kernel
+     *   Candidate.
+     *
+     * @param domain
+     *   Domain to measure over.
+     *
+     * @param options
+     *   Inputs and overhead to time over.
+     *
+     * @returns
+     *   Measurements.
+     */
+    SelectionEntry measure(const Kernel &kernel, const Domain &domain, const ModeOptions &options) const;
+
+    /**
+     * Write the table to the cache.
+     *
+     * @throws std::system_error
+     *   If the file can't be written.
+     */
+    void save() const;
+
+    /** Kernels which may be selected. */
+    std::vector<const Kernel *> candidates_;
+
+    /** Pool to check accuracy with. */
+    ThreadPool &pool_;
+
+    /** Cache and timing options. */
+    SelectorOptions options_;
+
+    /** Identifies the build and cpu the table was measured on. */
+    std::string key_;
+
+    /** Every measurement made or loaded. */
+    std::vector<SelectionEntry> table_;
+};
+
+}
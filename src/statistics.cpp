@@ -0,0 +1,209 @@
+#include "statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <vector>
+
+namespace
+{
+
+/** Largest combined sample count the exact Mann-Whitney distribution is calculated for. */
+constexpr auto exact_limit = std::size_t{40u};
+
+/**
+ * Count the orderings of two samples which give each value of the Mann-Whitney U statistic.
+ *
+ * @param m
+ *   Size of first sample.
+ *
+ * @param n
+ *   Size of second sample.
+ *
+ * @returns
+ *   Number of orderings for each U in [0, m * n].
+ */
+std::vector<double> u_distribution(std::size_t m, std::size_t n)
+{
+    // counts[i][j] holds the distribution for sample sizes i and j, built up from the recurrence
+    // N(u; i, j) = N(u - j; i - 1, j) + N(u; i, j - 1)
+    auto counts = std::vector<std::vector<std::vector<double>>>(m + 1u, std::vector<std::vector<double>>(n + 1u));
+
+    for (auto i = std::size_t{0u}; i <= m; ++i)
+    {
+        for (auto j = std::size_t{0u}; j <= n; ++j)
+        {
+            auto &current = counts[i][j];
+            current.assign((i * j) + 1u, 0.0);
+
+            if ((i == 0u) || (j == 0u))
+            {
+                current[0] = 1.0;
+                continue;
+            }
+
+            const auto &fewer_first = counts[i - 1u][j];
+            const auto &fewer_second = counts[i][j - 1u];
+
+            for (auto u = std::size_t{0u}; u < current.size(); ++u)
+            {
+                if ((u >= j) && (u - j < fewer_first.size()))
+                {
+                    current[u] += fewer_first[u - j];
+                }
+
+                if (u < fewer_second.size())
+                {
+                    current[u] += fewer_second[u];
+                }
+            }
+        }
+    }
+
+    return counts[m][n];
+}
+
+}
+
+namespace fs::harness
+{
+
+double percentile(std::span<const double> sorted, double fraction)
+{
+    const auto position = std::clamp(fraction, 0.0, 1.0) * static_cast<double>(sorted.size() - 1u);
+    const auto lower = static_cast<std::size_t>(position);
+    const auto upper = std::min(lower + 1u, sorted.size() - 1u);
+    const auto weight = position - static_cast<double>(lower);
+
+    return sorted[lower] + ((sorted[upper] - sorted[lower]) * weight);
+}
+
+Summary summarise(std::span<const double> samples)
+{
+    if (samples.empty())
+    {
+        return {};
+    }
+
+    auto sorted = std::vector<double>(samples.begin(), samples.end());
+    std::ranges::sort(sorted);
+
+    auto summary = Summary{};
+    summary.samples = sorted.size();
+    summary.min = sorted.front();
+    summary.p5 = percentile(sorted, 0.05);
+    summary.median = percentile(sorted, 0.5);
+    summary.p95 = percentile(sorted, 0.95);
+    summary.max = sorted.back();
+
+    auto sum = 0.0;
+    auto deviations = std::vector<double>{};
+    deviations.reserve(sorted.size());
+
+    for (const auto sample : sorted)
+    {
+        sum += sample;
+        deviations.push_back(std::fabs(sample - summary.median));
+    }
+
+    std::ranges::sort(deviations);
+    summary.mad = percentile(deviations, 0.5);
+    summary.mean = sum / static_cast<double>(sorted.size());
+
+    return summary;
+}
+
+double mann_whitney_p(std::span<const double> a, std::span<const double> b)
+{
+    if (a.empty() || b.empty())
+    {
+        return 1.0;
+    }
+
+    struct Sample
+    {
+        double value;
+        bool first;
+    };
+
+    auto combined = std::vector<Sample>{};
+    combined.reserve(a.size() + b.size());
+    for (const auto value : a)
+    {
+        combined.push_back({value, true});
+    }
+    for (const auto value : b)
+    {
+        combined.push_back({value, false});
+    }
+
+    std::ranges::sort(combined, {}, &Sample::value);
+
+    // rank with ties sharing the average of their ranks, keeping the sum of t^3 - t for the variance correction
+    const auto total = combined.size();
+    auto rank_sum = 0.0;
+    auto tie_correction = 0.0;
+
+    for (auto i = std::size_t{0u}; i < total;)
+    {
+        auto j = i;
+        while ((j < total) && (combined[j].value == combined[i].value))
+        {
+            ++j;
+        }
+
+        const auto rank = (static_cast<double>(i + 1u) + static_cast<double>(j)) / 2.0;
+        for (auto k = i; k < j; ++k)
+        {
+            if (combined[k].first)
+            {
+                rank_sum += rank;
+            }
+        }
+
+        const auto tied = static_cast<double>(j - i);
+        tie_correction += (tied * tied * tied) - tied;
+
+        i = j;
+    }
+
+    const auto m = static_cast<double>(a.size());
+    const auto n = static_cast<double>(b.size());
+    const auto u = rank_sum - ((m * (m + 1.0)) / 2.0);
+    const auto smaller_u = std::min(u, (m * n) - u);
+
+    if ((tie_correction == 0.0) && (total <= exact_limit))
+    {
+        const auto distribution = u_distribution(a.size(), b.size());
+
+        auto orderings = 0.0;
+        auto as_extreme = 0.0;
+        for (auto k = std::size_t{0u}; k < distribution.size(); ++k)
+        {
+            orderings += distribution[k];
+            if (static_cast<double>(k) <= smaller_u)
+            {
+                as_extreme += distribution[k];
+            }
+        }
+
+        return std::min(1.0, (2.0 * as_extreme) / orderings);
+    }
+
+    const auto mean = (m * n) / 2.0;
+    const auto count = m + n;
+    const auto variance = ((m * n) / 12.0) * ((count + 1.0) - (tie_correction / (count * (count - 1.0))));
+
+    if (variance <= 0.0)
+    {
+        return 1.0;
+    }
+
+    const auto z = std::max(0.0, std::fabs(u - mean) - 0.5) / std::sqrt(variance);
+
+    return std::min(1.0, std::erfc(z / std::numbers::sqrt2));
+}
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+namespace fs::harness
+{
+
+/**
+ * Robust summary of a set of samples.
+ */
+struct Summary
+{
+    /** Number of samples. */
+    std::size_t samples = 0u;
+
+    /** Smallest sample. */
+    double min = 0.0;
+
+    /** 5th percentile. */
+    double p5 = 0.0;
+
+    /** Median. */
+    double median = 0.0;
+
+    /** 95th percentile. */
+    double p95 = 0.0;
+
+    /** Largest sample. */
+    double max = 0.0;
+
+    /** Median absolute deviation from the median, unscaled. */
+    double mad = 0.0;
+
+    /** Mean. */
+    double mean = 0.0;
+};
+
+/**
+ * Summarise a set of samples.
+ *
+ * @param samples
+ *   Samples to summarise, may be empty.
+ *
+ * @returns
+ *   Summary of samples, all zero if there are none.
+ */
+Summary summarise(std::span<const double> samples);
+
+/**
+ * Get a percentile of a set of samples, interpolating linearly between the closest ranks.
+ *
+ * @param sorted
+ *   Samples in ascending order, must not be empty.
+ *
+ * @param fraction
+ *   Percentile as a fraction in [0, 1].
+ *
+ * @returns
+ *   Value at percentile.
+ */
+double percentile(std::span<const double> sorted, double fraction);
+
+/**
+ * Two sided Mann-Whitney U test of whether two sets of samples come from the same distribution. This makes no
+ * assumption about the shape of the distributions, which matters for timings as they are skewed by interruptions.
+ *
+ * The p value is exact for small samples without ties and otherwise uses the normal approximation with a tie and
+ * continuity correction.
+ *
+ * @param a
+ *   First set of samples.
+ *
+ * @param b
+ *   Second set of samples.
+ *
+ * @returns
+ *   Probability of a difference at least this large if both came from the same distribution, 1 if either is empty.
+ */
+double mann_whitney_p(std::span<const double> a, std::span<const double> b);
+
+}
@@ -0,0 +1,623 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "calculator.h"
+#include "sin_cos_calculator.h"
+#include "thread_pool.h"
+#include "timing.h"
+
+namespace fs::harness
+{
+
+/**
+ * Options controlling a parallel sweep over float bit patterns.
+ */
+struct SweepOptions
+{
+    /** First bit pattern to sweep. */
+    std::uint64_t first = 0u;
+
+    /** Number of bit patterns to sweep. */
+    std::uint64_t count = std::uint64_t{1u} << 32u;
+
+    /** Number of bit patterns in each unit of work handed to the thread pool. */
+    std::uint64_t chunk_size = std::uint64_t{1u} << 20u;
+
+    /** Number of inputs timed between each pair of clock reads. */
+    std::size_t block_size = 4096u;
+
+    /** Whether to also read the cpu cycle counter around each block. */
+    bool use_cycle_counter = true;
+
+    /** Whether to compare every result against the reference. */
+    bool check_accuracy = true;
+
+    /** Loop overhead to subtract from the per element figures of sweeps one element at a time. */
+    Baseline baseline = {};
+
+    /** Overhead of timing a batch call to subtract from the per element figures of batch sweeps. */
+    Baseline batch_baseline = {};
+};
+
+/**
+ * Output layout used when sweeping a SinCosCalculator through its batch interface.
+ */
+enum class SinCosLayout
+{
+    /** Sines and cosines in separate outputs. */
+    SPLIT,
+
+    /** Sine and cos pairs in a single output. */
+    INTERLEAVED
+};
+
+/**
+ * Check if a float is NaN by looking at its bits, so the check still works when built with fast maths.
+ *
+ * @param value
+ *   Value to check.
+ *
+ * @returns
+ *   True if value is NaN, otherwise false.
+ */
+inline bool is_nan(float value)
+{
+    return (std::bit_cast<std::uint32_t>(value) & 0x7fffffffu) > 0x7f800000u;
+}
+
+/**
+ * Check if a double is NaN by looking at its bits, so the check still works when built with fast maths.
+ *
+ * @param value
+ *   Value to check.
+ *
+ * @returns
+ *   True if value is NaN, otherwise false.
+ */
+inline bool is_nan(double value)
+{
+    return (std::bit_cast<std::uint64_t>(value) & 0x7fffffffffffffffu) > 0x7ff0000000000000u;
+}
+
+/**
+ * Running statistics of the absolute error between a calculator and its reference.
+ */
+struct ErrorStats
+{
+    /** Number of results compared. */
+    std::uint64_t compared = 0u;
+
+    /** Number of results where only one of the calculator and reference produced NaN. */
+    std::uint64_t nan_mismatches = 0u;
+
+    /** Largest absolute error seen. */
+    double max_error = 0.0;
+
+    /** Input which produced max_error. */
+    float max_error_input = 0.0f;
+
+    /** Sum of all absolute errors. */
+    double sum_error = 0.0;
+
+    /**
+     * Get the mean absolute error.
+     *
+     * @returns
+     *   Mean absolute error of all compared results.
+     */
+    double mean_error() const
+    {
+        return compared == 0u ? 0.0 : sum_error / static_cast<double>(compared);
+    }
+
+    /**
+     * Add a single error.
+     *
+     * @param input
+     *   Input that produced the error.
+     *
+     * @param error
+     *   Absolute error, NaN indicates a NaN mismatch.
+     */
+    void add(float input, double error)
+    {
+        if (is_nan(error))
+        {
+            ++nan_mismatches;
+            return;
+        }
+
+        ++compared;
+        sum_error += error;
+
+        if (error > max_error)
+        {
+            max_error = error;
+            max_error_input = input;
+        }
+    }
+
+    /**
+     * Merge in statistics from a later part of a sweep. Merging in sweep order gives the same result regardless of how
+     * the sweep was split up.
+     *
+     * @param other
+     *   Statistics to merge.
+     */
+    void merge(const ErrorStats &other)
+    {
+        compared += other.compared;
+        nan_mismatches += other.nan_mismatches;
+        sum_error += other.sum_error;
+
+        if (other.max_error > max_error)
+        {
+            max_error = other.max_error;
+            max_error_input = other.max_error_input;
+        }
+    }
+};
+
+/**
+ * Result of a parallel sweep.
+ */
+struct SweepResult
+{
+    /** Time spent calculating, summed over all threads. */
+    Timing timing;
+
+    /** Elapsed time of the whole sweep, including making the inputs and checking the results. */
+    std::chrono::nanoseconds wall_time;
+
+    /** Number of threads used. */
+    std::size_t threads;
+
+    /** Error against the reference, empty if accuracy wasn't checked. */
+    ErrorStats errors;
+
+    /**
+     * Get the throughput of the sweep across all threads. This comes from the timed blocks, shared between the threads,
+     * so checking against the reference doesn't slow it down the way it does wall_time.
+     *
+     * @returns
+     *   Elements calculated per second of timed calculation.
+     */
+    double elements_per_second() const
+    {
+        if ((threads == 0u) || (timing.total.count() == 0))
+        {
+            return 0.0;
+        }
+
+        const auto seconds = std::chrono::duration<double>(timing.total).count() / static_cast<double>(threads);
+        return static_cast<double>(timing.elements) / seconds;
+    }
+};
+
+/**
+ * Calculate the absolute error between a result and its reference.
+ *
+ * @param result
+ *   Calculated value.
+ *
+ * @param reference
+ *   Reference value.
+ *
+ * @returns
+ *   Absolute error, zero if both are NaN and NaN if only one is.
+ */
+inline double absolute_error(float result, float reference)
+{
+    const auto result_nan = is_nan(result);
+    const auto reference_nan = is_nan(reference);
+
+    if (result_nan || reference_nan)
+    {
+        return result_nan == reference_nan ? 0.0 : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    if (result == reference)
+    {
+        return 0.0;
+    }
+
+    return std::fabs(static_cast<double>(result) - static_cast<double>(reference));
+}
+
+/**
+ * Calculate the absolute error between a sine and cos result and its reference.
+ *
+ * @param result
+ *   Calculated values.
+ *
+ * @param reference
+ *   Reference values.
+ *
+ * @returns
+ *   Largest absolute error of the two values, NaN if either was a NaN mismatch.
+ */
+inline double absolute_error(const std::tuple<float, float> &result, const std::tuple<float, float> &reference)
+{
+    const auto sin_error = absolute_error(std::get<0>(result), std::get<0>(reference));
+    const auto cos_error = absolute_error(std::get<1>(result), std::get<1>(reference));
+
+    if (is_nan(sin_error) || is_nan(cos_error))
+    {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    return std::max(sin_error, cos_error);
+}
+
+namespace detail
+{
+
+/**
+ * Get the options for a batch sweep, which subtracts the batch overhead instead of the per element one.
+ *
+ * @param options
+ *   Options for sweep.
+ *
+ * @returns
+ *   Options with the batch baseline as the baseline.
+ */
+inline SweepOptions batch_sweep_options(const SweepOptions &options)
+{
+    auto batch_options = options;
+    batch_options.baseline = options.batch_baseline;
+    return batch_options;
+}
+
+/**
+ * Sweep a range of bit patterns across a thread pool, using the supplied functions to calculate and time each block
+ * and to check its results. Every sweep goes through this, whatever its inputs are made from the patterns.
+ *
+ * The range is split into chunks which are stolen between threads. Errors are kept per chunk and merged in order, so
+ * the accuracy results are the same for any number of threads.
+ *
+ * @tparam In
+ *   Input type.
+ *
+ * @tparam R
+ *   Result type.
+ *
+ * @tparam Outputs
+ *   Number of results for each input.
+ *
+ * @param time_block
+ *   Function called with the first bit pattern of a block, space for its inputs, space for its results and the timing
+ *   to add to. It makes the inputs itself, so it can leave them out of the timing.
+ *
+ * @param check_block
+ *   Function called with the first bit pattern of a block, its inputs, its results and the errors of its chunk to add
+ *   to, only if accuracy is checked.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for sweep.
+ *
+ * @returns
+ *   Combined result of sweep.
+ */
+template <class In, class R, std::size_t Outputs = 1u, class TimeBlock, class CheckBlock>
+SweepResult sweep_blocks(TimeBlock time_block, CheckBlock check_block, ThreadPool &pool, const SweepOptions &options)
+{
+    // keep each thread's running total on its own cache line
+    struct alignas(64) WorkerTiming
+    {
+        Timing timing;
+    };
+
+    const auto chunk_size = std::max<std::uint64_t>(options.chunk_size, 1u);
+    const auto block_size = std::max<std::uint64_t>(options.block_size, 1u);
+    const auto chunk_count = static_cast<std::size_t>((options.count + chunk_size - 1u) / chunk_size);
+
+    auto chunk_errors = std::vector<ErrorStats>(chunk_count);
+    auto worker_timings = std::vector<WorkerTiming>(pool.size());
+
+    const auto start = std::chrono::steady_clock::now();
+
+    pool.parallel_for(
+        chunk_count,
+        [&](std::size_t chunk, std::size_t worker)
+        {
+            auto inputs = std::vector<In>(block_size);
+            auto results = std::vector<R>(Outputs * block_size);
+
+            const auto chunk_first = options.first + (chunk * chunk_size);
+            const auto chunk_end = std::min(options.first + options.count, chunk_first + chunk_size);
+
+            for (auto block_first = chunk_first; block_first < chunk_end; block_first += block_size)
+            {
+                const auto size = static_cast<std::size_t>(std::min(block_size, chunk_end - block_first));
+                const auto in = std::span{inputs}.first(size);
+                const auto out = std::span{results}.first(Outputs * size);
+
+                time_block(block_first, in, out, worker_timings[worker].timing);
+
+                if (options.check_accuracy)
+                {
+                    check_block(block_first, std::span<const In>{in}, std::span<const R>{out}, chunk_errors[chunk]);
+                }
+            }
+        });
+
+    const auto end = std::chrono::steady_clock::now();
+
+    auto result = SweepResult{
+        .timing = {.baseline = options.baseline},
+        .wall_time = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start),
+        .threads = pool.size(),
+        .errors = {}};
+
+    for (const auto &worker_timing : worker_timings)
+    {
+        result.timing.total += worker_timing.timing.total;
+        result.timing.cycles += worker_timing.timing.cycles;
+        result.timing.elements += worker_timing.timing.elements;
+    }
+
+    for (const auto &errors : chunk_errors)
+    {
+        result.errors.merge(errors);
+    }
+
+    return result;
+}
+
+/**
+ * Get a check for sweep_blocks over float bit patterns, comparing each result to a reference.
+ *
+ * @param reference
+ *   Function to compare results against.
+ *
+ * @returns
+ *   Function checking a block.
+ */
+template <class Ref>
+auto check_reference(Ref reference)
+{
+    return [reference](std::uint64_t first, std::span<const float>, auto results, ErrorStats &errors)
+    {
+        for (auto i = std::size_t{0u}; i < results.size(); ++i)
+        {
+            const auto f = std::bit_cast<float>(static_cast<std::uint32_t>(first + i));
+            errors.add(f, absolute_error(results[i], reference(f)));
+        }
+    };
+}
+
+}
+
+/**
+ * Sweep a range of float bit patterns across a thread pool, timing a calculator and comparing it to a reference.
+ *
+ * @param calculator
+ *   Function to sweep.
+ *
+ * @param reference
+ *   Function to compare results against.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for sweep.
+ *
+ * @returns
+ *   Combined result of sweep.
+ */
+template <std::invocable<float> F, class Ref>
+SweepResult sweep(F calculator, Ref reference, ThreadPool &pool, const SweepOptions &options = {})
+{
+    const auto use_cycle_counter = options.use_cycle_counter && has_cycle_counter();
+
+    return detail::sweep_blocks<float, std::invoke_result_t<F, float>>(
+        [&](std::uint64_t first, std::span<float>, auto results, Timing &timing)
+        { time_block(calculator, first, results, use_cycle_counter, timing); },
+        detail::check_reference(reference),
+        pool,
+        options);
+}
+
+/**
+ * Sweep a range of float bit patterns across a thread pool, timing a Calculator one element at a time through its
+ * scalar interface and comparing it to a reference.
+ *
+ * @param calculator
+ *   Calculator to sweep.
+ *
+ * @param reference
+ *   Function to compare results against.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for sweep.
+ *
+ * @returns
+ *   Combined result of sweep.
+ */
+template <class Ref>
+SweepResult sweep(const Calculator &calculator, Ref reference, ThreadPool &pool, const SweepOptions &options = {})
+{
+    return sweep([&calculator](float theta) { return calculator.calculate(theta); }, reference, pool, options);
+}
+
+/**
+ * Sweep a range of float bit patterns across a thread pool, timing a batch function a block at a time and comparing it
+ * to a reference.
+ *
+ * @param batch
+ *   Function writing the sine of a span of inputs to a span of outputs.
+ *
+ * @param reference
+ *   Function to compare results against.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for sweep.
+ *
+ * @returns
+ *   Combined result of sweep.
+ */
+template <std::invocable<std::span<const float>, std::span<float>> F, class Ref>
+SweepResult sweep_batch(F batch, Ref reference, ThreadPool &pool, const SweepOptions &options = {})
+{
+    const auto use_cycle_counter = options.use_cycle_counter && has_cycle_counter();
+
+    return detail::sweep_blocks<float, float>(
+        [&](std::uint64_t first, std::span<float> thetas, std::span<float> results, Timing &timing)
+        { time_batch_block(batch, first, thetas, results, use_cycle_counter, timing); },
+        detail::check_reference(reference),
+        pool,
+        detail::batch_sweep_options(options));
+}
+
+/**
+ * Sweep a range of float bit patterns across a thread pool, timing a Calculator a block at a time through its batch
+ * interface and comparing it to a reference.
+ *
+ * @param calculator
+ *   Calculator to sweep.
+ *
+ * @param reference
+ *   Function to compare results against.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for sweep.
+ *
+ * @returns
+ *   Combined result of sweep.
+ */
+template <class Ref>
+SweepResult sweep_batch(
+    const Calculator &calculator,
+    Ref reference,
+    ThreadPool &pool,
+    const SweepOptions &options = {})
+{
+    return sweep_batch(
+        [&calculator](std::span<const float> in, std::span<float> out) { calculator.calculate(in, out); },
+        reference,
+        pool,
+        options);
+}
+
+/**
+ * Sweep a range of float bit patterns across a thread pool, timing a SinCosCalculator one element at a time through its
+ * scalar interface and comparing it to a reference.
+ *
+ * @param calculator
+ *   Calculator to sweep.
+ *
+ * @param reference
+ *   Function to compare results against, returning sine and cos.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for sweep.
+ *
+ * @returns
+ *   Combined result of sweep.
+ */
+template <class Ref>
+SweepResult sweep(const SinCosCalculator &calculator, Ref reference, ThreadPool &pool, const SweepOptions &options = {})
+{
+    return sweep([&calculator](float theta) { return calculator.calculate(theta); }, reference, pool, options);
+}
+
+/**
+ * Sweep a range of float bit patterns across a thread pool, timing a SinCosCalculator a block at a time through one of
+ * its batch interfaces and comparing it to a reference.
+ *
+ * @param calculator
+ *   Calculator to sweep.
+ *
+ * @param reference
+ *   Function to compare results against, returning sine and cos.
+ *
+ * @param pool
+ *   Thread pool to run on.
+ *
+ * @param options
+ *   Options for sweep.
+ *
+ * @param layout
+ *   Which batch interface to time.
+ *
+ * @returns
+ *   Combined result of sweep.
+ */
+template <class Ref>
+SweepResult sweep_batch(
+    const SinCosCalculator &calculator,
+    Ref reference,
+    ThreadPool &pool,
+    const SweepOptions &options = {},
+    SinCosLayout layout = SinCosLayout::SPLIT)
+{
+    const auto use_cycle_counter = options.use_cycle_counter && has_cycle_counter();
+
+    return detail::sweep_blocks<float, std::tuple<float, float>>(
+        [&](std::uint64_t first, std::span<float> thetas, std::span<std::tuple<float, float>> results, Timing &timing)
+        {
+            // the batch interface writes floats, so time into scratch space and then pair the results up for comparing
+            thread_local auto outputs = std::vector<float>{};
+            outputs.resize(2u * thetas.size());
+
+            const auto count = thetas.size();
+            const auto all = std::span{outputs};
+
+            time_batch_block(
+                [&](std::span<const float> in, std::span<float>)
+                {
+                    if (layout == SinCosLayout::SPLIT)
+                    {
+                        calculator.calculate(in, all.first(count), all.subspan(count, count));
+                    }
+                    else
+                    {
+                        calculator.calculate(in, all);
+                    }
+                },
+                first,
+                thetas,
+                all.first(count),
+                use_cycle_counter,
+                timing);
+
+            for (auto i = std::size_t{0u}; i < count; ++i)
+            {
+                results[i] = layout == SinCosLayout::SPLIT ? std::tuple{all[i], all[count + i]}
+                                                           : std::tuple{all[2u * i], all[(2u * i) + 1u]};
+            }
+        },
+        detail::check_reference(reference),
+        pool,
+        detail::batch_sweep_options(options));
+}
+
+}
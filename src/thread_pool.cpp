@@ -0,0 +1,265 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <barrier>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+
+/**
+ * Get the cpus the process is allowed to run on.
+ *
+ * @returns
+ *   Cpu indices in ascending order, empty if they can't be found.
+ */
+std::vector<int> allowed_cpus()
+{
+    auto cpus = std::vector<int>{};
+
+#if defined(__linux__)
+    auto set = ::cpu_set_t{};
+    CPU_ZERO(&set);
+
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (auto cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+
+    return cpus;
+}
+
+/**
+ * Pin a thread to a cpu.
+ *
+ * @param thread
+ *   Thread to pin, or null for the calling thread.
+ *
+ * @param cpu
+ *   Cpu to pin to.
+ *
+ * @returns
+ *   True if the thread was pinned, otherwise false.
+ */
+bool pin_thread(std::thread *thread, int cpu)
+{
+#if defined(__linux__)
+    auto set = ::cpu_set_t{};
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    const auto handle = thread == nullptr ? ::pthread_self() : thread->native_handle();
+    return ::pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+#else
+    static_cast<void>(thread);
+    static_cast<void>(cpu);
+    return false;
+#endif
+}
+
+}
+
+namespace fs::harness
+{
+
+ThreadPool::ThreadPool(std::size_t thread_count, bool pin)
+    : queues_()
+    , threads_()
+    , mutex_()
+    , start_()
+    , done_()
+    , task_(nullptr)
+    , generation_(0u)
+    , finished_(0u)
+    , stopping_(false)
+    , pinned_(false)
+{
+    if (thread_count == 0u)
+    {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (auto i = 0u; i < thread_count; ++i)
+    {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+
+    for (auto i = 1u; i < thread_count; ++i)
+    {
+        threads_.emplace_back([this, i] { worker_loop(i); });
+    }
+
+    if (pin)
+    {
+        // with more workers than cpus some have to share, which defeats the point but is still better than failing
+        const auto cpus = allowed_cpus();
+        pinned_ = !cpus.empty();
+
+        for (auto i = std::size_t{0u}; pinned_ && (i < thread_count); ++i)
+        {
+            pinned_ = pin_thread(i == 0u ? nullptr : &threads_[i - 1u], cpus[i % cpus.size()]);
+        }
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::scoped_lock lock{mutex_};
+        stopping_ = true;
+    }
+
+    start_.notify_all();
+
+    for (auto &thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+std::size_t ThreadPool::size() const
+{
+    return queues_.size();
+}
+
+bool ThreadPool::pinned() const
+{
+    return pinned_;
+}
+
+void ThreadPool::parallel_for(std::size_t task_count, const Task &task)
+{
+    {
+        std::scoped_lock lock{mutex_};
+
+        // hand each worker a contiguous range, neighbouring tasks tend to cost the same so this keeps stealing rare
+        for (auto worker = 0u; worker < queues_.size(); ++worker)
+        {
+            const auto begin = (task_count * worker) / queues_.size();
+            const auto end = (task_count * (worker + 1u)) / queues_.size();
+
+            auto &tasks = queues_[worker]->tasks;
+            for (auto i = begin; i < end; ++i)
+            {
+                tasks.push_back(i);
+            }
+        }
+
+        task_ = &task;
+        finished_ = 0u;
+        ++generation_;
+    }
+
+    start_.notify_all();
+
+    while (run_one(0u))
+    {
+    }
+
+    std::unique_lock lock{mutex_};
+    done_.wait(lock, [this] { return finished_ == threads_.size(); });
+    task_ = nullptr;
+}
+
+void ThreadPool::on_every_worker(const std::function<void(std::size_t worker)> &function)
+{
+    // each queue gets one task, and a worker waiting at the barrier can't steal, so every worker runs its own
+    auto arrived = std::barrier{static_cast<std::ptrdiff_t>(queues_.size())};
+
+    parallel_for(
+        queues_.size(),
+        [&](std::size_t, std::size_t worker)
+        {
+            function(worker);
+            arrived.arrive_and_wait();
+        });
+}
+
+void ThreadPool::worker_loop(std::size_t worker)
+{
+    auto seen = std::uint64_t{0u};
+
+    for (;;)
+    {
+        {
+            std::unique_lock lock{mutex_};
+            start_.wait(lock, [this, seen] { return stopping_ || (generation_ != seen); });
+
+            if (stopping_)
+            {
+                return;
+            }
+
+            seen = generation_;
+        }
+
+        while (run_one(worker))
+        {
+        }
+
+        {
+            std::scoped_lock lock{mutex_};
+            ++finished_;
+        }
+
+        done_.notify_one();
+    }
+}
+
+bool ThreadPool::run_one(std::size_t worker)
+{
+    auto task = std::optional<std::size_t>{};
+
+    {
+        auto &own = *queues_[worker];
+        std::scoped_lock lock{own.mutex};
+
+        if (!own.tasks.empty())
+        {
+            task = own.tasks.front();
+            own.tasks.pop_front();
+        }
+    }
+
+    for (auto i = 1u; !task && (i < queues_.size()); ++i)
+    {
+        auto &victim = *queues_[(worker + i) % queues_.size()];
+        std::scoped_lock lock{victim.mutex};
+
+        if (!victim.tasks.empty())
+        {
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+        }
+    }
+
+    if (!task)
+    {
+        return false;
+    }
+
+    (*task_)(*task, worker);
+
+    return true;
+}
+
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fs::harness
+{
+
+/**
+ * A fixed size pool of threads for running a batch of independent tasks.
+ *
+ * Each worker owns a queue of task indices. A worker takes tasks from the front of its own queue and, once that is
+ * empty, steals from the back of the other queues so that slow tasks don't leave the rest of the pool idle.
+ */
+class ThreadPool
+{
+  public:
+    /**
+     * Signature of a task, called with the index of the task and the index of the worker running it.
+     */
+    using Task = std::function<void(std::size_t task, std::size_t worker)>;
+
+    /**
+     * Construct a new ThreadPool.
+     *
+     * @param thread_count
+     *   Number of workers, including the thread which calls parallel_for. Zero means use all hardware threads.
+     *
+     * @param pin
+     *   Whether to pin each worker to its own cpu, taken in order from the cpus the process may run on. The thread
+     *   constructing the pool is pinned as worker zero.
+     */
+    explicit ThreadPool(std::size_t thread_count, bool pin = false);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Get the number of workers in the pool.
+     *
+     * @returns
+     *   Number of workers.
+     */
+    std::size_t size() const;
+
+    /**
+     * Check if the workers are pinned to cpus.
+     *
+     * @returns
+     *   True if pinning was requested and succeeded for every worker, otherwise false.
+     */
+    bool pinned() const;
+
+    /**
+     * Run a task for every index in [0, task_count) and wait for them all to finish. The calling thread acts as worker
+     * zero.
+     *
+     * @param task_count
+     *   Number of tasks to run.
+     *
+     * @param task
+     *   Task to run, must not throw.
+     */
+    void parallel_for(std::size_t task_count, const Task &task);
+
+    /**
+     * Run a function once on every worker, including the calling thread, and wait for them all to finish. For per
+     * thread state such as the floating point mode.
+     *
+     * @param function
+     *   Function taking the index of the worker, must not throw.
+     */
+    void on_every_worker(const std::function<void(std::size_t worker)> &function);
+
+  private:
+    /**
+     * Queue of work owned by a single worker.
+     */
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::size_t> tasks;
+    };
+
+    /**
+     * Entry point for spawned workers.
+     *
+     * @param worker
+     *   Index of worker.
+     */
+    void worker_loop(std::size_t worker);
+
+    /**
+     * Run a single task, taking it from the worker's own queue if possible and stealing otherwise.
+     *
+     * @param worker
+     *   Index of worker.
+     *
+     * @returns
+     *   True if a task was run, false if there was no work left.
+     */
+    bool run_one(std::size_t worker);
+
+    /** One queue per worker. */
+    std::vector<std::unique_ptr<Queue>> queues_;
+
+    /** Spawned workers, worker zero is the caller of parallel_for so isn't in here. */
+    std::vector<std::thread> threads_;
+
+    /** Guards all state below. */
+    std::mutex mutex_;
+
+    /** Signalled when a new batch starts or the pool is stopping. */
+    std::condition_variable start_;
+
+    /** Signalled when a spawned worker finishes a batch. */
+    std::condition_variable done_;
+
+    /** Task being run for the current batch. */
+    const Task *task_;
+
+    /** Incremented for every batch so workers can tell a new one has started. */
+    std::uint64_t generation_;
+
+    /** Number of spawned workers which have finished the current batch. */
+    std::size_t finished_;
+
+    /** Set when the pool is being destroyed. */
+    bool stopping_;
+
+    /** Whether every worker was pinned to a cpu. */
+    bool pinned_;
+};
+
+}
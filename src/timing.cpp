@@ -0,0 +1,157 @@
+#include "timing.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+
+/**
+ * Take the quickest of a few timings of an overhead, anything slower was disturbed by something other than the loop.
+ *
+ * @param time
+ *   Function returning a Timing.
+ *
+ * @returns
+ *   Quickest overhead.
+ */
+template <class F>
+fs::harness::Baseline quickest(F time)
+{
+    auto best = fs::harness::Baseline{};
+
+    for (auto run = 0u; run < 3u; ++run)
+    {
+        const auto timing = time();
+
+        const auto result = fs::harness::Baseline{
+            .ns_per_element = timing.ns_per_element(),
+            .cycles_per_element = timing.cycles_per_element()};
+
+        if ((run == 0u) || (result.ns_per_element < best.ns_per_element))
+        {
+            best = result;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Batch calculator which copies its inputs, for measuring the overhead of a batch call.
+ *
+ * @param inputs
+ *   Inputs.
+ *
+ * @param results
+ *   Where to copy the inputs.
+ */
+void copy_batch(std::span<const float> inputs, std::span<float> results)
+{
+    std::memcpy(results.data(), inputs.data(), inputs.size_bytes());
+}
+
+}
+
+namespace fs::harness
+{
+
+std::string_view to_string(TimingMode mode)
+{
+    switch (mode)
+    {
+        case TimingMode::LATENCY: return "latency";
+        case TimingMode::THROUGHPUT: return "throughput";
+    }
+
+    return "unknown";
+}
+
+Baseline calibrate_baseline(const TimingOptions &options)
+{
+    // a sample of the space is enough to get a stable overhead, the empty loop is the same for every input
+    auto calibration_options = options;
+    calibration_options.count = std::min(options.count, std::uint64_t{1u} << 26u);
+    calibration_options.baseline = {};
+
+    return quickest([&] { return time_calculations([](float theta) { return theta; }, calibration_options); });
+}
+
+Baseline calibrate_batch_baseline(const TimingOptions &options)
+{
+    const auto use_cycle_counter = options.use_cycle_counter && has_cycle_counter();
+    const auto block_size = std::max<std::uint64_t>(options.block_size, 1u);
+    const auto count = std::min(options.count, std::uint64_t{1u} << 26u);
+
+    auto thetas = std::vector<float>(block_size);
+    auto results = std::vector<float>(block_size);
+
+    return quickest(
+        [&]
+        {
+            auto timing = Timing{};
+
+            for (auto block_start = std::uint64_t{0u}; block_start < count; block_start += block_size)
+            {
+                const auto size = std::min(count, block_start + block_size) - block_start;
+
+                time_batch_block(
+                    copy_batch,
+                    block_start,
+                    std::span{thetas}.first(size),
+                    std::span{results}.first(size),
+                    use_cycle_counter,
+                    timing);
+            }
+
+            return timing;
+        });
+}
+
+std::vector<float> spread_inputs(std::uint64_t first, std::uint64_t count, std::size_t size)
+{
+    auto inputs = std::vector<float>(size);
+
+    for (auto i = std::size_t{0u}; i < size; ++i)
+    {
+        // 128 bit product so a full sweep times a large size doesn't overflow
+        const auto offset = static_cast<std::uint64_t>((static_cast<unsigned __int128>(count) * i) / size);
+        inputs[i] = std::bit_cast<float>(static_cast<std::uint32_t>(first + offset));
+    }
+
+    return inputs;
+}
+
+Baseline calibrate_latency_baseline(std::span<const float> inputs, bool use_cycle_counter)
+{
+    const auto options = StreamOptions{.use_cycle_counter = use_cycle_counter};
+    return quickest([&] { return time_latency([](float theta) { return theta; }, inputs, options); });
+}
+
+Baseline calibrate_throughput_baseline(std::span<const float> inputs, bool use_cycle_counter)
+{
+    const auto options = StreamOptions{.use_cycle_counter = use_cycle_counter};
+    return quickest([&] { return time_throughput([](float theta) { return theta; }, inputs, options); });
+}
+
+Baseline calibrate_batch_latency_baseline(std::span<const float> inputs, bool use_cycle_counter)
+{
+    const auto options = StreamOptions{.use_cycle_counter = use_cycle_counter};
+    return quickest([&] { return time_batch_latency(copy_batch, inputs, options); });
+}
+
+Baseline calibrate_batch_throughput_baseline(std::span<const float> inputs, bool use_cycle_counter)
+{
+    const auto options = StreamOptions{.use_cycle_counter = use_cycle_counter};
+    auto results = std::vector<float>(inputs.size());
+
+    return quickest([&] { return time_batch_throughput(copy_batch, inputs, std::span{results}, options); });
+}
+
+}
@@ -0,0 +1,864 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "perf_counters.h"
+
+namespace fs::harness
+{
+
+/**
+ * Per element cost of the timing loop itself, measured by timing a calculator which does no work.
+ */
+struct Baseline
+{
+    double ns_per_element = 0.0;
+    double cycles_per_element = 0.0;
+};
+
+/**
+ * How a calculator is timed over inputs that are already in memory.
+ */
+enum class TimingMode
+{
+    /** Each input depends on the previous result, giving the latency of a call. */
+    LATENCY,
+
+    /** Inputs are independent, giving the reciprocal throughput of a call. */
+    THROUGHPUT
+};
+
+/**
+ * Get the name of a timing mode.
+ *
+ * @param mode
+ *   Mode.
+ *
+ * @returns
+ *   Name of mode.
+ */
+std::string_view to_string(TimingMode mode);
+
+/**
+ * Options controlling how time_calculations measures a calculator.
+ */
+struct TimingOptions
+{
+    /** Number of inputs timed between each pair of clock reads, a value of 1 times every call individually. */
+    std::size_t block_size = 4096u;
+
+    /** Whether to also read the cpu cycle counter around each block. */
+    bool use_cycle_counter = true;
+
+    /** Number of bit patterns to sweep, starting from zero. */
+    std::uint64_t count = std::uint64_t{1u} << 32u;
+
+    /** Loop overhead to subtract from the per element figures. */
+    Baseline baseline = {};
+};
+
+/**
+ * Result of timing a calculator.
+ */
+struct Timing
+{
+    /** Total time spent in timed blocks, this includes the loop overhead. */
+    std::chrono::nanoseconds total = std::chrono::nanoseconds{0};
+
+    /** Total cycles spent in timed blocks, zero if the cycle counter was not used. */
+    std::uint64_t cycles = 0u;
+
+    /** Number of elements calculated. */
+    std::uint64_t elements = 0u;
+
+    /** Overhead that was subtracted from the per element figures. */
+    Baseline baseline = {};
+
+    /** Hardware counts over the run, empty if they weren't read. */
+    CounterValues counters = {};
+
+    /**
+     * Get the time spent per element, with the baseline removed.
+     *
+     * @returns
+     *   Nanoseconds per element.
+     */
+    double ns_per_element() const
+    {
+        if (elements == 0u)
+        {
+            return 0.0;
+        }
+
+        const auto raw = static_cast<double>(total.count()) / static_cast<double>(elements);
+        return std::max(0.0, raw - baseline.ns_per_element);
+    }
+
+    /**
+     * Get the cycles spent per element, with the baseline removed.
+     *
+     * @returns
+     *   Cycles per element.
+     */
+    double cycles_per_element() const
+    {
+        if (elements == 0u)
+        {
+            return 0.0;
+        }
+
+        const auto raw = static_cast<double>(cycles) / static_cast<double>(elements);
+        return std::max(0.0, raw - baseline.cycles_per_element);
+    }
+
+    /**
+     * Check whether the time per element was less than the baseline, which ns_per_element clamps to zero. Some of the
+     * overhead the baseline measured wasn't there, so the figure is meaningless rather than free.
+     *
+     * @returns
+     *   True if the time was below the baseline.
+     */
+    bool below_baseline() const
+    {
+        return (elements != 0u) &&
+               (static_cast<double>(total.count()) < (baseline.ns_per_element * static_cast<double>(elements)));
+    }
+};
+
+/**
+ * Check if this platform has a cycle counter which read_cycle_counter can use.
+ *
+ * @returns
+ *   True if a cycle counter is available, otherwise false.
+ */
+constexpr bool has_cycle_counter()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Read the cpu cycle counter.
+ *
+ * On x86 this is the time stamp counter, which ticks at a constant reference rate rather than the current core clock.
+ * On aarch64 this is the virtual counter.
+ *
+ * @returns
+ *   Current value of cycle counter, or zero if there isn't one.
+ */
+inline std::uint64_t read_cycle_counter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    std::uint64_t value;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return 0u;
+#endif
+}
+
+/**
+ * Prevent the compiler from treating the memory pointed to as unused.
+ *
+ * @param pointer
+ *   Pointer to memory which should be considered read.
+ */
+inline void escape(const void *pointer)
+{
+    asm volatile("" : : "r"(pointer) : "memory");
+}
+
+/**
+ * Time a calculator over a single block of consecutive bit patterns, writing the results out and adding the time taken
+ * to a running total.
+ *
+ * @param calculator
+ *   Function to time.
+ *
+ * @param first
+ *   Bit pattern of the first input in the block.
+ *
+ * @param results
+ *   Where to write results, the size of this sets the size of the block.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter around the block.
+ *
+ * @param timing
+ *   Timing to add to.
+ */
+template <class F, class R>
+void time_block(F calculator, std::uint64_t first, std::span<R> results, bool use_cycle_counter, Timing &timing)
+{
+    const auto start_cycles = use_cycle_counter ? read_cycle_counter() : 0u;
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    for (auto i = std::size_t{0u}; i < results.size(); ++i)
+    {
+        const auto n = static_cast<std::uint32_t>(first + i);
+        const auto f = std::bit_cast<float>(n);
+
+        results[i] = calculator(f);
+    }
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    const auto end_cycles = use_cycle_counter ? read_cycle_counter() : 0u;
+
+    escape(results.data());
+
+    timing.total += end - start;
+    timing.cycles += end_cycles - start_cycles;
+    timing.elements += results.size();
+}
+
+/**
+ * Time a single batch call on inputs already in memory, adding the time taken to a running total.
+ *
+ * @param calculator
+ *   Function taking a span of inputs and a span of outputs.
+ *
+ * @param inputs
+ *   Inputs, the size of this sets the number of elements timed.
+ *
+ * @param results
+ *   Where to write results, may hold more than one output for each input.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter around the call.
+ *
+ * @param timing
+ *   Timing to add to.
+ */
+template <class F, class In, class R>
+void time_batch_call(
+    F calculator,
+    std::span<const In> inputs,
+    std::span<R> results,
+    bool use_cycle_counter,
+    Timing &timing)
+{
+    const auto start_cycles = use_cycle_counter ? read_cycle_counter() : 0u;
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    calculator(inputs, results);
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    const auto end_cycles = use_cycle_counter ? read_cycle_counter() : 0u;
+
+    escape(results.data());
+
+    timing.total += end - start;
+    timing.cycles += end_cycles - start_cycles;
+    timing.elements += inputs.size();
+}
+
+/**
+ * Time a batch calculator over a single block of consecutive bit patterns. The inputs are generated before the clock
+ * is read so only the batch call itself is timed.
+ *
+ * @param calculator
+ *   Function taking a span of inputs and a span of outputs.
+ *
+ * @param first
+ *   Bit pattern of the first input in the block.
+ *
+ * @param thetas
+ *   Scratch space for the inputs, must be the same size as results.
+ *
+ * @param results
+ *   Where to write results, the size of this sets the size of the block.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter around the block.
+ *
+ * @param timing
+ *   Timing to add to.
+ */
+template <class F>
+void time_batch_block(
+    F calculator,
+    std::uint64_t first,
+    std::span<float> thetas,
+    std::span<float> results,
+    bool use_cycle_counter,
+    Timing &timing)
+{
+    for (auto i = std::size_t{0u}; i < thetas.size(); ++i)
+    {
+        thetas[i] = std::bit_cast<float>(static_cast<std::uint32_t>(first + i));
+    }
+
+    time_batch_call(calculator, std::span<const float>{thetas}, results, use_cycle_counter, timing);
+}
+
+/**
+ * Time a single call computing a whole run of results, then pass each result to a check outside the timed region.
+ * The benchmarks which time one long loop rather than sweeping blocks all go through this.
+ *
+ * @param compute
+ *   Function filling a span with results.
+ *
+ * @param results
+ *   Where to write results.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter around the call.
+ *
+ * @param check
+ *   Function called with the index and value of every result.
+ *
+ * @returns
+ *   Timing of compute.
+ */
+template <class F, class R, class Check>
+Timing time_and_check(F compute, std::span<R> results, bool use_cycle_counter, Check check)
+{
+    auto timing = Timing{};
+
+    const auto start_cycles = use_cycle_counter ? read_cycle_counter() : 0u;
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    compute(results);
+
+    const auto end = std::chrono::high_resolution_clock::now();
+    const auto end_cycles = use_cycle_counter ? read_cycle_counter() : 0u;
+
+    escape(results.data());
+
+    timing.total = end - start;
+    timing.cycles = end_cycles - start_cycles;
+    timing.elements = results.size();
+
+    for (auto i = std::size_t{0u}; i < results.size(); ++i)
+    {
+        check(i, std::as_const(results[i]));
+    }
+
+    return timing;
+}
+
+/**
+ * Time how long it takes for a function to calculate every possible float.
+ *
+ * Inputs are timed in blocks so the cost of reading the clock is amortised over options.block_size calls.
+ *
+ * @param calculator
+ *   Function to time.
+ *
+ * @param options
+ *   Options for timing.
+ *
+ * @returns
+ *   Timing of function for all floats.
+ */
+template <class F>
+Timing time_calculations(F calculator, const TimingOptions &options = {})
+{
+    const auto use_cycle_counter = options.use_cycle_counter && has_cycle_counter();
+    const auto block_size = std::max<std::uint64_t>(options.block_size, 1u);
+
+    auto timing = Timing{.baseline = options.baseline};
+    auto results = std::vector<std::invoke_result_t<F, float>>(block_size);
+
+    for (auto block_start = std::uint64_t{0u}; block_start < options.count; block_start += block_size)
+    {
+        const auto block_end = std::min(options.count, block_start + block_size);
+        const auto block = std::span{results}.first(block_end - block_start);
+
+        time_block(calculator, block_start, block, use_cycle_counter, timing);
+    }
+
+    return timing;
+}
+
+/**
+ * Measure the per element overhead of the time_calculations loop by timing a calculator which just returns its input.
+ *
+ * @param options
+ *   Options that will be used for the real measurements, the count is reduced when calibrating.
+ *
+ * @returns
+ *   Per element loop overhead.
+ */
+Baseline calibrate_baseline(const TimingOptions &options);
+
+/**
+ * Measure the per element overhead of timing a batch call with time_batch_block, by timing a batch calculator which
+ * copies its inputs. The inputs are generated outside the timed region there, so this is much smaller than the
+ * overhead from calibrate_baseline.
+ *
+ * @param options
+ *   Options that will be used for the real measurements, the count is reduced when calibrating.
+ *
+ * @returns
+ *   Per element overhead of a batch call.
+ */
+Baseline calibrate_batch_baseline(const TimingOptions &options);
+
+/**
+ * Get inputs spread evenly over a range of float bit patterns, for the latency and throughput modes which need the
+ * inputs in memory before timing starts.
+ *
+ * @param first
+ *   First bit pattern of range.
+ *
+ * @param count
+ *   Number of bit patterns in range.
+ *
+ * @param size
+ *   Number of inputs to make.
+ *
+ * @returns
+ *   Inputs in bit pattern order.
+ */
+std::vector<float> spread_inputs(std::uint64_t first, std::uint64_t count, std::size_t size);
+
+/**
+ * Get the value of a result that is fed into the next call when measuring latency, the sine of a sine and cos pair.
+ *
+ * @param result
+ *   Result of a calculator.
+ *
+ * @returns
+ *   Value to feed forward.
+ */
+template <class R>
+float chain_value(const R &result)
+{
+    if constexpr (std::is_same_v<R, float>)
+    {
+        return result;
+    }
+    else
+    {
+        return std::get<0>(result);
+    }
+}
+
+/**
+ * Make an input depend on the previous result without changing its value.
+ *
+ * @param input
+ *   Input to use, a float or any other type kernels take.
+ *
+ * @param previous
+ *   Previous result.
+ *
+ * @param mask
+ *   Zero, but not known to be zero by the compiler.
+ *
+ * @returns
+ *   Input, which can't be calculated until previous is known.
+ */
+template <class S>
+S chain(S input, S previous, std::uint32_t mask)
+{
+    using Bits = std::conditional_t<
+        sizeof(S) == sizeof(std::uint16_t),
+        std::uint16_t,
+        std::conditional_t<sizeof(S) == sizeof(std::uint64_t), std::uint64_t, std::uint32_t>>;
+
+    return std::bit_cast<S>(
+        static_cast<Bits>(std::bit_cast<Bits>(input) | (std::bit_cast<Bits>(previous) & static_cast<Bits>(mask))));
+}
+
+/**
+ * Get a zero the compiler can't see through, for building dependency chains.
+ *
+ * @returns
+ *   Zero.
+ */
+inline std::uint32_t opaque_zero()
+{
+    static volatile std::uint32_t zero = 0u;
+    return zero;
+}
+
+/**
+ * Options controlling how a calculator is timed over preloaded inputs.
+ */
+struct StreamOptions
+{
+    /** Whether to read the cycle counter around the run. */
+    bool use_cycle_counter = true;
+
+    /** Overhead to subtract from the per element figures. */
+    Baseline baseline = {};
+
+    /** Overhead to subtract instead when a batch calculator is timed through time_batch_mode. */
+    Baseline batch_baseline = {};
+
+    /** Hardware counters to read around the run, null to not count. */
+    PerfCounters *counters = nullptr;
+};
+
+/**
+ * Start reading the clocks and counters around a run over preloaded inputs.
+ *
+ * @param options
+ *   Options for run.
+ *
+ * @returns
+ *   Timing with the start cycle count in cycles, to be passed to finish_run.
+ */
+inline Timing start_run(const StreamOptions &options)
+{
+    if (options.counters != nullptr)
+    {
+        options.counters->start();
+    }
+
+    return {.cycles = options.use_cycle_counter ? read_cycle_counter() : 0u, .baseline = options.baseline};
+}
+
+/**
+ * Finish reading the clocks and counters around a run over preloaded inputs, counters are read last so they don't
+ * add to the time.
+ *
+ * @param options
+ *   Options for run.
+ *
+ * @param timing
+ *   Timing returned by start_run.
+ *
+ * @param start
+ *   Time the run started.
+ *
+ * @param elements
+ *   Number of elements calculated.
+ *
+ * @returns
+ *   Timing of run.
+ */
+inline Timing finish_run(
+    const StreamOptions &options,
+    Timing timing,
+    std::chrono::high_resolution_clock::time_point start,
+    std::uint64_t elements)
+{
+    const auto end = std::chrono::high_resolution_clock::now();
+    const auto end_cycles = options.use_cycle_counter ? read_cycle_counter() : 0u;
+
+    timing.total = end - start;
+    timing.cycles = end_cycles - timing.cycles;
+    timing.elements = elements;
+
+    if (options.counters != nullptr)
+    {
+        timing.counters = options.counters->stop(elements);
+    }
+
+    return timing;
+}
+
+/**
+ * Time a calculator in a dependent chain, where every input waits for the previous result, so the time per element is
+ * the latency of a call rather than how many can be in flight at once.
+ *
+ * @param calculator
+ *   Function to time.
+ *
+ * @param inputs
+ *   Inputs, each is used unchanged but only once the previous result is ready.
+ *
+ * @param options
+ *   Options for timing.
+ *
+ * @returns
+ *   Timing of chain.
+ */
+template <class F>
+Timing time_latency(F calculator, std::span<const float> inputs, const StreamOptions &options = {})
+{
+    const auto mask = opaque_zero();
+    auto previous = 0.0f;
+
+    auto timing = start_run(options);
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    for (const auto input : inputs)
+    {
+        previous = chain_value(calculator(chain(input, previous, mask)));
+    }
+
+    timing = finish_run(options, timing, start, inputs.size());
+
+    escape(&previous);
+
+    return timing;
+}
+
+/**
+ * Time a batch calculator in a dependent chain of single element calls, giving the latency of one result through the
+ * batch interface including its dispatch.
+ *
+ * @tparam Outputs
+ *   Number of outputs the calculator writes per input.
+ *
+ * @param calculator
+ *   Function taking a span of inputs and a span of Outputs times as many outputs, the first output is fed forward.
+ *
+ * @param inputs
+ *   Inputs, of whichever type the calculator takes, each is used unchanged but only once the previous result is ready.
+ *
+ * @param options
+ *   Options for timing.
+ *
+ * @returns
+ *   Timing of chain.
+ */
+template <std::size_t Outputs = 1u, class F, class S>
+Timing time_batch_latency(F calculator, std::span<const S> inputs, const StreamOptions &options = {})
+{
+    const auto mask = opaque_zero();
+    S input[1] = {};
+    S output[Outputs] = {};
+
+    auto timing = start_run(options);
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    for (const auto theta : inputs)
+    {
+        input[0] = chain(theta, output[0], mask);
+        calculator(std::span<const S>{input}, std::span<S>{output});
+    }
+
+    timing = finish_run(options, timing, start, inputs.size());
+
+    escape(output);
+
+    return timing;
+}
+
+/**
+ * Time a calculator over every input with nothing linking one call to the next, so the time per element is the
+ * reciprocal throughput with as many calls in flight as the cpu can manage.
+ *
+ * @param calculator
+ *   Function to time.
+ *
+ * @param inputs
+ *   Inputs.
+ *
+ * @param options
+ *   Options for timing.
+ *
+ * @returns
+ *   Timing of loop.
+ */
+template <class F>
+Timing time_throughput(F calculator, std::span<const float> inputs, const StreamOptions &options = {})
+{
+    auto results = std::vector<std::invoke_result_t<F, float>>(inputs.size());
+
+    auto timing = start_run(options);
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    for (auto i = std::size_t{0u}; i < inputs.size(); ++i)
+    {
+        results[i] = calculator(inputs[i]);
+    }
+
+    timing = finish_run(options, timing, start, inputs.size());
+
+    escape(results.data());
+
+    return timing;
+}
+
+/**
+ * Time a batch calculator over every input in a single call, giving its reciprocal throughput.
+ *
+ * @param calculator
+ *   Function taking a span of inputs and a span of outputs.
+ *
+ * @param inputs
+ *   Inputs, of whichever type the calculator takes.
+ *
+ * @param outputs
+ *   Where to write results, must be as large as calculator needs.
+ *
+ * @param options
+ *   Options for timing.
+ *
+ * @returns
+ *   Timing of call.
+ */
+template <class F, class S>
+Timing time_batch_throughput(
+    F calculator,
+    std::span<const S> inputs,
+    std::span<S> outputs,
+    const StreamOptions &options = {})
+{
+    auto timing = start_run(options);
+    const auto start = std::chrono::high_resolution_clock::now();
+
+    calculator(inputs, outputs);
+
+    timing = finish_run(options, timing, start, inputs.size());
+
+    escape(outputs.data());
+
+    return timing;
+}
+
+/**
+ * Time a calculator one element at a time in either mode.
+ *
+ * @param calculator
+ *   Function to time.
+ *
+ * @param mode
+ *   Mode to time in.
+ *
+ * @param inputs
+ *   Inputs.
+ *
+ * @param options
+ *   Options for timing.
+ *
+ * @returns
+ *   Timing of calculator.
+ */
+template <class F>
+Timing time_mode(F calculator, TimingMode mode, std::span<const float> inputs, const StreamOptions &options)
+{
+    return mode == TimingMode::LATENCY ? time_latency(calculator, inputs, options)
+                                       : time_throughput(calculator, inputs, options);
+}
+
+namespace detail
+{
+
+/**
+ * Get the options for timing a batch calculator, which subtracts the batch overhead instead of the per element one.
+ *
+ * @param options
+ *   Options for timing.
+ *
+ * @returns
+ *   Options with the batch baseline as the baseline.
+ */
+inline StreamOptions batch_stream_options(const StreamOptions &options)
+{
+    auto batch_options = options;
+    batch_options.baseline = options.batch_baseline;
+    return batch_options;
+}
+
+}
+
+/**
+ * Time a batch calculator in either mode, subtracting the batch baseline.
+ *
+ * @tparam Outputs
+ *   Number of outputs the calculator writes per input.
+ *
+ * @param calculator
+ *   Function taking a span of inputs and a span of Outputs times as many outputs.
+ *
+ * @param mode
+ *   Mode to time in.
+ *
+ * @param inputs
+ *   Inputs, of whichever type the calculator takes.
+ *
+ * @param options
+ *   Options for timing.
+ *
+ * @returns
+ *   Timing of calculator.
+ */
+template <std::size_t Outputs = 1u, class F, class S>
+Timing time_batch_mode(F calculator, TimingMode mode, std::span<const S> inputs, const StreamOptions &options)
+{
+    const auto batch_options = detail::batch_stream_options(options);
+
+    if (mode == TimingMode::LATENCY)
+    {
+        return time_batch_latency<Outputs>(calculator, inputs, batch_options);
+    }
+
+    auto outputs = std::vector<S>(Outputs * inputs.size());
+    return time_batch_throughput(calculator, inputs, std::span{outputs}, batch_options);
+}
+
+/**
+ * Measure the per element cost of the latency chain by timing a calculator which just returns its input.
+ *
+ * @param inputs
+ *   Inputs that will be used for the real measurements.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter.
+ *
+ * @returns
+ *   Per element chain overhead.
+ */
+Baseline calibrate_latency_baseline(std::span<const float> inputs, bool use_cycle_counter);
+
+/**
+ * Measure the per element cost of the throughput loop by timing a calculator which just returns its input.
+ *
+ * @param inputs
+ *   Inputs that will be used for the real measurements.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter.
+ *
+ * @returns
+ *   Per element loop overhead.
+ */
+Baseline calibrate_throughput_baseline(std::span<const float> inputs, bool use_cycle_counter);
+
+/**
+ * Measure the per element cost of the batch latency chain by timing a batch calculator which copies its input, one
+ * element per call the same as time_batch_latency.
+ *
+ * @param inputs
+ *   Inputs that will be used for the real measurements.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter.
+ *
+ * @returns
+ *   Per element overhead of a chained batch call.
+ */
+Baseline calibrate_batch_latency_baseline(std::span<const float> inputs, bool use_cycle_counter);
+
+/**
+ * Measure the per element cost of a batch throughput call by timing a batch calculator which copies all of its inputs
+ * in one call.
+ *
+ * @param inputs
+ *   Inputs that will be used for the real measurements.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter.
+ *
+ * @returns
+ *   Per element overhead of a batch call.
+ */
+Baseline calibrate_batch_throughput_baseline(std::span<const float> inputs, bool use_cycle_counter);
+
+}
@@ -0,0 +1,690 @@
+#include "transform.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "output.h"
+#include "thread_pool.h"
+
+namespace
+{
+
+/** Number of buffers a stream cycles through, so one can be read, one calculated and one written at the same time. */
+constexpr auto slot_count = std::size_t{3u};
+
+/**
+ * Throw the current errno as an exception.
+ *
+ * @param what
+ *   Description of what failed.
+ *
+ * @throws std::system_error
+ *   Always.
+ */
+[[noreturn]] void throw_errno(const std::string &what)
+{
+    throw std::system_error{errno, std::generic_category(), what};
+}
+
+/**
+ * Throw the error for an input which ends part way through a float.
+ *
+ * @param path
+ *   Path of input.
+ *
+ * @throws std::system_error
+ *   Always.
+ */
+[[noreturn]] void throw_partial(const std::string &path)
+{
+    throw std::system_error{
+        std::make_error_code(std::errc::invalid_argument), path + " is not a whole number of floats"};
+}
+
+/**
+ * Releases a memory mapping.
+ */
+struct Unmap
+{
+    /** Size of mapping in bytes. */
+    std::size_t size;
+
+    void operator()(std::byte *data) const noexcept
+    {
+        ::munmap(data, size);
+    }
+};
+
+/**
+ * Owned memory mapping.
+ */
+using Mapping = std::unique_ptr<std::byte[], Unmap>;
+
+/**
+ * A file descriptor, closed on destruction if it was opened here rather than inherited.
+ */
+class Descriptor
+{
+  public:
+    /**
+     * Construct a new Descriptor.
+     *
+     * @param descriptor
+     *   Open file descriptor.
+     *
+     * @param owned
+     *   Whether to close the descriptor.
+     */
+    Descriptor(int descriptor, bool owned) noexcept
+        : descriptor_(descriptor)
+        , owned_(owned)
+    {
+    }
+
+    ~Descriptor()
+    {
+        if (owned_)
+        {
+            ::close(descriptor_);
+        }
+    }
+
+    Descriptor(const Descriptor &) = delete;
+    Descriptor &operator=(const Descriptor &) = delete;
+
+    /**
+     * Get the file descriptor.
+     *
+     * @returns
+     *   File descriptor.
+     */
+    int get() const noexcept
+    {
+        return descriptor_;
+    }
+
+    /**
+     * Close the descriptor if it is owned, so errors from the final write back can be seen.
+     *
+     * @param path
+     *   Path of file, used in error messages.
+     *
+     * @throws std::system_error
+     *   If closing fails.
+     */
+    void close(const std::string &path)
+    {
+        if (!owned_)
+        {
+            return;
+        }
+
+        owned_ = false;
+
+        if (::close(descriptor_) != 0)
+        {
+            throw_errno("failed to close " + path);
+        }
+    }
+
+  private:
+    /** File descriptor. */
+    int descriptor_;
+
+    /** Whether the descriptor is closed on destruction. */
+    bool owned_;
+};
+
+/**
+ * Open a file.
+ *
+ * @param path
+ *   Path of file, - for one of the standard streams.
+ *
+ * @param flags
+ *   Flags to open with.
+ *
+ * @param standard
+ *   Descriptor to use for -.
+ *
+ * @returns
+ *   Open file.
+ *
+ * @throws std::system_error
+ *   If the file can't be opened.
+ */
+Descriptor open_file(const std::string &path, int flags, int standard)
+{
+    if (path == "-")
+    {
+        return Descriptor{standard, false};
+    }
+
+    const auto descriptor = ::open(path.c_str(), flags | O_CLOEXEC, 0644);
+    if (descriptor < 0)
+    {
+        throw_errno("failed to open " + path);
+    }
+
+    return Descriptor{descriptor, true};
+}
+
+/**
+ * Check if a path names a regular file, which can be memory mapped.
+ *
+ * @param path
+ *   Path to check.
+ *
+ * @param missing
+ *   What to return if nothing exists at path.
+ *
+ * @returns
+ *   True if path is a regular file, otherwise false.
+ */
+bool is_regular_file(const std::string &path, bool missing)
+{
+    struct ::stat status = {};
+
+    if (::stat(path.c_str(), &status) != 0)
+    {
+        return missing && (errno == ENOENT);
+    }
+
+    return S_ISREG(status.st_mode);
+}
+
+/**
+ * Check if two paths name the same file, so writing one would overwrite the other.
+ *
+ * @param a
+ *   First path.
+ *
+ * @param b
+ *   Second path.
+ *
+ * @returns
+ *   True if both exist and are the same file, otherwise false.
+ */
+bool same_file(const std::string &a, const std::string &b)
+{
+    struct ::stat a_status = {};
+    struct ::stat b_status = {};
+
+    return (::stat(a.c_str(), &a_status) == 0) && (::stat(b.c_str(), &b_status) == 0) &&
+           (a_status.st_dev == b_status.st_dev) && (a_status.st_ino == b_status.st_ino);
+}
+
+/**
+ * Read into a buffer until it is full or the end of the file, retrying short reads as pipes return whatever is
+ * available.
+ *
+ * @param descriptor
+ *   File to read from.
+ *
+ * @param bytes
+ *   Where to read to.
+ *
+ * @param path
+ *   Path of file, used in error messages.
+ *
+ * @returns
+ *   Number of bytes read, less than the size of bytes only at the end of the file.
+ *
+ * @throws std::system_error
+ *   If the read fails.
+ */
+std::size_t read_full(int descriptor, std::span<std::byte> bytes, const std::string &path)
+{
+    auto total = std::size_t{0u};
+
+    while (total < bytes.size())
+    {
+        const auto read = ::read(descriptor, bytes.data() + total, bytes.size() - total);
+        if (read < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            throw_errno("failed to read " + path);
+        }
+
+        if (read == 0)
+        {
+            break;
+        }
+
+        total += static_cast<std::size_t>(read);
+    }
+
+    return total;
+}
+
+/**
+ * Calculate a window of inputs across the pool, one chunk per task.
+ *
+ * @param calculate
+ *   Kernel to run.
+ *
+ * @param pool
+ *   Pool to calculate with.
+ *
+ * @param thetas
+ *   Inputs.
+ *
+ * @param results
+ *   Where to write results, may be the same as thetas.
+ *
+ * @param chunk_size
+ *   Number of inputs per task.
+ */
+void calculate_window(
+    const fs::harness::TransformFunction &calculate,
+    fs::harness::ThreadPool &pool,
+    std::span<const float> thetas,
+    std::span<float> results,
+    std::size_t chunk_size)
+{
+    const auto tasks = (thetas.size() + chunk_size - 1u) / chunk_size;
+
+    pool.parallel_for(
+        tasks,
+        [&](std::size_t task, std::size_t)
+        {
+            const auto first = task * chunk_size;
+            const auto count = std::min(chunk_size, thetas.size() - first);
+
+            calculate(thetas.subspan(first, count), results.subspan(first, count));
+        });
+}
+
+/**
+ * Which stage of a stream a buffer is waiting for.
+ */
+enum class SlotState
+{
+    /** Waiting to be read into. */
+    FREE,
+
+    /** Holds inputs waiting to be calculated. */
+    FILLED,
+
+    /** Holds results waiting to be written. */
+    CALCULATED
+};
+
+/**
+ * One buffer of a stream.
+ */
+struct Slot
+{
+    /** Whole buffer. */
+    std::span<float> data;
+
+    /** Number of floats in use. */
+    std::size_t count = 0u;
+
+    /** Whether this buffer holds the end of the stream. */
+    bool last = false;
+
+    /** Stage the buffer is waiting for. */
+    SlotState state = SlotState::FREE;
+};
+
+/**
+ * Ring of buffers passed between the stages of a stream, each stage running on its own thread and taking the buffers
+ * in order.
+ */
+class Ring
+{
+  public:
+    /**
+     * Construct a new Ring.
+     *
+     * @param buffers
+     *   Memory to split into slot_count buffers.
+     */
+    explicit Ring(std::span<float> buffers)
+        : mutex_()
+        , changed_()
+        , slots_()
+        , failed_(false)
+        , error_()
+    {
+        const auto size = buffers.size() / slot_count;
+
+        for (auto i = std::size_t{0u}; i < slot_count; ++i)
+        {
+            slots_.push_back({buffers.subspan(i * size, size)});
+        }
+    }
+
+    /**
+     * Run one stage of the stream, taking each buffer in turn once it is waiting for from, working on it and passing
+     * it on as to. Returns after the last buffer of the stream, or as soon as any stage fails, in which case the error
+     * is kept for rethrow.
+     *
+     * @param from
+     *   State of buffers this stage takes.
+     *
+     * @param to
+     *   State of buffers this stage passes on.
+     *
+     * @param work
+     *   Called with each buffer while this stage holds it.
+     */
+    template <class Work>
+    void run(SlotState from, SlotState to, Work work) noexcept
+    {
+        try
+        {
+            for (auto i = std::size_t{0u};; i = (i + 1u) % slots_.size())
+            {
+                auto &slot = slots_[i];
+
+                {
+                    auto lock = std::unique_lock{mutex_};
+                    changed_.wait(lock, [&] { return failed_ || (slot.state == from); });
+
+                    if (failed_)
+                    {
+                        return;
+                    }
+                }
+
+                work(slot);
+
+                // the next stage owns the slot once it is passed on
+                const auto last = slot.last;
+
+                {
+                    auto lock = std::lock_guard{mutex_};
+                    slot.state = to;
+                }
+
+                changed_.notify_all();
+
+                if (last)
+                {
+                    return;
+                }
+            }
+        }
+        catch (...)
+        {
+            {
+                auto lock = std::lock_guard{mutex_};
+                if (!failed_)
+                {
+                    failed_ = true;
+                    error_ = std::current_exception();
+                }
+            }
+
+            changed_.notify_all();
+        }
+    }
+
+    /**
+     * Throw the first error of any stage, once every stage has returned.
+     */
+    void rethrow() const
+    {
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+    }
+
+  private:
+    /** Guards the slot states and error. */
+    std::mutex mutex_;
+
+    /** Signalled whenever a slot changes state or a stage fails. */
+    std::condition_variable changed_;
+
+    /** Buffers in the order they are used. */
+    std::vector<Slot> slots_;
+
+    /** Whether any stage has failed. */
+    bool failed_;
+
+    /** Error of the first stage to fail. */
+    std::exception_ptr error_;
+};
+
+/**
+ * Calculate a file into another file, or in place, with both memory mapped.
+ *
+ * @param calculate
+ *   Kernel to run.
+ *
+ * @param pool
+ *   Pool to calculate with.
+ *
+ * @param options
+ *   Input and output, which must both be regular files.
+ *
+ * @returns
+ *   Number of floats calculated.
+ */
+std::uint64_t transform_mapped(
+    const fs::harness::TransformFunction &calculate,
+    fs::harness::ThreadPool &pool,
+    const fs::harness::TransformOptions &options)
+{
+    const auto in_place = options.output.empty();
+
+    auto input = open_file(options.input, in_place ? O_RDWR : O_RDONLY, -1);
+
+    struct ::stat status = {};
+    if (::fstat(input.get(), &status) != 0)
+    {
+        throw_errno("failed to stat " + options.input);
+    }
+
+    const auto size = static_cast<std::size_t>(status.st_size);
+    if ((size % sizeof(float)) != 0u)
+    {
+        throw_partial(options.input);
+    }
+
+    const auto count = size / sizeof(float);
+
+    auto output = std::optional<fs::harness::OutputFile>{};
+    if (!in_place)
+    {
+        output.emplace(options.output, count, fs::harness::OutputFormat::RAW);
+    }
+
+    if (count != 0u)
+    {
+        auto *const mapping =
+            ::mmap(nullptr, size, in_place ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, input.get(), 0);
+        if (mapping == MAP_FAILED)
+        {
+            throw_errno("failed to map " + options.input);
+        }
+
+        const auto bytes = Mapping{static_cast<std::byte *>(mapping), Unmap{size}};
+        input.close(options.input);
+
+        // every page is touched once front to back
+        ::madvise(bytes.get(), size, MADV_SEQUENTIAL);
+
+        const auto thetas = std::span<const float>{reinterpret_cast<const float *>(bytes.get()), count};
+        const auto results =
+            in_place ? std::span<float>{reinterpret_cast<float *>(bytes.get()), count} : output->data();
+
+        const auto window = pool.size() * options.chunk_size;
+        const auto page_mask = ~(static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) - 1u);
+
+        for (auto first = std::size_t{0u}; first < count; first += window)
+        {
+            const auto next = first + window;
+
+            // start reading the next window while this one is calculated, so the pool rarely waits on a page fault
+            if (next < count)
+            {
+                const auto begin = (next * sizeof(float)) & page_mask;
+                const auto end = std::min(next + window, count) * sizeof(float);
+
+                ::madvise(bytes.get() + begin, end - begin, MADV_WILLNEED);
+            }
+
+            const auto length = std::min(window, count - first);
+            calculate_window(
+                calculate, pool, thetas.subspan(first, length), results.subspan(first, length), options.chunk_size);
+        }
+    }
+
+    if (output)
+    {
+        output->close();
+    }
+
+    return count;
+}
+
+/**
+ * Calculate a stream through a ring of buffers, reading and writing on their own threads.
+ *
+ * @param calculate
+ *   Kernel to run.
+ *
+ * @param pool
+ *   Pool to calculate with.
+ *
+ * @param options
+ *   Input and output.
+ *
+ * @returns
+ *   Number of floats calculated.
+ */
+std::uint64_t transform_streamed(
+    const fs::harness::TransformFunction &calculate,
+    fs::harness::ThreadPool &pool,
+    const fs::harness::TransformOptions &options)
+{
+    const auto output_path = options.output.empty() ? std::string{"-"} : options.output;
+    const auto input_name = options.input == "-" ? std::string{"stdin"} : options.input;
+    const auto output_name = output_path == "-" ? std::string{"stdout"} : output_path;
+
+    auto input = open_file(options.input, O_RDONLY, STDIN_FILENO);
+    auto output = open_file(output_path, O_WRONLY | O_CREAT | O_TRUNC, STDOUT_FILENO);
+
+    const auto slot_size = pool.size() * options.chunk_size;
+    const auto size = slot_count * slot_size * sizeof(float);
+
+    auto *const mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        throw_errno("failed to allocate stream buffers");
+    }
+
+    const auto buffers = Mapping{static_cast<std::byte *>(mapping), Unmap{size}};
+    auto ring = Ring{{reinterpret_cast<float *>(buffers.get()), slot_count * slot_size}};
+    auto count = std::uint64_t{0u};
+
+    auto reader = std::thread{
+        [&]
+        {
+            ring.run(
+                SlotState::FREE,
+                SlotState::FILLED,
+                [&](Slot &slot)
+                {
+                    const auto read = read_full(input.get(), std::as_writable_bytes(slot.data), input_name);
+                    if ((read % sizeof(float)) != 0u)
+                    {
+                        throw_partial(input_name);
+                    }
+
+                    slot.count = read / sizeof(float);
+                    slot.last = slot.count < slot.data.size();
+                    count += slot.count;
+                });
+        }};
+
+    auto writer = std::thread{
+        [&]
+        {
+            ring.run(
+                SlotState::CALCULATED,
+                SlotState::FREE,
+                [&](Slot &slot)
+                { fs::harness::write_all(output.get(), std::as_bytes(slot.data.first(slot.count)), output_name); });
+        }};
+
+    ring.run(
+        SlotState::FILLED,
+        SlotState::CALCULATED,
+        [&](Slot &slot)
+        {
+            const auto values = slot.data.first(slot.count);
+            calculate_window(calculate, pool, values, values, options.chunk_size);
+        });
+
+    reader.join();
+    writer.join();
+
+    ring.rethrow();
+    output.close(output_name);
+
+    return count;
+}
+
+}
+
+namespace fs::harness
+{
+
+TransformResult transform(const TransformFunction &calculate, ThreadPool &pool, const TransformOptions &options)
+{
+    auto resolved = options;
+    resolved.chunk_size = std::max(resolved.chunk_size, std::size_t{1u});
+
+    // writing over the input through a second mapping would truncate it first
+    if ((resolved.input != "-") && (resolved.output != "-") && same_file(resolved.input, resolved.output))
+    {
+        resolved.output.clear();
+    }
+
+    const auto input_mapped = (resolved.input != "-") && is_regular_file(resolved.input, false);
+    const auto output_mapped =
+        resolved.output.empty() || ((resolved.output != "-") && is_regular_file(resolved.output, true));
+    const auto mapped = input_mapped && output_mapped;
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto count =
+        mapped ? transform_mapped(calculate, pool, resolved) : transform_streamed(calculate, pool, resolved);
+    const auto end = std::chrono::steady_clock::now();
+
+    auto result = TransformResult{};
+    result.elements = count;
+    result.total = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    result.mapped = mapped;
+
+    return result;
+}
+
+}
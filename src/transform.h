@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+
+#include "thread_pool.h"
+
+namespace fs::harness
+{
+
+/**
+ * Signature of a kernel run over a batch of inputs, where the results may be the same span as the inputs.
+ */
+using TransformFunction = std::function<void(std::span<const float>, std::span<float>)>;
+
+/**
+ * Options for running a kernel over a stream of raw floats, the same format write_data produces.
+ */
+struct TransformOptions
+{
+    /** Path of file to read, - for stdin. */
+    std::string input;
+
+    /** Path of file to write, - for stdout, empty to overwrite the input, or write to stdout if it isn't a file. */
+    std::string output;
+
+    /** Number of floats calculated by each task given to the thread pool. */
+    std::size_t chunk_size = std::size_t{1u} << 18u;
+};
+
+/**
+ * Result of running a kernel over a stream.
+ */
+struct TransformResult
+{
+    /** Number of floats calculated. */
+    std::uint64_t elements = 0u;
+
+    /** Time from opening the input to finishing the output. */
+    std::chrono::nanoseconds total = std::chrono::nanoseconds{0};
+
+    /** Whether both ends were memory mapped, otherwise they were read and written through buffers. */
+    bool mapped = false;
+
+    /**
+     * Get the rate inputs were consumed at.
+     *
+     * @returns
+     *   Bytes of input per second.
+     */
+    double bytes_per_second() const
+    {
+        if (total.count() == 0)
+        {
+            return 0.0;
+        }
+
+        return static_cast<double>(elements * sizeof(float)) * 1e9 / static_cast<double>(total.count());
+    }
+};
+
+/**
+ * Calculate sine of every float in a stream, so the harness can be used as a stage in a pipeline.
+ *
+ * When both ends are files they are memory mapped and the thread pool writes results straight into the output, with
+ * the next window of input prefetched while the current one is calculated. When either end is a pipe the stream is
+ * read into a ring of page aligned buffers by one thread and written out by another, so reading the next buffer and
+ * writing the previous one overlap with calculating the current one in place.
+ *
+ * @param calculate
+ *   Kernel to run.
+ *
+ * @param pool
+ *   Pool to calculate with.
+ *
+ * @param options
+ *   Input and output.
+ *
+ * @returns
+ *   Amount calculated and time taken.
+ *
+ * @throws std::system_error
+ *   If reading or writing fails, or the input isn't a whole number of floats.
+ */
+TransformResult transform(const TransformFunction &calculate, ThreadPool &pool, const TransformOptions &options);
+
+}
@@ -0,0 +1,208 @@
+#include "workload.h"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <numbers>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "timing.h"
+
+namespace
+{
+
+/** Seed for every random workload. */
+constexpr auto seed = std::uint32_t{0x5eed5eedu};
+
+/**
+ * Fill inputs from a distribution.
+ *
+ * @param inputs
+ *   Where to write inputs.
+ *
+ * @param next
+ *   Function taking the random engine and returning the next input.
+ */
+template <class F>
+void generate(std::span<float> inputs, F next)
+{
+    auto engine = std::mt19937{seed};
+
+    for (auto &input : inputs)
+    {
+        input = next(engine);
+    }
+}
+
+/**
+ * Fill inputs by replaying a file of raw floats from the start as many times as needed.
+ *
+ * @param inputs
+ *   Where to write inputs.
+ *
+ * @param path
+ *   Path of file.
+ *
+ * @throws std::runtime_error
+ *   If the file can't be read or doesn't hold a whole number of floats, at least one.
+ */
+void replay(std::span<float> inputs, const std::string &path)
+{
+    auto file = std::ifstream{path, std::ios::binary};
+    if (!file)
+    {
+        throw std::runtime_error{"failed to open " + path};
+    }
+
+    const auto bytes = std::vector<char>{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    if (file.bad())
+    {
+        throw std::runtime_error{"failed to read " + path};
+    }
+
+    if (bytes.empty() || (bytes.size() % sizeof(float) != 0u))
+    {
+        throw std::runtime_error{"trace " + path + " is not a whole number of floats"};
+    }
+
+    const auto trace_size = bytes.size() / sizeof(float);
+
+    for (auto i = std::size_t{0u}; i < inputs.size(); ++i)
+    {
+        std::memcpy(&inputs[i], bytes.data() + ((i % trace_size) * sizeof(float)), sizeof(float));
+    }
+}
+
+}
+
+namespace fs::harness
+{
+
+std::string_view to_string(WorkloadKind kind)
+{
+    switch (kind)
+    {
+        case WorkloadKind::SPREAD: return "spread";
+        case WorkloadKind::UNIFORM: return "uniform";
+        case WorkloadKind::GAUSSIAN: return "gaussian";
+        case WorkloadKind::LARGE: return "large";
+        case WorkloadKind::DENORMAL: return "denormal";
+        case WorkloadKind::TRACE: return "trace";
+    }
+
+    return "unknown";
+}
+
+std::string to_string(const Workload &workload)
+{
+    auto description = std::string{to_string(workload.kind)};
+
+    switch (workload.kind)
+    {
+        case WorkloadKind::GAUSSIAN:
+        case WorkloadKind::LARGE:
+        case WorkloadKind::DENORMAL:
+        {
+            char buffer[32];
+            const auto end = std::to_chars(buffer, buffer + sizeof(buffer), workload.parameter).ptr;
+            description += ':';
+            description.append(buffer, end);
+            break;
+        }
+        case WorkloadKind::TRACE: description += ':' + workload.path; break;
+        default: break;
+    }
+
+    return description;
+}
+
+InputBuffer::InputBuffer(std::size_t size)
+    : data_(static_cast<float *>(::operator new(size * sizeof(float), std::align_val_t{alignment})))
+    , size_(size)
+{
+}
+
+void InputBuffer::Free::operator()(float *data) const noexcept
+{
+    ::operator delete(data, std::align_val_t{alignment});
+}
+
+InputBuffer make_workload(const Workload &workload, std::uint64_t first, std::uint64_t count, std::size_t size)
+{
+    constexpr auto pi = std::numbers::pi_v<float>;
+
+    auto buffer = InputBuffer{size};
+    const auto inputs = buffer.span();
+
+    switch (workload.kind)
+    {
+        case WorkloadKind::SPREAD:
+        {
+            const auto spread = spread_inputs(first, count, size);
+            std::ranges::copy(spread, inputs.begin());
+            break;
+        }
+        case WorkloadKind::UNIFORM:
+        {
+            auto distribution = std::uniform_real_distribution<float>{-pi, pi};
+            generate(inputs, [&](auto &engine) { return distribution(engine); });
+            break;
+        }
+        case WorkloadKind::GAUSSIAN:
+        {
+            auto distribution = std::normal_distribution<double>{0.0, workload.parameter};
+            generate(inputs, [&](auto &engine) { return static_cast<float>(distribution(engine)); });
+            break;
+        }
+        case WorkloadKind::LARGE:
+        {
+            const auto lowest = std::log(std::numbers::pi);
+            auto exponent = std::uniform_real_distribution<double>{lowest, std::log(workload.parameter)};
+            auto sign = std::bernoulli_distribution{0.5};
+            generate(
+                inputs,
+                [&](auto &engine)
+                {
+                    const auto magnitude = static_cast<float>(std::exp(exponent(engine)));
+                    return sign(engine) ? -magnitude : magnitude;
+                });
+            break;
+        }
+        case WorkloadKind::DENORMAL:
+        {
+            auto denormal = std::bernoulli_distribution{workload.parameter};
+            auto mantissa = std::uniform_int_distribution<std::uint32_t>{1u, 0x007fffffu};
+            auto sign = std::bernoulli_distribution{0.5};
+            auto uniform = std::uniform_real_distribution<float>{-pi, pi};
+            generate(
+                inputs,
+                [&](auto &engine)
+                {
+                    if (!denormal(engine))
+                    {
+                        return uniform(engine);
+                    }
+
+                    return std::bit_cast<float>(mantissa(engine) | (sign(engine) ? 0x80000000u : 0u));
+                });
+            break;
+        }
+        case WorkloadKind::TRACE: replay(inputs, workload.path); break;
+    }
+
+    return buffer;
+}
+
+}
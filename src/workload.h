@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace fs::harness
+{
+
+/**
+ * How the inputs for the latency and throughput modes are made.
+ */
+enum class WorkloadKind
+{
+    /** Spread evenly over the sweep range of bit patterns, which is mostly NaN, denormal or huge for a full sweep. */
+    SPREAD,
+
+    /** Uniform over [-pi, pi]. */
+    UNIFORM,
+
+    /** Normal around zero with a standard deviation given by the parameter. */
+    GAUSSIAN,
+
+    /** Random sign and a magnitude uniform in log scale over [pi, parameter]. */
+    LARGE,
+
+    /** The parameter's fraction of inputs are random denormals, the rest are uniform over [-pi, pi]. */
+    DENORMAL,
+
+    /** Replayed from a file of raw floats, repeated or cut to the stream size. */
+    TRACE
+};
+
+/**
+ * Get the name of a workload kind.
+ *
+ * @param kind
+ *   Workload kind.
+ *
+ * @returns
+ *   Name of kind.
+ */
+std::string_view to_string(WorkloadKind kind);
+
+/**
+ * Description of the inputs for the latency and throughput modes.
+ */
+struct Workload
+{
+    /** How the inputs are made. */
+    WorkloadKind kind = WorkloadKind::SPREAD;
+
+    /** Standard deviation, largest magnitude or fraction of denormals, depending on the kind. */
+    double parameter = 0.0;
+
+    /** File to replay for a trace. */
+    std::string path;
+};
+
+/**
+ * Get a description of a workload in the same form it is given on the command line.
+ *
+ * @param workload
+ *   Workload.
+ *
+ * @returns
+ *   Description of workload.
+ */
+std::string to_string(const Workload &workload);
+
+/**
+ * Inputs made before timing starts, aligned to a cache line so every kernel sees the same alignment and no vector load
+ * is split across lines by the allocator.
+ */
+class InputBuffer
+{
+  public:
+    /** Alignment of the inputs in bytes. */
+    static constexpr std::size_t alignment = 64u;
+
+    /**
+     * Construct a new InputBuffer of uninitialised inputs.
+     *
+     * @param size
+     *   Number of inputs.
+     */
+    explicit InputBuffer(std::size_t size);
+
+    /**
+     * Get the inputs.
+     *
+     * @returns
+     *   Every input.
+     */
+    std::span<float> span() noexcept
+    {
+        return {data_.get(), size_};
+    }
+
+    /**
+     * Get the inputs.
+     *
+     * @returns
+     *   Every input.
+     */
+    std::span<const float> span() const noexcept
+    {
+        return {data_.get(), size_};
+    }
+
+    /**
+     * Get the number of inputs.
+     *
+     * @returns
+     *   Number of inputs.
+     */
+    std::size_t size() const noexcept
+    {
+        return size_;
+    }
+
+  private:
+    /**
+     * Frees memory allocated with the buffer's alignment.
+     */
+    struct Free
+    {
+        void operator()(float *data) const noexcept;
+    };
+
+    /** Inputs. */
+    std::unique_ptr<float[], Free> data_;
+
+    /** Number of inputs. */
+    std::size_t size_;
+};
+
+/**
+ * Make the inputs of a workload. Random workloads use a fixed seed, so every run and every kernel sees the same inputs.
+ *
+ * @param workload
+ *   Workload to make.
+ *
+ * @param first
+ *   First bit pattern of the sweep range, only used to spread inputs.
+ *
+ * @param count
+ *   Number of bit patterns in the sweep range, only used to spread inputs.
+ *
+ * @param size
+ *   Number of inputs to make.
+ *
+ * @returns
+ *   Inputs.
+ *
+ * @throws std::runtime_error
+ *   If a trace can't be read or holds no floats.
+ */
+InputBuffer make_workload(const Workload &workload, std::uint64_t first, std::uint64_t count, std::size_t size);
+
+}
@@ -0,0 +1,278 @@
+#include "x87_benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cpu_features.h"
+#include "kernel_calculator.h"
+#include "polynomial.h"
+#include "scalar_calculators.h"
+#include "simd.h"
+#include "sine_kernel.h"
+
+namespace
+{
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/** Kernel the register only loops use, the same accuracy as x87 over [-pi, pi]. */
+using Kernel = fs::PolynomialKernel<7u>;
+
+/**
+ * Sine of one float with the scalar polynomial, kept in a register so the compiler can't merge neighbouring calls
+ * into a vector and the loop stays one element at a time like the x87 one.
+ *
+ * @param theta
+ *   Input value.
+ *
+ * @returns
+ *   Sine of input value.
+ */
+FS_ALWAYS_INLINE float scalar_sine(float theta)
+{
+    auto result = fs::evaluate<Kernel>(theta);
+    asm("" : "+x"(result));
+    return result;
+}
+
+/**
+ * Sine of each lane through x87, every lane goes through memory onto the x87 stack and back.
+ */
+struct X87Lanes
+{
+    template <class V>
+    FS_ALWAYS_INLINE static V evaluate(V theta)
+    {
+        V result;
+        for (auto i = 0u; i < fs::simd::lane_traits<V>::lanes; ++i)
+        {
+            result[i] = fs::asm_calculator(theta[i]);
+        }
+        return result;
+    }
+};
+
+/**
+ * Sine of each lane through the scalar polynomial.
+ */
+struct ScalarLanes
+{
+    template <class V>
+    FS_ALWAYS_INLINE static V evaluate(V theta)
+    {
+        V result;
+        for (auto i = 0u; i < fs::simd::lane_traits<V>::lanes; ++i)
+        {
+            result[i] = scalar_sine(theta[i]);
+        }
+        return result;
+    }
+};
+
+/**
+ * Sine of every lane at once through the vector polynomial.
+ */
+struct VectorLanes
+{
+    template <class V>
+    FS_ALWAYS_INLINE static V evaluate(V theta)
+    {
+        return Kernel::evaluate(theta);
+    }
+};
+
+/**
+ * Calculate sin(x) * sin(x / 2) for every input N lanes at a time, with the second sine from Second.
+ *
+ * @param inputs
+ *   Inputs, a whole number of vectors.
+ *
+ * @param results
+ *   Where to write results.
+ */
+template <std::size_t N, class Second>
+FS_ALWAYS_INLINE void mixed_loop(std::span<const float> inputs, std::span<float> results)
+{
+    using V = fs::simd::vec<float, N>;
+
+    for (auto i = std::size_t{0u}; i + N <= inputs.size(); i += N)
+    {
+        const auto theta = fs::simd::load<V>(inputs.data() + i);
+        fs::simd::store(results.data() + i, Kernel::evaluate(theta) * Second::evaluate(theta * 0.5f));
+    }
+}
+
+template <class Second>
+FS_TARGET_AVX512 void mixed_avx512(std::span<const float> inputs, std::span<float> results)
+{
+    mixed_loop<16u, Second>(inputs, results);
+}
+
+template <class Second>
+FS_TARGET_AVX2 void mixed_avx2(std::span<const float> inputs, std::span<float> results)
+{
+    mixed_loop<8u, Second>(inputs, results);
+}
+
+template <class Second>
+void mixed_generic(std::span<const float> inputs, std::span<float> results)
+{
+    mixed_loop<4u, Second>(inputs, results);
+}
+
+/**
+ * Get the mixed loop built for an instruction set.
+ *
+ * @param isa
+ *   Instruction set, must be supported on the current cpu.
+ *
+ * @returns
+ *   Mixed loop for isa.
+ */
+template <class Second>
+fs::detail::BatchFunction<float> mixed_for(fs::Isa isa)
+{
+    switch (isa)
+    {
+        case fs::Isa::AVX512: return mixed_avx512<Second>;
+        case fs::Isa::AVX2: return mixed_avx2<Second>;
+        default: return mixed_generic<Second>;
+    }
+}
+
+/**
+ * Time a loop over every input, then compare every result to the reference.
+ *
+ * @param label
+ *   What the loop calculates with.
+ *
+ * @param compute
+ *   Function taking the inputs and where to write the results.
+ *
+ * @param reference
+ *   Function giving the exact result for an input.
+ *
+ * @param inputs
+ *   Inputs.
+ *
+ * @param use_cycle_counter
+ *   Whether to read the cycle counter.
+ *
+ * @returns
+ *   Timing and errors of loop.
+ */
+template <class F, class Ref>
+fs::harness::MixedRun run_loop(
+    std::string label,
+    F compute,
+    Ref reference,
+    std::span<const float> inputs,
+    bool use_cycle_counter)
+{
+    auto results = std::vector<float>(inputs.size());
+    auto errors = fs::harness::ErrorStats{};
+
+    const auto timing = fs::harness::time_and_check(
+        [&](std::span<float> out) { compute(inputs, out); },
+        std::span{results},
+        use_cycle_counter,
+        [&](std::size_t i, float result)
+        {
+            const auto error = std::fabs(static_cast<long double>(result) - reference(inputs[i]));
+            errors.add(inputs[i], static_cast<double>(error));
+        });
+
+    return fs::harness::MixedRun{.label = std::move(label), .timing = timing, .errors = errors};
+}
+
+#endif
+
+}
+
+namespace fs::harness
+{
+
+X87Result benchmark_x87(const X87Options &options)
+{
+    auto result = X87Result{};
+
+#if defined(__x86_64__) || defined(__i386__)
+    constexpr auto widest = std::size_t{16u};
+
+    const auto count = std::max(options.count / widest, std::size_t{1u}) * widest;
+    const auto use_cycle_counter = options.use_cycle_counter && has_cycle_counter();
+
+    auto inputs = std::vector<float>(count);
+    for (auto i = std::size_t{0u}; i < count; ++i)
+    {
+        const auto fraction = (static_cast<double>(i) + 0.5) / static_cast<double>(count);
+        inputs[i] = static_cast<float>(std::numbers::pi * ((2.0 * fraction) - 1.0));
+    }
+
+    const auto isa = selected_isa();
+    const auto isa_name = std::string{to_string(isa)};
+    const auto calculator = KernelCalculator<Kernel>{isa};
+
+    const auto sine = [](float theta) { return std::sin(static_cast<long double>(theta)); };
+    const auto product = [](float theta)
+    { return std::sin(static_cast<long double>(theta)) * std::sin(static_cast<long double>(theta) * 0.5L); };
+
+    result.alone.push_back(run_loop(
+        "x87 alone",
+        [](std::span<const float> in, std::span<float> out)
+        {
+            for (auto i = std::size_t{0u}; i < in.size(); ++i)
+            {
+                out[i] = asm_calculator(in[i]);
+            }
+        },
+        sine,
+        inputs,
+        use_cycle_counter));
+    result.alone.push_back(run_loop(
+        "scalar polynomial_7 alone",
+        [](std::span<const float> in, std::span<float> out)
+        {
+            for (auto i = std::size_t{0u}; i < in.size(); ++i)
+            {
+                out[i] = scalar_sine(in[i]);
+            }
+        },
+        sine,
+        inputs,
+        use_cycle_counter));
+    result.alone.push_back(run_loop(
+        "vector polynomial_7 alone " + isa_name,
+        [&](std::span<const float> in, std::span<float> out) { calculator.calculate(in, out); },
+        sine,
+        inputs,
+        use_cycle_counter));
+
+    result.mixed.push_back(
+        run_loop("mixed " + isa_name + " with x87", mixed_for<X87Lanes>(isa), product, inputs, use_cycle_counter));
+    result.mixed.push_back(run_loop(
+        "mixed " + isa_name + " with scalar polynomial_7",
+        mixed_for<ScalarLanes>(isa),
+        product,
+        inputs,
+        use_cycle_counter));
+    result.mixed.push_back(run_loop(
+        "mixed " + isa_name + " with vector polynomial_7",
+        mixed_for<VectorLanes>(isa),
+        product,
+        inputs,
+        use_cycle_counter));
+#else
+    static_cast<void>(options);
+#endif
+
+    return result;
+}
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "sweep.h"
+#include "timing.h"
+
+namespace fs::harness
+{
+
+/**
+ * Options for measuring the cost of x87 sine in vectorised code.
+ */
+struct X87Options
+{
+    /** Number of inputs, spread evenly over [-pi, pi] and rounded down to a whole number of the widest vectors. */
+    std::size_t count = std::size_t{1u} << 22u;
+
+    /** Whether to also read the cpu cycle counter. */
+    bool use_cycle_counter = true;
+};
+
+/**
+ * Result of one loop of the x87 benchmark.
+ */
+struct MixedRun
+{
+    /** What the loop calculates with. */
+    std::string label;
+
+    /** Time for the whole loop. */
+    Timing timing;
+
+    /** Error of every result against a long double reference. */
+    ErrorStats errors;
+};
+
+/**
+ * Results of the x87 benchmark, empty on targets without x87.
+ */
+struct X87Result
+{
+    /** Sine alone through x87, the scalar polynomial and the vector polynomial, in that order. */
+    std::vector<MixedRun> alone;
+
+    /**
+     * A vectorised loop of sin(x) * sin(x / 2), where the first sine is always the vector polynomial and the second is
+     * x87, the scalar polynomial or the vector polynomial, in that order. The difference between the first and the
+     * others is what x87 costs in code which is otherwise vectorised.
+     */
+    std::vector<MixedRun> mixed;
+};
+
+/**
+ * Time the x87 kernel against register only scalar and vector equivalents, alone and inside vectorised code. The x87
+ * kernel stores each input to memory to load it onto the x87 stack, and stores each result to memory to get it back
+ * into a vector register, which the other loops don't.
+ *
+ * @param options
+ *   Inputs to time over.
+ *
+ * @returns
+ *   Result of each loop.
+ */
+X87Result benchmark_x87(const X87Options &options);
+
+}
@@ -4,7 +4,13 @@ import sys
 import numpy as np
 from matplotlib import pyplot as plt
 
-data = np.memmap(sys.argv[1], dtype="float32", mode="r")
+if sys.argv[1].endswith(".zst"):
+    import zstandard
+
+    with open(sys.argv[1], "rb") as compressed:
+        data = np.frombuffer(zstandard.ZstdDecompressor().stream_reader(compressed).read(), dtype="float32")
+else:
+    data = np.memmap(sys.argv[1], dtype="float32", mode="r")
 plt.rcParams["figure.figsize"] = (12, 7)
 frame1 = plt.gca()
 frame1.axes.xaxis.set_ticklabels([])